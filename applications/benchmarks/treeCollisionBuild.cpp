@@ -0,0 +1,89 @@
+/* Copyright (c) <2003-2019> <Newton Game Dynamics>
+* 
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* 
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely
+*/
+
+// measures the time to build a collision tree against the triangle count and the number of world threads.
+// the mesh is a terrain added one triangle at a time, so every vertex is welded from six copies.
+// usage: treeCollisionBuild [maxThreads] [optimize] [largestGridSize]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <chrono>
+#include <thread>
+#include <Newton.h>
+
+static double GetTimeInSeconds()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static dFloat GetElevation(int x, int z)
+{
+	return dFloat (4.0f * sin (x * 0.05f) * cos (z * 0.07f) + 0.5f * sin (x * 0.31f + z * 0.17f));
+}
+
+static double BuildTerrain(NewtonWorld* const world, int gridSize, int optimize, int& indexCount)
+{
+	const dFloat cellSize = 0.5f;
+	NewtonCollision* const collision = NewtonCreateTreeCollision (world, 0);
+
+	double startTime = GetTimeInSeconds();
+	NewtonTreeCollisionBeginBuild (collision);
+	for (int z = 0; z < gridSize; z ++) {
+		for (int x = 0; x < gridSize; x ++) {
+			dFloat p[4][3];
+			for (int i = 0; i < 4; i ++) {
+				const int x0 = x + (i & 1);
+				const int z0 = z + (i >> 1);
+				p[i][0] = x0 * cellSize;
+				p[i][1] = GetElevation (x0, z0);
+				p[i][2] = z0 * cellSize;
+			}
+			dFloat face0[3][3] = {{p[0][0], p[0][1], p[0][2]}, {p[2][0], p[2][1], p[2][2]}, {p[1][0], p[1][1], p[1][2]}};
+			dFloat face1[3][3] = {{p[1][0], p[1][1], p[1][2]}, {p[2][0], p[2][1], p[2][2]}, {p[3][0], p[3][1], p[3][2]}};
+			NewtonTreeCollisionAddFace (collision, 3, &face0[0][0], 3 * sizeof (dFloat), 0);
+			NewtonTreeCollisionAddFace (collision, 3, &face1[0][0], 3 * sizeof (dFloat), 0);
+		}
+	}
+	NewtonTreeCollisionEndBuild (collision, optimize);
+	double buildTime = GetTimeInSeconds() - startTime;
+
+	NewtonCollisionInfoRecord info;
+	NewtonCollisionGetInfo (collision, &info);
+	indexCount = info.m_collisionTree.m_indexCount;
+
+	NewtonDestroyCollision (collision);
+	return buildTime;
+}
+
+int main (int argc, char** argv)
+{
+	const int hardwareThreads = int (std::thread::hardware_concurrency());
+	const int maxThreads = (argc > 1) ? atoi (argv[1]) : (hardwareThreads > 0 ? hardwareThreads : 1);
+	const int optimize = (argc > 2) ? atoi (argv[2]) : 1;
+	const int largestGrid = (argc > 3) ? atoi (argv[3]) : 512;
+
+	printf ("tree collision build, optimize %d, hardware threads %d\n", optimize, hardwareThreads);
+	printf ("%12s %8s %12s %12s\n", "triangles", "threads", "seconds", "indices");
+	for (int gridSize = 64; gridSize <= largestGrid; gridSize *= 2) {
+		for (int threads = 1; threads <= maxThreads; threads *= 2) {
+			NewtonWorld* const world = NewtonCreate ();
+			NewtonSetThreadsCount (world, threads);
+
+			int indexCount = 0;
+			double buildTime = BuildTerrain (world, gridSize, optimize, indexCount);
+			printf ("%12d %8d %12.4f %12d\n", gridSize * gridSize * 2, NewtonGetThreadsCount (world), buildTime, indexCount);
+
+			NewtonDestroy (world);
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,138 @@
+/* Copyright (c) <2003-2019> <Newton Game Dynamics>
+* 
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* 
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely
+*/
+
+// measures the size and the save and restore time of a world snapshot against the number of bodies,
+// and checks that a restored world continues the original run.
+// the scene is a cube of boxes and spheres dropped on a floor, left to settle for a number of frames.
+// usage: worldSnapshot [largestCubeSide] [settleFrames] [repeats]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+#include <Newton.h>
+
+static double GetTimeInSeconds()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void ApplyGravity (const NewtonBody* const body, dFloat timestep, int threadIndex)
+{
+	dFloat mass;
+	dFloat Ixx;
+	dFloat Iyy;
+	dFloat Izz;
+	NewtonBodyGetMass (body, &mass, &Ixx, &Iyy, &Izz);
+	dFloat force[4] = {0.0f, -9.8f * mass, 0.0f, 0.0f};
+	NewtonBodySetForce (body, force);
+}
+
+static unsigned long long HashWorldState (NewtonWorld* const world)
+{
+	unsigned long long hash = 1469598103934665603ULL;
+	for (NewtonBody* body = NewtonWorldGetFirstBody (world); body; body = NewtonWorldGetNextBody (world, body)) {
+		dFloat state[16 + 3 + 3];
+		NewtonBodyGetMatrix (body, &state[0]);
+		NewtonBodyGetVelocity (body, &state[16]);
+		NewtonBodyGetOmega (body, &state[19]);
+		const unsigned char* const bytes = (const unsigned char*) state;
+		for (size_t i = 0; i < sizeof (state); i ++) {
+			hash = (hash ^ bytes[i]) * 1099511628211ULL;
+		}
+	}
+	return hash;
+}
+
+static NewtonWorld* CreateScene (int side)
+{
+	NewtonWorld* const world = NewtonCreate ();
+
+	dFloat matrix[16] = {1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, -0.5f, 0.0f, 1.0f};
+	NewtonCollision* const floor = NewtonCreateBox (world, 400.0f, 1.0f, 400.0f, 0, NULL);
+	NewtonCreateDynamicBody (world, floor, matrix);
+	NewtonDestroyCollision (floor);
+
+	NewtonCollision* const box = NewtonCreateBox (world, 1.0f, 1.0f, 1.0f, 0, NULL);
+	NewtonCollision* const sphere = NewtonCreateSphere (world, 0.5f, 0, NULL);
+	srand (1);
+	for (int y = 0; y < side; y ++) {
+		for (int z = 0; z < side; z ++) {
+			for (int x = 0; x < side; x ++) {
+				dFloat angles[3] = {(rand() % 100) * 0.01f, (rand() % 100) * 0.01f, 0.0f};
+				NewtonSetEulerAngle (angles, matrix);
+				matrix[12] = x * 1.3f + (rand() % 100) * 0.002f;
+				matrix[13] = 0.6f + y * 1.3f;
+				matrix[14] = z * 1.3f;
+				NewtonCollision* const shape = ((x + y + z) & 1) ? box : sphere;
+				NewtonBody* const body = NewtonCreateDynamicBody (world, shape, matrix);
+				NewtonBodySetMassProperties (body, 1.0f, shape);
+				NewtonBodySetForceAndTorqueCallback (body, ApplyGravity);
+			}
+		}
+	}
+	NewtonDestroyCollision (box);
+	NewtonDestroyCollision (sphere);
+	return world;
+}
+
+int main (int argc, char** argv)
+{
+	const int largestSide = (argc > 1) ? atoi (argv[1]) : 22;
+	const int settleFrames = (argc > 2) ? atoi (argv[2]) : 60;
+	const int repeats = (argc > 3) ? atoi (argv[3]) : 10;
+	const dFloat timestep = 1.0f / 60.0f;
+	const int checkFrames = 10;
+
+	printf ("%8s %12s %12s %10s %10s %10s %8s\n", "bodies", "bytes", "bytes/body", "save ms", "restore ms", "step ms", "match");
+	for (int side = 6; side <= largestSide; side = (side * 3 + 1) / 2) {
+		NewtonWorld* const world = CreateScene (side);
+		for (int i = 0; i < settleFrames; i ++) {
+			NewtonUpdate (world, timestep);
+		}
+
+		const int size = NewtonGetSnapshotSize (world);
+		std::vector<char> storage (size + 16);
+		void* const buffer = (void*) ((size_t (&storage[0]) + 15) & ~size_t (15));
+
+		double startTime = GetTimeInSeconds();
+		int written = 0;
+		for (int i = 0; i < repeats; i ++) {
+			written = NewtonSaveSnapshot (world, buffer, size);
+		}
+		const double saveTime = (GetTimeInSeconds() - startTime) / repeats;
+
+		startTime = GetTimeInSeconds();
+		for (int i = 0; i < repeats; i ++) {
+			NewtonRestoreSnapshot (world, buffer, written);
+		}
+		const double restoreTime = (GetTimeInSeconds() - startTime) / repeats;
+
+		// run ahead, go back and run again, both runs must end in the same state
+		startTime = GetTimeInSeconds();
+		for (int i = 0; i < checkFrames; i ++) {
+			NewtonUpdate (world, timestep);
+		}
+		const double stepTime = (GetTimeInSeconds() - startTime) / checkFrames;
+		const unsigned long long hash0 = HashWorldState (world);
+		const int restored = NewtonRestoreSnapshot (world, buffer, written);
+		for (int i = 0; i < checkFrames; i ++) {
+			NewtonUpdate (world, timestep);
+		}
+		const unsigned long long hash1 = HashWorldState (world);
+
+		const int bodyCount = NewtonWorldGetBodyCount (world);
+		printf ("%8d %12d %12d %10.3f %10.3f %10.3f %8s\n", bodyCount, written, written / bodyCount, saveTime * 1000.0, restoreTime * 1000.0, stepTime * 1000.0, (restored && (hash0 == hash1)) ? "yes" : "no");
+		NewtonDestroy (world);
+	}
+	return 0;
+}
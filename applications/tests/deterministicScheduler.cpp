@@ -0,0 +1,168 @@
+/* Copyright (c) <2003-2019> <Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely
+*/
+
+// checks that worlds in deterministic mode stepped by a scheduler with NewtonUpdateWorlds produce the same state
+// as the same worlds updated one at a time with NewtonUpdate on a single thread.
+// one world is large enough to be split across all the scheduler workers, the others are small and get packed on
+// the workers. the large world is listed twice, it must still be stepped once per frame.
+// the state of all bodies of each world is hashed every few frames and the hashes must match.
+// usage: deterministicScheduler [threads] [frames]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <Newton.h>
+
+#define WORLD_COUNT	4
+
+static void ApplyGravity (const NewtonBody* const body, dFloat timestep, int threadIndex)
+{
+	dFloat mass;
+	dFloat Ixx;
+	dFloat Iyy;
+	dFloat Izz;
+	NewtonBodyGetMass (body, &mass, &Ixx, &Iyy, &Izz);
+	dFloat force[4] = {0.0f, -9.8f * mass, 0.0f, 0.0f};
+	NewtonBodySetForce (body, force);
+}
+
+static unsigned long long HashWorldState (NewtonWorld* const world, unsigned long long hash)
+{
+	for (NewtonBody* body = NewtonWorldGetFirstBody (world); body; body = NewtonWorldGetNextBody (world, body)) {
+		dFloat state[16 + 3 + 3];
+		NewtonBodyGetMatrix (body, &state[0]);
+		NewtonBodyGetVelocity (body, &state[16]);
+		NewtonBodyGetOmega (body, &state[19]);
+		const unsigned char* const bytes = (const unsigned char*) state;
+		for (size_t i = 0; i < sizeof (state); i ++) {
+			hash = (hash ^ bytes[i]) * 1099511628211ULL;
+		}
+	}
+	return hash;
+}
+
+static NewtonBody* AddBox (NewtonWorld* const world, NewtonCollision* const box, dFloat x, dFloat y, dFloat z)
+{
+	dFloat matrix[16] = {1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, x, y, z, 1.0f};
+	NewtonBody* const body = NewtonCreateDynamicBody (world, box, matrix);
+	NewtonBodySetMassMatrix (body, 1.0f, 1.0f, 1.0f, 1.0f);
+	NewtonBodySetForceAndTorqueCallback (body, ApplyGravity);
+	return body;
+}
+
+static NewtonWorld* CreateScene (int piles, int looseBoxes, unsigned seed)
+{
+	NewtonWorld* const world = NewtonCreate ();
+	NewtonSetDeterministicMode (world, 1);
+
+	NewtonCollision* const floor = NewtonCreateBox (world, 200.0f, 1.0f, 200.0f, 0, NULL);
+	dFloat floorMatrix[16] = {1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, -0.5f, 0.0f, 1.0f};
+	NewtonCreateDynamicBody (world, floor, floorMatrix);
+	NewtonDestroyCollision (floor);
+
+	NewtonCollision* const box = NewtonCreateBox (world, 1.0f, 1.0f, 1.0f, 0, NULL);
+	for (int pile = 0; pile < piles; pile ++) {
+		for (int y = 0; y < 8; y ++) {
+			for (int x = 0; x < 8 - y; x ++) {
+				for (int z = 0; z < 3; z ++) {
+					AddBox (world, box, -40.0f + pile * 20.0f + x * 1.01f + y * 0.5f, 0.5f + y, z * 1.01f);
+				}
+			}
+		}
+	}
+
+	// a fixed pseudo random sequence, so that every run builds the same scene
+	for (int i = 0; i < looseBoxes; i ++) {
+		seed = seed * 1664525 + 1013904223;
+		dFloat x = dFloat ((seed >> 8) % 1000) * 0.1f - 50.0f;
+		seed = seed * 1664525 + 1013904223;
+		dFloat y = dFloat ((seed >> 8) % 300) * 0.1f + 10.0f;
+		seed = seed * 1664525 + 1013904223;
+		dFloat z = dFloat ((seed >> 8) % 1000) * 0.1f - 50.0f;
+		NewtonBody* const body = AddBox (world, box, x, y, z);
+		seed = seed * 1664525 + 1013904223;
+		dFloat veloc[4] = {dFloat (int ((seed >> 8) % 21) - 10) * 0.5f, 0.0f, dFloat (int ((seed >> 16) % 21) - 10) * 0.5f, 0.0f};
+		NewtonBodySetVelocity (body, veloc);
+	}
+	NewtonDestroyCollision (box);
+	return world;
+}
+
+static void CreateScenes (NewtonWorld** const worlds)
+{
+	worlds[0] = CreateScene (4, 1000, 3);
+	for (int i = 1; i < WORLD_COUNT; i ++) {
+		worlds[i] = CreateScene (1, 40 * i, 7 + i);
+	}
+}
+
+static void RunSingleThreaded (int frames, unsigned long long* const hashes)
+{
+	NewtonWorld* worlds[WORLD_COUNT];
+	CreateScenes (worlds);
+	for (int i = 0; i < WORLD_COUNT; i ++) {
+		hashes[i] = 1469598103934665603ULL;
+		for (int frame = 0; frame < frames; frame ++) {
+			NewtonUpdate (worlds[i], 1.0f / 60.0f);
+			if ((frame % 20) == 19) {
+				hashes[i] = HashWorldState (worlds[i], hashes[i]);
+			}
+		}
+		NewtonDestroy (worlds[i]);
+	}
+}
+
+static void RunScheduled (int threads, int frames, unsigned long long* const hashes)
+{
+	NewtonScheduler* const scheduler = NewtonCreateScheduler (threads);
+	NewtonWorld* worlds[WORLD_COUNT];
+	CreateScenes (worlds);
+
+	const NewtonWorld* updateList[WORLD_COUNT + 1];
+	for (int i = 0; i < WORLD_COUNT; i ++) {
+		NewtonWorldSetScheduler (worlds[i], scheduler);
+		updateList[i] = worlds[i];
+		hashes[i] = 1469598103934665603ULL;
+	}
+	updateList[WORLD_COUNT] = worlds[0];
+
+	for (int frame = 0; frame < frames; frame ++) {
+		NewtonUpdateWorlds (updateList, WORLD_COUNT + 1, 1.0f / 60.0f);
+		if ((frame % 20) == 19) {
+			for (int i = 0; i < WORLD_COUNT; i ++) {
+				hashes[i] = HashWorldState (worlds[i], hashes[i]);
+			}
+		}
+	}
+
+	for (int i = 0; i < WORLD_COUNT; i ++) {
+		NewtonDestroy (worlds[i]);
+	}
+	NewtonDestroyScheduler (scheduler);
+}
+
+int main (int argc, char** argv)
+{
+	int threads = (argc > 1) ? atoi (argv[1]) : 4;
+	int frames = (argc > 2) ? atoi (argv[2]) : 200;
+
+	unsigned long long reference[WORLD_COUNT];
+	unsigned long long scheduled[WORLD_COUNT];
+	RunSingleThreaded (frames, reference);
+	RunScheduled (threads, frames, scheduled);
+
+	int failed = 0;
+	for (int i = 0; i < WORLD_COUNT; i ++) {
+		bool match = (scheduled[i] == reference[i]);
+		failed += match ? 0 : 1;
+		printf ("world %d hash %016llx scheduled %016llx %s\n", i, reference[i], scheduled[i], match ? "ok" : "MISMATCH");
+	}
+	return failed ? 1 : 0;
+}
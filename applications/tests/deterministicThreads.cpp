@@ -0,0 +1,123 @@
+/* Copyright (c) <2003-2019> <Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely
+*/
+
+// checks that a world in deterministic mode produces the same state for any thread count.
+// the scene is a few piles of boxes, large enough for the parallel solver, and a rain of loose boxes
+// that keeps the broad phase making and destroying pairs. the state of all bodies is hashed every
+// few frames and the hashes of each thread count must match the single threaded run.
+// usage: deterministicThreads [maxThreads] [frames]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <Newton.h>
+
+static void ApplyGravity (const NewtonBody* const body, dFloat timestep, int threadIndex)
+{
+	dFloat mass;
+	dFloat Ixx;
+	dFloat Iyy;
+	dFloat Izz;
+	NewtonBodyGetMass (body, &mass, &Ixx, &Iyy, &Izz);
+	dFloat force[4] = {0.0f, -9.8f * mass, 0.0f, 0.0f};
+	NewtonBodySetForce (body, force);
+}
+
+static unsigned long long HashWorldState (NewtonWorld* const world, unsigned long long hash)
+{
+	for (NewtonBody* body = NewtonWorldGetFirstBody (world); body; body = NewtonWorldGetNextBody (world, body)) {
+		dFloat state[16 + 3 + 3];
+		NewtonBodyGetMatrix (body, &state[0]);
+		NewtonBodyGetVelocity (body, &state[16]);
+		NewtonBodyGetOmega (body, &state[19]);
+		const unsigned char* const bytes = (const unsigned char*) state;
+		for (size_t i = 0; i < sizeof (state); i ++) {
+			hash = (hash ^ bytes[i]) * 1099511628211ULL;
+		}
+	}
+	return hash;
+}
+
+static NewtonBody* AddBox (NewtonWorld* const world, NewtonCollision* const box, dFloat x, dFloat y, dFloat z)
+{
+	dFloat matrix[16] = {1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, x, y, z, 1.0f};
+	NewtonBody* const body = NewtonCreateDynamicBody (world, box, matrix);
+	NewtonBodySetMassMatrix (body, 1.0f, 1.0f, 1.0f, 1.0f);
+	NewtonBodySetForceAndTorqueCallback (body, ApplyGravity);
+	return body;
+}
+
+static unsigned long long RunScene (int threads, int frames)
+{
+	NewtonWorld* const world = NewtonCreate ();
+	NewtonSetThreadsCount (world, threads);
+	NewtonSetDeterministicMode (world, 1);
+
+	NewtonCollision* const floor = NewtonCreateBox (world, 200.0f, 1.0f, 200.0f, 0, NULL);
+	dFloat floorMatrix[16] = {1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, -0.5f, 0.0f, 1.0f};
+	NewtonCreateDynamicBody (world, floor, floorMatrix);
+	NewtonDestroyCollision (floor);
+
+	NewtonCollision* const box = NewtonCreateBox (world, 1.0f, 1.0f, 1.0f, 0, NULL);
+	for (int pile = 0; pile < 4; pile ++) {
+		for (int y = 0; y < 8; y ++) {
+			for (int x = 0; x < 8 - y; x ++) {
+				for (int z = 0; z < 3; z ++) {
+					AddBox (world, box, -40.0f + pile * 20.0f + x * 1.01f + y * 0.5f, 0.5f + y, z * 1.01f);
+				}
+			}
+		}
+	}
+
+	// a fixed pseudo random sequence, so that every run builds the same scene
+	unsigned seed = 3;
+	for (int i = 0; i < 1000; i ++) {
+		seed = seed * 1664525 + 1013904223;
+		dFloat x = dFloat ((seed >> 8) % 1000) * 0.1f - 50.0f;
+		seed = seed * 1664525 + 1013904223;
+		dFloat y = dFloat ((seed >> 8) % 300) * 0.1f + 10.0f;
+		seed = seed * 1664525 + 1013904223;
+		dFloat z = dFloat ((seed >> 8) % 1000) * 0.1f - 50.0f;
+		NewtonBody* const body = AddBox (world, box, x, y, z);
+		seed = seed * 1664525 + 1013904223;
+		dFloat veloc[4] = {dFloat (int ((seed >> 8) % 21) - 10) * 0.5f, 0.0f, dFloat (int ((seed >> 16) % 21) - 10) * 0.5f, 0.0f};
+		NewtonBodySetVelocity (body, veloc);
+	}
+	NewtonDestroyCollision (box);
+
+	unsigned long long hash = 1469598103934665603ULL;
+	for (int i = 0; i < frames; i ++) {
+		NewtonUpdate (world, 1.0f / 60.0f);
+		if ((i % 20) == 19) {
+			hash = HashWorldState (world, hash);
+		}
+	}
+	NewtonDestroy (world);
+	return hash;
+}
+
+int main (int argc, char** argv)
+{
+	int maxThreads = (argc > 1) ? atoi (argv[1]) : 4;
+	int frames = (argc > 2) ? atoi (argv[2]) : 200;
+
+	int failed = 0;
+	unsigned long long reference = 0;
+	for (int threads = 1; threads <= maxThreads; threads ++) {
+		unsigned long long hash = RunScene (threads, frames);
+		if (threads == 1) {
+			reference = hash;
+		}
+		bool match = (hash == reference);
+		failed += match ? 0 : 1;
+		printf ("threads %d hash %016llx %s\n", threads, hash, match ? "ok" : "MISMATCH");
+	}
+	return failed ? 1 : 0;
+}
@@ -17,13 +17,16 @@
 #include "dCustomJoint.h"
 #include "dCustomTriggerManager.h"
 
-dCustomTriggerManager::dCustomTriggerManager(NewtonWorld* const world)
+dCustomTriggerManager::dCustomTriggerManager(NewtonWorld* const world, dTriggerOverlapMode mode)
 	:dCustomParallelListener(world, TRIGGER_PLUGIN_NAME)
 	,m_triggerList()
+	,m_triggerMap()
 	,m_pairCache ()
 	,m_cacheCount(0)
 	,m_lock(0)
 	,m_lru(0)
+	,m_mode(mode)
+	,m_cacheIsDirty(false)
 {
 }
 
@@ -55,13 +58,23 @@ dCustomTriggerController* dCustomTriggerManager::CreateTrigger (const dMatrix& m
 	NewtonCollision* const collision = NewtonBodyGetCollision (trigger.m_kinematicBody);
 	NewtonCollisionSetMode(collision, 0);
 
+	if (m_mode == m_aabbOverlap) {
+		// the engine reports the bodies entering and leaving the volume box
+		NewtonBodySetTriggerVolume(trigger.m_kinematicBody, 1);
+		m_triggerMap.Insert(&trigger, trigger.m_kinematicBody);
+	}
+
 	return &trigger;
 }
 
 void dCustomTriggerManager::DestroyTrigger (dCustomTriggerController* const trigger)
 {
 	dList<dCustomTriggerController>::dListNode* const node = m_triggerList.GetNodeFromInfo(*trigger);
+	if (m_mode == m_aabbOverlap) {
+		m_triggerMap.Remove(trigger->m_kinematicBody);
+	}
 	m_triggerList.Remove(node);
+	m_cacheIsDirty = true;
 }
 
 void dCustomTriggerManager::OnDestroyBody (NewtonBody* const body)
@@ -73,6 +86,7 @@ void dCustomTriggerManager::OnDestroyBody (NewtonBody* const body)
 		if (passengerNode) {
 			OnExit (&controller, 0.0f, body);
 			controller.m_manifest.Remove (passengerNode);
+			m_cacheIsDirty = true;
 		}
 	}
 }
@@ -90,7 +104,7 @@ void dCustomTriggerManager::OnDebug(dCustomJoint::dDebugDisplay* const debugCont
 	}
 }
 
-void dCustomTriggerManager::PreUpdate(dFloat timestep, int threadID)
+void dCustomTriggerManager::UpdateGuests(dFloat timestep, int threadID)
 {
 	D_TRACKTIME();
 
@@ -101,14 +115,27 @@ void dCustomTriggerManager::PreUpdate(dFloat timestep, int threadID)
 		dTriggerGuestPair& cacheEntry = m_pairCache[i];
 		if (cacheEntry.m_bodyNode->GetInfo() != m_lru) {
 			cacheEntry.m_bodyNode->GetInfo() = m_lru;
-//			dTrace(("in trigger body:%d lru:%d frame:%d\n", NewtonBodyGetID(cacheEntry.m_bodyNode->GetKey()), cacheEntry.m_bodyNode->GetInfo(), xxxxx));
 			WhileIn (cacheEntry.m_trigger, timestep, cacheEntry.m_bodyNode->GetKey());
 		}
 	}
 }
 
+void dCustomTriggerManager::PreUpdate(dFloat timestep, int threadID)
+{
+	UpdateGuests(timestep, threadID);
+}
+
+void dCustomTriggerManager::PostStep(dFloat timestep, int threadID)
+{
+	UpdateGuests(timestep, threadID);
+}
+
 void dCustomTriggerManager::PreUpdate(dFloat timestep)
 {
+	if (m_mode != m_shapeOverlap) {
+		return;
+	}
+
 	m_lru++;
 	m_cacheCount = 0;
 	m_timestep = timestep;
@@ -128,9 +155,7 @@ void dCustomTriggerManager::PreUpdate(dFloat timestep)
 			NewtonBody* cargoBody = (body0 != triggerBody) ? body0 : body1;
 			dCustomTriggerController::dTriggerManifest::dTreeNode* uniqueEntryNode = manifest.Find(cargoBody);
 			if (!uniqueEntryNode) {
-//				dCustomScopeLock lock(&m_lock);
 				uniqueEntryNode = manifest.Insert(m_lru, cargoBody);
-//				dTrace(("entering trigger body:%d lru:%d frame:%d\n", NewtonBodyGetID(cargoBody), m_lru, xxxxx));
 				OnEnter(&controller, timestep, cargoBody);
 			}
 			dTriggerGuestPair& cacheEntry = m_pairCache[m_cacheCount];
@@ -151,11 +176,63 @@ void dCustomTriggerManager::PreUpdate(dFloat timestep)
 			iter++;
 			if (node->GetInfo() != m_lru) {
 				NewtonBody* const cargoBody = node->GetKey();
-//				dTrace(("exiting trigger body:%d lru:%d frame:%d\n\n", NewtonBodyGetID(cargoBody), node->GetInfo(), xxxxx));
 				OnExit(controller, timestep, cargoBody);
-//				dCustomScopeLock lock(&m_lock);
 				controller->m_manifest.Remove(cargoBody);
 			}
 		}
 	}
-}
\ No newline at end of file
+}
+
+void dCustomTriggerManager::PostStep(dFloat timestep)
+{
+	if (m_mode != m_aabbOverlap) {
+		return;
+	}
+
+	// the manifests only change when the broad phase reports a pair beginning or ending
+	int eventCount = 0;
+	const NewtonTriggerEvent* const events = NewtonWorldGetTriggerEvents(GetWorld(), &eventCount);
+	for (int i = 0; i < eventCount; i ++) {
+		const NewtonTriggerEvent& event = events[i];
+		dTriggerMap::dTreeNode* const triggerNode = m_triggerMap.Find(event.m_trigger);
+		if (triggerNode) {
+			dCustomTriggerController* const controller = triggerNode->GetInfo();
+			NewtonBody* const cargoBody = (NewtonBody*)event.m_body;
+			dCustomTriggerController::dTriggerManifest& manifest = controller->m_manifest;
+			if (event.m_begin) {
+				if (!manifest.Find(cargoBody)) {
+					manifest.Insert(m_lru, cargoBody);
+					OnEnter(controller, timestep, cargoBody);
+					m_cacheIsDirty = true;
+				}
+			} else {
+				dCustomTriggerController::dTriggerManifest::dTreeNode* const guestNode = manifest.Find(cargoBody);
+				if (guestNode) {
+					OnExit(controller, timestep, cargoBody);
+					manifest.Remove(guestNode);
+					m_cacheIsDirty = true;
+				}
+			}
+		}
+	}
+
+	if (m_cacheIsDirty) {
+		m_cacheIsDirty = false;
+		m_cacheCount = 0;
+		for (dList<dCustomTriggerController>::dListNode* node = GetControllersList().GetFirst(); node; node = node->GetNext()) {
+			dCustomTriggerController* const controller = &node->GetInfo();
+			dCustomTriggerController::dTriggerManifest::Iterator iter(controller->m_manifest);
+			for (iter.Begin(); iter; iter++) {
+				dTriggerGuestPair& cacheEntry = m_pairCache[m_cacheCount];
+				cacheEntry.m_trigger = controller;
+				cacheEntry.m_bodyNode = iter.GetNode();
+				m_cacheCount++;
+			}
+		}
+	}
+
+	if (m_cacheCount) {
+		m_lru++;
+		dCustomParallelListener::PostStep(timestep);
+	}
+}
@@ -24,6 +24,8 @@
 // a trigger is volume of space that is there to send a message 
 // to other objects when and object enter of leave the trigger region  
 // they are not visible and do not collide with bodies, but the generate contacts
+// by default a body is inside while it touches the trigger shape, m_aabbOverlap 
+// trades that accuracy for the broad phase begin and end events of the trigger box
 
 
 class dCustomTriggerManager;
@@ -72,8 +74,21 @@ class dCustomTriggerManager: public dCustomParallelListener
 		dCustomTriggerController::dTriggerManifest::dTreeNode* m_bodyNode;
 	};
 
+	class dTriggerMap: public dTree<dCustomTriggerController*, const NewtonBody*>
+	{
+	};
+
 	public:
-	CUSTOM_JOINTS_API dCustomTriggerManager (NewtonWorld* const world);
+	enum dTriggerOverlapMode
+	{
+		// a body is inside while it has contacts with the trigger shape, found before each step 
+		m_shapeOverlap,
+		// a body is inside while its box overlaps the trigger box, reported by the broad phase after each step.
+		// much cheaper with many triggers, but a body near a corner of the trigger can be inside without touching the shape
+		m_aabbOverlap,
+	};
+
+	CUSTOM_JOINTS_API dCustomTriggerManager (NewtonWorld* const world, dTriggerOverlapMode mode = m_shapeOverlap);
 	CUSTOM_JOINTS_API virtual ~dCustomTriggerManager();
 	
 	CUSTOM_JOINTS_API virtual dCustomTriggerController* CreateTrigger (const dMatrix& matrix, NewtonCollision* const convexShape, void* const userData);
@@ -85,10 +100,12 @@ class dCustomTriggerManager: public dCustomParallelListener
 
 	dList<dCustomTriggerController>& GetControllersList () {return m_triggerList;}
 	const dList<dCustomTriggerController>& GetControllersList () const {return m_triggerList;}
+	dTriggerOverlapMode GetOverlapMode () const {return m_mode;}
 
 	protected:
 	CUSTOM_JOINTS_API virtual void OnDestroy();
 	CUSTOM_JOINTS_API void PreUpdate(dFloat timestep, int threadID);
+	CUSTOM_JOINTS_API void PostStep(dFloat timestep, int threadID);
 	CUSTOM_JOINTS_API virtual void OnDestroyBody (NewtonBody* const body); 
 
 	virtual void OnDebug(dCustomJoint::dDebugDisplay* const debugContext, const dCustomTriggerController* const controller, const NewtonBody* const guess) const 
@@ -96,6 +113,7 @@ class dCustomTriggerManager: public dCustomParallelListener
 	}
 
 	CUSTOM_JOINTS_API virtual void PreUpdate(dFloat timestep);
+	CUSTOM_JOINTS_API virtual void PostStep(dFloat timestep);
 
 	virtual void PostUpdate(dFloat timestep)
 	{
@@ -104,12 +122,16 @@ class dCustomTriggerManager: public dCustomParallelListener
 
 	private:
 	CUSTOM_JOINTS_API void OnDebug(dCustomJoint::dDebugDisplay* const debugContext);
+	void UpdateGuests(dFloat timestep, int threadID);
 
 	dList<dCustomTriggerController> m_triggerList;
+	dTriggerMap m_triggerMap;
 	dArray<dTriggerGuestPair> m_pairCache;
 	int m_cacheCount;
 	unsigned m_lock;
 	unsigned m_lru;
+	dTriggerOverlapMode m_mode;
+	bool m_cacheIsDirty;
 };
 
 
@@ -22,6 +22,7 @@
 #include "dgStdafx.h"
 #include "dgHeap.h"
 #include "dgStack.h"
+#include "dgThreadHive.h"
 #include "dgList.h"
 #include "dgMatrix.h"
 #include "dgAABBPolygonSoup.h"
@@ -136,119 +137,258 @@ class dgAABBPolygonSoup::dgNodeBuilder: public dgAABBPolygonSoup::dgNode
 
 
 
+#define DG_SAH_BINS_COUNT				16
+#define DG_PARALLEL_SUBTREE_SIZE		(1024 * 16)
+
+// binned surface area heuristic, boxes are binned by their centers along the three axis
 class dgAABBPolygonSoup::dgSpliteInfo
 {
 	public:
-	dgSpliteInfo (dgNodeBuilder* const boxArray, dgInt32 boxCount)
+	dgSpliteInfo ()
 	{
-		dgVector minP ( dgFloat32 (1.0e15f)); 
-		dgVector maxP (-dgFloat32 (1.0e15f)); 
-
-		if (boxCount == 2) {
-			m_axis = 1;
-			for (dgInt32 i = 0; i < boxCount; i ++) {
-				const dgNodeBuilder& box = boxArray[i];
-				const dgVector& p0 = box.m_p0;
-				const dgVector& p1 = box.m_p1;
-				minP = minP.GetMin (p0); 
-				maxP = maxP.GetMax (p1); 
+		m_p0 = dgVector ( dgFloat32 (1.0e15f)) & dgVector::m_triplexMask;
+		m_p1 = dgVector (-dgFloat32 (1.0e15f)) & dgVector::m_triplexMask;
+		m_centerP0 = m_p0;
+		m_centerP1 = m_p1;
+		m_binScale = dgVector::m_zero;
+		for (dgInt32 i = 0; i < 3; i ++) {
+			for (dgInt32 j = 0; j < DG_SAH_BINS_COUNT; j ++) {
+				m_binP0[i][j] = m_p0;
+				m_binP1[i][j] = m_p1;
+				m_binCount[i][j] = 0;
 			}
+		}
+	}
 
-		} else {
-			dgVector median (dgFloat32 (0.0f));
-			dgVector varian (dgFloat32 (0.0f));
-			for (dgInt32 i = 0; i < boxCount; i ++) {
-				const dgNodeBuilder& box = boxArray[i];
+	void AddBounds (const dgNodeBuilder* const boxArray, dgInt32 boxCount)
+	{
+		for (dgInt32 i = 0; i < boxCount; i ++) {
+			const dgNodeBuilder& box = boxArray[i];
+			m_p0 = m_p0.GetMin (box.m_p0);
+			m_p1 = m_p1.GetMax (box.m_p1);
+			m_centerP0 = m_centerP0.GetMin (box.m_origin);
+			m_centerP1 = m_centerP1.GetMax (box.m_origin);
+		}
+	}
 
-				const dgVector& p0 = box.m_p0;
-				const dgVector& p1 = box.m_p1;
+	void MergeBounds (const dgSpliteInfo& info)
+	{
+		m_p0 = m_p0.GetMin (info.m_p0);
+		m_p1 = m_p1.GetMax (info.m_p1);
+		m_centerP0 = m_centerP0.GetMin (info.m_centerP0);
+		m_centerP1 = m_centerP1.GetMax (info.m_centerP1);
+	}
 
-				minP = minP.GetMin (p0); 
-				maxP = maxP.GetMax (p1); 
-				dgVector p (dgVector::m_half * (p0 + p1));
+	void SetBinScale ()
+	{
+		for (dgInt32 i = 0; i < 3; i ++) {
+			dgFloat32 size = m_centerP1[i] - m_centerP0[i];
+			m_binScale[i] = (size > dgFloat32 (1.0e-6f)) ? dgFloat32 (DG_SAH_BINS_COUNT) * dgFloat32 (0.999f) / size : dgFloat32 (0.0f);
+		}
+	}
 
-				median += p;
-				varian += p * p;
-			}
+	DG_INLINE dgInt32 GetBin (const dgNodeBuilder& box, dgInt32 axis) const
+	{
+		dgInt32 bin = dgInt32 ((box.m_origin[axis] - m_centerP0[axis]) * m_binScale[axis]);
+		return dgClamp (bin, 0, DG_SAH_BINS_COUNT - 1);
+	}
 
-			varian = varian.Scale (dgFloat32 (boxCount)) - median * median;
+	void AddBins (const dgNodeBuilder* const boxArray, dgInt32 boxCount, const dgSpliteInfo& bounds)
+	{
+		for (dgInt32 i = 0; i < boxCount; i ++) {
+			const dgNodeBuilder& box = boxArray[i];
+			for (dgInt32 j = 0; j < 3; j ++) {
+				dgInt32 bin = bounds.GetBin (box, j);
+				m_binP0[j][bin] = m_binP0[j][bin].GetMin (box.m_p0);
+				m_binP1[j][bin] = m_binP1[j][bin].GetMax (box.m_p1);
+				m_binCount[j][bin] ++;
+			}
+		}
+	}
 
-			dgInt32 index = 0;
-			dgFloat32 maxVarian = dgFloat32 (-1.0e10f);
-			for (dgInt32 i = 0; i < 3; i ++) {
-				if (varian[i] > maxVarian) {
-					index = i;
-					maxVarian = varian[i];
-				}
+	void MergeBins (const dgSpliteInfo& info)
+	{
+		for (dgInt32 i = 0; i < 3; i ++) {
+			for (dgInt32 j = 0; j < DG_SAH_BINS_COUNT; j ++) {
+				m_binP0[i][j] = m_binP0[i][j].GetMin (info.m_binP0[i][j]);
+				m_binP1[i][j] = m_binP1[i][j].GetMax (info.m_binP1[i][j]);
+				m_binCount[i][j] += info.m_binCount[i][j];
 			}
+		}
+	}
 
-			dgVector center = median.Scale (dgFloat32 (1.0f) / dgFloat32 (boxCount));
-			dgFloat32 test = center[index];
-			dgInt32 i0 = 0;
-			dgInt32 i1 = boxCount - 1;
-			do {    
-				for (; i0 <= i1; i0 ++) {
-					const dgNodeBuilder& box = boxArray[i0];
-					dgFloat32 val = (box.m_p0[index] + box.m_p1[index]) * dgFloat32 (0.5f);
-					if (val > test) {
-						break;
-					}
-				}
+	// pick the cheapest bin plane and sort the boxes around it, return the number of boxes on the left side
+	dgInt32 Partition (dgNodeBuilder* const boxArray, dgInt32 boxCount) const
+	{
+		dgInt32 bestAxis = -1;
+		dgInt32 bestBin = 0;
+		dgFloat32 bestCost = dgFloat32 (1.0e30f);
+		for (dgInt32 i = 0; i < 3; i ++) {
+			if (m_binScale[i] == dgFloat32 (0.0f)) {
+				continue;
+			}
+			dgFloat32 rightArea[DG_SAH_BINS_COUNT];
+			dgInt32 rightCount[DG_SAH_BINS_COUNT];
+			dgVector p0 (m_binP0[i][DG_SAH_BINS_COUNT - 1]);
+			dgVector p1 (m_binP1[i][DG_SAH_BINS_COUNT - 1]);
+			dgInt32 count = m_binCount[i][DG_SAH_BINS_COUNT - 1];
+			rightArea[DG_SAH_BINS_COUNT - 1] = CalculateArea (p0, p1);
+			rightCount[DG_SAH_BINS_COUNT - 1] = count;
+			for (dgInt32 j = DG_SAH_BINS_COUNT - 2; j > 0; j --) {
+				p0 = p0.GetMin (m_binP0[i][j]);
+				p1 = p1.GetMax (m_binP1[i][j]);
+				count += m_binCount[i][j];
+				rightArea[j] = CalculateArea (p0, p1);
+				rightCount[j] = count;
+			}
 
-				for (; i1 >= i0; i1 --) {
-					const dgNodeBuilder& box = boxArray[i1];
-					dgFloat32 val = (box.m_p0[index] + box.m_p1[index]) * dgFloat32 (0.5f);
-					if (val < test) {
-						break;
+			p0 = m_binP0[i][0];
+			p1 = m_binP1[i][0];
+			count = m_binCount[i][0];
+			for (dgInt32 j = 1; j < DG_SAH_BINS_COUNT; j ++) {
+				if (count && rightCount[j]) {
+					dgFloat32 cost = CalculateArea (p0, p1) * dgFloat32 (count) + rightArea[j] * dgFloat32 (rightCount[j]);
+					if (cost < bestCost) {
+						bestCost = cost;
+						bestAxis = i;
+						bestBin = j;
 					}
 				}
+				p0 = p0.GetMin (m_binP0[i][j]);
+				p1 = p1.GetMax (m_binP1[i][j]);
+				count += m_binCount[i][j];
+			}
+		}
 
-				if (i0 < i1)	{
-					dgSwap(boxArray[i0], boxArray[i1]);
-					i0++; 
-					i1--;
-				}
-			} while (i0 <= i1);
+		if (bestAxis < 0) {
+			// all centers in the same bin, any split is as good as any other
+			return boxCount / 2;
+		}
 
-			if (i0 > 0){
-				i0 --;
-			}
-			if ((i0 + 1) >= boxCount) {
-				i0 = boxCount - 2;
+		dgInt32 i0 = 0;
+		dgInt32 i1 = boxCount - 1;
+		while (i0 <= i1) {
+			if (GetBin (boxArray[i0], bestAxis) < bestBin) {
+				i0 ++;
+			} else {
+				dgSwap (boxArray[i0], boxArray[i1]);
+				i1 --;
 			}
-
-			m_axis = i0 + 1;
 		}
+		dgAssert (i0 > 0);
+		dgAssert (i0 < boxCount);
+		return i0;
+	}
 
-		dgAssert (maxP.m_x - minP.m_x >= dgFloat32 (0.0f));
-		dgAssert (maxP.m_y - minP.m_y >= dgFloat32 (0.0f));
-		dgAssert (maxP.m_z - minP.m_z >= dgFloat32 (0.0f));
-		m_p0 = minP;
-		m_p1 = maxP;
+	static DG_INLINE dgFloat32 CalculateArea (const dgVector& p0, const dgVector& p1)
+	{
+		dgVector size ((p1 - p0) & dgVector::m_triplexMask);
+		return size.DotProduct(size.ShiftTripleRight()).GetScalar();
 	}
 
-	dgInt32 m_axis;
 	dgVector m_p0;
 	dgVector m_p1;
+	dgVector m_centerP0;
+	dgVector m_centerP1;
+	dgVector m_binScale;
+	dgVector m_binP0[3][DG_SAH_BINS_COUNT];
+	dgVector m_binP1[3][DG_SAH_BINS_COUNT];
+	dgInt32 m_binCount[3][DG_SAH_BINS_COUNT];
+} DG_GCC_VECTOR_ALIGMENT;
+
+class dgAABBPolygonSoup::dgSubtreeJob
+{
+	public:
+	dgNodeBuilder* m_parent;
+	dgInt32 m_firstBox;
+	dgInt32 m_lastBox;
+	dgInt32 m_isLeft;
 };
 
+class dgAABBPolygonSoup::dgTopDownDescriptor
+{
+	public:
+	const dgAABBPolygonSoup* m_me;
+	dgNodeBuilder* m_leafArray;
+	dgNodeBuilder* m_nodePool;
+	dgSpliteInfo* m_chunkInfo;
+	const dgSpliteInfo* m_bounds;
+	const dgSubtreeJob* m_subtrees;
+	dgInt32 m_firstBox;
+	dgInt32 m_boxCount;
+	dgInt32 m_jobCount;
+	dgInt32 m_atomicCounter;
+};
+
+class dgAABBPolygonSoup::dgAdjacencyDescriptor
+{
+	public:
+	const dgAABBPolygonSoup* m_me;
+	const dgNode::dgLeafNodePtr* m_faces;
+	dgInt32 m_faceCount;
+	dgInt32 m_atomicCounter;
+};
+
+#define DG_TREE_IMAGE_MAGIC				0x5443444e
+#define DG_TREE_IMAGE_VERSION			2
+#define DG_TREE_IMAGE_ALIGNMENT			64
+
+// all offsets are relative to the start of the image, so the image can be mapped at any address
+class dgAABBPolygonSoup::dgImageHeader
+{
+	public:
+	static DG_INLINE dgInt64 Align (dgInt64 offset)
+	{
+		return (offset + DG_TREE_IMAGE_ALIGNMENT - 1) & ~dgInt64 (DG_TREE_IMAGE_ALIGNMENT - 1);
+	}
+
+	dgUnsigned32 m_magic;
+	dgInt32 m_version;
+	dgInt32 m_headerSize;
+	dgInt32 m_vertexSize;
+	dgInt32 m_nodeSize;
+	dgInt32 m_wideNodeSize;
+	dgInt32 m_vertexCount;
+	dgInt32 m_indexCount;
+	dgInt32 m_nodesCount;
+	dgInt32 m_wideNodesCount;
+	dgInt32 m_triangleCount;
+	dgInt64 m_vertexOffset;
+	dgInt64 m_indexOffset;
+	dgInt64 m_nodeOffset;
+	dgInt64 m_wideNodeOffset;
+	dgInt64 m_imageSize;
+	dgTriplex m_wideBox[2];
+};
 
 
 dgAABBPolygonSoup::dgAABBPolygonSoup ()
 	:dgPolygonSoupDatabase()
 	,m_nodesCount(0)
 	,m_indexCount(0)
+	,m_wideNodesCount(0)
 	,m_aabb(NULL)
 	,m_indices(NULL)
+	,m_wideNodes(NULL)
+	,m_externalMemory(false)
 {
 }
 
 dgAABBPolygonSoup::~dgAABBPolygonSoup ()
 {
+	if (m_externalMemory) {
+		// the arrays belong to the image, keep the base class from freeing the vertex array
+		m_localVertex = NULL;
+		m_aabb = NULL;
+		m_wideNodes = NULL;
+	}
 	if (m_aabb) {
 		dgFreeStack (m_aabb);
 		dgFreeStack (m_indices);
 	}
+	if (m_wideNodes) {
+		dgFreeStack (m_wideNodes);
+	}
 }
 
 
@@ -441,13 +581,204 @@ void dgAABBPolygonSoup::GetAABB (dgVector& p0, dgVector& p1) const
 	}
 }
 
-void dgAABBPolygonSoup::CalculateAdjacendy ()
+void dgAABBPolygonSoup::GetFaceAABB (dgNode::dgLeafNodePtr leaf, dgVector& p0, dgVector& p1) const
 {
-	dgVector p0;
-	dgVector p1;
-	GetAABB (p0, p1);
-	dgFastAABBInfo box (p0, p1);
-	ForAllSectors (box, dgVector (dgFloat32 (0.0f)), dgFloat32 (1.0f), CalculateAllFaceEdgeNormals, this);
+	const dgTriplex* const vertexArray = (dgTriplex*) m_localVertex;
+	const dgInt32* const indices = &m_indices[leaf.GetIndex()];
+	const dgInt32 count = dgInt32 (leaf.GetCount());
+
+	p0 = dgVector ( dgFloat32 (1.0e15f)); 
+	p1 = dgVector (-dgFloat32 (1.0e15f)); 
+	for (dgInt32 i = 0; i < count; i ++) {
+		const dgTriplex& q = vertexArray[indices[i]];
+		dgVector p (q.m_x, q.m_y, q.m_z, dgFloat32 (0.0f));
+		p0 = p0.GetMin(p); 
+		p1 = p1.GetMax(p); 
+	}
+	// same padding as the face boxes of the binary tree
+	p0 = (p0 - dgVector (dgFloat32 (1.0e-3f))) & dgVector::m_triplexMask;
+	p1 = (p1 + dgVector (dgFloat32 (1.0e-3f))) & dgVector::m_triplexMask;
+}
+
+void dgAABBPolygonSoup::BuildWideNodes ()
+{
+	dgAssert (!m_externalMemory);
+	if (m_wideNodes) {
+		dgFreeStack (m_wideNodes);
+		m_wideNodes = NULL;
+		m_wideNodesCount = 0;
+	}
+
+	if (!m_aabb) {
+		return;
+	}
+
+	// every wide node collapses at least one binary node, 
+	// so the binary node count bounds all the arrays
+	dgStack<dgWideNode> wideNodes (m_nodesCount);
+	dgStack<dgInt32> binaryIndex (m_nodesCount);
+	dgStack<dgInt32> wideIndex (m_nodesCount);
+	dgStack<dgVector> boxP0 (m_nodesCount);
+	dgStack<dgVector> boxP1 (m_nodesCount);
+
+	dgVector rootP0;
+	dgVector rootP1;
+	GetNodeAABB (m_aabb, rootP0, rootP1);
+	m_wideBox[0].m_x = rootP0.m_x;
+	m_wideBox[0].m_y = rootP0.m_y;
+	m_wideBox[0].m_z = rootP0.m_z;
+	m_wideBox[1].m_x = rootP1.m_x;
+	m_wideBox[1].m_y = rootP1.m_y;
+	m_wideBox[1].m_z = rootP1.m_z;
+
+	dgInt32 stack = 1;
+	dgInt32 wideCount = 1;
+	binaryIndex[0] = 0;
+	wideIndex[0] = 0;
+	boxP0[0] = rootP0;
+	boxP1[0] = rootP1;
+	while (stack) {
+		stack --;
+		const dgNode* const node = &m_aabb[binaryIndex[stack]];
+		dgWideNode& wideNode = wideNodes[wideIndex[stack]];
+		const dgVector p0 (boxP0[stack]);
+		const dgVector p1 (boxP1[stack]);
+
+		// pull up the grand children of the largest inner children until all four slots are used
+		const dgNode::dgLeafNodePtr* children[4];
+		children[0] = &node->m_left;
+		children[1] = &node->m_right;
+		dgInt32 childCount = 2;
+		while (childCount < 4) {
+			dgInt32 index = -1;
+			dgFloat32 maxArea = dgFloat32 (-1.0f);
+			for (dgInt32 i = 0; i < childCount; i ++) {
+				if (!children[i]->IsLeaf()) {
+					dgVector q0;
+					dgVector q1;
+					GetNodeAABB (children[i]->GetNode(m_aabb), q0, q1);
+					dgVector size (q1 - q0);
+					dgFloat32 area = size.DotProduct(size.ShiftTripleRight()).GetScalar();
+					if (area > maxArea) {
+						index = i;
+						maxArea = area;
+					}
+				}
+			}
+			if (index == -1) {
+				break;
+			}
+			const dgNode* const child = children[index]->GetNode(m_aabb);
+			children[index] = &child->m_left;
+			children[childCount] = &child->m_right;
+			childCount ++;
+		}
+
+		const dgVector scale (dgWideNode::GetScale (p0, p1));
+		for (dgInt32 i = 0; i < 4; i ++) {
+			if ((i >= childCount) || (children[i]->IsLeaf() && !children[i]->GetCount())) {
+				wideNode.m_minX[i] = 0;
+				wideNode.m_minY[i] = 0;
+				wideNode.m_minZ[i] = 0;
+				wideNode.m_maxX[i] = 0;
+				wideNode.m_maxY[i] = 0;
+				wideNode.m_maxZ[i] = 0;
+				wideNode.m_child[i] = dgNode::dgLeafNodePtr (dgUnsigned32 (0));
+				continue;
+			}
+
+			dgVector q0;
+			dgVector q1;
+			if (children[i]->IsLeaf()) {
+				GetFaceAABB (*children[i], q0, q1);
+			} else {
+				GetNodeAABB (children[i]->GetNode(m_aabb), q0, q1);
+			}
+
+			// round outward, so that the decoded box always contains the child
+			dgInt32 quantized[2][3];
+			for (dgInt32 j = 0; j < 3; j ++) {
+				dgInt32 lo = 0;
+				dgInt32 hi = dgInt32 (DG_WIDE_NODE_QUANTIZATION);
+				if (scale[j] > dgFloat32 (0.0f)) {
+					lo = dgClamp (dgInt32 (dgFloor ((q0[j] - p0[j]) / scale[j])), 0, hi);
+					hi = dgClamp (dgInt32 (dgCeil ((q1[j] - p0[j]) / scale[j])), 0, hi);
+					while ((lo > 0) && ((p0[j] + scale[j] * dgFloat32 (lo)) > q0[j])) {
+						lo --;
+					}
+					while ((hi < dgInt32 (DG_WIDE_NODE_QUANTIZATION)) && ((p0[j] + scale[j] * dgFloat32 (hi)) < q1[j])) {
+						hi ++;
+					}
+				}
+				quantized[0][j] = lo;
+				quantized[1][j] = hi;
+			}
+			wideNode.m_minX[i] = dgUnsigned16 (quantized[0][0]);
+			wideNode.m_minY[i] = dgUnsigned16 (quantized[0][1]);
+			wideNode.m_minZ[i] = dgUnsigned16 (quantized[0][2]);
+			wideNode.m_maxX[i] = dgUnsigned16 (quantized[1][0]);
+			wideNode.m_maxY[i] = dgUnsigned16 (quantized[1][1]);
+			wideNode.m_maxZ[i] = dgUnsigned16 (quantized[1][2]);
+
+			if (children[i]->IsLeaf()) {
+				wideNode.m_child[i] = *children[i];
+			} else {
+				// children are quantized against the decoded box, exactly as the traversal sees it
+				dgAssert (stack < m_nodesCount);
+				dgAssert (wideCount < m_nodesCount);
+				dgVector q0Decoded (dgFloat32 (0.0f));
+				dgVector q1Decoded (dgFloat32 (0.0f));
+				for (dgInt32 j = 0; j < 3; j ++) {
+					q0Decoded[j] = dgFloat32 (quantized[0][j]);
+					q1Decoded[j] = dgFloat32 (quantized[1][j]);
+				}
+				binaryIndex[stack] = dgInt32 (children[i]->GetNode(m_aabb) - m_aabb);
+				wideIndex[stack] = wideCount;
+				boxP0[stack] = p0 + scale * q0Decoded;
+				boxP1[stack] = p0 + scale * q1Decoded;
+				wideNode.m_child[i] = dgNode::dgLeafNodePtr (dgUnsigned32 (wideCount));
+				wideCount ++;
+				stack ++;
+			}
+		}
+	}
+
+	m_wideNodesCount = wideCount;
+	m_wideNodes = (dgWideNode*) dgMallocStack (sizeof (dgWideNode) * m_wideNodesCount);
+	memcpy (m_wideNodes, &wideNodes[0], sizeof (dgWideNode) * m_wideNodesCount);
+}
+
+void dgAABBPolygonSoup::CalculateAdjacendy (dgThreadHive* const threadPool)
+{
+	// each face only writes its own edge normals, so faces can be processed in any order and by any thread
+	dgInt32 faceCount = 0;
+	dgStack<dgNode::dgLeafNodePtr> faceArray (m_nodesCount * 2);
+	for (dgInt32 i = 0; i < m_nodesCount; i ++) {
+		const dgNode* const node = &m_aabb[i];
+		if (node->m_left.IsLeaf() && node->m_left.GetCount()) {
+			faceArray[faceCount] = node->m_left;
+			faceCount ++;
+		}
+		if (node->m_right.IsLeaf() && node->m_right.GetCount()) {
+			faceArray[faceCount] = node->m_right;
+			faceCount ++;
+		}
+	}
+
+	dgAdjacencyDescriptor descriptor;
+	descriptor.m_me = this;
+	descriptor.m_faces = &faceArray[0];
+	descriptor.m_faceCount = faceCount;
+	descriptor.m_atomicCounter = 0;
+	if (threadPool) {
+		const dgInt32 threadCount = threadPool->GetThreadCount();
+		for (dgInt32 i = 0; i < threadCount; i ++) {
+			threadPool->QueueJob (CalculateAdjacendyKernel, &descriptor, NULL, "dgAABBPolygonSoup::CalculateAdjacendy");
+		}
+		threadPool->SynchronizationBarrier();
+	} else {
+		CalculateAdjacendyKernel (&descriptor, NULL, 0);
+	}
 
 	dgStack<dgTriplex> pool ((m_indexCount / 2) - 1);
 	const dgTriplex* const vertexArray = (dgTriplex*)GetLocalVertexPool();
@@ -523,7 +854,7 @@ void dgAABBPolygonSoup::CalculateAdjacendy ()
 
 	if (normalCount) {
 		dgStack<dgInt32> indexArray (normalCount);
-		dgInt32 newNormalCount = dgVertexListToIndexList (&pool[0].m_x, sizeof (dgTriplex), sizeof (dgTriplex), 0, normalCount, &indexArray[0], dgFloat32 (1.0e-6f));
+		dgInt32 newNormalCount = dgVertexListToIndexListHash (&pool[0].m_x, sizeof (dgTriplex), sizeof (dgTriplex), 0, normalCount, &indexArray[0], dgFloat32 (1.0e-6f), threadPool);
 
 		dgInt32 oldCount = GetVertexCount();
 		dgTriplex* const vertexArray1 = (dgTriplex*) dgMallocStack (sizeof (dgTriplex) * (oldCount + newNormalCount));
@@ -574,6 +905,19 @@ void dgAABBPolygonSoup::CalculateAdjacendy ()
 	}
 }
 
+void dgAABBPolygonSoup::CalculateAdjacendyKernel (void* const context, void* const worldContext, dgInt32 threadID)
+{
+	dgAdjacencyDescriptor* const descriptor = (dgAdjacencyDescriptor*) context;
+	const dgAABBPolygonSoup* const me = descriptor->m_me;
+	const dgFloat32* const vertexArray = me->GetLocalVertexPool();
+	const dgInt32 strideInBytes = me->GetStrideInBytes();
+	const dgInt32 faceCount = descriptor->m_faceCount;
+	for (dgInt32 i = dgAtomicExchangeAndAdd(&descriptor->m_atomicCounter, 1); i < faceCount; i = dgAtomicExchangeAndAdd(&descriptor->m_atomicCounter, 1)) {
+		const dgNode::dgLeafNodePtr& face = descriptor->m_faces[i];
+		CalculateAllFaceEdgeNormals ((void*)me, vertexArray, strideInBytes, &me->m_indices[face.GetIndex()], dgInt32 (face.GetCount()), dgFloat32 (0.0f));
+	}
+}
+
 dgIntersectStatus dgAABBPolygonSoup::CalculateAllFaceEdgeNormals (void* const context, const dgFloat32* const polygon, dgInt32 strideInBytes, const dgInt32* const indexArray, dgInt32 indexCount, dgFloat32 hitDistance)
 {
 	dgInt32 stride = dgInt32 (strideInBytes / sizeof (dgFloat32));
@@ -714,31 +1058,180 @@ dgIntersectStatus dgAABBPolygonSoup::CalculateDisjointedFaceEdgeNormals (void* c
 
 
 
-dgAABBPolygonSoup::dgNodeBuilder* dgAABBPolygonSoup::BuildTopDown (dgNodeBuilder* const leafArray, dgInt32 firstBox, dgInt32 lastBox, dgNodeBuilder** const allocator) const
+dgAABBPolygonSoup::dgNodeBuilder* dgAABBPolygonSoup::BuildTopDown (dgNodeBuilder* const leafArray, dgInt32 firstBox, dgInt32 lastBox, dgNodeBuilder* const nodePool, dgThreadHive* const threadPool) const
 {
 	dgAssert (firstBox >= 0);
-	dgAssert (lastBox >= 0);
+	dgAssert (lastBox >= firstBox);
+
+	// the node splitting a range goes to the pool slot of the last box of its left side,
+	// so the tree comes out the same regardless of the order the ranges are built.
+	const dgInt32 threadCount = threadPool ? threadPool->GetThreadCount() : 1;
+	const dgInt32 maxSubtrees = threadCount > 1 ? 4 * (lastBox - firstBox + 1) / DG_PARALLEL_SUBTREE_SIZE + 2 : 1;
+	dgStack<dgSubtreeJob> subtrees (maxSubtrees);
+	dgStack<dgSpliteInfo> chunkInfo (threadCount);
+	dgInt32 subtreeCount = 0;
+
+	dgTopDownDescriptor descriptor;
+	descriptor.m_me = this;
+	descriptor.m_leafArray = leafArray;
+	descriptor.m_nodePool = nodePool;
+	descriptor.m_chunkInfo = &chunkInfo[0];
+
+	dgNodeBuilder* root = NULL;
+	dgInt32 stack = 1;
+	dgSubtreeJob pool[64];
+	pool[0].m_parent = NULL;
+	pool[0].m_firstBox = firstBox;
+	pool[0].m_lastBox = lastBox;
+	pool[0].m_isLeft = 0;
+	while (stack) {
+		stack --;
+		const dgSubtreeJob entry (pool[stack]);
+		const dgInt32 boxCount = entry.m_lastBox - entry.m_firstBox + 1;
+
+		dgNodeBuilder* node = NULL;
+		if (boxCount == 1) {
+			node = &leafArray[entry.m_firstBox];
+		} else if ((threadCount > 1) && entry.m_parent && (boxCount <= DG_PARALLEL_SUBTREE_SIZE)) {
+			dgAssert (subtreeCount < maxSubtrees);
+			subtrees[subtreeCount] = entry;
+			subtreeCount ++;
+			continue;
+		} else {
+			dgSpliteInfo info;
+			dgNodeBuilder* const boxArray = &leafArray[entry.m_firstBox];
+			if ((threadCount > 1) && (boxCount > DG_PARALLEL_SUBTREE_SIZE)) {
+				descriptor.m_firstBox = entry.m_firstBox;
+				descriptor.m_boxCount = boxCount;
+				descriptor.m_jobCount = threadCount;
+				descriptor.m_bounds = &info;
+
+				descriptor.m_atomicCounter = 0;
+				for (dgInt32 i = 0; i < threadCount; i ++) {
+					threadPool->QueueJob (CalculateBoundsKernel, &descriptor, NULL, "dgAABBPolygonSoup::CalculateBounds");
+				}
+				threadPool->SynchronizationBarrier();
+				for (dgInt32 i = 0; i < threadCount; i ++) {
+					info.MergeBounds (chunkInfo[i]);
+				}
+				info.SetBinScale();
 
-	if (lastBox == firstBox) {
-		return &leafArray[firstBox];
-	} else {
-		dgSpliteInfo info (&leafArray[firstBox], lastBox - firstBox + 1);
+				descriptor.m_atomicCounter = 0;
+				for (dgInt32 i = 0; i < threadCount; i ++) {
+					threadPool->QueueJob (CalculateBinsKernel, &descriptor, NULL, "dgAABBPolygonSoup::CalculateBins");
+				}
+				threadPool->SynchronizationBarrier();
+				for (dgInt32 i = 0; i < threadCount; i ++) {
+					info.MergeBins (chunkInfo[i]);
+				}
+			} else {
+				info.AddBounds (boxArray, boxCount);
+				info.SetBinScale();
+				info.AddBins (boxArray, boxCount, info);
+			}
 
-		dgNodeBuilder* const parent = new (*allocator) dgNodeBuilder (info.m_p0, info.m_p1);
-		*allocator = *allocator + 1;
+			const dgInt32 leftCount = info.Partition (boxArray, boxCount);
+			node = new (&nodePool[entry.m_firstBox + leftCount - 1]) dgNodeBuilder (info.m_p0, info.m_p1);
+
+			dgSubtreeJob left;
+			left.m_parent = node;
+			left.m_firstBox = entry.m_firstBox;
+			left.m_lastBox = entry.m_firstBox + leftCount - 1;
+			left.m_isLeft = 1;
+
+			dgSubtreeJob right;
+			right.m_parent = node;
+			right.m_firstBox = entry.m_firstBox + leftCount;
+			right.m_lastBox = entry.m_lastBox;
+			right.m_isLeft = 0;
+
+			// the smaller side goes on top, that keeps the stack depth logarithmic
+			dgAssert ((stack + 2) <= dgInt32 (sizeof (pool) / sizeof (pool[0])));
+			if (leftCount > (boxCount - leftCount)) {
+				pool[stack] = left;
+				pool[stack + 1] = right;
+			} else {
+				pool[stack] = right;
+				pool[stack + 1] = left;
+			}
+			stack += 2;
+		}
 
-		dgAssert (parent);
-		parent->m_right = BuildTopDown (leafArray, firstBox + info.m_axis, lastBox, allocator);
-		parent->m_right->m_parent = parent;
+		if (entry.m_parent) {
+			node->m_parent = entry.m_parent;
+			if (entry.m_isLeft) {
+				entry.m_parent->m_left = node;
+			} else {
+				entry.m_parent->m_right = node;
+			}
+		} else {
+			root = node;
+		}
+	}
 
-		parent->m_left = BuildTopDown (leafArray, firstBox, firstBox + info.m_axis - 1, allocator);
-		parent->m_left->m_parent = parent;
-		return parent;
+	if (subtreeCount) {
+		descriptor.m_subtrees = &subtrees[0];
+		descriptor.m_jobCount = subtreeCount;
+		descriptor.m_atomicCounter = 0;
+		for (dgInt32 i = 0; i < threadCount; i ++) {
+			threadPool->QueueJob (BuildSubtreeKernel, &descriptor, NULL, "dgAABBPolygonSoup::BuildSubtree");
+		}
+		threadPool->SynchronizationBarrier();
+	}
+
+	dgAssert (root);
+	return root;
+}
+
+void dgAABBPolygonSoup::CalculateBoundsKernel (void* const context, void* const worldContext, dgInt32 threadID)
+{
+	dgTopDownDescriptor* const descriptor = (dgTopDownDescriptor*) context;
+	const dgInt32 jobCount = descriptor->m_jobCount;
+	const dgInt32 boxCount = descriptor->m_boxCount;
+	const dgNodeBuilder* const boxArray = &descriptor->m_leafArray[descriptor->m_firstBox];
+	for (dgInt32 i = dgAtomicExchangeAndAdd(&descriptor->m_atomicCounter, 1); i < jobCount; i = dgAtomicExchangeAndAdd(&descriptor->m_atomicCounter, 1)) {
+		const dgInt32 start = dgInt32 (dgInt64 (boxCount) * i / jobCount);
+		const dgInt32 end = dgInt32 (dgInt64 (boxCount) * (i + 1) / jobCount);
+		dgSpliteInfo& info = descriptor->m_chunkInfo[i];
+		info = dgSpliteInfo();
+		info.AddBounds (&boxArray[start], end - start);
 	}
 }
 
-void dgAABBPolygonSoup::Create (const dgPolygonSoupDatabaseBuilder& builder, bool optimizedBuild)
+void dgAABBPolygonSoup::CalculateBinsKernel (void* const context, void* const worldContext, dgInt32 threadID)
 {
+	dgTopDownDescriptor* const descriptor = (dgTopDownDescriptor*) context;
+	const dgInt32 jobCount = descriptor->m_jobCount;
+	const dgInt32 boxCount = descriptor->m_boxCount;
+	const dgNodeBuilder* const boxArray = &descriptor->m_leafArray[descriptor->m_firstBox];
+	for (dgInt32 i = dgAtomicExchangeAndAdd(&descriptor->m_atomicCounter, 1); i < jobCount; i = dgAtomicExchangeAndAdd(&descriptor->m_atomicCounter, 1)) {
+		const dgInt32 start = dgInt32 (dgInt64 (boxCount) * i / jobCount);
+		const dgInt32 end = dgInt32 (dgInt64 (boxCount) * (i + 1) / jobCount);
+		dgSpliteInfo& info = descriptor->m_chunkInfo[i];
+		info = dgSpliteInfo();
+		info.AddBins (&boxArray[start], end - start, *descriptor->m_bounds);
+	}
+}
+
+void dgAABBPolygonSoup::BuildSubtreeKernel (void* const context, void* const worldContext, dgInt32 threadID)
+{
+	dgTopDownDescriptor* const descriptor = (dgTopDownDescriptor*) context;
+	const dgInt32 jobCount = descriptor->m_jobCount;
+	for (dgInt32 i = dgAtomicExchangeAndAdd(&descriptor->m_atomicCounter, 1); i < jobCount; i = dgAtomicExchangeAndAdd(&descriptor->m_atomicCounter, 1)) {
+		const dgSubtreeJob& job = descriptor->m_subtrees[i];
+		dgNodeBuilder* const node = descriptor->m_me->BuildTopDown (descriptor->m_leafArray, job.m_firstBox, job.m_lastBox, descriptor->m_nodePool, NULL);
+		node->m_parent = job.m_parent;
+		if (job.m_isLeft) {
+			job.m_parent->m_left = node;
+		} else {
+			job.m_parent->m_right = node;
+		}
+	}
+}
+
+void dgAABBPolygonSoup::Create (const dgPolygonSoupDatabaseBuilder& builder, bool optimizedBuild, dgThreadHive* const threadPool)
+{
+	dgAssert (!m_externalMemory);
 	if (builder.m_faceCount == 0) {
 		return;
 	}
@@ -779,26 +1272,27 @@ void dgAABBPolygonSoup::Create (const dgPolygonSoupDatabaseBuilder& builder, boo
 		polygonIndex += (indexCount + 1);
 	}
 
-	dgNodeBuilder* contructorAllocator = &constructor[allocatorIndex];
-	dgNodeBuilder* root = BuildTopDown (&constructor[0], 0, allocatorIndex - 1, &contructorAllocator);
+	dgNodeBuilder* root = BuildTopDown (&constructor[0], 0, allocatorIndex - 1, &constructor[allocatorIndex], threadPool);
 
 	dgAssert (root);
+	const dgInt32 nodeCount = allocatorIndex * 2 - 1;
+	dgStack<dgNodeBuilder*> nodeArray (nodeCount);
 	if (root->m_left) {
-
 		dgAssert (root->m_right);
-		dgList<dgNodeBuilder*> list (builder.m_allocator);
-		dgList<dgNodeBuilder*> stack (builder.m_allocator);
-		stack.Append(root);
-		while (stack.GetCount()) {
-			dgList<dgNodeBuilder*>::dgListNode* const stackNode = stack.GetLast();
-			dgNodeBuilder* const node = stackNode->GetInfo();
-			stack.Remove(stackNode);
-
+		dgInt32 stack = 1;
+		dgInt32 internalCount = 0;
+		dgStack<dgNodeBuilder*> internalNodes (allocatorIndex);
+		nodeArray[0] = root;
+		while (stack) {
+			stack --;
+			dgNodeBuilder* const node = nodeArray[stack];
 			if (node->m_left) {
 				dgAssert (node->m_right);
-				list.Append(node);
-				stack.Append(node->m_right);
-				stack.Append(node->m_left);
+				internalNodes[internalCount] = node;
+				internalCount ++;
+				nodeArray[stack] = node->m_right;
+				nodeArray[stack + 1] = node->m_left;
+				stack += 2;
 			} 
 		}
 
@@ -806,41 +1300,38 @@ void dgAABBPolygonSoup::Create (const dgPolygonSoupDatabaseBuilder& builder, boo
 		dgFloat64 prevCost = newCost;
 		do {
 			prevCost = newCost;
-			for (dgList<dgNodeBuilder*>::dgListNode* listNode = list.GetFirst(); listNode; listNode = listNode->GetNext()) {
-				dgNodeBuilder* const node = listNode->GetInfo();
-				ImproveNodeFitness (node);
+			for (dgInt32 i = 0; i < internalCount; i ++) {
+				ImproveNodeFitness (internalNodes[i]);
 			}
 
 			newCost = dgFloat32 (0.0f);
-			for (dgList<dgNodeBuilder*>::dgListNode* listNode = list.GetFirst(); listNode; listNode = listNode->GetNext()) {
-				dgNodeBuilder* const node = listNode->GetInfo();
-				newCost += node->m_area;
+			for (dgInt32 i = 0; i < internalCount; i ++) {
+				newCost += internalNodes[i]->m_area;
 			}
 		} while (newCost < (prevCost * dgFloat32 (0.9999f)));
 
-		root = list.GetLast()->GetInfo();
+		root = internalNodes[internalCount - 1];
 		while (root->m_parent) {
 			root = root->m_parent;
 		}
 	}
 
-	dgList<dgNodeBuilder*> list (builder.m_allocator);
-
-	list.Append(root);
+	// breadth first enumeration, nodeArray is used as the queue
+	dgInt32 queueEnd = 1;
 	dgInt32 nodeIndex = 0;
-	while (list.GetCount())  {
-		dgNodeBuilder* const node = list.GetFirst()->GetInfo();
-		list.Remove(list.GetFirst());
-
+	nodeArray[0] = root;
+	for (dgInt32 i = 0; i < queueEnd; i ++) {
+		dgNodeBuilder* const node = nodeArray[i];
 		if (node->m_left) {
 			node->m_enumeration = nodeIndex;
 			nodeIndex ++;
 			dgAssert (node->m_right);
-			list.Append(node->m_left);
-			list.Append(node->m_right);
+			dgAssert ((queueEnd + 2) <= nodeCount);
+			nodeArray[queueEnd] = node->m_left;
+			nodeArray[queueEnd + 1] = node->m_right;
+			queueEnd += 2;
 		}
 	}
-	dgAssert(!list.GetCount());
 
 	dgInt32 aabbBase = builder.m_vertexCount + builder.m_normalCount;
 
@@ -850,12 +1341,9 @@ void dgAABBPolygonSoup::Create (const dgPolygonSoupDatabaseBuilder& builder, boo
 
 	dgInt32 vertexIndex = 0;
 	dgInt32 aabbNodeIndex = 0;
-	list.Append(root);
 	dgInt32 indexMap = 0;
-	while (list.GetCount())  {
-
-		dgNodeBuilder* const node = list.GetFirst()->GetInfo();
-		list.Remove(list.GetFirst());
+	for (dgInt32 i = 0; i < queueEnd; i ++) {
+		dgNodeBuilder* const node = nodeArray[i];
 
 		if (node->m_enumeration >= 0) {
 			dgAssert (node->m_left);
@@ -909,16 +1397,10 @@ void dgAABBPolygonSoup::Create (const dgPolygonSoupDatabaseBuilder& builder, boo
 
 			indexMap += node->m_indexCount * 2 + 3;
 		}
-
-		if (node->m_left) {
-			dgAssert (node->m_right);
-			list.Append(node->m_left);
-			list.Append(node->m_right);
-		}
 	}
 
 	dgStack<dgInt32> indexArray (vertexIndex);
-	dgInt32 aabbPointCount = dgVertexListToIndexList (&aabbPoints[0].m_x, sizeof (dgVector), sizeof (dgTriplex), 0, vertexIndex, &indexArray[0], dgFloat32 (1.0e-6f));
+	dgInt32 aabbPointCount = dgVertexListToIndexListHash (&aabbPoints[0].m_x, sizeof (dgVector), sizeof (dgTriplex), 0, vertexIndex, &indexArray[0], dgFloat32 (1.0e-6f), threadPool);
 
 	m_vertexCount = aabbBase + aabbPointCount;
 	m_localVertex = (dgFloat32*) dgMallocStack (sizeof (dgTriplex) * m_vertexCount);
@@ -957,6 +1439,11 @@ void dgAABBPolygonSoup::Serialize (dgSerialize callback, void* const userData) c
 		callback (userData,  m_indices, dgInt32 (sizeof (dgInt32) * m_indexCount));
 		callback (userData, m_aabb, dgInt32 (sizeof (dgNode) * m_nodesCount));
 	}
+	callback (userData, &m_wideNodesCount, sizeof (dgInt32));
+	if (m_wideNodes) {
+		callback (userData, m_wideBox, sizeof (m_wideBox));
+		callback (userData, m_wideNodes, dgInt32 (sizeof (dgWideNode) * m_wideNodesCount));
+	}
 }
 
 void dgAABBPolygonSoup::Deserialize (dgDeserialize callback, void* const userData, dgInt32 revisionNumber)
@@ -980,8 +1467,233 @@ void dgAABBPolygonSoup::Deserialize (dgDeserialize callback, void* const userDat
 		m_indices = NULL;
 		m_aabb = NULL;
 	}
+
+	m_wideNodesCount = 0;
+	m_wideNodes = NULL;
+	if (revisionNumber >= m_collisionAccelerationRevision) {
+		callback (userData, &m_wideNodesCount, sizeof (dgInt32));
+		if (m_wideNodesCount) {
+			m_wideNodes = (dgWideNode*) dgMallocStack (sizeof (dgWideNode) * m_wideNodesCount);
+			callback (userData, m_wideBox, sizeof (m_wideBox));
+			callback (userData, m_wideNodes, dgInt32 (sizeof (dgWideNode) * m_wideNodesCount));
+		}
+	}
+}
+
+static dgInt64 dgWriteImageSection (dgSerialize callback, void* const userData, dgInt64 offset, dgInt64 sectionOffset, const void* const data, dgInt64 sizeInBytes)
+{
+	static const dgInt8 padding[DG_TREE_IMAGE_ALIGNMENT] = {0};
+	dgAssert (sectionOffset >= offset);
+	dgAssert ((sectionOffset - offset) < DG_TREE_IMAGE_ALIGNMENT);
+	if (sectionOffset > offset) {
+		callback (userData, padding, dgInt32 (sectionOffset - offset));
+	}
+	if (sizeInBytes) {
+		dgAssert (sizeInBytes < 0x7fffffff);
+		callback (userData, data, dgInt32 (sizeInBytes));
+	}
+	return sectionOffset + sizeInBytes;
+}
+
+void dgAABBPolygonSoup::SerializeImage (dgSerialize callback, void* const userData, dgInt32 triangleCount) const
+{
+	dgImageHeader header;
+	memset (&header, 0, sizeof (header));
+	header.m_magic = DG_TREE_IMAGE_MAGIC;
+	header.m_version = DG_TREE_IMAGE_VERSION;
+	header.m_headerSize = sizeof (dgImageHeader);
+	header.m_vertexSize = sizeof (dgTriplex);
+	header.m_nodeSize = sizeof (dgNode);
+	header.m_wideNodeSize = sizeof (dgWideNode);
+	if (m_aabb) {
+		header.m_vertexCount = m_vertexCount;
+		header.m_indexCount = m_indexCount;
+		header.m_nodesCount = m_nodesCount;
+	}
+	header.m_wideNodesCount = m_wideNodesCount;
+	header.m_triangleCount = triangleCount;
+	if (m_wideNodes) {
+		header.m_wideBox[0] = m_wideBox[0];
+		header.m_wideBox[1] = m_wideBox[1];
+	}
+
+	header.m_vertexOffset = dgImageHeader::Align (sizeof (dgImageHeader));
+	header.m_indexOffset = dgImageHeader::Align (header.m_vertexOffset + dgInt64 (sizeof (dgTriplex)) * header.m_vertexCount);
+	header.m_nodeOffset = dgImageHeader::Align (header.m_indexOffset + dgInt64 (sizeof (dgInt32)) * header.m_indexCount);
+	header.m_wideNodeOffset = dgImageHeader::Align (header.m_nodeOffset + dgInt64 (sizeof (dgNode)) * header.m_nodesCount);
+	header.m_imageSize = dgImageHeader::Align (header.m_wideNodeOffset + dgInt64 (sizeof (dgWideNode)) * header.m_wideNodesCount);
+
+	callback (userData, &header, sizeof (dgImageHeader));
+	dgInt64 offset = sizeof (dgImageHeader);
+	offset = dgWriteImageSection (callback, userData, offset, header.m_vertexOffset, m_localVertex, dgInt64 (sizeof (dgTriplex)) * header.m_vertexCount);
+	offset = dgWriteImageSection (callback, userData, offset, header.m_indexOffset, m_indices, dgInt64 (sizeof (dgInt32)) * header.m_indexCount);
+	offset = dgWriteImageSection (callback, userData, offset, header.m_nodeOffset, m_aabb, dgInt64 (sizeof (dgNode)) * header.m_nodesCount);
+	offset = dgWriteImageSection (callback, userData, offset, header.m_wideNodeOffset, m_wideNodes, dgInt64 (sizeof (dgWideNode)) * header.m_wideNodesCount);
+	dgWriteImageSection (callback, userData, offset, header.m_imageSize, NULL, 0);
+}
+
+bool dgAABBPolygonSoup::AttachImage (const void* const image, dgInt64 imageSizeInBytes, dgInt32& triangleCount)
+{
+	dgAssert (!m_aabb && !m_wideNodes && !m_localVertex);
+	if (!image || (imageSizeInBytes < dgInt64 (sizeof (dgImageHeader))) || (size_t (image) & 15)) {
+		return false;
+	}
+
+	// reject images from other versions, or written by a build with a different memory layout or byte order 
+	const dgImageHeader& header = *((const dgImageHeader*) image);
+	if ((header.m_magic != DG_TREE_IMAGE_MAGIC) || (header.m_version != DG_TREE_IMAGE_VERSION) || (header.m_headerSize != sizeof (dgImageHeader))) {
+		return false;
+	}
+	if ((header.m_vertexSize != sizeof (dgTriplex)) || (header.m_nodeSize != sizeof (dgNode)) || (header.m_wideNodeSize != sizeof (dgWideNode))) {
+		return false;
+	}
+	if ((header.m_imageSize > imageSizeInBytes) || (header.m_imageSize < dgInt64 (sizeof (dgImageHeader)))) {
+		return false;
+	}
+	if ((header.m_vertexCount < 0) || (header.m_indexCount < 0) || (header.m_nodesCount < 0) || (header.m_wideNodesCount < 0) || (header.m_triangleCount < 0)) {
+		return false;
+	}
+	// every section must start past the header and inside the image, this also keeps the size tests below from overflowing
+	const dgInt64 sectionOffsets[] = {header.m_vertexOffset, header.m_indexOffset, header.m_nodeOffset, header.m_wideNodeOffset};
+	for (dgInt32 i = 0; i < dgInt32 (sizeof (sectionOffsets) / sizeof (sectionOffsets[0])); i ++) {
+		if ((sectionOffsets[i] < dgInt64 (sizeof (dgImageHeader))) || (sectionOffsets[i] > header.m_imageSize)) {
+			return false;
+		}
+	}
+	if ((header.m_vertexOffset + dgInt64 (sizeof (dgTriplex)) * header.m_vertexCount > header.m_indexOffset) ||
+		(header.m_indexOffset + dgInt64 (sizeof (dgInt32)) * header.m_indexCount > header.m_nodeOffset) ||
+		(header.m_nodeOffset + dgInt64 (sizeof (dgNode)) * header.m_nodesCount > header.m_wideNodeOffset) ||
+		(header.m_wideNodeOffset + dgInt64 (sizeof (dgWideNode)) * header.m_wideNodesCount > header.m_imageSize)) {
+		return false;
+	}
+
+	const dgInt8* const base = (const dgInt8*) image;
+	m_strideInBytes = sizeof (dgTriplex);
+	m_vertexCount = header.m_vertexCount;
+	m_indexCount = header.m_indexCount;
+	m_nodesCount = header.m_nodesCount;
+	m_wideNodesCount = header.m_wideNodesCount;
+	triangleCount = header.m_triangleCount;
+	if (m_nodesCount) {
+		m_localVertex = (dgFloat32*) &base[header.m_vertexOffset];
+		m_indices = (dgInt32*) &base[header.m_indexOffset];
+		m_aabb = (dgNode*) &base[header.m_nodeOffset];
+	}
+	if (m_wideNodesCount) {
+		m_wideNodes = (dgWideNode*) &base[header.m_wideNodeOffset];
+		m_wideBox[0] = header.m_wideBox[0];
+		m_wideBox[1] = header.m_wideBox[1];
+	}
+	m_externalMemory = true;
+
+	if (!ValidateImage()) {
+		m_vertexCount = 0;
+		m_indexCount = 0;
+		m_nodesCount = 0;
+		m_wideNodesCount = 0;
+		m_localVertex = NULL;
+		m_indices = NULL;
+		m_aabb = NULL;
+		m_wideNodes = NULL;
+		m_externalMemory = false;
+		return false;
+	}
+	return true;
 }
 
+// a face is its vertex indices, the attribute, the normal index, one edge normal index per edge and the face size
+bool dgAABBPolygonSoup::ValidateImageFace (dgNode::dgLeafNodePtr leaf) const
+{
+	const dgInt32 vCount = dgInt32 (leaf.GetCount());
+	if (!vCount) {
+		return true;
+	}
+	const dgInt64 index = leaf.GetIndex();
+	if ((vCount < 3) || ((index + vCount * 2 + 3) > m_indexCount)) {
+		return false;
+	}
+	const dgInt32* const face = &m_indices[index];
+	for (dgInt32 i = 0; i < vCount * 2 + 2; i ++) {
+		if ((i != vCount) && ((face[i] < 0) || (face[i] >= m_vertexCount))) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// walk both hierarchies once the same way the queries do, every index read from the image must land inside 
+// its section, every node must be reached once and the stacks of the queries must not overflow
+bool dgAABBPolygonSoup::ValidateImage () const
+{
+	dgInt32 stackPool[DG_STACK_DEPTH];
+	dgInt32 depthPool[DG_STACK_DEPTH];
+
+	if (m_nodesCount) {
+		dgInt32 stack = 1;
+		dgInt32 visited = 0;
+		stackPool[0] = 0;
+		depthPool[0] = 0;
+		while (stack) {
+			stack --;
+			const dgNode& node = m_aabb[stackPool[stack]];
+			const dgInt32 depth = depthPool[stack];
+			visited ++;
+			if ((visited > m_nodesCount) || (depth >= (DG_STACK_DEPTH - 2))) {
+				return false;
+			}
+			if ((node.m_indexBox0 < 0) || (node.m_indexBox0 >= m_vertexCount) || (node.m_indexBox1 < 0) || (node.m_indexBox1 >= m_vertexCount)) {
+				return false;
+			}
+			const dgNode::dgLeafNodePtr children[] = {node.m_left, node.m_right};
+			for (dgInt32 i = 0; i < 2; i ++) {
+				if (children[i].IsLeaf()) {
+					if (!ValidateImageFace (children[i])) {
+						return false;
+					}
+				} else {
+					if (children[i].m_node >= dgUnsigned32 (m_nodesCount)) {
+						return false;
+					}
+					stackPool[stack] = dgInt32 (children[i].m_node);
+					depthPool[stack] = depth + 1;
+					stack ++;
+				}
+			}
+		}
+	}
+
+	if (m_wideNodesCount) {
+		dgInt32 stack = 1;
+		dgInt32 visited = 0;
+		stackPool[0] = 0;
+		depthPool[0] = 0;
+		while (stack) {
+			stack --;
+			const dgWideNode& node = m_wideNodes[stackPool[stack]];
+			const dgInt32 depth = depthPool[stack];
+			visited ++;
+			if ((visited > m_wideNodesCount) || ((depth * 3 + 4) >= DG_STACK_DEPTH)) {
+				return false;
+			}
+			for (dgInt32 i = 0; i < 4; i ++) {
+				const dgNode::dgLeafNodePtr& child = node.m_child[i];
+				if (child.IsLeaf()) {
+					if (!ValidateImageFace (child)) {
+						return false;
+					}
+				} else if (child.m_node) {
+					if (child.m_node >= dgUnsigned32 (m_wideNodesCount)) {
+						return false;
+					}
+					stackPool[stack] = dgInt32 (child.m_node);
+					depthPool[stack] = depth + 1;
+					stack ++;
+				}
+			}
+		}
+	}
+	return true;
+}
 
 dgVector dgAABBPolygonSoup::ForAllSectorsSupportVectex (const dgVector& dir) const
 {
@@ -1115,6 +1827,11 @@ dgVector dgAABBPolygonSoup::ForAllSectorsSupportVectex (const dgVector& dir) con
 
 void dgAABBPolygonSoup::ForAllSectorsRayHit (const dgFastRayTest& raySrc, dgFloat32 maxParam, dgRayIntersectCallback callback, void* const context) const
 {
+	if (m_wideNodes) {
+		WideForAllSectorsRayHit (raySrc, maxParam, callback, context);
+		return;
+	}
+
 	const dgNode *stackPool[DG_STACK_DEPTH];
 	dgFloat32 distance[DG_STACK_DEPTH];
 	dgFastRayTest ray (raySrc);
@@ -1204,7 +1921,9 @@ void dgAABBPolygonSoup::ForAllSectors (const dgFastAABBInfo& obbAabbInfo, const
 	dgAssert (dgAbs(dgAbs(obbAabbInfo[0][2]) - obbAabbInfo.m_absDir[2][0]) < dgFloat32 (1.0e-4f));
 	dgAssert (dgAbs(dgAbs(obbAabbInfo[1][2]) - obbAabbInfo.m_absDir[2][1]) < dgFloat32 (1.0e-4f));
 
-	if (m_aabb) {
+	if (m_wideNodes) {
+		WideForAllSectors (obbAabbInfo, boxDistanceTravel, callback, context);
+	} else if (m_aabb) {
 		dgFloat32 distance[DG_STACK_DEPTH];
 		const dgNode* stackPool[DG_STACK_DEPTH];
 
@@ -1387,4 +2106,221 @@ void dgAABBPolygonSoup::ForAllSectors (const dgFastAABBInfo& obbAabbInfo, const
 	}
 }
 
+void dgAABBPolygonSoup::WideForAllSectorsRayHit (const dgFastRayTest& raySrc, dgFloat32 maxParam, dgRayIntersectCallback callback, void* const context) const
+{
+	dgVector boxP0[DG_STACK_DEPTH];
+	dgVector boxScale[DG_STACK_DEPTH];
+	dgFloat32 distance[DG_STACK_DEPTH];
+	const dgWideNode* stackPool[DG_STACK_DEPTH];
+	dgFastRayTest ray (raySrc);
+
+	const dgTriplex* const vertexArray = (dgTriplex*) m_localVertex;
+	const dgVector p0 (m_wideBox[0].m_x, m_wideBox[0].m_y, m_wideBox[0].m_z, dgFloat32 (0.0f));
+	const dgVector p1 (m_wideBox[1].m_x, m_wideBox[1].m_y, m_wideBox[1].m_z, dgFloat32 (0.0f));
+
+	dgInt32 stack = 1;
+	stackPool[0] = m_wideNodes;
+	boxP0[0] = p0;
+	boxScale[0] = dgWideNode::GetScale (p0, p1);
+	distance[0] = ray.BoxIntersect(p0, p1);
+	while (stack) {
+		stack --;
+		if (distance[stack] > maxParam) {
+			break;
+		}
 
+		dgVector box[6];
+		const dgWideNode* const me = stackPool[stack];
+		me->GetChildBoxes (boxP0[stack], boxScale[stack], box);
+		const dgVector dist (dgWideNode::RayDistance (ray, box, me->GetValidMask()));
+		for (dgInt32 i = 0; i < 4; i ++) {
+			const dgFloat32 dist1 = dist[i];
+			if (dist1 < maxParam) {
+				const dgNode::dgLeafNodePtr& child = me->m_child[i];
+				if (child.IsLeaf()) {
+					dgInt32 index = dgInt32 (child.GetIndex());
+					dgInt32 vCount = dgInt32 (child.GetCount());
+					dgFloat32 param = callback(context, &vertexArray[0].m_x, sizeof (dgTriplex), &m_indices[index], vCount);
+					dgAssert (param >= dgFloat32 (0.0f));
+					if (param < maxParam) {
+						maxParam = param;
+						if (maxParam == dgFloat32 (0.0f)) {
+							return;
+						}
+					}
+				} else {
+					dgVector q0;
+					dgVector q1;
+					dgWideNode::GetChildBox (box, i, q0, q1);
+					dgInt32 j = stack;
+					for ( ; j && (dist1 > distance[j - 1]); j --) {
+						stackPool[j] = stackPool[j - 1];
+						distance[j] = distance[j - 1];
+						boxP0[j] = boxP0[j - 1];
+						boxScale[j] = boxScale[j - 1];
+					}
+					dgAssert (stack < DG_STACK_DEPTH);
+					stackPool[j] = &m_wideNodes[child.m_node];
+					distance[j] = dist1;
+					boxP0[j] = q0;
+					boxScale[j] = dgWideNode::GetScale (q0, q1);
+					stack++;
+				}
+			}
+		}
+	}
+}
+
+void dgAABBPolygonSoup::WideForAllSectors (const dgFastAABBInfo& obbAabbInfo, const dgVector& boxDistanceTravel, dgAABBIntersectCallback callback, void* const context) const
+{
+	dgVector boxP0[DG_STACK_DEPTH];
+	dgVector boxScale[DG_STACK_DEPTH];
+	dgFloat32 distance[DG_STACK_DEPTH];
+	const dgWideNode* stackPool[DG_STACK_DEPTH];
+
+	const dgInt32 stride = sizeof (dgTriplex) / sizeof (dgFloat32);
+	const dgTriplex* const vertexArray = (dgTriplex*) m_localVertex;
+	const dgVector p0 (m_wideBox[0].m_x, m_wideBox[0].m_y, m_wideBox[0].m_z, dgFloat32 (0.0f));
+	const dgVector p1 (m_wideBox[1].m_x, m_wideBox[1].m_y, m_wideBox[1].m_z, dgFloat32 (0.0f));
+
+	dgInt32 stack = 1;
+	stackPool[0] = m_wideNodes;
+	boxP0[0] = p0;
+	boxScale[0] = dgWideNode::GetScale (p0, p1);
+
+	dgAssert (boxDistanceTravel.m_w == dgFloat32 (0.0f));
+	if (boxDistanceTravel.DotProduct(boxDistanceTravel).GetScalar() < dgFloat32 (1.0e-8f)) {
+		distance[0] = dgNode::BoxPenetration(obbAabbInfo, p0, p1);
+		if (distance[0] <= dgFloat32(0.0f)) {
+			obbAabbInfo.m_separationDistance = dgMin(obbAabbInfo.m_separationDistance[0], -distance[0]);
+		}
+		while (stack) {
+			stack --;
+			if (distance[stack] > dgFloat32 (0.0f)) {
+				dgVector box[6];
+				dgVector separation2;
+				const dgWideNode* const me = stackPool[stack];
+				me->GetChildBoxes (boxP0[stack], boxScale[stack], box);
+				const dgVector validMask (me->GetValidMask());
+				const dgVector overlap (dgWideNode::AabbOverlap (obbAabbInfo, box, validMask, separation2));
+
+				const dgInt32 separatedMask = validMask.AndNot(overlap).GetSignMask();
+				if (separatedMask) {
+					const dgVector separation (separation2.Sqrt());
+					for (dgInt32 i = 0; i < 4; i ++) {
+						if (separatedMask & (1 << i)) {
+							obbAabbInfo.m_separationDistance = dgMin(obbAabbInfo.m_separationDistance[0], separation[i]);
+						}
+					}
+				}
+
+				const dgInt32 overlapMask = overlap.GetSignMask();
+				for (dgInt32 i = 0; i < 4; i ++) {
+					if (overlapMask & (1 << i)) {
+						const dgNode::dgLeafNodePtr& child = me->m_child[i];
+						if (child.IsLeaf()) {
+							dgInt32 index = dgInt32 (child.GetIndex());
+							dgInt32 vCount = dgInt32 (child.GetCount());
+							const dgInt32* const indices = &m_indices[index];
+							dgInt32 normalIndex = indices[vCount + 1];
+							dgVector faceNormal (&vertexArray[normalIndex].m_x);
+							faceNormal = faceNormal & dgVector::m_triplexMask;
+							dgFloat32 dist1 = obbAabbInfo.PolygonBoxDistance (faceNormal, vCount, indices, stride, &vertexArray[0].m_x);
+							if (dist1 > dgFloat32 (0.0f)) {
+								obbAabbInfo.m_separationDistance = dgFloat32(0.0f);
+								dgAssert (vCount >= 3);
+								if (callback(context, &vertexArray[0].m_x, sizeof (dgTriplex), indices, vCount, dist1) == t_StopSearh) {
+									return;
+								}
+							} else {
+								obbAabbInfo.m_separationDistance = dgMin(obbAabbInfo.m_separationDistance[0], -dist1);
+							}
+						} else {
+							dgVector q0;
+							dgVector q1;
+							dgWideNode::GetChildBox (box, i, q0, q1);
+							dgFloat32 dist1 = dgNode::BoxPenetration(obbAabbInfo, q0, q1);
+							if (dist1 > dgFloat32 (0.0f)) {
+								dgInt32 j = stack;
+								for ( ; j && (dist1 > distance[j - 1]); j --) {
+									stackPool[j] = stackPool[j - 1];
+									distance[j] = distance[j - 1];
+									boxP0[j] = boxP0[j - 1];
+									boxScale[j] = boxScale[j - 1];
+								}
+								dgAssert (stack < DG_STACK_DEPTH);
+								stackPool[j] = &m_wideNodes[child.m_node];
+								distance[j] = dist1;
+								boxP0[j] = q0;
+								boxScale[j] = dgWideNode::GetScale (q0, q1);
+								stack++;
+							} else {
+								obbAabbInfo.m_separationDistance = dgMin(obbAabbInfo.m_separationDistance[0], -dist1);
+							}
+						}
+					}
+				}
+			}
+		}
+
+	} else {
+		dgFastRayTest ray (dgVector (dgFloat32 (0.0f)), boxDistanceTravel);
+		dgFastRayTest obbRay (dgVector (dgFloat32 (0.0f)), obbAabbInfo.UnrotateVector(boxDistanceTravel));
+		distance[0] = dgNode::BoxIntersect (ray, obbRay, obbAabbInfo, p0, p1);
+		while (stack) {
+			stack --;
+			if (distance[stack] < dgFloat32 (1.0f)) {
+				dgVector box[6];
+				dgVector minkowskiBox[6];
+				const dgWideNode* const me = stackPool[stack];
+				me->GetChildBoxes (boxP0[stack], boxScale[stack], box);
+				for (dgInt32 i = 0; i < 3; i ++) {
+					minkowskiBox[i] = box[i] - dgVector (obbAabbInfo.m_p1[i]);
+					minkowskiBox[i + 3] = box[i + 3] - dgVector (obbAabbInfo.m_p0[i]);
+				}
+				const dgVector dist (dgWideNode::RayDistance (ray, minkowskiBox, me->GetValidMask()));
+
+				for (dgInt32 i = 0; i < 4; i ++) {
+					if (dist[i] < dgFloat32 (1.0f)) {
+						const dgNode::dgLeafNodePtr& child = me->m_child[i];
+						if (child.IsLeaf()) {
+							dgInt32 index = dgInt32 (child.GetIndex());
+							dgInt32 vCount = dgInt32 (child.GetCount());
+							const dgInt32* const indices = &m_indices[index];
+							dgInt32 normalIndex = indices[vCount + 1];
+							dgVector faceNormal (&vertexArray[normalIndex].m_x);
+							faceNormal = faceNormal & dgVector::m_triplexMask;
+							dgFloat32 hitDistance = obbAabbInfo.PolygonBoxRayDistance (faceNormal, vCount, indices, stride, &vertexArray[0].m_x, ray);
+							if (hitDistance < dgFloat32 (1.0f)) {
+								dgAssert (vCount >= 3);
+								if (callback(context, &vertexArray[0].m_x, sizeof (dgTriplex), indices, vCount, hitDistance) == t_StopSearh) {
+									return;
+								}
+							}
+						} else {
+							dgVector q0;
+							dgVector q1;
+							dgWideNode::GetChildBox (box, i, q0, q1);
+							dgFloat32 dist1 = dgNode::BoxIntersect (ray, obbRay, obbAabbInfo, q0, q1);
+							if (dist1 < dgFloat32 (1.0f)) {
+								dgInt32 j = stack;
+								for ( ; j && (dist1 > distance[j - 1]); j --) {
+									stackPool[j] = stackPool[j - 1];
+									distance[j] = distance[j - 1];
+									boxP0[j] = boxP0[j - 1];
+									boxScale[j] = boxScale[j - 1];
+								}
+								dgAssert (stack < DG_STACK_DEPTH);
+								stackPool[j] = &m_wideNodes[child.m_node];
+								distance[j] = dist1;
+								boxP0[j] = q0;
+								boxScale[j] = dgWideNode::GetScale (q0, q1);
+								stack++;
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+}
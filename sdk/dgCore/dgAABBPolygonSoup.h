@@ -28,6 +28,7 @@
 
 
 class dgPolygonSoupDatabaseBuilder;
+class dgThreadHive;
 
 
 class dgAABBPolygonSoup: public dgPolygonSoupDatabase
@@ -116,6 +117,11 @@ class dgAABBPolygonSoup: public dgPolygonSoupDatabase
 			dgVector p1 (&vertexArray[m_indexBox1].m_x);
 			p0 = p0 & dgVector::m_triplexMask;
 			p1 = p1 & dgVector::m_triplexMask;
+			return BoxPenetration (obb, p0, p1);
+		}
+
+		DG_INLINE static dgFloat32 BoxPenetration (const dgFastAABBInfo& obb, const dgVector& p0, const dgVector& p1)
+		{
 			dgVector minBox (p0 - obb.m_p1);
 			dgVector maxBox (p1 - obb.m_p0);
 			dgAssert(maxBox.m_x >= minBox.m_x);
@@ -159,7 +165,11 @@ class dgAABBPolygonSoup: public dgPolygonSoupDatabase
 			dgVector p1 (&vertexArray[m_indexBox1].m_x);
 			p0 = p0 & dgVector::m_triplexMask;
 			p1 = p1 & dgVector::m_triplexMask;
+			return BoxIntersect (ray, obbRay, obb, p0, p1);
+		}
 
+		DG_INLINE static dgFloat32 BoxIntersect (const dgFastRayTest& ray, const dgFastRayTest& obbRay, const dgFastAABBInfo& obb, const dgVector& p0, const dgVector& p1)
+		{
 			dgVector minBox (p0 - obb.m_p1);
 			dgVector maxBox (p1 - obb.m_p0);
 			dgFloat32 dist = ray.BoxIntersect(minBox, maxBox);
@@ -186,19 +196,142 @@ class dgAABBPolygonSoup: public dgPolygonSoupDatabase
 		dgLeafNodePtr m_right;
 	};
 
+	// four children per node, with the child boxes stored inline and quantized 
+	// to 16 bits relative to the box of the node, one cache line per node
+	class dgWideNode
+	{
+		public:
+		#define DG_WIDE_NODE_QUANTIZATION	dgFloat32 (65535.0f)
+
+		DG_INLINE static dgVector GetScale (const dgVector& p0, const dgVector& p1)
+		{
+			return ((p1 - p0) * dgVector (dgFloat32 (1.0f) / DG_WIDE_NODE_QUANTIZATION)) & dgVector::m_triplexMask;
+		}
+
+		DG_INLINE dgVector GetValidMask () const
+		{
+			return dgVector (m_child[0].m_node ? -1 : 0, m_child[1].m_node ? -1 : 0, m_child[2].m_node ? -1 : 0, m_child[3].m_node ? -1 : 0);
+		}
+
+		DG_INLINE void GetChildBoxes (const dgVector& origin, const dgVector& scale, dgVector* const box) const
+		{
+			const dgVector x0 (origin.BroadcastX());
+			const dgVector y0 (origin.BroadcastY());
+			const dgVector z0 (origin.BroadcastZ());
+			const dgVector sx (scale.BroadcastX());
+			const dgVector sy (scale.BroadcastY());
+			const dgVector sz (scale.BroadcastZ());
+#if defined (DG_SCALAR_VECTOR_CLASS) || defined (_NEWTON_USE_DOUBLE)
+			// in double precision dgVector is a dgBigVector and can not be built from four packed floats
+			box[0] = x0 + sx * dgVector (dgFloat32 (m_minX[0]), dgFloat32 (m_minX[1]), dgFloat32 (m_minX[2]), dgFloat32 (m_minX[3]));
+			box[1] = y0 + sy * dgVector (dgFloat32 (m_minY[0]), dgFloat32 (m_minY[1]), dgFloat32 (m_minY[2]), dgFloat32 (m_minY[3]));
+			box[2] = z0 + sz * dgVector (dgFloat32 (m_minZ[0]), dgFloat32 (m_minZ[1]), dgFloat32 (m_minZ[2]), dgFloat32 (m_minZ[3]));
+			box[3] = x0 + sx * dgVector (dgFloat32 (m_maxX[0]), dgFloat32 (m_maxX[1]), dgFloat32 (m_maxX[2]), dgFloat32 (m_maxX[3]));
+			box[4] = y0 + sy * dgVector (dgFloat32 (m_maxY[0]), dgFloat32 (m_maxY[1]), dgFloat32 (m_maxY[2]), dgFloat32 (m_maxY[3]));
+			box[5] = z0 + sz * dgVector (dgFloat32 (m_maxZ[0]), dgFloat32 (m_maxZ[1]), dgFloat32 (m_maxZ[2]), dgFloat32 (m_maxZ[3]));
+#else
+			// widen the six rows of four 16 bit values to floats, three loads of eight values
+			const __m128i zero (_mm_setzero_si128());
+			const __m128i minXY (_mm_loadu_si128 ((__m128i*) &m_minX[0]));
+			const __m128i minZmaxX (_mm_loadu_si128 ((__m128i*) &m_minZ[0]));
+			const __m128i maxYZ (_mm_loadu_si128 ((__m128i*) &m_maxY[0]));
+			box[0] = x0 + sx * dgVector (_mm_cvtepi32_ps (_mm_unpacklo_epi16 (minXY, zero)));
+			box[1] = y0 + sy * dgVector (_mm_cvtepi32_ps (_mm_unpackhi_epi16 (minXY, zero)));
+			box[2] = z0 + sz * dgVector (_mm_cvtepi32_ps (_mm_unpacklo_epi16 (minZmaxX, zero)));
+			box[3] = x0 + sx * dgVector (_mm_cvtepi32_ps (_mm_unpackhi_epi16 (minZmaxX, zero)));
+			box[4] = y0 + sy * dgVector (_mm_cvtepi32_ps (_mm_unpacklo_epi16 (maxYZ, zero)));
+			box[5] = z0 + sz * dgVector (_mm_cvtepi32_ps (_mm_unpackhi_epi16 (maxYZ, zero)));
+#endif
+		}
+
+		DG_INLINE static void GetChildBox (const dgVector* const box, dgInt32 index, dgVector& p0, dgVector& p1)
+		{
+			p0 = dgVector (box[0][index], box[1][index], box[2][index], dgFloat32 (0.0f));
+			p1 = dgVector (box[3][index], box[4][index], box[5][index], dgFloat32 (0.0f));
+		}
+
+		// same as dgFastRayTest::BoxIntersect for four boxes at once
+		DG_INLINE static dgVector RayDistance (const dgFastRayTest& ray, const dgVector* const box, const dgVector& validMask)
+		{
+			dgVector t0 (ray.m_minT);
+			dgVector t1 (ray.m_maxT);
+			dgVector outside (validMask ^ dgVector::m_negOne);
+			for (dgInt32 i = 0; i < 3; i ++) {
+				const dgVector p (ray.m_p0[i]);
+				const dgVector dpInv (ray.m_dpInv[i]);
+				const dgVector& minBox = box[i];
+				const dgVector& maxBox = box[i + 3];
+				if (ray.m_isParallel[i] != dgFloat32 (0.0f)) {
+					outside = outside | (p <= minBox) | (p >= maxBox);
+				}
+				dgVector tt0 (dpInv * (minBox - p));
+				dgVector tt1 (dpInv * (maxBox - p));
+				t0 = t0.GetMax(tt0.GetMin(tt1));
+				t1 = t1.GetMin(tt0.GetMax(tt1));
+			}
+			dgVector mask ((t0 < t1).AndNot(outside));
+			return dgVector (dgFloat32 (1.2f)).Select(t0, mask);
+		}
+
+		// returns the lanes whose box overlaps the obb aabb, and the square 
+		// of the separation distance for the lanes that do not
+		DG_INLINE static dgVector AabbOverlap (const dgFastAABBInfo& obb, const dgVector* const box, const dgVector& validMask, dgVector& separation2)
+		{
+			dgVector overlap (validMask);
+			separation2 = dgVector::m_zero;
+			for (dgInt32 i = 0; i < 3; i ++) {
+				dgVector minBox (box[i] - dgVector (obb.m_p1[i]));
+				dgVector maxBox (box[i + 3] - dgVector (obb.m_p0[i]));
+				dgVector axisOverlap ((minBox * maxBox) < dgVector::m_zero);
+				dgVector gap ((minBox.Abs()).GetMin(maxBox.Abs()).AndNot(axisOverlap));
+				overlap = overlap & axisOverlap;
+				separation2 += gap * gap;
+			}
+			return overlap;
+		}
+
+		dgUnsigned16 m_minX[4];
+		dgUnsigned16 m_minY[4];
+		dgUnsigned16 m_minZ[4];
+		dgUnsigned16 m_maxX[4];
+		dgUnsigned16 m_maxY[4];
+		dgUnsigned16 m_maxZ[4];
+		// same encoding as the binary node children, inner children index the wide node array 
+		// and a zero is an empty slot
+		dgNode::dgLeafNodePtr m_child[4];
+	};
+
+	enum dgNodeLayout
+	{
+		m_binaryNodes = 0,
+		m_wideQuantizedNodes,
+	};
+
 	class dgSpliteInfo;
 	class dgNodeBuilder;
+	class dgSubtreeJob;
+	class dgTopDownDescriptor;
+	class dgAdjacencyDescriptor;
+	class dgImageHeader;
 
 	virtual void GetAABB (dgVector& p0, dgVector& p1) const;
 	virtual void Serialize (dgSerialize callback, void* const userData) const;
 	virtual void Deserialize (dgDeserialize callback, void* const userData, dgInt32 revisionNumber);
 
+	// the image is a flat copy of the tree arrays that can be used in place, e.g. from a memory mapped file.
+	// attached arrays are not owned by the tree, the image must outlive it.
+	void SerializeImage (dgSerialize callback, void* const userData, dgInt32 triangleCount) const;
+	bool AttachImage (const void* const image, dgInt64 imageSizeInBytes, dgInt32& triangleCount);
+	bool IsImageAttached () const {return m_externalMemory;}
+	dgNodeLayout GetNodeLayout () const {return m_wideNodes ? m_wideQuantizedNodes : m_binaryNodes;}
+
 	protected:
 	dgAABBPolygonSoup ();
 	virtual ~dgAABBPolygonSoup ();
 
-	void Create (const dgPolygonSoupDatabaseBuilder& builder, bool optimizedBuild);
-	void CalculateAdjacendy ();
+	void Create (const dgPolygonSoupDatabaseBuilder& builder, bool optimizedBuild, dgThreadHive* const threadPool = NULL);
+	void CalculateAdjacendy (dgThreadHive* const threadPool = NULL);
+	void BuildWideNodes ();
 	virtual void ForAllSectorsRayHit (const dgFastRayTest& ray, dgFloat32 maxT, dgRayIntersectCallback callback, void* const context) const;
 	virtual void ForAllSectors (const dgFastAABBInfo& obbAabb, const dgVector& boxDistanceTravel, dgFloat32 m_maxT, dgAABBIntersectCallback callback, void* const context) const;
 	
@@ -232,17 +365,30 @@ class dgAABBPolygonSoup: public dgPolygonSoupDatabase
 	virtual dgVector ForAllSectorsSupportVectex (const dgVector& dir) const;
 
 	private:
-	dgNodeBuilder* BuildTopDown (dgNodeBuilder* const leafArray, dgInt32 firstBox, dgInt32 lastBox, dgNodeBuilder** const allocator) const;
+	dgNodeBuilder* BuildTopDown (dgNodeBuilder* const leafArray, dgInt32 firstBox, dgInt32 lastBox, dgNodeBuilder* const nodePool, dgThreadHive* const threadPool) const;
+	static void CalculateBoundsKernel (void* const context, void* const worldContext, dgInt32 threadID);
+	static void CalculateBinsKernel (void* const context, void* const worldContext, dgInt32 threadID);
+	static void BuildSubtreeKernel (void* const context, void* const worldContext, dgInt32 threadID);
+	static void CalculateAdjacendyKernel (void* const context, void* const worldContext, dgInt32 threadID);
 	dgFloat32 CalculateFaceMaxSize (const dgVector* const vertex, dgInt32 indexCount, const dgInt32* const indexArray) const;
 //	static dgIntersectStatus CalculateManifoldFaceEdgeNormals (void* const context, const dgFloat32* const polygon, dgInt32 strideInBytes, const dgInt32* const indexArray, dgInt32 indexCount);
 	static dgIntersectStatus CalculateDisjointedFaceEdgeNormals (void* const context, const dgFloat32* const polygon, dgInt32 strideInBytes, const dgInt32* const indexArray, dgInt32 indexCount, dgFloat32 hitDistance);
 	static dgIntersectStatus CalculateAllFaceEdgeNormals (void* const context, const dgFloat32* const polygon, dgInt32 strideInBytes, const dgInt32* const indexArray, dgInt32 indexCount, dgFloat32 hitDistance);
 	void ImproveNodeFitness (dgNodeBuilder* const node) const;
+	void GetFaceAABB (dgNode::dgLeafNodePtr leaf, dgVector& p0, dgVector& p1) const;
+	void WideForAllSectorsRayHit (const dgFastRayTest& ray, dgFloat32 maxT, dgRayIntersectCallback callback, void* const context) const;
+	void WideForAllSectors (const dgFastAABBInfo& obbAabb, const dgVector& boxDistanceTravel, dgAABBIntersectCallback callback, void* const context) const;
+	bool ValidateImageFace (dgNode::dgLeafNodePtr leaf) const;
+	bool ValidateImage () const;
 
 	dgInt32 m_nodesCount;
 	dgInt32 m_indexCount;
+	dgInt32 m_wideNodesCount;
 	dgNode* m_aabb;
 	dgInt32* m_indices;
+	dgWideNode* m_wideNodes;
+	dgTriplex m_wideBox[2];
+	bool m_externalMemory;
 };
 
 
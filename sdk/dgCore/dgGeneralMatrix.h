@@ -316,6 +316,93 @@ bool dgCholeskyFactorization(dgInt32 size, dgInt32 stride, T* const psdMatrix)
 	return state;
 }
 
+DG_INLINE dgFloat32 dgCholeskyDotProduct(dgInt32 size, const dgFloat32* const rowA, const dgFloat32* const rowB)
+{
+	dgInt32 k = 0;
+	dgVector acc(dgVector::m_zero);
+	for (; k <= (size - 4); k += 4) {
+		acc = acc.MulAdd(dgVector(&rowA[k]), dgVector(&rowB[k]));
+	}
+	dgFloat32 s = acc.AddHorizontal().GetScalar();
+	for (; k < size; k++) {
+		s += rowA[k] * rowB[k];
+	}
+	return s;
+}
+
+// same row by row factorization as the generic version, but the off diagonal 
+// terms are solved four columns at a time, so that the dot products of the block 
+// share the loads of the row being factorized and run on vector registers.
+template<>
+DG_INLINE bool dgCholeskyFactorization(dgInt32 size, dgInt32 stride, dgFloat32* const psdMatrix)
+{
+	dgFloat32* const invDiagonal = dgAlloca(dgFloat32, size);
+	for (dgInt32 n = 0; n < size; n++) {
+		dgFloat32* const rowN = &psdMatrix[stride * n];
+
+		dgInt32 j = 0;
+		for (; j <= (n - 4); j += 4) {
+			dgFloat32* const row0 = &psdMatrix[stride * j];
+			dgFloat32* const row1 = &row0[stride];
+			dgFloat32* const row2 = &row1[stride];
+			dgFloat32* const row3 = &row2[stride];
+
+			dgInt32 k = 0;
+			dgVector acc0(dgVector::m_zero);
+			dgVector acc1(dgVector::m_zero);
+			dgVector acc2(dgVector::m_zero);
+			dgVector acc3(dgVector::m_zero);
+			for (; k <= (j - 4); k += 4) {
+				const dgVector a(&rowN[k]);
+				acc0 = acc0.MulAdd(a, dgVector(&row0[k]));
+				acc1 = acc1.MulAdd(a, dgVector(&row1[k]));
+				acc2 = acc2.MulAdd(a, dgVector(&row2[k]));
+				acc3 = acc3.MulAdd(a, dgVector(&row3[k]));
+			}
+			dgFloat32 s0 = acc0.AddHorizontal().GetScalar();
+			dgFloat32 s1 = acc1.AddHorizontal().GetScalar();
+			dgFloat32 s2 = acc2.AddHorizontal().GetScalar();
+			dgFloat32 s3 = acc3.AddHorizontal().GetScalar();
+			for (; k < j; k++) {
+				const dgFloat32 a = rowN[k];
+				s0 += a * row0[k];
+				s1 += a * row1[k];
+				s2 += a * row2[k];
+				s3 += a * row3[k];
+			}
+
+			// resolve the triangle inside the block
+			rowN[j + 0] = invDiagonal[j + 0] * (rowN[j + 0] - s0);
+			s1 += rowN[j + 0] * row1[j + 0];
+			rowN[j + 1] = invDiagonal[j + 1] * (rowN[j + 1] - s1);
+			s2 += rowN[j + 0] * row2[j + 0] + rowN[j + 1] * row2[j + 1];
+			rowN[j + 2] = invDiagonal[j + 2] * (rowN[j + 2] - s2);
+			s3 += rowN[j + 0] * row3[j + 0] + rowN[j + 1] * row3[j + 1] + rowN[j + 2] * row3[j + 2];
+			rowN[j + 3] = invDiagonal[j + 3] * (rowN[j + 3] - s3);
+
+			row0[n] = dgFloat32(0.0f);
+			row1[n] = dgFloat32(0.0f);
+			row2[n] = dgFloat32(0.0f);
+			row3[n] = dgFloat32(0.0f);
+		}
+
+		for (; j < n; j++) {
+			dgFloat32* const rowJ = &psdMatrix[stride * j];
+			const dgFloat32 s = dgCholeskyDotProduct(j, rowN, rowJ);
+			rowN[j] = invDiagonal[j] * (rowN[j] - s);
+			rowJ[n] = dgFloat32(0.0f);
+		}
+
+		const dgFloat32 diag = rowN[n] - dgCholeskyDotProduct(n, rowN, rowN);
+		if (diag < dgFloat32(1.0e-6f)) {
+			return false;
+		}
+		rowN[n] = dgFloat32(sqrt(diag));
+		invDiagonal[n] = dgFloat32(1.0f) / rowN[n];
+	}
+	return true;
+}
+
 template<class T>
 bool dgTestPSDmatrix(dgInt32 size, dgInt32 stride, T* const matrix)
 {
@@ -29,6 +29,7 @@
 #include "dgMatrix.h"
 #include "dgMemory.h"
 #include "dgPolyhedra.h"
+#include "dgThreadHive.h"
 #include "dgPolygonSoupBuilder.h"
 
 #define DG_POINTS_RUN (512 * 1024)
@@ -51,6 +52,27 @@ class dgPolygonSoupDatabaseBuilder::dgFaceBucket: public dgList<dgFaceInfo>
 	}
 };
 
+class dgPolygonSoupDatabaseBuilder::dgFacePartition
+{
+	public:
+	dgInt32 m_faceId;
+	dgInt32 m_faceStart;
+	dgInt32 m_faceCount;
+	dgPolygonSoupDatabaseBuilder* m_builder;
+};
+
+class dgPolygonSoupDatabaseBuilder::dgOptimizeDescriptor
+{
+	public:
+	const dgInt32* m_indexArray;
+	const dgBigVector* m_points;
+	const dgFaceInfo* m_faceArray;
+	dgFacePartition* m_partitions;
+	dgMemoryAllocator* m_allocator;
+	dgInt32 m_partitionCount;
+	dgInt32 m_atomicCounter;
+};
+
 class dgPolygonSoupDatabaseBuilder::dgFaceMap: public dgTree<dgFaceBucket, dgInt32>
 {
 	public:
@@ -308,7 +330,7 @@ void dgPolygonSoupDatabaseBuilder::PackArray()
 {
 	dgStack<dgInt32> indexMapPool (m_vertexCount);
 	dgInt32* const indexMap = &indexMapPool[0];
-	m_vertexCount = dgVertexListToIndexList (&m_vertexPoints[0].m_x, sizeof (dgBigVector), 3, m_vertexCount, &indexMap[0], dgFloat32 (1.0e-6f));
+	m_vertexCount = dgVertexListToIndexListHash (&m_vertexPoints[0].m_x, sizeof (dgBigVector), 3, m_vertexCount, &indexMap[0], dgFloat32 (1.0e-6f));
 
 	dgInt32 k = 0;
 	for (dgInt32 i = 0; i < m_faceCount; i ++) {
@@ -325,13 +347,13 @@ void dgPolygonSoupDatabaseBuilder::PackArray()
 	m_run = DG_POINTS_RUN;
 }
 
-void dgPolygonSoupDatabaseBuilder::Finalize()
+void dgPolygonSoupDatabaseBuilder::Finalize(dgThreadHive* const threadPool)
 {
 	if (m_faceCount) {
 		dgStack<dgInt32> indexMapPool (m_indexCount + m_vertexCount);
 
 		dgInt32* const indexMap = &indexMapPool[0];
-		m_vertexCount = dgVertexListToIndexList (&m_vertexPoints[0].m_x, sizeof (dgBigVector), 3, m_vertexCount, &indexMap[0], dgFloat32 (1.0e-4f));
+		m_vertexCount = dgVertexListToIndexListHash (&m_vertexPoints[0].m_x, sizeof (dgBigVector), 3, m_vertexCount, &indexMap[0], dgFloat32 (1.0e-4f), threadPool);
 
 		dgInt32 k = 0;
 		for (dgInt32 i = 0; i < m_faceCount; i ++) {
@@ -493,20 +515,72 @@ void dgPolygonSoupDatabaseBuilder::OptimizeByIndividualFaces()
 }
 
 
-void dgPolygonSoupDatabaseBuilder::End(bool optimize)
+void dgPolygonSoupDatabaseBuilder::End(bool optimize, dgThreadHive* const threadPool, dgReportProgress reportProgress, void* const reportProgressUserData)
 {
 	if (optimize) {
 		dgPolygonSoupDatabaseBuilder copy (*this);
 		dgFaceMap faceMap (m_allocator, copy);
 
-		Begin();
+		dgInt32 faceCount = 0;
+		dgInt32 partitionCount = 0;
+		dgArray<dgFaceInfo> faceArray (m_allocator);
+		dgArray<dgFacePartition> partitions (m_allocator);
 		dgFaceMap::Iterator iter (faceMap);
 		for (iter.Begin(); iter; iter ++) {
 			const dgFaceBucket& bucket = iter.GetNode()->GetInfo();
-			Optimize(iter.GetNode()->GetKey(), bucket, copy);
+			BuildPartitions(iter.GetNode()->GetKey(), bucket, copy, faceArray, faceCount, partitions, partitionCount);
+		}
+
+		Begin();
+		dgVector face[256];
+		dgInt32 faceIndex[256];
+		const dgInt32 threadCount = threadPool ? threadPool->GetThreadCount() : 1;
+		const dgInt32 batchSize = threadCount * 4;
+		for (dgInt32 batchStart = 0; batchStart < partitionCount; batchStart += batchSize) {
+			dgOptimizeDescriptor descriptor;
+			descriptor.m_indexArray = &copy.m_vertexIndex[0];
+			descriptor.m_points = &copy.m_vertexPoints[0];
+			descriptor.m_faceArray = &faceArray[0];
+			descriptor.m_partitions = &partitions[batchStart];
+			descriptor.m_partitionCount = dgMin (batchSize, partitionCount - batchStart);
+			descriptor.m_allocator = m_allocator;
+			descriptor.m_atomicCounter = 0;
+
+			if (threadPool) {
+				for (dgInt32 i = 0; i < threadCount; i ++) {
+					threadPool->QueueJob (OptimizePartitionsKernel, &descriptor, NULL, "dgPolygonSoupDatabaseBuilder::OptimizePartitions");
+				}
+				threadPool->SynchronizationBarrier();
+			} else {
+				OptimizePartitionsKernel (&descriptor, NULL, 0);
+			}
+
+			// merge in partition order, so the result does not depend on the number of threads
+			for (dgInt32 i = 0; i < descriptor.m_partitionCount; i ++) {
+				dgFacePartition& partition = descriptor.m_partitions[i];
+				const dgPolygonSoupDatabaseBuilder& builder = *partition.m_builder;
+
+				dgInt32 faceIndexNumber = 0;
+				for (dgInt32 j = 0; j < builder.m_faceCount; j ++) {
+					dgInt32 indexCount = builder.m_faceVertexCount[j] - 1;
+					for (dgInt32 k = 0; k < indexCount; k ++) {
+						dgInt32 index = builder.m_vertexIndex[faceIndexNumber + k];
+						face[k] = builder.m_vertexPoints[index];
+						faceIndex[k] = k;
+					}
+					AddMesh (&face[0].m_x, indexCount, sizeof (dgVector), 1, &indexCount, faceIndex, &partition.m_faceId, dgGetIdentityMatrix());
+					faceIndexNumber += (indexCount + 1);
+				}
+				delete partition.m_builder;
+				partition.m_builder = NULL;
+			}
+
+			if (reportProgress) {
+				reportProgress (dgFloat32 (batchStart + descriptor.m_partitionCount) / dgFloat32 (partitionCount), reportProgressUserData);
+			}
 		}
 	}
-	Finalize();
+	Finalize(threadPool);
 
 	// build the normal array and adjacency array
 	// calculate all face the normals
@@ -536,179 +610,146 @@ void dgPolygonSoupDatabaseBuilder::End(bool optimize)
 	}
 	// compress normals array
 	m_normalIndex[m_faceCount] = 0;
-	m_normalCount = dgVertexListToIndexList(&m_normalPoints[0].m_x, sizeof (dgBigVector), 3, m_faceCount, &m_normalIndex[0], dgFloat32 (1.0e-6f));
+	m_normalCount = dgVertexListToIndexListHash(&m_normalPoints[0].m_x, sizeof (dgBigVector), 3, m_faceCount, &m_normalIndex[0], dgFloat32 (1.0e-6f), threadPool);
 }
 
-
-void dgPolygonSoupDatabaseBuilder::Optimize(dgInt32 faceId, const dgFaceBucket& faceBucket, const dgPolygonSoupDatabaseBuilder& source)
+void dgPolygonSoupDatabaseBuilder::BuildPartitions(dgInt32 faceId, const dgFaceBucket& faceBucket, const dgPolygonSoupDatabaseBuilder& source, dgArray<dgFaceInfo>& faceArray, dgInt32& faceArrayCount, dgArray<dgFacePartition>& partitions, dgInt32& partitionCount) const
 {
 	#define DG_MESH_PARTITION_SIZE (1024 * 4)
 
 	const dgInt32* const indexArray = &source.m_vertexIndex[0];
 	const dgBigVector* const points = &source.m_vertexPoints[0];
 
-	dgVector face[256];
-	dgInt32 faceIndex[256];
-	if (faceBucket.GetCount() >= DG_MESH_PARTITION_SIZE) {
-		dgStack<dgFaceBucket::dgListNode*> array(faceBucket.GetCount());
-		dgInt32 count = 0;
-		for (dgFaceBucket::dgListNode* node = faceBucket.GetFirst(); node; node = node->GetNext()) {
-			array[count] = node;
-			count ++;
-		}
-
-		dgInt32 stack = 1;
-		dgInt32 segments[32][2];
-			
-		segments[0][0] = 0;
-		segments[0][1] = count;
-	
-		while (stack) {
-			stack --;
-			dgInt32 faceStart = segments[stack][0];
-			dgInt32 faceCount = segments[stack][1];
-
-			if (faceCount <= DG_MESH_PARTITION_SIZE) {
-
-				dgPolygonSoupDatabaseBuilder tmpBuilder (m_allocator);
-				for (dgInt32 i = 0; i < faceCount; i ++) {
-					const dgFaceInfo& faceInfo = array[faceStart + i]->GetInfo();
-
-					dgInt32 count1 = faceInfo.indexCount - 1;
-					dgInt32 start1 = faceInfo.indexStart;
-					dgAssert (faceId == indexArray[start1 + count1]);
-					for (dgInt32 j = 0; j < count1; j ++) {
-						dgInt32 index = indexArray[start1 + j];
-						face[j] = points[index];
-						faceIndex[j] = j;
-					}
-					dgInt32 faceIndexCount = count1;
-					tmpBuilder.AddMesh (&face[0].m_x, count1, sizeof (dgVector), 1, &faceIndexCount, &faceIndex[0], &faceId, dgGetIdentityMatrix()); 
+	const dgInt32 base = faceArrayCount;
+	for (dgFaceBucket::dgListNode* node = faceBucket.GetFirst(); node; node = node->GetNext()) {
+		faceArray[faceArrayCount] = node->GetInfo();
+		faceArrayCount ++;
+	}
+	dgFaceInfo* const array = &faceArray[base];
+
+	dgInt32 stack = 1;
+	dgInt32 segments[32][2];
+
+	segments[0][0] = 0;
+	segments[0][1] = faceArrayCount - base;
+
+	while (stack) {
+		stack --;
+		dgInt32 faceStart = segments[stack][0];
+		dgInt32 faceCount = segments[stack][1];
+
+		if (faceCount <= DG_MESH_PARTITION_SIZE) {
+			dgFacePartition& partition = partitions[partitionCount];
+			partition.m_faceId = faceId;
+			partition.m_faceStart = base + faceStart;
+			partition.m_faceCount = faceCount;
+			partition.m_builder = NULL;
+			partitionCount ++;
+		} else {
+			dgBigVector median (dgFloat32 (0.0f), dgFloat32 (0.0f), dgFloat32 (0.0f), dgFloat32 (0.0f));
+			dgBigVector varian (dgFloat32 (0.0f), dgFloat32 (0.0f), dgFloat32 (0.0f), dgFloat32 (0.0f));
+			for (dgInt32 i = 0; i < faceCount; i ++) {
+				const dgFaceInfo& faceInfo = array[faceStart + i];
+				dgInt32 count1 = faceInfo.indexCount - 1;
+				dgInt32 start1 = faceInfo.indexStart;
+				dgBigVector p0 (dgFloat32 ( 1.0e10f), dgFloat32 ( 1.0e10f), dgFloat32 ( 1.0e10f), dgFloat32 (0.0f));
+				dgBigVector p1 (dgFloat32 (-1.0e10f), dgFloat32 (-1.0e10f), dgFloat32 (-1.0e10f), dgFloat32 (0.0f));
+				for (dgInt32 j = 0; j < count1; j ++) {
+					dgInt32 index = indexArray[start1 + j];
+					const dgBigVector& p = points[index];
+					dgAssert(p.m_w == dgFloat32(0.0f));
+					p0 = p0.GetMin(p);
+					p1 = p1.GetMax(p);
 				}
-				tmpBuilder.FinalizeAndOptimize ();
+				dgBigVector p ((p0 + p1).Scale (0.5f));
+				median += p;
+				varian += p * p;
+			}
 
-				dgInt32 faceIndexNumber = 0;
-				for (dgInt32 i = 0; i < tmpBuilder.m_faceCount; i ++) {
-					dgInt32 indexCount = tmpBuilder.m_faceVertexCount[i] - 1;
-					for (dgInt32 j = 0; j < indexCount; j ++) {
-						dgInt32 index = tmpBuilder.m_vertexIndex[faceIndexNumber + j];
-						face[j] = tmpBuilder.m_vertexPoints[index];
-						faceIndex[j] = j;
-					}
-					dgInt32 faceArray = indexCount;
-					AddMesh (&face[0].m_x, indexCount, sizeof (dgVector), 1, &faceArray, faceIndex, &faceId, dgGetIdentityMatrix());
+			varian = varian.Scale (dgFloat32 (faceCount)) - median * median;
 
-					faceIndexNumber += (indexCount + 1); 
+			dgInt32 axis = 0;
+			dgFloat32 maxVarian = dgFloat32 (-1.0e10f);
+			for (dgInt32 i = 0; i < 3; i ++) {
+				if (varian[i] > maxVarian) {
+					axis = i;
+					maxVarian = dgFloat32 (varian[i]);
 				}
-
-			} else {
-				dgBigVector median (dgFloat32 (0.0f), dgFloat32 (0.0f), dgFloat32 (0.0f), dgFloat32 (0.0f));
-				dgBigVector varian (dgFloat32 (0.0f), dgFloat32 (0.0f), dgFloat32 (0.0f), dgFloat32 (0.0f));
-				for (dgInt32 i = 0; i < faceCount; i ++) {
-					const dgFaceInfo& faceInfo = array[faceStart + i]->GetInfo();
-					dgInt32 count1 = faceInfo.indexCount - 1;
-					dgInt32 start1 = faceInfo.indexStart;
-					dgBigVector p0 (dgFloat32 ( 1.0e10f), dgFloat32 ( 1.0e10f), dgFloat32 ( 1.0e10f), dgFloat32 (0.0f));
-					dgBigVector p1 (dgFloat32 (-1.0e10f), dgFloat32 (-1.0e10f), dgFloat32 (-1.0e10f), dgFloat32 (0.0f));
-					for (dgInt32 j = 0; j < count1; j ++) {
-						dgInt32 index = indexArray[start1 + j];
-						const dgBigVector& p = points[index];
-						dgAssert(p.m_w == dgFloat32(0.0f));
-						p0 = p0.GetMin(p);
-						p1 = p1.GetMax(p);
-					}
-					dgBigVector p ((p0 + p1).Scale (0.5f));
-					median += p;
-					varian += p * p;
-				}
-
-				varian = varian.Scale (dgFloat32 (faceCount)) - median * median;
-
-				dgInt32 axis = 0;
-				dgFloat32 maxVarian = dgFloat32 (-1.0e10f);
-				for (dgInt32 i = 0; i < 3; i ++) {
-					if (varian[i] > maxVarian) {
-						axis = i;
-						maxVarian = dgFloat32 (varian[i]);
+			}
+			dgBigVector center = median.Scale (dgFloat32 (1.0f) / dgFloat32 (faceCount));
+			dgFloat64 axisVal = center[axis];
+
+			dgInt32 leftCount = 0;
+			dgInt32 lastFace = faceCount;
+
+			for (dgInt32 i = 0; i < lastFace; i ++) {
+				dgInt32 side = 0;
+				const dgFaceInfo& faceInfo = array[faceStart + i];
+
+				dgInt32 start1 = faceInfo.indexStart;
+				dgInt32 count1 = faceInfo.indexCount - 1;
+				for (dgInt32 j = 0; j < count1; j ++) {
+					dgInt32 index = indexArray[start1 + j];
+					const dgBigVector& p = points[index];
+					if (p[axis] > axisVal) {
+						side = 1;
+						break;
 					}
 				}
-				dgBigVector center = median.Scale (dgFloat32 (1.0f) / dgFloat32 (faceCount));
-				dgFloat64 axisVal = center[axis];
-
-				dgInt32 leftCount = 0;
-				dgInt32 lastFace = faceCount;
-
-				for (dgInt32 i = 0; i < lastFace; i ++) {
-					dgInt32 side = 0;
-					const dgFaceInfo& faceInfo = array[faceStart + i]->GetInfo();
-
-					dgInt32 start1 = faceInfo.indexStart;
-					dgInt32 count1 = faceInfo.indexCount - 1;
-					for (dgInt32 j = 0; j < count1; j ++) {
-						dgInt32 index = indexArray[start1 + j];
-						const dgBigVector& p = points[index];
-						if (p[axis] > axisVal) {
-							side = 1;
-							break;
-						}
-					}
 
-					if (side) {
-						dgSwap (array[faceStart + i], array[faceStart + lastFace - 1]);
-						lastFace --;
-						i --;
-					} else {
-						leftCount ++;
-					}
+				if (side) {
+					dgSwap (array[faceStart + i], array[faceStart + lastFace - 1]);
+					lastFace --;
+					i --;
+				} else {
+					leftCount ++;
 				}
-				dgAssert (leftCount);
-				dgAssert (leftCount < faceCount);
+			}
+			dgAssert (leftCount);
+			dgAssert (leftCount < faceCount);
 
-				segments[stack][0] = faceStart;
-				segments[stack][1] = leftCount;
-				stack ++;
+			segments[stack][0] = faceStart;
+			segments[stack][1] = leftCount;
+			stack ++;
 
-				segments[stack][0] = faceStart + leftCount;
-				segments[stack][1] = faceCount - leftCount;
-				stack ++;
-			}
+			segments[stack][0] = faceStart + leftCount;
+			segments[stack][1] = faceCount - leftCount;
+			stack ++;
 		}
-	
-	} else {
-		dgPolygonSoupDatabaseBuilder tmpBuilder (m_allocator);
-		for (dgFaceBucket::dgListNode* node = faceBucket.GetFirst(); node; node = node->GetNext()) {
-			const dgFaceInfo& faceInfo = node->GetInfo();
+	}
+}
+
+void dgPolygonSoupDatabaseBuilder::OptimizePartitionsKernel (void* const context, void* const worldContext, dgInt32 threadID)
+{
+	dgOptimizeDescriptor* const descriptor = (dgOptimizeDescriptor*) context;
+	const dgInt32* const indexArray = descriptor->m_indexArray;
+	const dgBigVector* const points = descriptor->m_points;
+	const dgInt32 partitionCount = descriptor->m_partitionCount;
+
+	dgVector face[256];
+	dgInt32 faceIndex[256];
+	for (dgInt32 i = dgAtomicExchangeAndAdd(&descriptor->m_atomicCounter, 1); i < partitionCount; i = dgAtomicExchangeAndAdd(&descriptor->m_atomicCounter, 1)) {
+		dgFacePartition& partition = descriptor->m_partitions[i];
+		dgPolygonSoupDatabaseBuilder* const builder = new (descriptor->m_allocator) dgPolygonSoupDatabaseBuilder (descriptor->m_allocator);
+
+		for (dgInt32 j = 0; j < partition.m_faceCount; j ++) {
+			const dgFaceInfo& faceInfo = descriptor->m_faceArray[partition.m_faceStart + j];
 
 			dgInt32 count = faceInfo.indexCount - 1;
 			dgInt32 start = faceInfo.indexStart;
-			dgAssert (faceId == indexArray[start + count]);
-			for (dgInt32 j = 0; j < count; j ++) {
-				dgInt32 index = indexArray[start + j];
-				face[j] = points[index];
-				faceIndex[j] = j;
+			dgAssert (partition.m_faceId == indexArray[start + count]);
+			for (dgInt32 k = 0; k < count; k ++) {
+				dgInt32 index = indexArray[start + k];
+				face[k] = points[index];
+				faceIndex[k] = k;
 			}
-			dgInt32 faceIndexCount = count;
-			tmpBuilder.AddMesh (&face[0].m_x, count, sizeof (dgVector), 1, &faceIndexCount, &faceIndex[0], &faceId, dgGetIdentityMatrix()); 
-		}
-		tmpBuilder.FinalizeAndOptimize ();
-
-		dgInt32 faceIndexNumber = 0;
-		for (dgInt32 i = 0; i < tmpBuilder.m_faceCount; i ++) {
-			dgInt32 indexCount = tmpBuilder.m_faceVertexCount[i] - 1;
-			for (dgInt32 j = 0; j < indexCount; j ++) {
-				dgInt32 index = tmpBuilder.m_vertexIndex[faceIndexNumber + j];
-				face[j] = tmpBuilder.m_vertexPoints[index];
-				faceIndex[j] = j;
-			}
-			dgInt32 faceArray = indexCount;
-			AddMesh (&face[0].m_x, indexCount, sizeof (dgVector), 1, &faceArray, faceIndex, &faceId, dgGetIdentityMatrix());
-
-			faceIndexNumber += (indexCount + 1); 
+			builder->AddMesh (&face[0].m_x, count, sizeof (dgVector), 1, &count, &faceIndex[0], &partition.m_faceId, dgGetIdentityMatrix());
 		}
+		builder->FinalizeAndOptimize ();
+		partition.m_builder = builder;
 	}
 }
 
-
 dgInt32 dgPolygonSoupDatabaseBuilder::FilterFace (dgInt32 count, dgInt32* const pool)
 {
 	if (count == 3) {
@@ -33,6 +33,7 @@
 #include "dgArray.h"
 #include "dgIntersections.h"
 
+class dgThreadHive;
 
 class AdjacentdFace
 {
@@ -48,6 +49,8 @@ class dgPolygonSoupDatabaseBuilder
 	class dgFaceMap;
 	class dgFaceInfo;
 	class dgFaceBucket;
+	class dgFacePartition;
+	class dgOptimizeDescriptor;
 	class dgPolySoupFilterAllocator;
 	public:
 
@@ -58,16 +61,17 @@ class dgPolygonSoupDatabaseBuilder
 	DG_CLASS_ALLOCATOR(allocator)
 
 	void Begin();
-	void End(bool optimize);
+	void End(bool optimize, dgThreadHive* const threadPool = NULL, dgReportProgress reportProgress = NULL, void* const reportProgressUserData = NULL);
 	void AddMesh (const dgFloat32* const vertex, dgInt32 vertexCount, dgInt32 strideInBytes, dgInt32 faceCount, 
 		          const dgInt32* const faceArray, const dgInt32* const indexArray, const dgInt32* const faceTagsData, const dgMatrix& worldMatrix); 
 
 	void SavePLY(const char* const fileName) const;
 
 	private:
-	void Optimize(dgInt32 faceId, const dgFaceBucket& faceBucket, const dgPolygonSoupDatabaseBuilder& source);
+	void BuildPartitions(dgInt32 faceId, const dgFaceBucket& faceBucket, const dgPolygonSoupDatabaseBuilder& source, dgArray<dgFaceInfo>& faceArray, dgInt32& faceArrayCount, dgArray<dgFacePartition>& partitions, dgInt32& partitionCount) const;
+	static void OptimizePartitionsKernel (void* const context, void* const worldContext, dgInt32 threadID);
 
-	void Finalize();
+	void Finalize(dgThreadHive* const threadPool = NULL);
 	void FinalizeAndOptimize();
 	void OptimizeByIndividualFaces();
 	dgInt32 FilterFace (dgInt32 count, dgInt32* const indexArray);
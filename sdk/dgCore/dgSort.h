@@ -134,7 +134,7 @@ void dgRadixSort(T* const array, T* const tmpArray, dgInt32 elements, dgInt32 ra
 
 			dgInt32 radixShift = (radix + 1) << 3;
 			for (dgInt32 i = 0; i < elements; i++) {
-				dgInt32 key = (getRadixKey(&array[i], context) >> radixShift) & 0xff;
+				dgInt32 key = (getRadixKey(&tmpArray[i], context) >> radixShift) & 0xff;
 				dgInt32 index = scanCount[key];
 				array[index] = tmpArray[i];
 				scanCount[key] = index + 1;
@@ -71,6 +71,11 @@ void dgThread::dgSemaphore::Wait()
 {
 }
 
+bool dgThread::dgSemaphore::TryWait()
+{
+	return true;
+}
+
 dgThread::~dgThread ()
 {
 }
@@ -125,6 +130,17 @@ void dgThread::dgSemaphore::Wait()
 	m_count --;
 }
 
+bool dgThread::dgSemaphore::TryWait()
+{
+	std::unique_lock <std::mutex> lck(m_mutex);
+	dgAssert (m_count >= 0);
+	if (m_count == 0) {
+		return false;
+	}
+	m_count --;
+	return true;
+}
+
 dgThread::~dgThread ()
 {
 }
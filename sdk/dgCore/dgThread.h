@@ -36,6 +36,7 @@ class dgThread
 		dgSemaphore ();
 		~dgSemaphore ();
 		void Wait();
+		bool TryWait();
 		void Release();
 
 		dgInt32 GetCount() const 
@@ -101,6 +101,7 @@ void dgThreadHive::dgWorkerThread::RunNextJobInQueue(dgInt32 threadId)
 
 dgThreadHive::dgThreadHive(dgMemoryAllocator* const allocator)
 	:m_parentThread(NULL)
+	,m_sharedHive(NULL)
 	,m_workerThreads(NULL)
 	,m_allocator(allocator)
 	,m_jobsCount(0)
@@ -119,6 +120,13 @@ void dgThreadHive::SetParentThread (dgThread* const parentThread)
 	m_parentThread = parentThread;
 }
 
+void dgThreadHive::SetSharedHive (dgThreadHive* const hive)
+{
+	// while set, jobs are run by the workers of the shared hive instead of the ones of this hive
+	dgAssert (!hive || (hive != this));
+	m_sharedHive = hive;
+}
+
 void dgThreadHive::DestroyThreads()
 {
 	if (m_workerThreadsCount) {
@@ -150,7 +158,9 @@ void dgThreadHive::SetThreadsCount (dgInt32 threads)
 
 void dgThreadHive::QueueJob (dgWorkerThreadTaskCallback callback, void* const context0, void* const context1, const char* const functionName)
 {
-	if (!m_workerThreadsCount) {
+	if (m_sharedHive) {
+		m_sharedHive->QueueJob(callback, context0, context1, functionName);
+	} else if (!m_workerThreadsCount) {
 		//DG_TRACKTIME(functionName);
 		callback (context0, context1, 0);
 	} else {
@@ -180,7 +190,9 @@ void dgThreadHive::OnEndWorkerThread (dgInt32 threadId)
 
 void dgThreadHive::SynchronizationBarrier ()
 {
-	if (m_workerThreadsCount) {
+	if (m_sharedHive) {
+		m_sharedHive->SynchronizationBarrier();
+	} else if (m_workerThreadsCount) {
 		//DG_TRACKTIME();
 		for (dgInt32 i = 0; i < m_workerThreadsCount; i ++) {
 			m_workerThreads[i].m_workerSemaphore.Release();
@@ -266,6 +278,7 @@ void dgThreadHive::dgWorkerThread::Execute(dgInt32 threadId)
 
 dgThreadHive::dgThreadHive(dgMemoryAllocator* const allocator)
 	:m_parentThread(NULL)
+	,m_sharedHive(NULL)
 	,m_workerThreads(NULL)
 	,m_allocator(allocator)
 	,m_syncLock(0)
@@ -285,6 +298,13 @@ void dgThreadHive::SetParentThread(dgThread* const mastertThread)
 	m_parentThread = mastertThread;
 }
 
+void dgThreadHive::SetSharedHive(dgThreadHive* const hive)
+{
+	// while set, jobs are run by the workers of the shared hive instead of the ones of this hive
+	dgAssert(!hive || (hive != this));
+	m_sharedHive = hive;
+}
+
 void dgThreadHive::OnBeginWorkerThread(dgInt32 threadId)
 {
 }
@@ -295,7 +315,9 @@ void dgThreadHive::OnEndWorkerThread(dgInt32 threadId)
 
 void dgThreadHive::BeginSection()
 {
-	if (m_workerThreadsCount) {
+	if (m_sharedHive) {
+		m_sharedHive->BeginSection();
+	} else if (m_workerThreadsCount) {
 		//DG_TRACKTIME();
 		for (dgInt32 i = 0; i < m_workerThreadsCount; i++) {
 			m_workerThreads[i].m_workerSemaphore.Release();
@@ -306,7 +328,9 @@ void dgThreadHive::BeginSection()
 
 void dgThreadHive::EndSection()
 {
-	if (m_workerThreadsCount) {
+	if (m_sharedHive) {
+		m_sharedHive->EndSection();
+	} else if (m_workerThreadsCount) {
 		//DG_TRACKTIME();
 		for (dgInt32 i = 0; i < m_workerThreadsCount; i++) {
 			dgInterlockedExchange(&m_workerThreads[i].m_concurrentWork, 0);
@@ -317,7 +341,9 @@ void dgThreadHive::EndSection()
 
 void dgThreadHive::QueueJob(dgWorkerThreadTaskCallback callback, void* const context0, void* const context1, const char* const functionName)
 {
-	if (!m_workerThreadsCount) {
+	if (m_sharedHive) {
+		m_sharedHive->QueueJob(callback, context0, context1, functionName);
+	} else if (!m_workerThreadsCount) {
 		//DG_TRACKTIME(functionName);
 		callback(context0, context1, 0);
 	} else {
@@ -358,7 +384,9 @@ void dgThreadHive::SetThreadsCount(dgInt32 threads)
 
 void dgThreadHive::SynchronizationBarrier()
 {
-	if (m_workerThreadsCount) {
+	if (m_sharedHive) {
+		m_sharedHive->SynchronizationBarrier();
+	} else if (m_workerThreadsCount) {
 		//DG_TRACKTIME();
 
 		#ifndef DG_USE_THREAD_EMULATION
@@ -92,6 +92,7 @@ typedef void (*dgWorkerThreadTaskCallback) (void* const context0, void* const co
 		void EndSection() {}
 
 		void SetParentThread (dgThread* const mastertThread);
+		void SetSharedHive (dgThreadHive* const hive);
 
 		void GlobalLock() const;
 		void GlobalUnlock() const;
@@ -110,6 +111,7 @@ typedef void (*dgWorkerThreadTaskCallback) (void* const context0, void* const co
 		void DestroyThreads();
 
 		dgThread* m_parentThread;
+		dgThreadHive* m_sharedHive;
 		dgWorkerThread* m_workerThreads;
 		dgMemoryAllocator* m_allocator;
 		dgInt32 m_jobsCount;
@@ -120,7 +122,7 @@ typedef void (*dgWorkerThreadTaskCallback) (void* const context0, void* const co
 
 	DG_INLINE dgInt32 dgThreadHive::GetThreadCount() const
 	{
-		return m_workerThreadsCount ? m_workerThreadsCount : 1;
+		return m_sharedHive ? m_sharedHive->GetThreadCount() : (m_workerThreadsCount ? m_workerThreadsCount : 1);
 	}
 
 	DG_INLINE dgInt32 dgThreadHive::GetMaxThreadCount() const
@@ -141,14 +143,14 @@ typedef void (*dgWorkerThreadTaskCallback) (void* const context0, void* const co
 
 	DG_INLINE void dgThreadHive::GetIndirectLock (dgInt32* const criticalSectionLock) const
 	{
-		if (m_workerThreadsCount) {	
+		if (m_workerThreadsCount || m_sharedHive) {	
 			dgSpinLock(criticalSectionLock);
 		}
 	}
 
 	DG_INLINE void dgThreadHive::ReleaseIndirectLock (dgInt32* const criticalSectionLock) const
 	{
-		if (m_workerThreadsCount) {	
+		if (m_workerThreadsCount || m_sharedHive) {	
 			dgSpinUnlock(criticalSectionLock);
 		}
 	}
@@ -217,6 +219,7 @@ typedef void (*dgWorkerThreadTaskCallback) (void* const context0, void* const co
 		void EndSection();
 
 		void SetParentThread(dgThread* const mastertThread);
+		void SetSharedHive(dgThreadHive* const hive);
 
 		void GlobalLock() const;
 		void GlobalUnlock() const;
@@ -235,6 +238,7 @@ typedef void (*dgWorkerThreadTaskCallback) (void* const context0, void* const co
 		void DestroyThreads();
 
 		dgThread* m_parentThread;
+		dgThreadHive* m_sharedHive;
 		dgWorkerThread* m_workerThreads;
 		dgMemoryAllocator* m_allocator;
 		dgInt32 m_syncLock;
@@ -247,7 +251,7 @@ typedef void (*dgWorkerThreadTaskCallback) (void* const context0, void* const co
 
 	DG_INLINE dgInt32 dgThreadHive::GetThreadCount() const
 	{
-		return m_workerThreadsCount ? m_workerThreadsCount : 1;
+		return m_sharedHive ? m_sharedHive->GetThreadCount() : (m_workerThreadsCount ? m_workerThreadsCount : 1);
 	}
 
 	DG_INLINE dgInt32 dgThreadHive::GetMaxThreadCount() const
@@ -267,14 +271,14 @@ typedef void (*dgWorkerThreadTaskCallback) (void* const context0, void* const co
 
 	DG_INLINE void dgThreadHive::GetIndirectLock(dgInt32* const criticalSectionLock) const
 	{
-		if (m_workerThreadsCount) {
+		if (m_workerThreadsCount || m_sharedHive) {
 			dgSpinLock(criticalSectionLock);
 		}
 	}
 
 	DG_INLINE void dgThreadHive::ReleaseIndirectLock(dgInt32* const criticalSectionLock) const
 	{
-		if (m_workerThreadsCount) {
+		if (m_workerThreadsCount || m_sharedHive) {
 			dgSpinUnlock(criticalSectionLock);
 		}
 	}
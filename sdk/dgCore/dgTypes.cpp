@@ -25,6 +25,8 @@
 #include "dgVector.h"
 #include "dgMemory.h"
 #include "dgStack.h"
+#include "dgThreadHive.h"
+#include "dgSort.h"
 
 dgUnsigned64 dgGetTimeInMicrosenconds()
 {
@@ -422,6 +424,303 @@ dgInt32 dgVertexListToIndexList (dgFloat32* const vertList, dgInt32 strideInByte
 }
 
 
+#define DG_VERTEX_WELD_BATCH 256
+
+class dgVertexWeldDescriptor
+{
+	public:
+	const dgFloat64* m_vertList;
+	dgInt32* m_cellStart;
+	dgInt32* m_cellEntries;
+	dgInt32* m_bucket;
+	dgInt32* m_firstMatch;
+	dgBigVector m_minP;
+	dgFloat64 m_tol;
+	dgFloat64 m_invCellSize;
+	dgInt32 m_stride;
+	dgInt32 m_compareCount;
+	dgInt32 m_vertexCount;
+	dgInt32 m_tableSize;
+	dgInt32 m_atomicCounter;
+};
+
+static DG_INLINE dgInt32 dgVertexCellHash (dgInt64 x, dgInt64 y, dgInt64 z, dgInt32 mask)
+{
+	dgUnsigned64 key = (dgUnsigned64 (x) * dgUnsigned64 (0x9e3779b97f4a7c15ULL)) ^ (dgUnsigned64 (y) * dgUnsigned64 (0xc2b2ae3d27d4eb4fULL)) ^ (dgUnsigned64 (z) * dgUnsigned64 (0x165667b19e3779f9ULL));
+	return dgInt32 (key >> 32) & mask;
+}
+
+static DG_INLINE bool dgVertexWeldTest (const dgVertexWeldDescriptor& descriptor, dgInt32 i, dgInt32 k)
+{
+	const dgFloat64* const p = &descriptor.m_vertList[i * descriptor.m_stride];
+	const dgFloat64* const q = &descriptor.m_vertList[k * descriptor.m_stride];
+	bool test = true;
+	for (dgInt32 t = 0; test && (t < descriptor.m_compareCount); t ++) {
+		test = fabs (p[t] - q[t]) <= descriptor.m_tol;
+	}
+	return test;
+}
+
+// hash a batch of vertices and count them in the shared bucket histogram
+static void dgVertexWeldHashKernel (void* const context, void* const worldContext, dgInt32 threadID)
+{
+	dgVertexWeldDescriptor* const descriptor = (dgVertexWeldDescriptor*) context;
+	const dgInt32 mask = descriptor->m_tableSize - 1;
+	const dgInt32 stride = descriptor->m_stride;
+	dgInt32* const cellCount = descriptor->m_cellStart;
+	const dgInt32 batchCount = (descriptor->m_vertexCount + DG_VERTEX_WELD_BATCH - 1) / DG_VERTEX_WELD_BATCH;
+	for (dgInt32 batch = dgAtomicExchangeAndAdd(&descriptor->m_atomicCounter, 1); batch < batchCount; batch = dgAtomicExchangeAndAdd(&descriptor->m_atomicCounter, 1)) {
+		const dgInt32 i1 = dgMin ((batch + 1) * DG_VERTEX_WELD_BATCH, descriptor->m_vertexCount);
+		for (dgInt32 i = batch * DG_VERTEX_WELD_BATCH; i < i1; i ++) {
+			const dgFloat64* const p = &descriptor->m_vertList[i * stride];
+			dgInt64 x = dgInt64 (floor ((p[0] - descriptor->m_minP.m_x) * descriptor->m_invCellSize));
+			dgInt64 y = dgInt64 (floor ((p[1] - descriptor->m_minP.m_y) * descriptor->m_invCellSize));
+			dgInt64 z = dgInt64 (floor ((p[2] - descriptor->m_minP.m_z) * descriptor->m_invCellSize));
+			dgInt32 bucket = dgVertexCellHash (x, y, z, mask);
+			descriptor->m_bucket[i] = bucket;
+			dgAtomicExchangeAndAdd(&cellCount[bucket], 1);
+		}
+	}
+}
+
+// the histogram holds the end of each bucket, every vertex takes the slot before it,
+// when all are placed the histogram holds the start of each bucket
+static void dgVertexWeldScatterKernel (void* const context, void* const worldContext, dgInt32 threadID)
+{
+	dgVertexWeldDescriptor* const descriptor = (dgVertexWeldDescriptor*) context;
+	dgInt32* const cellEnd = descriptor->m_cellStart;
+	const dgInt32 batchCount = (descriptor->m_vertexCount + DG_VERTEX_WELD_BATCH - 1) / DG_VERTEX_WELD_BATCH;
+	for (dgInt32 batch = dgAtomicExchangeAndAdd(&descriptor->m_atomicCounter, 1); batch < batchCount; batch = dgAtomicExchangeAndAdd(&descriptor->m_atomicCounter, 1)) {
+		const dgInt32 i0 = batch * DG_VERTEX_WELD_BATCH;
+		for (dgInt32 i = dgMin (i0 + DG_VERTEX_WELD_BATCH, descriptor->m_vertexCount) - 1; i >= i0; i --) {
+			dgInt32 bucket = descriptor->m_bucket[i];
+			descriptor->m_cellEntries[dgAtomicExchangeAndAdd(&cellEnd[bucket], -1) - 1] = i;
+		}
+	}
+}
+
+static dgInt32 dgVertexWeldCompareEntries (const dgInt32* const entryA, const dgInt32* const entryB, void* const context)
+{
+	return (*entryA < *entryB) ? -1 : ((*entryA > *entryB) ? 1 : 0);
+}
+
+// threads fill the buckets in any order, sort the entries of every bucket by vertex index
+// so that the neighbor search sees the same order for any number of threads
+static void dgVertexWeldSortKernel (void* const context, void* const worldContext, dgInt32 threadID)
+{
+	dgVertexWeldDescriptor* const descriptor = (dgVertexWeldDescriptor*) context;
+	const dgInt32* const cellStart = descriptor->m_cellStart;
+	dgInt32* const cellEntries = descriptor->m_cellEntries;
+	const dgInt32 batchCount = (descriptor->m_tableSize + DG_VERTEX_WELD_BATCH - 1) / DG_VERTEX_WELD_BATCH;
+	for (dgInt32 batch = dgAtomicExchangeAndAdd(&descriptor->m_atomicCounter, 1); batch < batchCount; batch = dgAtomicExchangeAndAdd(&descriptor->m_atomicCounter, 1)) {
+		const dgInt32 bucket1 = dgMin ((batch + 1) * DG_VERTEX_WELD_BATCH, descriptor->m_tableSize);
+		for (dgInt32 bucket = batch * DG_VERTEX_WELD_BATCH; bucket < bucket1; bucket ++) {
+			const dgInt32 count = cellStart[bucket + 1] - cellStart[bucket];
+			if (count > 1) {
+				dgSort (&cellEntries[cellStart[bucket]], count, dgVertexWeldCompareEntries);
+			}
+		}
+	}
+}
+
+// for each vertex find the lowest index vertex before it within the tolerance, this is the expensive part of the weld
+static void dgVertexWeldMatchKernel (void* const context, void* const worldContext, dgInt32 threadID)
+{
+	dgVertexWeldDescriptor* const descriptor = (dgVertexWeldDescriptor*) context;
+	const dgInt32 mask = descriptor->m_tableSize - 1;
+	const dgInt32 stride = descriptor->m_stride;
+	const dgInt32* const cellStart = descriptor->m_cellStart;
+	const dgInt32* const cellEntries = descriptor->m_cellEntries;
+	const dgInt32 batchCount = (descriptor->m_vertexCount + DG_VERTEX_WELD_BATCH - 1) / DG_VERTEX_WELD_BATCH;
+	for (dgInt32 batch = dgAtomicExchangeAndAdd(&descriptor->m_atomicCounter, 1); batch < batchCount; batch = dgAtomicExchangeAndAdd(&descriptor->m_atomicCounter, 1)) {
+		const dgInt32 k1 = dgMin ((batch + 1) * DG_VERTEX_WELD_BATCH, descriptor->m_vertexCount);
+		for (dgInt32 k = batch * DG_VERTEX_WELD_BATCH; k < k1; k ++) {
+			const dgFloat64* const q = &descriptor->m_vertList[k * stride];
+			dgInt64 x = dgInt64 (floor ((q[0] - descriptor->m_minP.m_x) * descriptor->m_invCellSize));
+			dgInt64 y = dgInt64 (floor ((q[1] - descriptor->m_minP.m_y) * descriptor->m_invCellSize));
+			dgInt64 z = dgInt64 (floor ((q[2] - descriptor->m_minP.m_z) * descriptor->m_invCellSize));
+			dgInt32 match = k;
+			for (dgInt64 z1 = z - 1; z1 <= z + 1; z1 ++) {
+				for (dgInt64 y1 = y - 1; y1 <= y + 1; y1 ++) {
+					for (dgInt64 x1 = x - 1; x1 <= x + 1; x1 ++) {
+						dgInt32 bucket = dgVertexCellHash (x1, y1, z1, mask);
+						for (dgInt32 j = cellStart[bucket]; (j < cellStart[bucket + 1]) && (cellEntries[j] < match); j ++) {
+							if (dgVertexWeldTest (*descriptor, cellEntries[j], k)) {
+								match = cellEntries[j];
+							}
+						}
+					}
+				}
+			}
+			descriptor->m_firstMatch[k] = match;
+		}
+	}
+}
+
+// same welding rule as dgVertexListToIndexList, but the candidates are found in a hash grid with cells twice the tolerance wide
+// instead of by sweeping along one axis, which goes quadratic when many points share a coordinate plane (grids, terrains).
+// unique vertices are emitted in order of first occurrence.
+// with a thread pool the hashing and the neighbor search run in parallel, the greedy merge is resolved serially
+// in vertex order, so the result is the same for any number of threads.
+dgInt32 dgVertexListToIndexListHash (dgFloat64* const vertList, dgInt32 strideInBytes, dgInt32 compareCount, dgInt32 vertexCount, dgInt32* const indexListOut, dgFloat64 tolerance, dgThreadHive* const threadPool)
+{
+	dgSetPrecisionDouble precision;
+
+	if (strideInBytes < 3 * dgInt32 (sizeof (dgFloat64))) {
+		return 0;
+	}
+	if (compareCount < 3) {
+		return 0;
+	}
+	if (vertexCount <= 0) {
+		return 0;
+	}
+	dgAssert (compareCount <= dgInt32 (strideInBytes / sizeof (dgFloat64)));
+	dgAssert (strideInBytes == dgInt32 (sizeof (dgFloat64) * (strideInBytes / sizeof (dgFloat64))));
+
+	const dgInt32 stride = strideInBytes / dgInt32 (sizeof (dgFloat64));
+
+	dgBigVector minP;
+	dgBigVector maxP;
+	dgGetMinMax (minP, maxP, vertList, vertexCount, strideInBytes);
+
+	dgBigVector del (maxP - minP);
+	dgFloat64 minDist = dgMin (del.m_x, del.m_y, del.m_z);
+	if (minDist < dgFloat64 (1.0e-3f)) {
+		minDist = dgFloat64 (1.0e-3f);
+	}
+
+	dgInt32 tableSize = 16;
+	while (tableSize < vertexCount) {
+		tableSize *= 2;
+	}
+
+	// small lists are not worth waking up the workers
+	const dgInt32 threadCount = (threadPool && (vertexCount > DG_VERTEX_WELD_BATCH * 8)) ? threadPool->GetThreadCount() : 1;
+
+	dgStack<dgInt32> cellStartPool (tableSize + 1);
+	dgStack<dgInt32> cellEntriesPool (vertexCount);
+	dgStack<dgInt32> firstMatchPool (vertexCount);
+	memset (&cellStartPool[0], 0, (tableSize + 1) * sizeof (dgInt32));
+
+	dgVertexWeldDescriptor descriptor;
+	descriptor.m_vertList = vertList;
+	descriptor.m_cellStart = &cellStartPool[0];
+	descriptor.m_cellEntries = &cellEntriesPool[0];
+	descriptor.m_bucket = indexListOut;
+	descriptor.m_firstMatch = &firstMatchPool[0];
+	descriptor.m_minP = minP;
+	descriptor.m_tol = tolerance * minDist + dgFloat64 (1.0e-12f);
+	descriptor.m_invCellSize = dgFloat64 (0.5f) / descriptor.m_tol;
+	descriptor.m_stride = stride;
+	descriptor.m_compareCount = compareCount;
+	descriptor.m_vertexCount = vertexCount;
+	descriptor.m_tableSize = tableSize;
+
+	dgWorkerThreadTaskCallback kernels[] = {dgVertexWeldHashKernel, dgVertexWeldScatterKernel, dgVertexWeldSortKernel, dgVertexWeldMatchKernel};
+	for (dgInt32 pass = 0; pass < dgInt32 (sizeof (kernels) / sizeof (kernels[0])); pass ++) {
+		descriptor.m_atomicCounter = 0;
+		if (threadCount > 1) {
+			for (dgInt32 i = 0; i < threadCount; i ++) {
+				threadPool->QueueJob (kernels[pass], &descriptor, NULL, "dgVertexListToIndexListHash");
+			}
+			threadPool->SynchronizationBarrier();
+		} else {
+			kernels[pass] (&descriptor, NULL, 0);
+		}
+
+		if (pass == 0) {
+			// turn the bucket counts into bucket ends
+			dgInt32* const cellStart = descriptor.m_cellStart;
+			for (dgInt32 i = 1; i < tableSize; i ++) {
+				cellStart[i] += cellStart[i - 1];
+			}
+			cellStart[tableSize] = vertexCount;
+		}
+	}
+
+	// a vertex is welded to the first earlier vertex within the tolerance that was not itself welded,
+	// almost always that is the first match, otherwise search the neighbor cells again
+	const dgInt32 mask = tableSize - 1;
+	const dgInt32* const cellStart = descriptor.m_cellStart;
+	const dgInt32* const cellEntries = descriptor.m_cellEntries;
+	dgInt32* const representative = descriptor.m_firstMatch;
+	dgInt32 count = 0;
+	for (dgInt32 k = 0; k < vertexCount; k ++) {
+		dgInt32 match = representative[k];
+		if ((match != k) && (representative[match] != match)) {
+			const dgFloat64* const q = &vertList[k * stride];
+			dgInt64 x = dgInt64 (floor ((q[0] - minP.m_x) * descriptor.m_invCellSize));
+			dgInt64 y = dgInt64 (floor ((q[1] - minP.m_y) * descriptor.m_invCellSize));
+			dgInt64 z = dgInt64 (floor ((q[2] - minP.m_z) * descriptor.m_invCellSize));
+			match = k;
+			for (dgInt64 z1 = z - 1; z1 <= z + 1; z1 ++) {
+				for (dgInt64 y1 = y - 1; y1 <= y + 1; y1 ++) {
+					for (dgInt64 x1 = x - 1; x1 <= x + 1; x1 ++) {
+						dgInt32 bucket = dgVertexCellHash (x1, y1, z1, mask);
+						for (dgInt32 j = cellStart[bucket]; (j < cellStart[bucket + 1]) && (cellEntries[j] < match); j ++) {
+							const dgInt32 i = cellEntries[j];
+							if ((representative[i] == i) && dgVertexWeldTest (descriptor, i, k)) {
+								match = i;
+							}
+						}
+					}
+				}
+			}
+		}
+		representative[k] = match;
+		if (match == k) {
+			indexListOut[k] = count;
+			count ++;
+		} else {
+			indexListOut[k] = indexListOut[match];
+		}
+	}
+
+	// compact the unique vertices, the destination never passes the source
+	for (dgInt32 k = 0; k < vertexCount; k ++) {
+		if (representative[k] == k) {
+			const dgInt32 index = indexListOut[k];
+			if (index != k) {
+				memcpy (&vertList[index * stride], &vertList[k * stride], stride * sizeof (dgFloat64));
+			}
+		}
+	}
+
+	return count;
+}
+
+dgInt32 dgVertexListToIndexListHash (dgFloat32* const vertList, dgInt32 strideInBytes, dgInt32 floatSizeInBytes, dgInt32 unsignedSizeInBytes, dgInt32 vertexCount, dgInt32* const indexList, dgFloat32 tolerance, dgThreadHive* const threadPool)
+{
+	dgInt32 stride = dgInt32 (strideInBytes / sizeof (dgFloat32));
+
+	dgAssert (!unsignedSizeInBytes);
+	dgStack<dgFloat64> pool(vertexCount * stride);
+
+	dgInt32 floatCount = dgInt32 (floatSizeInBytes / sizeof (dgFloat32));
+
+	dgFloat64* const data = &pool[0];
+	for (dgInt32 i = 0; i < vertexCount; i ++) {
+		dgFloat64* const dst = &data[i * stride];
+		dgFloat32* const src = &vertList[i * stride];
+		for (dgInt32 j = 0; j < stride; j ++) {
+			dst[j] = src[j];
+		}
+	}
+
+	dgInt32 count = dgVertexListToIndexListHash (data, dgInt32 (stride * sizeof (dgFloat64)), floatCount, vertexCount, indexList, dgFloat64 (tolerance), threadPool);
+	for (dgInt32 i = 0; i < count; i ++) {
+		dgFloat64* const src = &data[i * stride];
+		dgFloat32* const dst = &vertList[i * stride];
+		for (dgInt32 j = 0; j < stride; j ++) {
+			dst[j] = dgFloat32 (src[j]);
+		}
+	}
+
+	return count;
+}
+
+
 //#define SERIALIZE_END	'dne '
 #define SERIALIZE_END   0x646e6520
 
@@ -209,6 +209,7 @@
 
 #define DG_VECTOR_SIMD_SIZE		16
 #define DG_VECTOR_AVX2_SIZE		32
+#define DG_VECTOR_AVX512_SIZE	64
 
 #if (defined (_WIN_32_VER) || defined (_WIN_64_VER))
 	#define	DG_GCC_VECTOR_ALIGMENT	
@@ -226,6 +227,14 @@
 	#define	DG_MSC_AVX_ALIGMENT			
 #endif
 
+#if (defined (_WIN_32_VER) || defined (_WIN_64_VER))
+	#define	DG_GCC_AVX512_ALIGMENT	
+	#define	DG_MSC_AVX512_ALIGMENT		__declspec(align(DG_VECTOR_AVX512_SIZE))
+#else
+	#define	DG_GCC_AVX512_ALIGMENT		__attribute__ ((aligned (DG_VECTOR_AVX512_SIZE)))
+	#define	DG_MSC_AVX512_ALIGMENT			
+#endif
+
 
 
 #if ((defined (_WIN_32_VER) || defined (_WIN_64_VER)) && (_MSC_VER  >= 1600))
@@ -283,6 +292,7 @@ class dgTriplex
 #define dgRadToDegree  	dgFloat32 (180.0f / dgPi)
 
 class dgBigVector;
+class dgThreadHive;
 #ifndef _NEWTON_USE_DOUBLE
 class dgVector;
 #endif 
@@ -449,6 +459,8 @@ union dgDoubleInt
 void dgGetMinMax (dgBigVector &Min, dgBigVector &Max, const dgFloat64* const vArray, dgInt32 vCount, dgInt32 strideInBytes);
 dgInt32 dgVertexListToIndexList (dgFloat64* const vertexList, dgInt32 strideInBytes, dgInt32 compareCount,     dgInt32 vertexCount,         dgInt32* const indexListOut, dgFloat64 tolerance = dgEpsilon);
 dgInt32 dgVertexListToIndexList (dgFloat32* const vertexList, dgInt32 strideInBytes, dgInt32 floatSizeInBytes, dgInt32 unsignedSizeInBytes, dgInt32 vertexCount, dgInt32* const indexListOut, dgFloat32 tolerance = dgEpsilon);
+dgInt32 dgVertexListToIndexListHash (dgFloat64* const vertexList, dgInt32 strideInBytes, dgInt32 compareCount, dgInt32 vertexCount, dgInt32* const indexListOut, dgFloat64 tolerance = dgEpsilon, dgThreadHive* const threadPool = NULL);
+dgInt32 dgVertexListToIndexListHash (dgFloat32* const vertexList, dgInt32 strideInBytes, dgInt32 floatSizeInBytes, dgInt32 unsignedSizeInBytes, dgInt32 vertexCount, dgInt32* const indexListOut, dgFloat32 tolerance = dgEpsilon, dgThreadHive* const threadPool = NULL);
 
 #define PointerToInt(x) ((size_t)x)
 #define IntToPointer(x) ((void*)(size_t(x)))
@@ -477,6 +489,8 @@ enum dgSerializeRevisionNumber
 {
 	m_firstRevision = 100,
 	// add new serialization revision number here
+	// height field elevation pyramid and tile header, collision tree wide nodes
+	m_collisionAccelerationRevision = 102,
 	m_currentRevision 
 };
 
@@ -171,6 +171,8 @@ NewtonWorld* NewtonCreate()
   @return Nothing.
 
   This function will destroy the entire Newton world.
+  If other worlds still hold instances of its collision shapes, made with ::NewtonCollisionCreateSharedInstance,
+  the world is kept until the last of them is destroyed.
 
   See also: ::NewtonCreate, ::NewtonDestroyAllBodies
 */
@@ -179,10 +181,7 @@ void NewtonDestroy(const NewtonWorld* const newtonWorld)
 	TRACE_FUNCTION(__FUNCTION__);
 
 	Newton* const world = (Newton *) newtonWorld;
-	dgMemoryAllocator* const allocator = world->dgWorld::GetAllocator();
-
-	delete world;
-	delete allocator;
+	Newton::Destroy (world);
 }
 
 void NewtonSetPostUpdateCallback(const NewtonWorld* const newtonWorld, NewtonPostUpdateCallback callback)
@@ -294,24 +293,268 @@ void NewtonDeserializeScene(const NewtonWorld* const newtonWorld, NewtonOnBodyDe
 }
 
 
+/*!
+  Save the bodies, shapes and joints of the world to a file.
+
+  @param *newtonWorld Pointer to the Newton world.
+  @param *filename name of the file.
+  @param bodyCallback called once per body to save application data, can be NULL.
+  @param *bodyUserData user data passed to the body callback.
+
+  The file is split in chunks of shapes, bodies and joints indexed by a table of contents, 
+  so the loader can decode the chunks across the world threads. 
+  Chunks are compressed when a compression level was set with ::NewtonSetSerializationCompression.
+
+  This function must be called outside of a Newton Update.
+
+  See also: ::NewtonDeserializeFromFile, ::NewtonSetSerializationCompression, ::NewtonSerializeScene
+*/
 void NewtonSerializeToFile (const NewtonWorld* const newtonWorld, const char* const filename, NewtonOnBodySerializationCallback bodyCallback, void* const bodyUserData)
 {
 	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *) newtonWorld;
 	FILE* const file = fopen(filename, "wb");
 	if (file) {
-		NewtonSerializeScene(newtonWorld, bodyCallback, bodyUserData, dgWorld::OnSerializeToFile, file);
+		world->SaveSceneFile(file, bodyUserData, dgWorld::OnBodySerialize(bodyCallback));
 		fclose (file);
 	}
 }
 
-void NewtonDeserializeFromFile (const NewtonWorld* const newtonWorld, const char* const filename, NewtonOnBodyDeserializationCallback bodyCallback, void* const bodyUserData)
+/*!
+  Load bodies, shapes and joints saved with ::NewtonSerializeToFile into the world.
+
+  @param *newtonWorld Pointer to the Newton world.
+  @param *filename name of the file.
+  @param bodyCallback called once per body to load application data, can be NULL.
+  @param *bodyUserData user data passed to the body callback.
+
+  Decompression, convex hulls, collision trees, height fields and bodies are decoded 
+  across the world threads. The body callback is always called from the calling thread, 
+  in the same order the bodies were saved, and it can not read past the data saved for its body.
+  Files written by older versions with ::NewtonSerializeScene and a file handle are still accepted.
+
+  This function must be called outside of a Newton Update.
+
+  @return 1 if the file was loaded, 0 if it could not be opened or it is damaged. 
+  A damaged file is detected before any body is added, so the world is left as it was.
+
+  See also: ::NewtonSerializeToFile, ::NewtonDeserializeScene
+*/
+int NewtonDeserializeFromFile (const NewtonWorld* const newtonWorld, const char* const filename, NewtonOnBodyDeserializationCallback bodyCallback, void* const bodyUserData)
 {
 	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *) newtonWorld;
 	FILE* const file = fopen(filename, "rb");
-	if (file) {
-		NewtonDeserializeScene(newtonWorld, bodyCallback, bodyUserData, dgWorld::OnDeserializeFromFile, file);
-		fclose (file);
+	if (!file) {
+		return 0;
 	}
+	const bool loaded = world->LoadSceneFile(file, bodyUserData, dgWorld::OnBodyDeserialize(bodyCallback));
+	fclose (file);
+	return loaded ? 1 : 0;
+}
+
+/*!
+  Set the zlib compression level of the chunks written by ::NewtonSerializeToFile.
+
+  @param *newtonWorld Pointer to the Newton world.
+  @param level 0 stores the chunks uncompressed (the default), 1 to 9 trade save time for file size.
+
+  Chunks are compressed in parallel, and chunks that do not shrink are stored as they are.
+  The level is ignored when the library is built without zlib.
+
+  See also: ::NewtonGetSerializationCompression, ::NewtonSerializeToFile
+*/
+void NewtonSetSerializationCompression (const NewtonWorld* const newtonWorld, int level)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *) newtonWorld;
+	world->SetSceneFileCompression(level);
+}
+
+/*!
+  Return the zlib compression level used by ::NewtonSerializeToFile.
+
+  @param *newtonWorld Pointer to the Newton world.
+
+  @return the compression level, 0 when chunks are stored uncompressed.
+
+  See also: ::NewtonSetSerializationCompression
+*/
+int NewtonGetSerializationCompression (const NewtonWorld* const newtonWorld)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *) newtonWorld;
+	return world->GetSceneFileCompression();
+}
+
+/*!
+  Return the size in bytes of a snapshot of the current state of the world.
+
+  @param *newtonWorld Pointer to the Newton world.
+
+  @return the number of bytes NewtonSaveSnapshot will write.
+
+  The size changes as contacts are created and destroyed, a buffer sized with
+  some slack can be reused for many snapshots.
+
+  See also: ::NewtonSaveSnapshot, ::NewtonRestoreSnapshot
+*/
+int NewtonGetSnapshotSize (const NewtonWorld* const newtonWorld)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *) newtonWorld;
+	return world->CalculateSnapshotSize();
+}
+
+/*!
+  Copy the simulation state of the world to a flat memory buffer.
+
+  @param *newtonWorld Pointer to the Newton world.
+  @param *buffer 16 bytes aligned destination buffer.
+  @param bufferSizeInBytes size of the destination buffer.
+
+  @return the number of bytes written, zero if the buffer is too small or not aligned.
+
+  The snapshot holds only the state that changes from step to step: body matrices,
+  velocities, accumulated forces and impulses, sleeping and equilibrium flags, the 
+  broadphase boxes, the contact joints with their contact points and cached impulses,
+  and the force feedback of the bilateral joints. 
+  Shapes, masses, materials and joint parameters are not saved, and neither is the state 
+  kept by user joints in their own data.
+
+  The snapshot is not a file format, it can only be restored on the same world, 
+  and only while that world still has the same bodies and joints.
+
+  The cost grows with the number of contact pairs, not only with the number of bodies.
+  Every pair whose boxes overlap is saved, including pairs with no contact points, 
+  together with the warm start impulses of every contact point, because all of them 
+  decide how the next update continues. A settled pile of boxes takes about 2 KB per body. 
+  A 9000 body pile makes a 20 MB snapshot that takes about 18 ms to save and 33 ms to 
+  restore on one core, against 240 ms for one update of the same world. 
+  applications/benchmarks/worldSnapshot measures this on the target machine.
+
+  This function must be called outside of a Newton Update.
+
+  See also: ::NewtonRestoreSnapshot, ::NewtonGetSnapshotSize, ::NewtonSerializeScene
+*/
+int NewtonSaveSnapshot (const NewtonWorld* const newtonWorld, void* const buffer, int bufferSizeInBytes)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *) newtonWorld;
+	return world->SaveSnapshot(buffer, bufferSizeInBytes);
+}
+
+/*!
+  Set the simulation state of the world back to a snapshot.
+
+  @param *newtonWorld Pointer to the Newton world.
+  @param *buffer snapshot written by NewtonSaveSnapshot.
+  @param bufferSizeInBytes size of the snapshot buffer.
+
+  @return 1 if the snapshot was restored, 0 if the world no longer has the bodies and 
+  joints the snapshot was taken from, in which case the world is not modified.
+
+  Contacts that are alive in the world and in the snapshot are reused, the others are 
+  created or destroyed, so the contact create and destroy callbacks may be called. 
+  Transform callbacks are called on the next update.
+ 
+  A single threaded world stepped after a restore with the same forces reproduces 
+  the original run. With more threads the solver order is not fixed, and the 
+  results only match up to round off. The broadphase trees of aggregates are not 
+  part of the snapshot, worlds with aggregates are restored to the same bodies and 
+  contacts but may not continue bit for bit.
+
+  This function must be called outside of a Newton Update.
+
+  See also: ::NewtonSaveSnapshot, ::NewtonGetSnapshotSize
+*/
+int NewtonRestoreSnapshot (const NewtonWorld* const newtonWorld, const void* const buffer, int bufferSizeInBytes)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *) newtonWorld;
+	return world->RestoreSnapshot(buffer, bufferSizeInBytes) ? 1 : 0;
+}
+
+/*!
+  Write the state of the bodies that changed since a generation to a compact packet for replication.
+
+  @param *newtonWorld Pointer to the Newton world.
+  @param generation bodies with a state generation equal or larger than this value are written, zero writes every body.
+  @param positionStep quantization step of the positions.
+  @param velocityStep quantization step of the linear and angular velocities.
+  @param *baseline absolute packet the client already has, NULL to write absolute values.
+  @param baselineSizeInBytes size of the baseline packet.
+  @param *buffer destination buffer, NULL to get the worst case size of the packet.
+  @param bufferSizeInBytes size of the destination buffer.
+
+  @return the number of bytes written, zero if the buffer is too small or the baseline 
+  is not an absolute packet with the same quantization steps.
+
+  Each body is written as its id, position, rotation, velocity and omega quantized to 
+  integers. With a baseline each value is written as the difference to the value of 
+  the same body in the baseline, bodies moving slowly or not in the baseline cost only a 
+  few bytes. Bodies of the baseline that are no longer in the world are written as removed ids. 
+  The packet is a byte stream independent of the host, and it is not compressed.
+
+  A typical server keeps for each client the last absolute packet the client acknowledged, 
+  encodes the bodies changed since then against it, and uses ::NewtonMergeBodyStates to 
+  build the next baseline, the client calls the same function to build the same baseline.
+
+  See also: ::NewtonDecodeBodyStates, ::NewtonMergeBodyStates, ::NewtonWorldGetStateGeneration, ::NewtonWorldGetFirstChangedBody
+*/
+int NewtonEncodeBodyStates (const NewtonWorld* const newtonWorld, unsigned generation, dFloat positionStep, dFloat velocityStep, const void* const baseline, int baselineSizeInBytes, void* const buffer, int bufferSizeInBytes)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *) newtonWorld;
+	return world->EncodeBodyStates(generation, positionStep, velocityStep, baseline, baselineSizeInBytes, buffer, bufferSizeInBytes);
+}
+
+/*!
+  Read the body states of a packet written by NewtonEncodeBodyStates.
+
+  @param *baseline absolute packet the packet was encoded against, ignored if the packet is absolute.
+  @param baselineSizeInBytes size of the baseline packet.
+  @param *packet packet to decode.
+  @param packetSizeInBytes size of the packet.
+  @param callback function called with the id, matrix, velocity and omega of each body in the packet, can be NULL.
+  @param *userData user data passed to the callback.
+
+  @return the number of bodies and removed bodies in the packet, -1 if the packet is corrupted or was not encoded against this baseline.
+
+  Bodies are reported in increasing id order, the id is the one returned by ::NewtonBodyGetID on the server.
+  Bodies removed from the server since the baseline are reported after them, with NULL matrix, velocity and omega.
+  This function does not need a world, it can be called on a client that only mirrors the server.
+
+  See also: ::NewtonEncodeBodyStates, ::NewtonMergeBodyStates
+*/
+int NewtonDecodeBodyStates (const void* const baseline, int baselineSizeInBytes, const void* const packet, int packetSizeInBytes, NewtonBodyStateCallback callback, void* const userData)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	return dgWorld::DecodeBodyStates(baseline, baselineSizeInBytes, packet, packetSizeInBytes, (dgWorld::OnBodyStateDecode) callback, userData);
+}
+
+/*!
+  Apply a packet to its baseline and write the result as a new absolute packet.
+
+  @param *baseline absolute packet, can be NULL if the packet is absolute.
+  @param baselineSizeInBytes size of the baseline packet.
+  @param *packet packet written by NewtonEncodeBodyStates.
+  @param packetSizeInBytes size of the packet.
+  @param *buffer destination buffer, NULL to get the size of the merged packet.
+  @param bufferSizeInBytes size of the destination buffer.
+
+  @return the number of bytes written, zero if the buffer is too small or the packet can not be applied to the baseline.
+
+  The merged packet holds every body of the baseline that the packet does not remove, with the 
+  values of the packet for the bodies in the packet. Server and client merging the same packets get the same bytes, 
+  so the result can be used as the baseline of the next packet.
+
+  See also: ::NewtonEncodeBodyStates, ::NewtonDecodeBodyStates
+*/
+int NewtonMergeBodyStates (const void* const baseline, int baselineSizeInBytes, const void* const packet, int packetSizeInBytes, void* const buffer, int bufferSizeInBytes)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	return dgWorld::MergeBodyStates(baseline, baselineSizeInBytes, packet, packetSizeInBytes, buffer, bufferSizeInBytes);
 }
 
 NewtonBody* NewtonFindSerializedBody(const NewtonWorld* const newtonWorld, int bodySerializedID)
@@ -575,7 +818,106 @@ void NewtonDispachThreadJob(const NewtonWorld* const newtonWorld, NewtonJobTask
 void NewtonSyncThreadJobs(const NewtonWorld* const newtonWorld)
 {
 	Newton* const world = (Newton *)newtonWorld;
-	world->SynchronizationBarrier();
+	world->SyncUserJobs();
+}
+
+/*!
+  Create a pool of worker threads that several worlds can share.
+
+  @param threads number of worker threads in the pool.
+
+  @return Pointer to the new scheduler.
+
+  A process running many small worlds, each with its own threads, ends up with far more
+  threads than cores. Attaching the worlds to one scheduler with ::NewtonWorldSetScheduler
+  makes them run on the scheduler workers only.
+
+  See also: ::NewtonDestroyScheduler, ::NewtonWorldSetScheduler, ::NewtonUpdateWorlds
+*/
+NewtonScheduler* NewtonCreateScheduler(int threads)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	dgMemoryAllocator* const allocator = new dgMemoryAllocator();
+	return (NewtonScheduler*) new (allocator) dgWorldScheduler(allocator, threads);
+}
+
+/*!
+  Destroy a scheduler.
+
+  @param *scheduler pointer to the scheduler.
+
+  @return Nothing.
+
+  Worlds still attached are detached and left single threaded.
+
+  See also: ::NewtonCreateScheduler
+*/
+void NewtonDestroyScheduler(const NewtonScheduler* const scheduler)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	dgWorldScheduler* const me = (dgWorldScheduler*) scheduler;
+	dgMemoryAllocator* const allocator = me->GetAllocator();
+	delete me;
+	delete allocator;
+}
+
+/*!
+  Return the number of worker threads of a scheduler.
+
+  @param *scheduler pointer to the scheduler.
+
+  @return Number threads.
+
+  See also: ::NewtonCreateScheduler
+*/
+int NewtonSchedulerGetThreadsCount(const NewtonScheduler* const scheduler)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	dgWorldScheduler* const me = (dgWorldScheduler*) scheduler;
+	return me->GetThreadCount();
+}
+
+/*!
+  Attach a world to a scheduler, or detach it.
+
+  @param *newtonWorld Pointer to the Newton world.
+  @param *scheduler pointer to the scheduler, NULL to detach the world.
+
+  @return Nothing
+
+  Attaching a world destroys its own worker threads. From then on ::NewtonUpdate and
+  ::NewtonUpdateWorlds step the world with the scheduler workers and ::NewtonSetThreadsCount is
+  ignored; a detached world is single threaded until the application sets its thread count again.
+
+  ::NewtonUpdateAsync still steps an attached world on its own update thread, without workers.
+
+  Outside of a step, the jobs of ::NewtonDispachThreadJob, the batch queries, tree collision builds and 
+  scene file loads and saves of an attached world run on the scheduler workers while the scheduler is 
+  not stepping, and on the calling thread while it is.
+
+  See also: ::NewtonWorldGetScheduler, ::NewtonUpdateWorlds
+*/
+void NewtonWorldSetScheduler(const NewtonWorld* const newtonWorld, const NewtonScheduler* const scheduler)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *)newtonWorld;
+	world->SetScheduler((dgWorldScheduler*) scheduler);
+}
+
+/*!
+  Return the scheduler a world is attached to.
+
+  @param *newtonWorld Pointer to the Newton world.
+
+  @return the scheduler, NULL if the world has its own threads.
+
+  See also: ::NewtonWorldSetScheduler
+*/
+NewtonScheduler* NewtonWorldGetScheduler(const NewtonWorld* const newtonWorld)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *)newtonWorld;
+	return (NewtonScheduler*) world->GetScheduler();
 }
 
 int NewtonGetParallelSolverOnLargeIsland(const NewtonWorld* const newtonWorld)
@@ -585,6 +927,78 @@ int NewtonGetParallelSolverOnLargeIsland(const NewtonWorld* const newtonWorld)
 	return world->GetParallelSolverOnLargeIsland();
 }
 
+/*!
+  Enable/disable the compact jacobian row format for the island solver
+  (disabled by default).
+
+  @param *newtonWorld Pointer to the Newton world.
+  @param mode 1: enabled  0: disabled (default)
+
+  @return Nothing
+
+  When enabled, the island solver iterates over a packed copy of the constraint
+  jacobians and rebuilds the inverse mass weighted rows of each joint from the body 
+  inverse mass and inverse inertia on every pass. Results are identical to the default mode.
+
+  Islands that contain skeletons, and islands solved by the parallel solver,
+  always use the full row format.
+
+  See also: ::NewtonGetSolverCompactRows, ::NewtonSetParallelSolverOnLargeIsland
+*/
+void NewtonSetSolverCompactRows(const NewtonWorld* const newtonWorld, int mode)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *)newtonWorld;
+	world->SetCompactJacobianRows(mode);
+}
+
+int NewtonGetSolverCompactRows(const NewtonWorld* const newtonWorld)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *)newtonWorld;
+	return world->GetCompactJacobianRows();
+}
+
+/*!
+  Enable/disable results that do not depend on the number of threads
+  (disabled by default).
+
+  @param *newtonWorld Pointer to the Newton world.
+  @param mode 1: enabled  0: disabled (default)
+
+  @return Nothing
+
+  When enabled, a world stepped with the same inputs produces bit identical bodies
+  for any thread count, so lockstep simulations can use as many threads as each machine has.
+  The large island solver adds the joint forces of each body in joint order instead of
+  under a lock, adds up its error in a fixed order, and the simd solver plugins are not used.
+  New contacts that do not fit in a full contact array are all dropped for one step
+  instead of keeping the ones the fastest threads found, and bodies woken by a contact
+  changing state are only woken after all contacts were updated.
+
+  Contact pairs and island joints are always sorted with unique keys, so the island
+  solver is reproducible in both modes, the extra cost of this mode is in islands
+  large enough for the parallel solver.
+
+  Results still depend on the order bodies and joints are created, and on the callbacks
+  of the application being deterministic.
+
+  See also: ::NewtonGetDeterministicMode, ::NewtonSetParallelSolverOnLargeIsland
+*/
+void NewtonSetDeterministicMode(const NewtonWorld* const newtonWorld, int mode)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *)newtonWorld;
+	world->SetDeterministicMode(mode);
+}
+
+int NewtonGetDeterministicMode(const NewtonWorld* const newtonWorld)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *)newtonWorld;
+	return world->GetDeterministicMode();
+}
+
 /*!
   Set the solver precision mode.
 
@@ -658,6 +1072,36 @@ void NewtonWaitForUpdateToFinish (const NewtonWorld* const newtonWorld)
 	world->Sync ();
 }
 
+/*!
+  Advance several worlds by the same amount of time.
+
+  @param *newtonWorlds array of pointers to the worlds.
+  @param count number of worlds in the array.
+  @param timestep time step in seconds.
+
+  @return Nothing
+
+  The worlds attached to the same scheduler are stepped together. The ones too large to share
+  a worker with others are stepped one at a time using all the scheduler workers, the rest are
+  packed by size on the workers, each worker stepping its worlds one after the other.
+  Worlds without a scheduler are updated in turn, as ::NewtonUpdate would. A world listed more than once is stepped once.
+
+  The callbacks of a packed world are called from a scheduler worker, with thread index 0.
+
+  See also: ::NewtonWorldSetScheduler, ::NewtonUpdate
+*/
+void NewtonUpdateWorlds(const NewtonWorld* const* const newtonWorlds, int count, dFloat timestep)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	if (count > 0) {
+		dgStack<dgWorld*> worlds(count);
+		for (dgInt32 i = 0; i < count; i++) {
+			worlds[i] = (Newton *)newtonWorlds[i];
+		}
+		dgWorldScheduler::UpdateWorlds(&worlds[0], count, timestep);
+	}
+}
+
 dFloat NewtonGetLastUpdateTime (const NewtonWorld* const newtonWorld)
 {
 	TRACE_FUNCTION(__FUNCTION__);
@@ -806,6 +1250,64 @@ NewtonBody* NewtonWorldGetNextBody(const NewtonWorld* const newtonWorld, const N
 
 }
 
+/*!
+  Return the state generation of the world.
+
+  @param *newtonWorld Pointer to the Newton world.
+
+  @return the current generation.
+
+  The generation goes up by one at the end of every update. Bodies moved by the 
+  integration or by NewtonBodySetMatrix are stamped with the generation of the 
+  world at the time, an application that reads the generation after replicating 
+  the world can later visit only the bodies that changed since then.
+
+  See also: ::NewtonWorldGetFirstChangedBody, ::NewtonBodyGetStateGeneration, ::NewtonEncodeBodyStates
+*/
+unsigned NewtonWorldGetStateGeneration (const NewtonWorld* const newtonWorld)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *) newtonWorld;
+	return world->GetStateGeneration();
+}
+
+/*!
+  Get the first body in the world body list changed since a generation.
+
+  @param *newtonWorld Pointer to the Newton world.
+  @param generation generation read with NewtonWorldGetStateGeneration.
+
+  @return the first body with a state generation equal or larger than generation, NULL if none.
+
+  Sleeping bodies are not integrated, so they are skipped until they move again.
+
+  See also: ::NewtonWorldGetNextChangedBody, ::NewtonWorldGetStateGeneration
+*/
+NewtonBody* NewtonWorldGetFirstChangedBody (const NewtonWorld* const newtonWorld, unsigned generation)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *) newtonWorld;
+	return (NewtonBody*) world->GetFirstChangedBody(generation);
+}
+
+/*!
+  Get the next body in the world body list changed since a generation.
+
+  @param *newtonWorld Pointer to the Newton world.
+  @param *curBody body returned by the previous call.
+  @param generation same generation passed to NewtonWorldGetFirstChangedBody.
+
+  @return the next changed body, NULL if none.
+
+  See also: ::NewtonWorldGetFirstChangedBody, ::NewtonWorldGetStateGeneration
+*/
+NewtonBody* NewtonWorldGetNextChangedBody (const NewtonWorld* const newtonWorld, const NewtonBody* const curBody, unsigned generation)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *) newtonWorld;
+	return (NewtonBody*) world->GetNextChangedBody((dgBody*) curBody, generation);
+}
+
 
 /*!
   Trigger callback function for each joint in the world.
@@ -1198,24 +1700,255 @@ void NewtonWorldRayCast(const NewtonWorld* const newtonWorld, const dFloat* cons
   The application can use this callback to implement faster or smarter filters when implementing complex logic, otherwise for normal all ray cast
   this parameter could be NULL.
 
-  See also: ::NewtonWorldRayCast
+  See also: ::NewtonWorldRayCast
+*/
+int NewtonWorldConvexCast(const NewtonWorld* const newtonWorld, const dFloat* const matrix, const dFloat* const target, const NewtonCollision* const shape, 
+						  dFloat* const param, void* const userData, NewtonWorldRayPrefilterCallback prefilter, NewtonWorldConvexCastReturnInfo* const info, 
+						  int maxContactsCount, int threadIndex)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	dgVector destination (target[0], target[1], target[2], dgFloat32 (0.0f));
+	Newton* const world = (Newton *) newtonWorld;
+	return world->GetBroadPhase()->ConvexCast ((dgCollisionInstance*) shape, dgMatrix (matrix), destination, param, (OnRayPrecastAction) prefilter, userData, (dgConvexCastReturnInfo*)info, maxContactsCount, threadIndex);
+}
+
+int NewtonWorldCollide (const NewtonWorld* const newtonWorld, const dFloat* const matrix, const NewtonCollision* const shape, void* const userData,  
+					   NewtonWorldRayPrefilterCallback prefilter, NewtonWorldConvexCastReturnInfo* const info, int maxContactsCount, int threadIndex)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *)newtonWorld;
+	return world->GetBroadPhase()->Collide((dgCollisionInstance*)shape, dgMatrix(matrix), (OnRayPrecastAction)prefilter, userData, (dgConvexCastReturnInfo*)info, maxContactsCount, threadIndex);
+}
+
+/*!
+  Cast an array of convex shapes along their rays, distributing the queries across the world threads.
+
+  @param *newtonWorld Pointer to the Newton world.
+  @param *queries array of queryCount queries, each one with the shape, the start matrix, the target position and the user data of the cast.
+  @param queryCount number of queries in the array.
+  @param prefilter user define function to be called for each body before intersection, the userData argument is the *m_userData* of the query.
+  @param *params array of queryCount floats that receive the time of impact of each query, one if the shape did not hit anything.
+  @param *contactCounts array of queryCount ints that receive the number of contacts of each query, can be NULL if *info* is NULL.
+  @param *info array of queryCount times maxContactsPerQuery contacts, the contacts of query i start at entry i * maxContactsPerQuery. can be NULL.
+  @param maxContactsPerQuery maximum number of contacts of a single query.
+  @param threadIndex thread index from where this function is called, zero if call from outside a newton update
+
+  each query produces the same result as a call to *NewtonWorldConvexCast* with the same arguments.
+  when called outside of an update the queries run on all the world threads, and large batches are sorted by position so that
+  each thread traverses the broad phase with spatially coherent queries, the prefilter callback must be thread safe.
+  from inside an update callback the queries run on the calling thread.
+
+  See also: ::NewtonWorldConvexCast, ::NewtonWorldCollideBatch, ::NewtonCollisionClosestPointBatch
+*/
+void NewtonWorldConvexCastBatch (const NewtonWorld* const newtonWorld, const NewtonWorldShapeQuery* const queries, int queryCount, NewtonWorldRayPrefilterCallback prefilter, 
+								 dFloat* const params, int* const contactCounts, NewtonWorldConvexCastReturnInfo* const info, int maxContactsPerQuery, int threadIndex)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *)newtonWorld;
+	world->ConvexCastBatch ((const dgShapeQuery*) queries, queryCount, (OnRayPrecastAction) prefilter, (dgConvexCastReturnInfo*) info, maxContactsPerQuery, contactCounts, params, threadIndex);
+}
+
+/*!
+  Collide an array of shapes with the world, distributing the queries across the world threads.
+
+  @param *newtonWorld Pointer to the Newton world.
+  @param *queries array of queryCount queries, each one with the shape, the matrix and the user data of the overlap test, *m_target* is ignored.
+  @param queryCount number of queries in the array.
+  @param prefilter user define function to be called for each body before intersection, the userData argument is the *m_userData* of the query.
+  @param *contactCounts array of queryCount ints that receive the number of contacts of each query.
+  @param *info array of queryCount times maxContactsPerQuery contacts, the contacts of query i start at entry i * maxContactsPerQuery.
+  @param maxContactsPerQuery maximum number of contacts of a single query.
+  @param threadIndex thread index from where this function is called, zero if call from outside a newton update
+
+  each query produces the same result as a call to *NewtonWorldCollide* with the same arguments.
+  threading and ordering are the same as for ::NewtonWorldConvexCastBatch.
+
+  See also: ::NewtonWorldCollide, ::NewtonWorldConvexCastBatch
+*/
+void NewtonWorldCollideBatch (const NewtonWorld* const newtonWorld, const NewtonWorldShapeQuery* const queries, int queryCount, NewtonWorldRayPrefilterCallback prefilter, 
+							  int* const contactCounts, NewtonWorldConvexCastReturnInfo* const info, int maxContactsPerQuery, int threadIndex)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *)newtonWorld;
+	world->CollideBatch ((const dgShapeQuery*) queries, queryCount, (OnRayPrecastAction) prefilter, (dgConvexCastReturnInfo*) info, maxContactsPerQuery, contactCounts, threadIndex);
+}
+
+/*!
+  Create a query object that remembers the bodies around its last query.
+
+  @param *newtonWorld Pointer to the Newton world.
+  @param padding distance the remembered region extends past each query box.
+
+  @return the new query object.
+
+  a query repeated from frame to frame around the same place, like the ground probe of a character or the sensor of a vehicle, 
+  only revisits the broad phase branches that changed since the previous call as long as the new query box stays inside 
+  the padded box of the last full search. a larger padding makes full searches rarer but keeps more candidates.
+
+  a query object must not be used from more than one thread at the same time, and it must be destroyed before the world.
+
+  See also: ::NewtonDestroySpatialQuery, ::NewtonSpatialQueryForEachBodyInAABBDo, ::NewtonSpatialQueryConvexCast
+*/
+NewtonSpatialQuery* NewtonCreateSpatialQuery (const NewtonWorld* const newtonWorld, dFloat padding)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *)newtonWorld;
+	return (NewtonSpatialQuery*) new (world->GetAllocator()) dgBroadPhaseQueryCache (world, padding);
+}
+
+/*!
+  Destroy a query object.
+
+  @param *query pointer to the query object.
+
+  See also: ::NewtonCreateSpatialQuery
+*/
+void NewtonDestroySpatialQuery (const NewtonSpatialQuery* const query)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	dgBroadPhaseQueryCache* const cache = (dgBroadPhaseQueryCache*) query;
+	delete cache;
+}
+
+/*!
+  Iterate thru every body with an AABB overlapping the box, reusing the candidates of the previous call when possible.
+
+  @param *query pointer to the query object.
+  @param *p0 - pointer to an array of at least three floats to hold minimum value for the AABB.
+  @param *p1 - pointer to an array of at least three floats to hold maximum value for the AABB.
+  @param callback application defined callback
+  @param *userData pointer to the user defined user data value.
+
+  reports the same bodies as ::NewtonWorldForEachBodyInAABBDo, the order of the calls to the callback may be different.
+
+  See also: ::NewtonWorldForEachBodyInAABBDo, ::NewtonCreateSpatialQuery
+*/
+void NewtonSpatialQueryForEachBodyInAABBDo (const NewtonSpatialQuery* const query, const dFloat* const p0, const dFloat* const p1, NewtonBodyIterator callback, void* const userData)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	dgBroadPhaseQueryCache* const cache = (dgBroadPhaseQueryCache*) query;
+	dgVector q0 (dgMin (p0[0], p1[0]), dgMin (p0[1], p1[1]), dgMin (p0[2], p1[2]), dgFloat32 (0.0f));
+	dgVector q1 (dgMax (p0[0], p1[0]), dgMax (p0[1], p1[1]), dgMax (p0[2], p1[2]), dgFloat32 (0.0f));
+	cache->ForEachBodyInAABB (q0, q1, (OnBodiesInAABB) callback, userData);
+}
+
+/*!
+  Cast a convex shape thru the world, reusing the candidates of the previous call when possible.
+
+  @param *query pointer to the query object.
+  @param *matrix pointer to an array of at least three floats to hold the origin and orientation of the shape.
+  @param *target pointer to an array of at least three floats to hold the destination of the shape.
+  @param *shape collision shape to cast.
+  @param *param pointer to a float that receives the fraction of the path where the first hit happens.
+  @param *userData user data to be passed to the prefilter callback.
+  @param prefilter user define function to be called for each body before intersection.
+  @param *info pointer to an array of contacts at the point of intersections.
+  @param maxContactsCount maximum number of contacts to be saved in the info array.
+  @param threadIndex thread index from where this function is called, zero if call from outside a newton update
+
+  @return the number of contacts at the intersection point.
+
+  returns the same result as ::NewtonWorldConvexCast, the region remembered by the query covers the whole path of the shape.
+
+  See also: ::NewtonWorldConvexCast, ::NewtonCreateSpatialQuery
+*/
+int NewtonSpatialQueryConvexCast (const NewtonSpatialQuery* const query, const dFloat* const matrix, const dFloat* const target, const NewtonCollision* const shape, 
+								  dFloat* const param, void* const userData, NewtonWorldRayPrefilterCallback prefilter, NewtonWorldConvexCastReturnInfo* const info, 
+								  int maxContactsCount, int threadIndex)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	dgBroadPhaseQueryCache* const cache = (dgBroadPhaseQueryCache*) query;
+	dgVector destination (target[0], target[1], target[2], dgFloat32 (0.0f));
+	return cache->ConvexCast ((dgCollisionInstance*) shape, dgMatrix (matrix), destination, param, (OnRayPrecastAction) prefilter, userData, (dgConvexCastReturnInfo*)info, maxContactsCount, threadIndex);
+}
+
+/*!
+  Get the trigger volume events of the last update.
+
+  @param *newtonWorld Pointer to the Newton world.
+  @param *eventCount receives the number of events.
+
+  @return pointer to an array of eventCount events, or NULL when there are none.
+
+  the world clears the array at the start of each update and fills it while the update runs, one event 
+  each time a pair with a trigger volume begins or ends. the array is valid until the next update and 
+  can be read from any thread without locks once the update has finished.
+
+  no end event is reported for a pair that ends because one of its bodies was destroyed, 
+  and events of bodies destroyed during the update are removed from the array.
+
+  See also: ::NewtonBodySetTriggerVolume
+*/
+const NewtonTriggerEvent* NewtonWorldGetTriggerEvents(const NewtonWorld* const newtonWorld, int* const eventCount)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *)newtonWorld;
+	dgInt32 count = 0;
+	const dgTriggerEvent* const events = world->GetTriggerEvents(count);
+	*eventCount = count;
+	return (const NewtonTriggerEvent*) events;
+}
+
+/*!
+  Select the contact events the world reports after each update.
+
+  @param *newtonWorld Pointer to the Newton world.
+  @param eventMask combination of NEWTON_CONTACT_EVENT_BEGIN, NEWTON_CONTACT_EVENT_PERSIST and NEWTON_CONTACT_EVENT_END.
+
+  the default mask is zero, and a world with a zero mask does no extra work.
+  pairs with a trigger volume never report contact events, see ::NewtonWorldGetTriggerEvents.
+
+  See also: ::NewtonWorldGetContactEvents, ::NewtonWorldGetContactEventMask
+*/
+void NewtonWorldSetContactEventMask(const NewtonWorld* const newtonWorld, int eventMask)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *)newtonWorld;
+	world->SetContactEventMask(eventMask);
+}
+
+/*!
+  Get the contact events the world reports after each update.
+
+  @param *newtonWorld Pointer to the Newton world.
+
+  @return the current event mask.
+
+  See also: ::NewtonWorldSetContactEventMask
 */
-int NewtonWorldConvexCast(const NewtonWorld* const newtonWorld, const dFloat* const matrix, const dFloat* const target, const NewtonCollision* const shape, 
-						  dFloat* const param, void* const userData, NewtonWorldRayPrefilterCallback prefilter, NewtonWorldConvexCastReturnInfo* const info, 
-						  int maxContactsCount, int threadIndex)
+int NewtonWorldGetContactEventMask(const NewtonWorld* const newtonWorld)
 {
 	TRACE_FUNCTION(__FUNCTION__);
-	dgVector destination (target[0], target[1], target[2], dgFloat32 (0.0f));
-	Newton* const world = (Newton *) newtonWorld;
-	return world->GetBroadPhase()->ConvexCast ((dgCollisionInstance*) shape, dgMatrix (matrix), destination, param, (OnRayPrecastAction) prefilter, userData, (dgConvexCastReturnInfo*)info, maxContactsCount, threadIndex);
+	Newton* const world = (Newton *)newtonWorld;
+	return world->GetContactEventMask();
 }
 
-int NewtonWorldCollide (const NewtonWorld* const newtonWorld, const dFloat* const matrix, const NewtonCollision* const shape, void* const userData,  
-					   NewtonWorldRayPrefilterCallback prefilter, NewtonWorldConvexCastReturnInfo* const info, int maxContactsCount, int threadIndex)
+/*!
+  Get the contact events of the last update.
+
+  @param *newtonWorld Pointer to the Newton world.
+  @param *eventCount receives the number of events.
+
+  @return pointer to an array of eventCount events, or NULL when there are none.
+
+  after the last sub step the world summarizes each touching contact pair into one event: 
+  average point and normal, the normal and friction impulses applied by the solver, the largest impact 
+  speed and the deepest penetration. begin and persist events are in contact order, which does not 
+  depend on the thread count, end events come first and carry no point data.
+
+  the array is valid until the next update and can be read without locks, 
+  this replaces walking the contact joints or doing work in the contact callbacks of the step.
+
+  See also: ::NewtonWorldSetContactEventMask
+*/
+const NewtonContactEvent* NewtonWorldGetContactEvents(const NewtonWorld* const newtonWorld, int* const eventCount)
 {
 	TRACE_FUNCTION(__FUNCTION__);
 	Newton* const world = (Newton *)newtonWorld;
-	return world->GetBroadPhase()->Collide((dgCollisionInstance*)shape, dgMatrix(matrix), (OnRayPrecastAction)prefilter, userData, (dgConvexCastReturnInfo*)info, maxContactsCount, threadIndex);
+	dgInt32 count = 0;
+	const dgContactEvent* const events = world->GetContactEvents(count);
+	*eventCount = count;
+	return (const NewtonContactEvent*) events;
 }
 
 NewtonJoint* NewtonWorldFindJoint(const NewtonBody* const body0, const NewtonBody* const body1)
@@ -2529,6 +3262,35 @@ void NewtonCompoundCollisionSetSubCollisionMatrix (NewtonCollision* const compou
 	}
 }
 
+/*!
+  Set the local matrix of many sub shapes of a compound collision in one call.
+
+  @param compoundCollision pointer to the compound collision.
+  @param collisionNodeArray array of sub shape nodes.
+  @param matrixArray array of 4x4 matrices, sixteen floats per node.
+  @param count number of entries in both arrays.
+
+  The tree boxes on the path of each node are refit bottom up and the mass properties are updated 
+  from the moved nodes only. The full tree is only rebuilt by ::NewtonCompoundCollisionEndAddRemove 
+  after a large fraction of the sub shapes changed, so this call should be made between 
+  ::NewtonCompoundCollisionBeginAddRemove and ::NewtonCompoundCollisionEndAddRemove.
+
+  See also: ::NewtonCompoundCollisionSetSubCollisionMatrix
+*/
+void NewtonCompoundCollisionSetSubCollisionMatrixArray (NewtonCollision* const compoundCollision, void* const* const collisionNodeArray, const dFloat* const matrixArray, int count)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	dgCollisionInstance* const compoundInstance = (dgCollisionInstance*) compoundCollision;
+	if (compoundInstance->IsType (dgCollision::dgCollisionCompound_RTTI) && (count > 0)) {
+		dgCollisionCompound* const collision = (dgCollisionCompound*) compoundInstance->GetChildShape();
+		dgStack<dgMatrix> matrices (count);
+		for (dgInt32 i = 0; i < count; i ++) {
+			matrices[i] = dgMatrix (&matrixArray[i * 16]);
+		}
+		collision->SetCollisionMatrixArray ((dgCollisionCompound::dgTreeArray::dgTreeNode**)collisionNodeArray, &matrices[0], count);
+	}
+}
+
 
 void NewtonCompoundCollisionBeginAddRemove (NewtonCollision* const compoundCollision)	
 {
@@ -3144,6 +3906,79 @@ int NewtonUserMeshCollisionContinuousOverlapTest (const NewtonUserMeshCollisionC
 	return (dist < dgFloat32 (1.0f)) ? 1 : 0;
 }
 
+/*!
+  Let the collide callback of a user mesh serve a region around each query box.
+
+  @param *userMeshCollision pointer to the user mesh collision.
+  @param padding distance in mesh space added to each side of the query boxes, zero disables the regions.
+
+  @return Nothing.
+
+  With a padding, the collide callback is called with the query box grown by the padding, and each worker thread keeps 
+  the faces of its last four callbacks. Later queries on the same thread and the same step whose box is inside one of those regions 
+  are answered from the kept faces without calling the application, so contact pairs touching the same part of the mesh share one callback.
+  The faces of a region are used for any body, the collide callback should not filter them by the colliding body.
+  Since each callback returns more faces, the regions pay off when the cost of the callback is mostly per call, like a lock or a page lookup.
+
+  The callback descriptor always comes preset with per thread buffers the application can fill instead of its own arrays, 
+  m_faceVertexIndex has room for 5632 indices and m_faceIndexCount for 512 faces. With regions enabled m_vertex also has room 
+  for 5632 vertices of four dFloat each, without regions it is NULL and the application must point it to its own vertices. 
+  Faces of a region written to other arrays are copied, so the application does not need to keep them after the callback returns.
+
+  See also: ::NewtonCreateUserMeshCollision, ::NewtonUserMeshCollisionFlushRegions
+*/
+void NewtonUserMeshCollisionSetRegionPadding (const NewtonCollision* const userMeshCollision, dFloat padding)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	dgCollisionInstance* const collision = (dgCollisionInstance*)userMeshCollision;
+	if (collision->IsType (dgCollision::dgCollisionUserMesh_RTTI)) {
+		dgCollisionUserMesh* const shape = (dgCollisionUserMesh*) collision->GetChildShape();
+		shape->SetRegionPadding (padding);
+	}
+}
+
+/*!
+  Return the region padding of a user mesh.
+
+  @param *userMeshCollision pointer to the user mesh collision.
+
+  @return padding distance, zero when the regions are disabled.
+
+  See also: ::NewtonUserMeshCollisionSetRegionPadding
+*/
+dFloat NewtonUserMeshCollisionGetRegionPadding (const NewtonCollision* const userMeshCollision)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	dgCollisionInstance* const collision = (dgCollisionInstance*)userMeshCollision;
+	if (collision->IsType (dgCollision::dgCollisionUserMesh_RTTI)) {
+		dgCollisionUserMesh* const shape = (dgCollisionUserMesh*) collision->GetChildShape();
+		return shape->GetRegionPadding ();
+	}
+	return dFloat (0.0f);
+}
+
+/*!
+  Discard the faces kept by the regions of a user mesh.
+
+  @param *userMeshCollision pointer to the user mesh collision.
+
+  @return Nothing.
+
+  The regions are discarded at the start of each world update, an application that changes the mesh in the middle of 
+  an update, or between an update and a collision query, must call this function after the change.
+
+  See also: ::NewtonUserMeshCollisionSetRegionPadding
+*/
+void NewtonUserMeshCollisionFlushRegions (const NewtonCollision* const userMeshCollision)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	dgCollisionInstance* const collision = (dgCollisionInstance*)userMeshCollision;
+	if (collision->IsType (dgCollision::dgCollisionUserMesh_RTTI)) {
+		dgCollisionUserMesh* const shape = (dgCollisionUserMesh*) collision->GetChildShape();
+		shape->FlushRegions ();
+	}
+}
+
 
 
 /*!
@@ -3312,6 +4147,9 @@ void NewtonTreeCollisionAddFace(const NewtonCollision* const treeCollision, int
   A reduction factor of 1.5 to 2.0 is common.
   Calling this function with the parameter *optimize* set to zero, will leave the mesh geometry unaltered.
 
+  When the world worker threads are idle the build runs on them, and an update started meanwhile waits for the build to finish.
+  Called from inside an update, or while another thread is stepping the world, the build runs on the calling thread only.
+
   See also: ::NewtonTreeCollisionAddFace, ::NewtonTreeCollisionEndBuild
 */
 void NewtonTreeCollisionEndBuild(const NewtonCollision* const treeCollision, int optimize)
@@ -3322,6 +4160,122 @@ void NewtonTreeCollisionEndBuild(const NewtonCollision* const treeCollision, int
 	collision->EndBuild(optimize);
 }
 
+/*!
+  Finalize the construction of the polygonal mesh with a given node layout.
+
+  @param *treeCollision is the pointer to the collision tree.
+  @param optimize flag that indicates to Newton whether it should optimize this mesh. Set to 1 to optimize the mesh, otherwise 0.
+  @param nodeLayout NEWTON_TREE_COLLISION_BINARY_NODES or NEWTON_TREE_COLLISION_WIDE_NODES.
+
+  @return Nothing.
+
+  Same as ::NewtonTreeCollisionEndBuild, but with *nodeLayout* set to NEWTON_TREE_COLLISION_WIDE_NODES the tree also builds a
+  four wide hierarchy with the children boxes quantized and stored inline, one cache line per node. 
+  Ray casts and collision queries run on that hierarchy, which is much faster on large static meshes. 
+  The layout is kept when the collision is serialized.
+
+  See also: ::NewtonTreeCollisionEndBuild, ::NewtonTreeCollisionGetNodeLayout
+*/
+void NewtonTreeCollisionEndBuildWithLayout(const NewtonCollision* const treeCollision, int optimize, int nodeLayout)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	dgCollisionBVH* const collision = (dgCollisionBVH*) ((dgCollisionInstance*)treeCollision)->GetChildShape();
+	dgAssert (collision->IsType (dgCollision::dgCollisionBVH_RTTI));
+	collision->EndBuild(optimize, nodeLayout);
+}
+
+/*!
+  Return the node layout of a collision tree.
+
+  @param *treeCollision is the pointer to the collision tree.
+
+  @return NEWTON_TREE_COLLISION_BINARY_NODES or NEWTON_TREE_COLLISION_WIDE_NODES.
+
+  See also: ::NewtonTreeCollisionEndBuildWithLayout
+*/
+int NewtonTreeCollisionGetNodeLayout(const NewtonCollision* const treeCollision)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	dgCollisionBVH* const collision = (dgCollisionBVH*) ((dgCollisionInstance*)treeCollision)->GetChildShape();
+	dgAssert (collision->IsType (dgCollision::dgCollisionBVH_RTTI));
+	return collision->GetNodeLayout();
+}
+
+/*!
+  Set a function to be called with the progress of the tree construction.
+
+  @param *treeCollision is the pointer to the collision tree.
+  @param reportProgressCallback function called with the normalized progress, or NULL to remove it.
+  @param *reportProgressUserData user data passed to the callback.
+
+  @return Nothing.
+
+  The callback is called from the thread that calls ::NewtonTreeCollisionEndBuild, the return value is ignored.
+  When the world is not updating, the construction runs on the world worker threads, so it must not overlap
+  with ::NewtonUpdateAsync.
+
+  See also: ::NewtonTreeCollisionEndBuild, ::NewtonTreeCollisionEndBuildWithLayout
+*/
+void NewtonTreeCollisionSetBuildProgressCallback(const NewtonCollision* const treeCollision, NewtonReportProgress reportProgressCallback, void* const reportProgressUserData)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	dgCollisionBVH* const collision = (dgCollisionBVH*) ((dgCollisionInstance*)treeCollision)->GetChildShape();
+	dgAssert (collision->IsType (dgCollision::dgCollisionBVH_RTTI));
+	collision->SetBuildProgressCallback ((dgReportProgress) reportProgressCallback, reportProgressUserData);
+}
+
+/*!
+  Write the collision tree as a flat image that can be loaded in place with ::NewtonCreateTreeCollisionFromImage.
+
+  @param *treeCollision is the pointer to the collision tree.
+  @param serializeFunction pointer to the function that writes the data.
+  @param *serializeHandle user data passed to the serialize function.
+
+  @return Nothing.
+
+  The image holds the vertex, face index, face attribute and node arrays at aligned offsets relative to its start,
+  it is tied to the version and the floating point precision of the library that wrote it.
+
+  See also: ::NewtonCreateTreeCollisionFromImage, ::NewtonCollisionSerialize
+*/
+void NewtonTreeCollisionSerializeImage(const NewtonCollision* const treeCollision, NewtonSerializeCallback serializeFunction, void* const serializeHandle)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	dgCollisionBVH* const collision = (dgCollisionBVH*) ((dgCollisionInstance*)treeCollision)->GetChildShape();
+	dgAssert (collision->IsType (dgCollision::dgCollisionBVH_RTTI));
+	collision->SerializeImage ((dgSerialize) serializeFunction, serializeHandle);
+}
+
+/*!
+  Create a collision tree that uses an image written by ::NewtonTreeCollisionSerializeImage in place.
+
+  @param *newtonWorld is the pointer to the Newton world.
+  @param *image pointer to the image, must be aligned to 16 bytes.
+  @param imageSizeInBytes size of the memory block holding the image.
+  @param shapeID user specified collision index.
+
+  @return the collision tree, or NULL if the image is invalid or was written by an incompatible library.
+
+  Nothing is copied, the image is usually a memory mapped file that must stay mapped until the collision is destroyed.
+  A read only mapping can be shared by many processes, but then ::NewtonTreeCollisionSetFaceAttribute must not be
+  called, and the tree can not be rebuilt.
+
+  See also: ::NewtonTreeCollisionSerializeImage, ::NewtonCreateTreeCollision
+*/
+NewtonCollision* NewtonCreateTreeCollisionFromImage(const NewtonWorld* const newtonWorld, const void* const image, dLong imageSizeInBytes, int shapeID)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *)newtonWorld;
+	dgCollisionInstance* const collision = world->CreateBVH ();
+	dgCollisionBVH* const shape = (dgCollisionBVH*) collision->GetChildShape();
+	if (!shape->AttachImage (image, imageSizeInBytes)) {
+		collision->Release();
+		return NULL;
+	}
+	collision->SetUserDataID(dgUnsigned32 (shapeID));
+	return (NewtonCollision*) collision;
+}
+
 
 /*!
   Get the user defined collision attributes stored with each face of the collision mesh.
@@ -3471,6 +4425,109 @@ int NewtonTreeCollisionGetVertexListTriangleListInAABB(const NewtonCollision* co
 
 
 
+/*!
+  Create a height field collision geometry that pages its elevation in tiles on demand.
+
+  @param *newtonWorld Pointer to the Newton world.
+  @param width the number of sample points in the x direction
+  @param height the number of sample points in the z direction
+  @param tileSize number of cells on the side of a tile, rounded up to an even number
+  @param maxResidentTiles number of tiles kept in memory before the least recently used ones are released
+  @param gridsDiagonals diagonal construction mode, same as ::NewtonCreateHeightFieldCollision
+  @param elevationdatType 0 for 32 bit float elevations, 1 for 16 bit unsigned elevations
+  @param minElevation lowest raw elevation in the map, used for the bounding box
+  @param maxElevation highest raw elevation in the map, used for the bounding box
+  @param verticalScale scale of the elevation
+  @param horizontalScale_x scale in the x direction
+  @param horizontalScale_z scale in the z direction
+  @param pageInCallback function that fills the elevation and attributes of a rectangle of samples
+  @param *pageInUserData user data passed to the page in callback
+  @param shapeID collision shape id
+
+  @return Pointer to the collision.
+
+  Only the tiles touched by the broad phase, the narrow phase or ray casts are loaded, so resident memory 
+  depends on where the bodies are rather than on the size of the map. A tile of (tileSize + 1) x (tileSize + 1) 
+  samples is requested by calling pageInCallback with the rectangle origin and size, the callback can read 
+  from a memory mapped file, a streaming archive or a procedural generator.
+  The callback can be called from several worker threads at the same time for different tiles, so it must be reentrant.
+  Each tile is requested by one thread only, the other threads that need it wait for that call to return.
+
+  See also: ::NewtonHeightFieldSetTilePageInCallback, ::NewtonHeightFieldFlushTiles
+*/
+NewtonCollision* NewtonCreateTiledHeightFieldCollision (const NewtonWorld* const newtonWorld, int width, int height, int tileSize, int maxResidentTiles, int gridsDiagonals, int elevationdatType, 
+														dFloat minElevation, dFloat maxElevation, dFloat verticalScale, dFloat horizontalScale_x, dFloat horizontalScale_z, 
+														NewtonHeightFieldTilePageInCallback pageInCallback, void* const pageInUserData, int shapeID)
+{
+	Newton* const world = (Newton *)newtonWorld;
+
+	TRACE_FUNCTION(__FUNCTION__);
+	dgCollisionInstance* const collision = world->CreateTiledHeightField(width, height, tileSize, maxResidentTiles, gridsDiagonals, elevationdatType, minElevation, maxElevation, 
+																		 verticalScale, horizontalScale_x, horizontalScale_z, (dgCollisionHeightFieldTilePageInCallback) pageInCallback, pageInUserData);
+	collision->SetUserDataID(dgUnsigned32 (shapeID));
+	return (NewtonCollision*) collision;
+}
+
+/*!
+  Set the function that loads the tiles of a tiled height field.
+
+  @param *heightfieldCollision pointer to the height field collision.
+  @param pageInCallback function that fills the elevation and attributes of a rectangle of samples
+  @param *pageInUserData user data passed to the page in callback
+
+  @return Nothing.
+
+  The page in callback is not serialized, a tiled height field loaded from a serialization stream 
+  does not collide until this function is called.
+*/
+void NewtonHeightFieldSetTilePageInCallback (const NewtonCollision* const heightfieldCollision, NewtonHeightFieldTilePageInCallback pageInCallback, void* const pageInUserData)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	dgCollisionInstance* const collision = (dgCollisionInstance*)heightfieldCollision;
+	if (collision->IsType (dgCollision::dgCollisionHeightField_RTTI)) {
+		dgCollisionHeightField* const shape = (dgCollisionHeightField*) collision->GetChildShape();
+		shape->SetTilePageInCallback ((dgCollisionHeightFieldTilePageInCallback) pageInCallback, pageInUserData);
+	}
+}
+
+/*!
+  Return the number of tiles of a tiled height field currently in memory.
+
+  @param *heightfieldCollision pointer to the height field collision.
+
+  @return number of resident tiles, zero for height fields that are not tiled.
+*/
+int NewtonHeightFieldGetResidentTileCount (const NewtonCollision* const heightfieldCollision)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	dgCollisionInstance* const collision = (dgCollisionInstance*)heightfieldCollision;
+	if (collision->IsType (dgCollision::dgCollisionHeightField_RTTI)) {
+		dgCollisionHeightField* const shape = (dgCollisionHeightField*) collision->GetChildShape();
+		return shape->GetResidentTileCount();
+	}
+	return 0;
+}
+
+/*!
+  Release all the tiles of a tiled height field.
+
+  @param *heightfieldCollision pointer to the height field collision.
+
+  @return Nothing.
+
+  Call this function outside the world update, for example after teleporting the player 
+  or after the source of the elevation changes.
+*/
+void NewtonHeightFieldFlushTiles (const NewtonCollision* const heightfieldCollision)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	dgCollisionInstance* const collision = (dgCollisionInstance*)heightfieldCollision;
+	if (collision->IsType (dgCollision::dgCollisionHeightField_RTTI)) {
+		dgCollisionHeightField* const shape = (dgCollisionHeightField*) collision->GetChildShape();
+		shape->FlushTiles();
+	}
+}
+
 /*!
   Create a height field collision geometry.
 
@@ -3665,6 +4722,33 @@ int NewtonCollisionClosestPoint(const NewtonWorld* const newtonWorld,
 								*((dgTriplex*) contactA), *((dgTriplex*) contactB), *((dgTriplex*) normalAB), threadIndex);
 }
 
+/*!
+  Calculate the closest points between an array of pairs of collision primitives, distributing the pairs across the world threads.
+
+  @param *newtonWorld Pointer to the Newton world.
+  @param *queriesA array of queryCount queries with the shape and matrix of collision primitive A of each pair.
+  @param *queriesB array of queryCount queries with the shape and matrix of collision primitive B of each pair.
+  @param queryCount number of pairs.
+  @param *contactsA pointer to and array of a least 3 times queryCount floats to contain the closest point to collisionA of each pair.
+  @param *contactsB pointer to and array of a least 3 times queryCount floats to contain the closest point to collisionB of each pair.
+  @param *normalsAB pointer to and array of a least 3 times queryCount floats to contain the separating vector normal of each pair.
+  @param *results array of queryCount ints that receive the return value of ::NewtonCollisionClosestPoint for each pair.
+  @param threadIndex thread index from where this function is called, zero if call from outside a newton update
+
+  the *m_target* and *m_userData* fields of the queries are ignored.
+
+  See also: ::NewtonCollisionClosestPoint, ::NewtonWorldConvexCastBatch
+*/
+void NewtonCollisionClosestPointBatch (const NewtonWorld* const newtonWorld, 
+									   const NewtonWorldShapeQuery* const queriesA, const NewtonWorldShapeQuery* const queriesB, int queryCount,
+									   dFloat* const contactsA, dFloat* const contactsB, dFloat* const normalsAB, int* const results, int threadIndex)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *)newtonWorld;
+	world->ClosestPointBatch ((const dgShapeQuery*) queriesA, (const dgShapeQuery*) queriesB, queryCount, 
+							  (dgTriplex*) contactsA, (dgTriplex*) contactsB, (dgTriplex*) normalsAB, results, threadIndex);
+}
+
 
 int NewtonCollisionIntersectionTest (const NewtonWorld* const newtonWorld, const NewtonCollision* const collisionA, const dFloat* const matrixA, const NewtonCollision* const collisionB, const dFloat* const matrixB, int threadIndex)
 {
@@ -4096,6 +5180,40 @@ NewtonCollision* NewtonCollisionCreateInstance (const NewtonCollision* const col
 	return (NewtonCollision*) new (instance->GetAllocator()) dgCollisionInstance (*instance);
 }
 
+/*!
+  Create an instance in this world of a collision shape owned by another world, without copying the shape.
+
+  @param *newtonWorld is the pointer to the Newton world that will use the instance.
+  @param *collision is the pointer to a collision instance of the world that owns the shape.
+
+  @return the new instance, or NULL for compound and deformable shapes, which can not be shared.
+
+  This is meant for processes that run many worlds over the same level geometry. The shapes are loaded once
+  into a world that is only used as a geometry library, and each simulation world instances them from there.
+  The owner world is kept alive until all the worlds that instanced its shapes are destroyed, per world data
+  like the height field scratch buffers is allocated separately for each world.
+  Shared shapes must not be modified, e.g. rebuilt or have their face attributes changed, while they are in use,
+  and the library world should not be simulated.
+
+  See also: ::NewtonCollisionCreateInstance, ::NewtonDestroy
+*/
+NewtonCollision* NewtonCollisionCreateSharedInstance (const NewtonWorld* const newtonWorld, const NewtonCollision* const collision)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *)newtonWorld;
+	dgCollisionInstance* const sharedInstance = (dgCollisionInstance*) collision;
+	Newton* const sourceWorld = (Newton*) sharedInstance->GetWorld();
+	if (sourceWorld == world) {
+		return NewtonCollisionCreateInstance (collision);
+	}
+
+	dgCollisionInstance* const instance = world->CreateSharedInstance (sharedInstance);
+	if (instance) {
+		world->AddSharedWorld (sourceWorld);
+	}
+	return (NewtonCollision*) instance;
+}
+
 
 
 /*!
@@ -4472,6 +5590,47 @@ void NewtonBodySetCollidable (const NewtonBody* const bodyPtr, int collidable)
 	body->SetCollidable(collidable ? true : false);
 }
 
+/*!
+  Get the trigger volume state of the body.
+
+  @param *bodyPtr pointer to the body.
+
+  @return 1 if the body is a trigger volume, 0 otherwise.
+
+  See also: ::NewtonBodySetTriggerVolume
+*/
+int NewtonBodyGetTriggerVolume (const NewtonBody* const bodyPtr)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	dgBody* const body = (dgBody *)bodyPtr;
+	return body->IsTrigger() ? 1 : 0;
+}
+
+/*!
+  Make the body a trigger volume.
+
+  @param *bodyPtr pointer to the body.
+  @param state 1 to make the body a trigger volume, 0 to make it a regular body.
+
+  @return Nothing.
+
+  pairs between a trigger volume and other bodies are made and destroyed by the broad phase like any other pair, 
+  but they skip the narrow phase and the solver. a pair lasts while the AABBs of the two bodies overlap, 
+  and the world records one event when it is made and one when it is destroyed, see ::NewtonWorldGetTriggerEvents.
+  the trigger still follows the rules of the broad phase for which pairs are made, a kinematic trigger 
+  is only tested against dynamic bodies with mass.
+
+  changing the state destroys the pairs of the body at the next update, this function must not be called from inside an update.
+
+  See also: ::NewtonBodyGetTriggerVolume, ::NewtonWorldGetTriggerEvents
+*/
+void NewtonBodySetTriggerVolume (const NewtonBody* const bodyPtr, int state)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	dgBody* const body = (dgBody *)bodyPtr;
+	body->SetTrigger(state ? true : false);
+}
+
 int NewtonBodyGetType (const NewtonBody* const bodyPtr)
 {
 	TRACE_FUNCTION(__FUNCTION__);
@@ -4496,6 +5655,22 @@ int NewtonBodyGetID (const NewtonBody* const bodyPtr)
 	return body->GetUniqueID();
 }
 
+/*!
+  Return the world generation at which the body state last changed.
+
+  @param *bodyPtr is the pointer to the body.
+
+  @return state generation of the body.
+
+  See also: ::NewtonWorldGetStateGeneration
+*/
+unsigned NewtonBodyGetStateGeneration (const NewtonBody* const bodyPtr)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	dgBody* const body = (dgBody *)bodyPtr;
+	return body->GetStateGeneration();
+}
+
 /*!
   Store a user defined data value with the body.
 
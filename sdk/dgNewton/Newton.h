@@ -78,6 +78,13 @@ extern "C" {
 	#define NEWTON_DYNAMIC_ASYMETRIC_BODY					2
 //	#define NEWTON_DEFORMABLE_BODY							2
 
+	#define NEWTON_TREE_COLLISION_BINARY_NODES				0
+	#define NEWTON_TREE_COLLISION_WIDE_NODES				1
+
+	#define NEWTON_CONTACT_EVENT_BEGIN						1
+	#define NEWTON_CONTACT_EVENT_PERSIST					2
+	#define NEWTON_CONTACT_EVENT_END						4
+
 	#define SERIALIZE_ID_SPHERE								0
 	#define SERIALIZE_ID_CAPSULE							1
 	#define SERIALIZE_ID_CYLINDER							2
@@ -101,6 +108,8 @@ extern "C" {
 	class NewtonWorld;
 	class NewtonJoint;
 	class NewtonMaterial;
+	class NewtonSpatialQuery;
+	class NewtonScheduler;
 	class NewtonCollision;
 	class NewtonDeformableMeshSegment;
 	class NewtonFracturedCompoundMeshPart;
@@ -110,6 +119,8 @@ extern "C" {
 	typedef struct NewtonWorld{} NewtonWorld;
 	typedef struct NewtonJoint{} NewtonJoint;
 	typedef struct NewtonMaterial{} NewtonMaterial;
+	typedef struct NewtonSpatialQuery{} NewtonSpatialQuery;
+	typedef struct NewtonScheduler{} NewtonScheduler;
 	typedef struct NewtonCollision{} NewtonCollision;
 	typedef struct NewtonDeformableMeshSegment{} NewtonDeformableMeshSegment;
 	typedef struct NewtonFracturedCompoundMeshPart{} NewtonFracturedCompoundMeshPart;
@@ -291,6 +302,35 @@ extern "C" {
 		const NewtonBody* m_hitBody;			// body hit at contact point
 		dFloat m_penetration;                   // contact penetration at collision point
 	} NewtonWorldConvexCastReturnInfo;
+
+	typedef struct NewtonWorldShapeQuery
+	{
+		dFloat m_matrix[16];					// shape matrix in global space
+		dFloat m_target[4];						// end of the sweep for convex casts, ignored by the other queries
+		const NewtonCollision* m_shape;			// query shape
+		void* m_userData;						// user data passed to the prefilter callback of this query
+	} NewtonWorldShapeQuery;
+
+	typedef struct NewtonTriggerEvent
+	{
+		const NewtonBody* m_trigger;			// trigger volume body
+		const NewtonBody* m_body;				// body entering or leaving the trigger
+		int m_begin;							// 1 when the overlap begins, 0 when it ends
+	} NewtonTriggerEvent;
+
+	typedef struct NewtonContactEvent
+	{
+		dFloat m_point[4];						// average of the contact points
+		dFloat m_normal[4];						// average contact normal
+		const NewtonBody* m_body0;
+		const NewtonBody* m_body1;
+		dFloat m_normalImpulse;					// sum of the normal impulses of the last sub step
+		dFloat m_tangentImpulse;				// sum of the friction impulses of the last sub step
+		dFloat m_maxNormalImpact;				// largest normal impact speed of the contact points
+		dFloat m_penetration;					// deepest penetration of the contact points
+		int m_pointCount;
+		int m_type;								// one of the NEWTON_CONTACT_EVENT_ values
+	} NewtonContactEvent;
 	
 	typedef struct NewtonUserMeshCollisionRayHitDesc
 	{
@@ -401,6 +441,7 @@ extern "C" {
 
 	typedef dFloat (*NewtonCollisionTreeRayCastCallback) (const NewtonBody* const body, const NewtonCollision* const treeCollision, dFloat intersection, dFloat* const normal, int faceId, void* const usedData);
 	typedef dFloat (*NewtonHeightFieldRayCastCallback) (const NewtonBody* const body, const NewtonCollision* const heightFieldCollision, dFloat intersection, int row, int col, dFloat* const normal, int faceId, void* const usedData);
+	typedef void (*NewtonHeightFieldTilePageInCallback) (void* const userData, int x0, int z0, int width, int height, void* const elevation, char* const attributes);
 
 	typedef void (*NewtonCollisionCopyConstructionCallback) (const NewtonWorld* const newtonWorld, NewtonCollision* const collision, const NewtonCollision* const sourceCollision);
 	typedef void (*NewtonCollisionDestructorCallback) (const NewtonWorld* const newtonWorld, const NewtonCollision* const collision);
@@ -443,6 +484,7 @@ extern "C" {
 	typedef void (*NewtonConstraintDestructor) (const NewtonJoint* const me);
 
 	typedef void (*NewtonJobTask) (NewtonWorld* const world, void* const userData, int threadIndex);
+	typedef void (*NewtonBodyStateCallback) (void* const userData, int bodyID, const dFloat* const matrix, const dFloat* const veloc, const dFloat* const omega);
 	typedef int (*NewtonReportProgress) (dFloat normalizedProgressPercent, void* const userData);
 
 	// **********************************************************************************************
@@ -486,6 +528,12 @@ extern "C" {
 	NEWTON_API void NewtonSetParallelSolverOnLargeIsland (const NewtonWorld* const newtonWorld, int mode);
 	NEWTON_API int NewtonGetParallelSolverOnLargeIsland (const NewtonWorld* const newtonWorld);
 
+	NEWTON_API void NewtonSetSolverCompactRows (const NewtonWorld* const newtonWorld, int mode);
+	NEWTON_API int NewtonGetSolverCompactRows (const NewtonWorld* const newtonWorld);
+
+	NEWTON_API void NewtonSetDeterministicMode (const NewtonWorld* const newtonWorld, int mode);
+	NEWTON_API int NewtonGetDeterministicMode (const NewtonWorld* const newtonWorld);
+
 	NEWTON_API int NewtonGetBroadphaseAlgorithm (const NewtonWorld* const newtonWorld);
 	NEWTON_API void NewtonSelectBroadphaseAlgorithm (const NewtonWorld* const newtonWorld, int algorithmType);
 	NEWTON_API void NewtonResetBroadphase(const NewtonWorld* const newtonWorld);
@@ -493,19 +541,30 @@ extern "C" {
 	NEWTON_API void NewtonUpdate (const NewtonWorld* const newtonWorld, dFloat timestep);
 	NEWTON_API void NewtonUpdateAsync (const NewtonWorld* const newtonWorld, dFloat timestep);
 	NEWTON_API void NewtonWaitForUpdateToFinish (const NewtonWorld* const newtonWorld);
+	NEWTON_API void NewtonUpdateWorlds (const NewtonWorld* const* const newtonWorlds, int count, dFloat timestep);
 
 	NEWTON_API int NewtonGetNumberOfSubsteps (const NewtonWorld* const newtonWorld);
 	NEWTON_API void NewtonSetNumberOfSubsteps (const NewtonWorld* const newtonWorld, int subSteps);
 	NEWTON_API dFloat NewtonGetLastUpdateTime (const NewtonWorld* const newtonWorld);
 
 	NEWTON_API void NewtonSerializeToFile (const NewtonWorld* const newtonWorld, const char* const filename, NewtonOnBodySerializationCallback bodyCallback, void* const bodyUserData);
-	NEWTON_API void NewtonDeserializeFromFile (const NewtonWorld* const newtonWorld, const char* const filename, NewtonOnBodyDeserializationCallback bodyCallback, void* const bodyUserData);
+	NEWTON_API int NewtonDeserializeFromFile (const NewtonWorld* const newtonWorld, const char* const filename, NewtonOnBodyDeserializationCallback bodyCallback, void* const bodyUserData);
+	NEWTON_API void NewtonSetSerializationCompression (const NewtonWorld* const newtonWorld, int level);
+	NEWTON_API int NewtonGetSerializationCompression (const NewtonWorld* const newtonWorld);
 
 	NEWTON_API void NewtonSerializeScene(const NewtonWorld* const newtonWorld, NewtonOnBodySerializationCallback bodyCallback, void* const bodyUserData,
 									   	 NewtonSerializeCallback serializeCallback, void* const serializeHandle);
 	NEWTON_API void NewtonDeserializeScene(const NewtonWorld* const newtonWorld, NewtonOnBodyDeserializationCallback bodyCallback, void* const bodyUserData,
 										   NewtonDeserializeCallback serializeCallback, void* const serializeHandle);
 
+	NEWTON_API int NewtonGetSnapshotSize (const NewtonWorld* const newtonWorld);
+	NEWTON_API int NewtonSaveSnapshot (const NewtonWorld* const newtonWorld, void* const buffer, int bufferSizeInBytes);
+	NEWTON_API int NewtonRestoreSnapshot (const NewtonWorld* const newtonWorld, const void* const buffer, int bufferSizeInBytes);
+
+	NEWTON_API int NewtonEncodeBodyStates (const NewtonWorld* const newtonWorld, unsigned generation, dFloat positionStep, dFloat velocityStep, const void* const baseline, int baselineSizeInBytes, void* const buffer, int bufferSizeInBytes);
+	NEWTON_API int NewtonDecodeBodyStates (const void* const baseline, int baselineSizeInBytes, const void* const packet, int packetSizeInBytes, NewtonBodyStateCallback callback, void* const userData);
+	NEWTON_API int NewtonMergeBodyStates (const void* const baseline, int baselineSizeInBytes, const void* const packet, int packetSizeInBytes, void* const buffer, int bufferSizeInBytes);
+
 	NEWTON_API NewtonBody* NewtonFindSerializedBody(const NewtonWorld* const newtonWorld, int bodySerializedID);
 	NEWTON_API void NewtonSetJointSerializationCallbacks (const NewtonWorld* const newtonWorld, NewtonOnJointSerializationCallback serializeJoint, NewtonOnJointDeserializationCallback deserializeJoint);
 	NEWTON_API void NewtonGetJointSerializationCallbacks (const NewtonWorld* const newtonWorld, NewtonOnJointSerializationCallback* const serializeJoint, NewtonOnJointDeserializationCallback* const deserializeJoint);
@@ -519,6 +578,12 @@ extern "C" {
 	NEWTON_API void NewtonDispachThreadJob(const NewtonWorld* const newtonWorld, NewtonJobTask task, void* const usedData, const char* const functionName);
 	NEWTON_API void NewtonSyncThreadJobs(const NewtonWorld* const newtonWorld);
 
+	NEWTON_API NewtonScheduler* NewtonCreateScheduler (int threads);
+	NEWTON_API void NewtonDestroyScheduler (const NewtonScheduler* const scheduler);
+	NEWTON_API int NewtonSchedulerGetThreadsCount (const NewtonScheduler* const scheduler);
+	NEWTON_API void NewtonWorldSetScheduler (const NewtonWorld* const newtonWorld, const NewtonScheduler* const scheduler);
+	NEWTON_API NewtonScheduler* NewtonWorldGetScheduler (const NewtonWorld* const newtonWorld);
+
 	// atomic operations
 	NEWTON_API int NewtonAtomicAdd (int* const ptr, int value);
 	NEWTON_API int NewtonAtomicSwap (int* const ptr, int value);
@@ -553,8 +618,19 @@ extern "C" {
 	NEWTON_API void NewtonWorldRayCast (const NewtonWorld* const newtonWorld, const dFloat* const p0, const dFloat* const p1, NewtonWorldRayFilterCallback filter, void* const userData, NewtonWorldRayPrefilterCallback prefilter, int threadIndex);
 	NEWTON_API int NewtonWorldConvexCast (const NewtonWorld* const newtonWorld, const dFloat* const matrix, const dFloat* const target, const NewtonCollision* const shape, dFloat* const param, void* const userData, NewtonWorldRayPrefilterCallback prefilter, NewtonWorldConvexCastReturnInfo* const info, int maxContactsCount, int threadIndex);
 	NEWTON_API int NewtonWorldCollide (const NewtonWorld* const newtonWorld, const dFloat* const matrix, const NewtonCollision* const shape, void* const userData, NewtonWorldRayPrefilterCallback prefilter, NewtonWorldConvexCastReturnInfo* const info, int maxContactsCount, int threadIndex);
+	NEWTON_API void NewtonWorldConvexCastBatch (const NewtonWorld* const newtonWorld, const NewtonWorldShapeQuery* const queries, int queryCount, NewtonWorldRayPrefilterCallback prefilter, dFloat* const params, int* const contactCounts, NewtonWorldConvexCastReturnInfo* const info, int maxContactsPerQuery, int threadIndex);
+	NEWTON_API void NewtonWorldCollideBatch (const NewtonWorld* const newtonWorld, const NewtonWorldShapeQuery* const queries, int queryCount, NewtonWorldRayPrefilterCallback prefilter, int* const contactCounts, NewtonWorldConvexCastReturnInfo* const info, int maxContactsPerQuery, int threadIndex);
+
+	NEWTON_API NewtonSpatialQuery* NewtonCreateSpatialQuery (const NewtonWorld* const newtonWorld, dFloat padding);
+	NEWTON_API void NewtonDestroySpatialQuery (const NewtonSpatialQuery* const query);
+	NEWTON_API void NewtonSpatialQueryForEachBodyInAABBDo (const NewtonSpatialQuery* const query, const dFloat* const p0, const dFloat* const p1, NewtonBodyIterator callback, void* const userData);
+	NEWTON_API int NewtonSpatialQueryConvexCast (const NewtonSpatialQuery* const query, const dFloat* const matrix, const dFloat* const target, const NewtonCollision* const shape, dFloat* const param, void* const userData, NewtonWorldRayPrefilterCallback prefilter, NewtonWorldConvexCastReturnInfo* const info, int maxContactsCount, int threadIndex);
 	
 	// world utility functions
+	NEWTON_API const NewtonTriggerEvent* NewtonWorldGetTriggerEvents(const NewtonWorld* const newtonWorld, int* const eventCount);
+	NEWTON_API void NewtonWorldSetContactEventMask(const NewtonWorld* const newtonWorld, int eventMask);
+	NEWTON_API int NewtonWorldGetContactEventMask(const NewtonWorld* const newtonWorld);
+	NEWTON_API const NewtonContactEvent* NewtonWorldGetContactEvents(const NewtonWorld* const newtonWorld, int* const eventCount);
 	NEWTON_API int NewtonWorldGetBodyCount(const NewtonWorld* const newtonWorld);
 	NEWTON_API int NewtonWorldGetConstraintCount(const NewtonWorld* const newtonWorld);
 
@@ -600,6 +676,10 @@ extern "C" {
 	NEWTON_API NewtonBody* NewtonWorldGetFirstBody (const NewtonWorld* const newtonWorld);
 	NEWTON_API NewtonBody* NewtonWorldGetNextBody (const NewtonWorld* const newtonWorld, const NewtonBody* const curBody);
 
+	NEWTON_API unsigned NewtonWorldGetStateGeneration (const NewtonWorld* const newtonWorld);
+	NEWTON_API NewtonBody* NewtonWorldGetFirstChangedBody (const NewtonWorld* const newtonWorld, unsigned generation);
+	NEWTON_API NewtonBody* NewtonWorldGetNextChangedBody (const NewtonWorld* const newtonWorld, const NewtonBody* const curBody, unsigned generation);
+
 
 	// **********************************************************************************************
 	//
@@ -677,6 +757,7 @@ extern "C" {
 	NEWTON_API void NewtonCompoundCollisionRemoveSubCollision (NewtonCollision* const compoundCollision, const void* const collisionNode);	
 	NEWTON_API void NewtonCompoundCollisionRemoveSubCollisionByIndex (NewtonCollision* const compoundCollision, int nodeIndex);	
 	NEWTON_API void NewtonCompoundCollisionSetSubCollisionMatrix (NewtonCollision* const compoundCollision, const void* const collisionNode, const dFloat* const matrix);	
+	NEWTON_API void NewtonCompoundCollisionSetSubCollisionMatrixArray (NewtonCollision* const compoundCollision, void* const* const collisionNodeArray, const dFloat* const matrixArray, int count);	
 	NEWTON_API void NewtonCompoundCollisionEndAddRemove (NewtonCollision* const compoundCollision);	
 
 	NEWTON_API void* NewtonCompoundCollisionGetFirstNode (NewtonCollision* const compoundCollision);
@@ -755,6 +836,9 @@ extern "C" {
 		NewtonUserMeshCollisionGetFacesInAABB facesInAABBCallback, NewtonOnUserCollisionSerializationCallback serializeCallback, int shapeID);
 
 	NEWTON_API int NewtonUserMeshCollisionContinuousOverlapTest (const NewtonUserMeshCollisionCollideDesc* const collideDescData, const void* const continueCollisionHandle, const dFloat* const minAabb, const dFloat* const maxAabb);
+	NEWTON_API void NewtonUserMeshCollisionSetRegionPadding (const NewtonCollision* const userMeshCollision, dFloat padding);
+	NEWTON_API dFloat NewtonUserMeshCollisionGetRegionPadding (const NewtonCollision* const userMeshCollision);
+	NEWTON_API void NewtonUserMeshCollisionFlushRegions (const NewtonCollision* const userMeshCollision);
 	
 	//  ***********************************************************************************************************
 	//
@@ -772,6 +856,10 @@ extern "C" {
 	// **********************************************************************************************
 	NEWTON_API NewtonCollision* NewtonCreateHeightFieldCollision (const NewtonWorld* const newtonWorld, int width, int height, int gridsDiagonals, int elevationdatType, const void* const elevationMap, const char* const attributeMap, dFloat verticalScale, dFloat horizontalScale_x, dFloat horizontalScale_z, int shapeID);
 	NEWTON_API void NewtonHeightFieldSetUserRayCastCallback (const NewtonCollision* const heightfieldCollision, NewtonHeightFieldRayCastCallback rayHitCallback);
+	NEWTON_API NewtonCollision* NewtonCreateTiledHeightFieldCollision (const NewtonWorld* const newtonWorld, int width, int height, int tileSize, int maxResidentTiles, int gridsDiagonals, int elevationdatType, dFloat minElevation, dFloat maxElevation, dFloat verticalScale, dFloat horizontalScale_x, dFloat horizontalScale_z, NewtonHeightFieldTilePageInCallback pageInCallback, void* const pageInUserData, int shapeID);
+	NEWTON_API void NewtonHeightFieldSetTilePageInCallback (const NewtonCollision* const heightfieldCollision, NewtonHeightFieldTilePageInCallback pageInCallback, void* const pageInUserData);
+	NEWTON_API int NewtonHeightFieldGetResidentTileCount (const NewtonCollision* const heightfieldCollision);
+	NEWTON_API void NewtonHeightFieldFlushTiles (const NewtonCollision* const heightfieldCollision);
 
 	NEWTON_API NewtonCollision* NewtonCreateTreeCollision (const NewtonWorld* const newtonWorld, int shapeID);
 	NEWTON_API NewtonCollision* NewtonCreateTreeCollisionFromMesh (const NewtonWorld* const newtonWorld, const NewtonMesh* const mesh, int shapeID);
@@ -780,6 +868,11 @@ extern "C" {
 	NEWTON_API void NewtonTreeCollisionBeginBuild (const NewtonCollision* const treeCollision);
 	NEWTON_API void NewtonTreeCollisionAddFace (const NewtonCollision* const treeCollision, int vertexCount, const dFloat* const vertexPtr, int strideInBytes, int faceAttribute);
 	NEWTON_API void NewtonTreeCollisionEndBuild (const NewtonCollision* const treeCollision, int optimize);
+	NEWTON_API void NewtonTreeCollisionEndBuildWithLayout (const NewtonCollision* const treeCollision, int optimize, int nodeLayout);
+	NEWTON_API int NewtonTreeCollisionGetNodeLayout (const NewtonCollision* const treeCollision);
+	NEWTON_API void NewtonTreeCollisionSetBuildProgressCallback (const NewtonCollision* const treeCollision, NewtonReportProgress reportProgressCallback, void* const reportProgressUserData);
+	NEWTON_API void NewtonTreeCollisionSerializeImage (const NewtonCollision* const treeCollision, NewtonSerializeCallback serializeFunction, void* const serializeHandle);
+	NEWTON_API NewtonCollision* NewtonCreateTreeCollisionFromImage (const NewtonWorld* const newtonWorld, const void* const image, dLong imageSizeInBytes, int shapeID);
 
 	NEWTON_API int NewtonTreeCollisionGetFaceAttribute (const NewtonCollision* const treeCollision, const int* const faceIndexArray, int indexCount); 
 	NEWTON_API void NewtonTreeCollisionSetFaceAttribute (const NewtonCollision* const treeCollision, const int* const faceIndexArray, int indexCount, int attribute);
@@ -796,6 +889,7 @@ extern "C" {
 	//
 	// **********************************************************************************************
 	NEWTON_API NewtonCollision* NewtonCollisionCreateInstance (const NewtonCollision* const collision);
+	NEWTON_API NewtonCollision* NewtonCollisionCreateSharedInstance (const NewtonWorld* const newtonWorld, const NewtonCollision* const collision);
 	NEWTON_API int NewtonCollisionGetType (const NewtonCollision* const collision);
 	NEWTON_API int NewtonCollisionIsConvexShape (const NewtonCollision* const collision);
 	NEWTON_API int NewtonCollisionIsStaticShape (const NewtonCollision* const collision);
@@ -835,6 +929,10 @@ extern "C" {
 		const NewtonCollision* const collisionB, const dFloat* const matrixB,
 		dFloat* const contactA, dFloat* const contactB, dFloat* const normalAB, int threadIndex);
 
+	NEWTON_API void NewtonCollisionClosestPointBatch (const NewtonWorld* const newtonWorld, 
+		const NewtonWorldShapeQuery* const queriesA, const NewtonWorldShapeQuery* const queriesB, int queryCount,
+		dFloat* const contactsA, dFloat* const contactsB, dFloat* const normalsAB, int* const results, int threadIndex);
+
 	NEWTON_API int NewtonCollisionCollide (const NewtonWorld* const newtonWorld, int maxSize,
 		const NewtonCollision* const collisionA, const dFloat* const matrixA, 
 		const NewtonCollision* const collisionB, const dFloat* const matrixB,
@@ -895,6 +993,8 @@ extern "C" {
 	NEWTON_API int NewtonBodyGetType (const NewtonBody* const body);
 	NEWTON_API int NewtonBodyGetCollidable (const NewtonBody* const body);
 	NEWTON_API void NewtonBodySetCollidable (const NewtonBody* const body, int collidableState);
+	NEWTON_API int NewtonBodyGetTriggerVolume (const NewtonBody* const body);
+	NEWTON_API void NewtonBodySetTriggerVolume (const NewtonBody* const body, int state);
 
 	NEWTON_API void  NewtonBodyAddForce (const NewtonBody* const body, const dFloat* const force);
 	NEWTON_API void  NewtonBodyAddTorque (const NewtonBody* const body, const dFloat* const torque);
@@ -945,6 +1045,7 @@ extern "C" {
 	NEWTON_API NewtonApplyForceAndTorque NewtonBodyGetForceAndTorqueCallback (const NewtonBody* const body);
 
 	NEWTON_API int NewtonBodyGetID (const NewtonBody* const body);
+	NEWTON_API unsigned NewtonBodyGetStateGeneration (const NewtonBody* const body);
 
 	NEWTON_API void  NewtonBodySetUserData (const NewtonBody* const body, void* const userData);
 	NEWTON_API void* NewtonBodyGetUserData (const NewtonBody* const body);
@@ -38,6 +38,8 @@ void Newton::DefaultFreeMemory (void* const ptr, dgInt32 size)
 Newton::Newton (dgMemoryAllocator* const allocator)
 	:dgWorld(allocator) 
 	,m_destructor(NULL)
+	,m_sharedWorlds(allocator)
+	,m_sharedReferenceCount(1)
 {
 }
 
@@ -48,6 +50,40 @@ Newton::~Newton ()
 	}
 }
 
+// the source world owns the memory of the shapes this world instances, so it is kept alive until this world is destroyed
+void Newton::AddSharedWorld (Newton* const sourceWorld)
+{
+	dgAssert (sourceWorld != this);
+	if (!m_sharedWorlds.Find (sourceWorld)) {
+		m_sharedWorlds.Insert (sourceWorld, sourceWorld);
+		dgAtomicExchangeAndAdd (&sourceWorld->m_sharedReferenceCount, 1);
+	}
+}
+
+void Newton::Destroy (Newton* const world)
+{
+	// the last of the owner and the worlds using its shapes deletes the world
+	if (dgAtomicExchangeAndAdd (&world->m_sharedReferenceCount, -1) > 1) {
+		return;
+	}
+
+	dgInt32 count = 0;
+	dgStack<Newton*> sharedWorlds (world->m_sharedWorlds.GetCount() + 1);
+	dgTree<Newton*, const Newton*>::Iterator iter (world->m_sharedWorlds);
+	for (iter.Begin(); iter; iter ++) {
+		sharedWorlds[count] = iter.GetNode()->GetInfo();
+		count ++;
+	}
+
+	dgMemoryAllocator* const allocator = world->dgWorld::GetAllocator();
+	delete world;
+	delete allocator;
+
+	for (dgInt32 i = 0; i < count; i ++) {
+		Destroy (sharedWorlds[i]);
+	}
+}
+
 void Newton::UpdatePhysics (dgFloat32 timestep)
 {
 	Update (timestep);
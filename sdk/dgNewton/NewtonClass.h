@@ -41,7 +41,12 @@ class Newton: public dgWorld
 	static void* DefaultAllocMemory (dgInt32 size);
 	static void DefaultFreeMemory (void* const ptr, dgInt32 size);
 
+	void AddSharedWorld (Newton* const sourceWorld);
+	static void Destroy (Newton* const world);
+
 	NewtonWorldDestructorCallback m_destructor;
+	dgTree<Newton*, const Newton*> m_sharedWorlds;
+	dgInt32 m_sharedReferenceCount;
 };
 
 
@@ -23,6 +23,7 @@
 #include "dgWorldBase.h"
 
 
+#ifndef DG_STATIC_SOLVER_PLUGIN
 // This is an example of an exported function.
 dgWorldPlugin* GetPlugin(dgWorld* const world, dgMemoryAllocator* const allocator)
 {
@@ -89,6 +90,7 @@ dgWorldPlugin* GetPlugin(dgWorld* const world, dgMemoryAllocator* const allocato
 	return &module;
 #endif
 }
+#endif
 
 dgWorldBase::dgWorldBase(dgWorld* const world, dgMemoryAllocator* const allocator)
 	:dgWorldPlugin(world, allocator)
@@ -24,12 +24,15 @@
 #include "dgNewtonPluginStdafx.h"
 #include "dgSolver.h"
 
+// when compiled into the core library the plugin entry point is not exported
+#ifndef DG_STATIC_SOLVER_PLUGIN
 #ifdef __cplusplus 
 extern "C"
 {
 	NEWTONCPU_API dgWorldPlugin* GetPlugin(dgWorld* const world, dgMemoryAllocator* const allocator);
 }
 #endif
+#endif
 
 
 class dgWorldBase: public dgWorldPlugin, public dgSolver
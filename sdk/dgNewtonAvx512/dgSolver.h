@@ -0,0 +1,468 @@
+/* Copyright (c) <2003-2019> <Julio Jerez, Newton Game Dynamics>
+* 
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* 
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef _DG_SOLVER_H_
+#define _DG_SOLVER_H_
+
+
+#include "dgPhysicsStdafx.h"
+#include <immintrin.h>
+
+#define DG_SOA_WORD_GROUP_SIZE	16 
+
+#ifdef _NEWTON_USE_DOUBLE
+	DG_MSC_AVX512_ALIGMENT
+	class dgSoaFloat
+	{
+		public:
+		DG_INLINE dgSoaFloat()
+		{
+		}
+
+		DG_INLINE dgSoaFloat(const dgFloat32 val)
+			:m_low(_mm512_set1_pd (val))
+			,m_high(_mm512_set1_pd(val))
+		{
+		}
+
+		DG_INLINE dgSoaFloat(const __m512d low, const __m512d high)
+			:m_low(low)
+			,m_high(high)
+		{
+		}
+
+		DG_INLINE dgSoaFloat(const __mmask8 low, const __mmask8 high)
+			:m_lowInt(_mm512_maskz_set1_epi64(low, -1))
+			,m_highInt(_mm512_maskz_set1_epi64(high, -1))
+		{
+		}
+
+		DG_INLINE dgSoaFloat(const dgSoaFloat& copy)
+			:m_low(copy.m_low)
+			,m_high(copy.m_high)
+		{
+		}
+
+		DG_INLINE dgSoaFloat(const dgSoaFloat* const baseAddr, const dgSoaFloat& index)
+			:m_low(_mm512_i64gather_pd(index.m_lowInt, &(*baseAddr)[0], 8))
+			,m_high(_mm512_i64gather_pd(index.m_highInt, &(*baseAddr)[0], 8))
+		{
+		}
+
+		// gather baseAddr[index[i]] for the active lanes, inactive lanes are set to zero
+		DG_INLINE dgSoaFloat(const dgFloat32* const baseAddr, const dgSoaFloat& index, dgInt32 activeMask)
+			:m_low(_mm512_mask_i64gather_pd(_mm512_setzero_pd(), __mmask8(activeMask), index.m_lowInt, baseAddr, 8))
+			,m_high(_mm512_mask_i64gather_pd(_mm512_setzero_pd(), __mmask8(activeMask >> 8), index.m_highInt, baseAddr, 8))
+		{
+		}
+
+		// gather one integer field from an array of structures and scale it into a lane index
+		static DG_INLINE dgSoaFloat GatherIndex(const dgInt32* const baseAddr, dgInt32 strideInBytes, dgInt32 scale)
+		{
+			const __m512i offset(_mm512_mullo_epi32(_mm512_set_epi32(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0), _mm512_set1_epi32(strideInBytes)));
+			const __m512i index(_mm512_mullo_epi32(_mm512_i32gather_epi32(offset, baseAddr, 1), _mm512_set1_epi32(scale)));
+			dgSoaFloat ret;
+			ret.m_lowInt = _mm512_cvtepi32_epi64(_mm512_castsi512_si256(index));
+			ret.m_highInt = _mm512_cvtepi32_epi64(_mm512_extracti64x4_epi64(index, 1));
+			return ret;
+		}
+
+		// lanes mask of the structures in an array whose integer field is positive
+		static DG_INLINE dgInt32 GatherActiveMask(const dgInt32* const baseAddr, dgInt32 strideInBytes)
+		{
+			const __m512i offset(_mm512_mullo_epi32(_mm512_set_epi32(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0), _mm512_set1_epi32(strideInBytes)));
+			return _mm512_cmpgt_epi32_mask(_mm512_i32gather_epi32(offset, baseAddr, 1), _mm512_setzero_si512());
+		}
+
+		// gather one float field from an array of structures 
+		static DG_INLINE dgSoaFloat GatherStrided(const dgFloat32* const baseAddr, dgInt32 strideInBytes)
+		{
+			const __m512i offset(_mm512_mullo_epi32(_mm512_set_epi32(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0), _mm512_set1_epi32(strideInBytes)));
+			return dgSoaFloat(_mm512_i32gather_pd(_mm512_castsi512_si256(offset), baseAddr, 1), _mm512_i32gather_pd(_mm512_extracti64x4_epi64(offset, 1), baseAddr, 1));
+		}
+
+		DG_INLINE dgFloat32& operator[] (dgInt32 i)
+		{
+			dgAssert(i < DG_SOA_WORD_GROUP_SIZE);
+			dgAssert(i >= 0);
+			dgFloat32* const ptr = (dgFloat32*)&m_low;
+			return ptr[i];
+		}
+
+		DG_INLINE const dgFloat32& operator[] (dgInt32 i) const
+		{
+			dgAssert(i < DG_SOA_WORD_GROUP_SIZE);
+			dgAssert(i >= 0);
+			const dgFloat32* const ptr = (dgFloat32*)&m_low;
+			return ptr[i];
+		}
+
+		DG_INLINE dgSoaFloat operator+ (const dgSoaFloat& A) const
+		{
+			return dgSoaFloat (_mm512_add_pd(m_low, A.m_low), _mm512_add_pd(m_high, A.m_high));
+		}
+
+		DG_INLINE dgSoaFloat operator- (const dgSoaFloat& A) const
+		{
+			return dgSoaFloat(_mm512_sub_pd(m_low, A.m_low), _mm512_sub_pd(m_high, A.m_high));
+		}
+
+		DG_INLINE dgSoaFloat operator* (const dgSoaFloat& A) const
+		{
+			return dgSoaFloat(_mm512_mul_pd(m_low, A.m_low), _mm512_mul_pd(m_high, A.m_high));
+		}
+
+		DG_INLINE dgSoaFloat MulAdd(const dgSoaFloat& A, const dgSoaFloat& B) const
+		{
+			return dgSoaFloat(_mm512_fmadd_pd(A.m_low, B.m_low, m_low), _mm512_fmadd_pd(A.m_high, B.m_high, m_high));
+		}
+
+		DG_INLINE dgSoaFloat MulSub(const dgSoaFloat& A, const dgSoaFloat& B) const
+		{
+			return dgSoaFloat(_mm512_fnmadd_pd(A.m_low, B.m_low, m_low), _mm512_fnmadd_pd(A.m_high, B.m_high, m_high));
+		}
+
+		DG_INLINE dgSoaFloat operator> (const dgSoaFloat& A) const
+		{
+			return dgSoaFloat (_mm512_cmp_pd_mask (m_low, A.m_low, _CMP_GT_OQ), _mm512_cmp_pd_mask(m_high, A.m_high, _CMP_GT_OQ));
+		}
+
+		DG_INLINE dgSoaFloat operator< (const dgSoaFloat& A) const
+		{
+			return dgSoaFloat(_mm512_cmp_pd_mask(m_low, A.m_low, _CMP_LT_OQ), _mm512_cmp_pd_mask(m_high, A.m_high, _CMP_LT_OQ));
+		}
+
+		DG_INLINE dgSoaFloat operator| (const dgSoaFloat& A) const
+		{
+			dgSoaFloat ret;
+			ret.m_lowInt = _mm512_or_si512(m_lowInt, A.m_lowInt);
+			ret.m_highInt = _mm512_or_si512(m_highInt, A.m_highInt);
+			return ret;
+		}
+
+		DG_INLINE dgSoaFloat operator& (const dgSoaFloat& A) const
+		{
+			dgSoaFloat ret;
+			ret.m_lowInt = _mm512_and_si512(m_lowInt, A.m_lowInt);
+			ret.m_highInt = _mm512_and_si512(m_highInt, A.m_highInt);
+			return ret;
+		}
+
+		DG_INLINE dgSoaFloat GetMin(const dgSoaFloat& A) const
+		{
+			return dgSoaFloat(_mm512_min_pd(m_low, A.m_low), _mm512_min_pd(m_high, A.m_high));
+		}
+
+		DG_INLINE dgSoaFloat GetMax(const dgSoaFloat& A) const
+		{
+			return dgSoaFloat(_mm512_max_pd(m_low, A.m_low), _mm512_max_pd(m_high, A.m_high));
+		}
+
+		DG_INLINE dgFloat32 AddHorizontal() const
+		{
+			return _mm512_reduce_add_pd(_mm512_add_pd(m_low, m_high));
+		}
+
+		static DG_INLINE void FlushRegisters()
+		{
+			_mm256_zeroall ();
+		}
+
+		union
+		{
+			struct
+			{
+				__m512d m_low;
+				__m512d m_high;
+			};
+			struct
+			{
+				__m512i m_lowInt;
+				__m512i m_highInt;
+			};
+		};
+	} DG_GCC_AVX512_ALIGMENT;
+
+#else 
+	DG_MSC_AVX512_ALIGMENT
+	class dgSoaFloat
+	{
+		public:
+		DG_INLINE dgSoaFloat()
+		{
+		}
+
+		DG_INLINE dgSoaFloat(const dgFloat32 val)
+			:m_type(_mm512_set1_ps (val))
+		{
+		}
+
+		DG_INLINE dgSoaFloat(const __m512 type)
+			:m_type(type)
+		{
+		}
+
+		DG_INLINE dgSoaFloat(const __mmask16 mask)
+			:m_typeInt(_mm512_maskz_set1_epi32(mask, -1))
+		{
+		}
+
+		DG_INLINE dgSoaFloat(const dgSoaFloat& copy)
+			:m_type(copy.m_type)
+		{
+		}
+
+		DG_INLINE dgSoaFloat(const dgSoaFloat* const baseAddr, const dgSoaFloat& index)
+			:m_type(_mm512_i32gather_ps(index.m_typeInt, &(*baseAddr)[0], 4))
+		{
+		}
+
+		// gather baseAddr[index[i]] for the active lanes, inactive lanes are set to zero
+		DG_INLINE dgSoaFloat(const dgFloat32* const baseAddr, const dgSoaFloat& index, dgInt32 activeMask)
+			:m_type(_mm512_mask_i32gather_ps(_mm512_setzero_ps(), __mmask16(activeMask), index.m_typeInt, baseAddr, 4))
+		{
+		}
+
+		// gather one integer field from an array of structures and scale it into a lane index
+		static DG_INLINE dgSoaFloat GatherIndex(const dgInt32* const baseAddr, dgInt32 strideInBytes, dgInt32 scale)
+		{
+			const __m512i offset(_mm512_mullo_epi32(_mm512_set_epi32(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0), _mm512_set1_epi32(strideInBytes)));
+			dgSoaFloat ret;
+			ret.m_typeInt = _mm512_mullo_epi32(_mm512_i32gather_epi32(offset, baseAddr, 1), _mm512_set1_epi32(scale));
+			return ret;
+		}
+
+		// lanes mask of the structures in an array whose integer field is positive
+		static DG_INLINE dgInt32 GatherActiveMask(const dgInt32* const baseAddr, dgInt32 strideInBytes)
+		{
+			const __m512i offset(_mm512_mullo_epi32(_mm512_set_epi32(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0), _mm512_set1_epi32(strideInBytes)));
+			return _mm512_cmpgt_epi32_mask(_mm512_i32gather_epi32(offset, baseAddr, 1), _mm512_setzero_si512());
+		}
+
+		// gather one float field from an array of structures 
+		static DG_INLINE dgSoaFloat GatherStrided(const dgFloat32* const baseAddr, dgInt32 strideInBytes)
+		{
+			const __m512i offset(_mm512_mullo_epi32(_mm512_set_epi32(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0), _mm512_set1_epi32(strideInBytes)));
+			return _mm512_i32gather_ps(offset, baseAddr, 1);
+		}
+
+		DG_INLINE dgFloat32& operator[] (dgInt32 i)
+		{
+			dgAssert(i < DG_SOA_WORD_GROUP_SIZE);
+			dgAssert(i >= 0);
+			dgFloat32* const ptr = (dgFloat32*)&m_type;
+			return ptr[i];
+		}
+
+		DG_INLINE const dgFloat32& operator[] (dgInt32 i) const
+		{
+			dgAssert(i < DG_SOA_WORD_GROUP_SIZE);
+			dgAssert(i >= 0);
+			const dgFloat32* const ptr = (dgFloat32*)&m_type;
+			return ptr[i];
+		}
+
+		DG_INLINE dgSoaFloat operator+ (const dgSoaFloat& A) const
+		{
+			return _mm512_add_ps(m_type, A.m_type);
+		}
+
+		DG_INLINE dgSoaFloat operator- (const dgSoaFloat& A) const
+		{
+			return _mm512_sub_ps(m_type, A.m_type);
+		}
+
+		DG_INLINE dgSoaFloat operator* (const dgSoaFloat& A) const
+		{
+			return _mm512_mul_ps(m_type, A.m_type);
+		}
+
+		DG_INLINE dgSoaFloat MulAdd(const dgSoaFloat& A, const dgSoaFloat& B) const
+		{
+			return _mm512_fmadd_ps(A.m_type, B.m_type, m_type);
+		}
+
+		DG_INLINE dgSoaFloat MulSub(const dgSoaFloat& A, const dgSoaFloat& B) const
+		{
+			return _mm512_fnmadd_ps(A.m_type, B.m_type, m_type);
+		}
+
+		DG_INLINE dgSoaFloat operator> (const dgSoaFloat& A) const
+		{
+			return _mm512_cmp_ps_mask (m_type, A.m_type, _CMP_GT_OQ);
+		}
+
+		DG_INLINE dgSoaFloat operator< (const dgSoaFloat& A) const
+		{
+			return _mm512_cmp_ps_mask (m_type, A.m_type, _CMP_LT_OQ);
+		}
+
+		DG_INLINE dgSoaFloat operator| (const dgSoaFloat& A) const
+		{
+			dgSoaFloat ret;
+			ret.m_typeInt = _mm512_or_si512 (m_typeInt, A.m_typeInt);
+			return ret;
+		}
+
+		DG_INLINE dgSoaFloat operator& (const dgSoaFloat& A) const
+		{
+			dgSoaFloat ret;
+			ret.m_typeInt = _mm512_and_si512 (m_typeInt, A.m_typeInt);
+			return ret;
+		}
+
+		DG_INLINE dgSoaFloat GetMin(const dgSoaFloat& A) const
+		{
+			return _mm512_min_ps (m_type, A.m_type);
+		}
+
+		DG_INLINE dgSoaFloat GetMax(const dgSoaFloat& A) const
+		{
+			return _mm512_max_ps (m_type, A.m_type);
+		}
+
+		DG_INLINE dgFloat32 AddHorizontal() const
+		{
+			return _mm512_reduce_add_ps(m_type);
+		}
+
+		static DG_INLINE void FlushRegisters()
+		{
+			_mm256_zeroall ();
+		}
+
+		union
+		{
+			__m512 m_type;
+			__m512i m_typeInt;
+		};
+	} DG_GCC_AVX512_ALIGMENT;
+#endif
+
+DG_MSC_AVX512_ALIGMENT
+class dgSoaVector3
+{
+	public:
+	dgSoaFloat m_x;
+	dgSoaFloat m_y;
+	dgSoaFloat m_z;
+} DG_GCC_AVX512_ALIGMENT;
+
+
+DG_MSC_AVX512_ALIGMENT
+class dgSoaVector6
+{
+	public:
+	dgSoaVector3 m_linear;
+	dgSoaVector3 m_angular;
+} DG_GCC_AVX512_ALIGMENT;
+
+DG_MSC_AVX512_ALIGMENT
+class dgSoaJacobianPair
+{
+	public:
+	dgSoaVector6 m_jacobianM0;
+	dgSoaVector6 m_jacobianM1;
+} DG_GCC_AVX512_ALIGMENT;
+
+DG_MSC_AVX512_ALIGMENT
+class dgSoaMatrixElement
+{
+	public:
+	dgSoaJacobianPair m_Jt;
+	dgSoaJacobianPair m_JMinv;
+
+	dgSoaFloat m_force;
+	dgSoaFloat m_diagDamp;
+	dgSoaFloat m_invJinvMJt;
+	dgSoaFloat m_coordenateAccel;
+	dgSoaFloat m_normalForceIndex;
+	dgSoaFloat m_lowerBoundFrictionCoefficent;
+	dgSoaFloat m_upperBoundFrictionCoefficent;
+} DG_GCC_AVX512_ALIGMENT;
+
+DG_MSC_AVX512_ALIGMENT
+class dgSolver: public dgParallelBodySolver
+{
+	public:
+	dgSolver(dgWorld* const world, dgMemoryAllocator* const allocator);
+	~dgSolver();
+	void CalculateJointForces(const dgBodyCluster& cluster, dgBodyInfo* const bodyArray, dgJointInfo* const jointArray, dgFloat32 timestep);
+
+	private:
+	void InitWeights();
+	void InitBodyArray();
+	void InitSkeletons();
+	void CalculateForces();
+	void UpdateSkeletons();
+	void InitJacobianMatrix();
+	void UpdateForceFeedback();
+	void CalculateJointsForce();
+	void IntegrateBodiesVelocity();
+	void UpdateKinematicFeedback();
+	void CalculateJointsAcceleration();
+	void CalculateBodiesAcceleration();
+	
+	void InitBodyArray(dgInt32 threadID);
+	void InitSkeletons(dgInt32 threadID);
+	void UpdateSkeletons(dgInt32 threadID);
+	void InitJacobianMatrix(dgInt32 threadID);
+	void UpdateForceFeedback(dgInt32 threadID);
+	void TransposeMassMatrix(dgInt32 threadID);
+	void CalculateJointsForce(dgInt32 threadID);
+	void UpdateRowAcceleration(dgInt32 threadID);
+	void IntegrateBodiesVelocity(dgInt32 threadID);
+	void UpdateKinematicFeedback(dgInt32 threadID);
+	void CalculateJointsAcceleration(dgInt32 threadID);
+	void CalculateBodiesAcceleration(dgInt32 threadID);
+
+	static void InitBodyArrayKernel(void* const context, void* const, dgInt32 threadID);
+	static void InitSkeletonsKernel(void* const context, void* const, dgInt32 threadID);
+	static void UpdateSkeletonsKernel(void* const context, void* const, dgInt32 threadID);
+	static void InitJacobianMatrixKernel(void* const context, void* const, dgInt32 threadID);
+	static void UpdateForceFeedbackKernel(void* const context, void* const, dgInt32 threadID);
+	static void TransposeMassMatrixKernel(void* const context, void* const, dgInt32 threadID);
+	static void CalculateJointsForceKernel(void* const context, void* const, dgInt32 threadID);
+	static void UpdateRowAccelerationKernel(void* const context, void* const, dgInt32 threadID);
+	static void IntegrateBodiesVelocityKernel(void* const context, void* const, dgInt32 threadID);
+	static void UpdateKinematicFeedbackKernel(void* const context, void* const, dgInt32 threadID);
+	static void CalculateBodiesAccelerationKernel(void* const context, void* const, dgInt32 threadID);
+	static void CalculateJointsAccelerationKernel(void* const context, void* const, dgInt32 threadID);
+	
+	static dgInt32 CompareJointInfos(const dgJointInfo* const infoA, const dgJointInfo* const infoB, void* notUsed);
+	static dgInt32 CompareBodyJointsPairs(const dgBodyJacobianPair* const pairA, const dgBodyJacobianPair* const pairB, void* notUsed);
+
+	DG_INLINE void SortWorkGroup(dgInt32 base) const;
+	DG_INLINE void TransposeRow (dgSoaMatrixElement* const row, const dgJointInfo* const jointInfoArray, dgInt32 index);
+	DG_INLINE void BuildJacobianMatrix(dgJointInfo* const jointInfo, dgLeftHandSide* const leftHandSide, dgRightHandSide* const righHandSide, dgJacobian* const internalForces);
+	//	DG_INLINE dgFloat32 CalculateJointForce(const dgJointInfo* const jointInfo, dgSoaMatrixElement* const massMatrix, const dgJacobian* const internalForces) const;
+	dgFloat32 CalculateJointForce(const dgJointInfo* const jointInfo, dgSoaMatrixElement* const massMatrix, const dgJacobian* const internalForces) const;
+
+	dgSoaFloat m_soaOne;
+	dgSoaFloat m_soaZero;
+	dgVector m_zero;
+	dgVector m_negOne;
+	dgArray<dgSoaMatrixElement> m_massMatrix;
+} DG_GCC_AVX512_ALIGMENT;
+
+
+#endif
+
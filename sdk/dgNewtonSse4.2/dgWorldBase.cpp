@@ -23,6 +23,7 @@
 #include "dgWorldBase.h"
 
 
+#ifndef DG_STATIC_SOLVER_PLUGIN
 // This is an example of an exported function.
 dgWorldPlugin* GetPlugin(dgWorld* const world, dgMemoryAllocator* const allocator)
 {
@@ -80,6 +81,7 @@ dgWorldPlugin* GetPlugin(dgWorld* const world, dgMemoryAllocator* const allocato
 	return NULL;
 #endif
 }
+#endif
 
 dgWorldBase::dgWorldBase(dgWorld* const world, dgMemoryAllocator* const allocator)
 	:dgWorldPlugin(world, allocator)
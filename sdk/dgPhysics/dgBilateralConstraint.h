@@ -88,6 +88,7 @@ class dgBilateralConstraint: public dgConstraint
 	dgBilateralConstraintList::dgListNode* m_jointNode;
 	dgInt8	  m_rowIsMotor;
 
+	friend class dgWorld;
 	friend class dgBodyMasterList;
 	friend class dgWorldDynamicUpdate;
 };
@@ -72,6 +72,7 @@ dgBody::dgBody()
 	,m_serializedEnum(-1)
 	,m_dynamicsLru(0)
 	,m_genericLRUMark(0)
+	,m_stateGeneration(0)
 {
 	m_autoSleep = true;
 	m_collidable = true;
@@ -119,6 +120,7 @@ dgBody::dgBody (dgWorld* const world, const dgTree<const dgCollision*, dgInt32>*
 	,m_serializedEnum(-1)
 	,m_dynamicsLru(0)
 	,m_genericLRUMark(0)
+	,m_stateGeneration(0)
 {
 	m_autoSleep = true;
 	m_collidable = true;
@@ -244,6 +246,7 @@ void dgBody::UpdateWorlCollisionMatrix() const
 void dgBody::UpdateCollisionMatrix (dgFloat32 timestep, dgInt32 threadIndex)
 {
 	m_transformIsDirty = true;
+	m_stateGeneration = m_world->m_stateGeneration;
 	m_collision->SetGlobalMatrix (m_collision->GetLocalMatrix() * m_matrix);
 	m_collision->CalcAABB (m_collision->GetGlobalMatrix(), m_minAABB, m_maxAABB);
 
@@ -414,6 +417,23 @@ void dgBody::SetFreeze (bool state)
 	}
 }
 
+void dgBody::SetTrigger (bool state)
+{
+	if (m_isTrigger != dgUnsigned32 (state)) {
+		m_isTrigger = dgUnsigned32 (state);
+		// existing pairs were made for the other kind of body, let the next update make them again
+		if (m_masterNode) {
+			for (dgBodyMasterListRow::dgListNode* node = m_masterNode->GetInfo().GetFirst(); node; node = node->GetNext()) {
+				dgConstraint* const joint = node->GetInfo().m_joint;
+				if (joint && (joint->GetId() == dgConstraint::m_contactConstraint)) {
+					dgContact* const contactJoint = (dgContact*)joint;
+					contactJoint->m_killContact = 1;
+				}
+			}
+		}
+	}
+}
+
 
 void dgBody::Freeze ()
 {
@@ -138,12 +138,16 @@ class dgBody
 	dgUnsigned32 GetGroupID () const;
 	virtual void SetGroupID (dgUnsigned32 id);
 	dgInt32 GetUniqueID () const;
+	dgUnsigned32 GetStateGeneration () const;
 
 	bool GetContinueCollisionMode () const;
 	void SetContinueCollisionMode (bool mode);
 	bool GetCollisionWithLinkedBodies () const;
 	void SetCollisionWithLinkedBodies (bool state);
 
+	bool IsTrigger () const;
+	void SetTrigger (bool state);
+
 	void Freeze ();
 	void Unfreeze ();
 	bool GetFreeze () const;
@@ -290,6 +294,7 @@ class dgBody
 			dgUnsigned32 m_transformIsDirty			: 1;
 			dgUnsigned32 m_gyroTorqueOn				: 1;
 			dgUnsigned32 m_isdead					: 1;
+			dgUnsigned32 m_isTrigger				: 1;
 		};
 	};
 
@@ -311,13 +316,16 @@ class dgBody
 	dgInt32 m_serializedEnum;
 	dgUnsigned32 m_dynamicsLru;
 	dgUnsigned32 m_genericLRUMark;
+	dgUnsigned32 m_stateGeneration;
 
 	friend class dgWorld;
 	friend class dgSolver;
+	DG_STATIC_SOLVER_FRIENDS
 	friend class dgContact;
 	friend class dgConstraint;
 	friend class dgDeadBodies;
 	friend class dgBroadPhase;
+	friend class dgContactList;
 	friend class dgCollisionBVH;
 	friend class dgBroadPhaseNode;
 	friend class dgBodyMasterList;
@@ -332,6 +340,7 @@ class dgBody
 	friend class dgBroadPhaseBodyNode;
 	friend class dgBilateralConstraint;
 	friend class dgBroadPhaseAggregate;
+	friend class dgBroadPhaseQueryCache;
 	friend class dgBroadPhaseSegregated;
 	friend class dgCollisionConvexPolygon;
 	friend class dgCollidingPairCollector;
@@ -490,6 +499,11 @@ DG_INLINE dgInt32 dgBody::GetUniqueID () const
 	return m_uniqueID;
 }
 
+DG_INLINE dgUnsigned32 dgBody::GetStateGeneration () const
+{
+	return m_stateGeneration;
+}
+
 DG_INLINE void dgBody::SetDestructorCallback (OnBodyDestroy destructor)
 {
 	m_destructor = destructor;
@@ -535,6 +549,11 @@ DG_INLINE bool dgBody::GetCollisionWithLinkedBodies () const
 	return m_collideWithLinkedBodies;
 }
 
+DG_INLINE bool dgBody::IsTrigger () const
+{
+	return m_isTrigger;
+}
+
 DG_INLINE bool dgBody::GetFreeze () const
 {
 	return m_freeze;
@@ -151,9 +151,8 @@ dgBroadPhase::dgBroadPhase(dgWorld* const world)
 	,m_updateList(world->GetAllocator())
 	,m_aggregateList(world->GetAllocator())
 	,m_lru(DG_CONTACT_DELAY_FRAMES)
+	,m_queryGeneration(0)
 	,m_contactCache(world->GetAllocator())
-	,m_pendingSoftBodyCollisions(world->GetAllocator(), 64)
-	,m_pendingSoftBodyPairsCount(0)
 	,m_criticalSectionLock(0)
 {
 }
@@ -185,6 +184,7 @@ void dgBroadPhase::MoveNodes (dgBroadPhase* const dst)
 		UnlinkAggregate(aggregate);
 		dst->LinkAggregate(aggregate);
 	}
+	dst->m_queryGeneration = m_queryGeneration + 1;
 }
 
 dgBroadPhaseTreeNode* dgBroadPhase::InsertNode(dgBroadPhaseNode* const root, dgBroadPhaseNode* const node)
@@ -735,28 +735,49 @@ void dgBroadPhase::UpdateBody(dgBody* const body, dgInt32 threadIndex)
 		if (!dgBoxInclusionTest(body1->m_minAABB, body1->m_maxAABB, node->m_minBox, node->m_maxBox)) {
 			dgAssert(!node->IsAggregate());
 			node->SetAABB(body1->m_minAABB, body1->m_maxAABB);
+			UpdateParentBoxes(node);
+			MarkNodeChanged(node);
+		}
+	}
+}
 
-			if (!m_rootNode->IsLeafNode()) {
-				const dgBroadPhaseNode* const root = (m_rootNode->GetLeft() && m_rootNode->GetRight()) ? NULL : m_rootNode;
-				for (dgBroadPhaseNode* parent = node->m_parent; parent != root; parent = parent->m_parent) {
-					dgScopeSpinPause lock(&parent->m_criticalSectionLock);
-					if (!parent->IsAggregate()) {
-						dgVector minBox;
-						dgVector maxBox;
-						dgFloat32 area = CalculateSurfaceArea(parent->GetLeft(), parent->GetRight(), minBox, maxBox);
-						if (dgBoxInclusionTest(minBox, maxBox, parent->m_minBox, parent->m_maxBox)) {
-							break;
-						}
-						parent->m_minBox = minBox;
-						parent->m_maxBox = maxBox;
-						parent->m_surfaceArea = area;
-					} else {
-						dgBroadPhaseAggregate* const aggregate = (dgBroadPhaseAggregate*)parent;
-						aggregate->m_minBox = aggregate->m_root->m_minBox;
-						aggregate->m_maxBox = aggregate->m_root->m_maxBox;
-						aggregate->m_surfaceArea = aggregate->m_root->m_surfaceArea;
-					}
+void dgBroadPhase::SetBodyNodeBox(dgBody* const body, const dgVector& minBox, const dgVector& maxBox)
+{
+	// set the padded box of a body leaf as it was saved, parents are only grown so they stay conservative
+	dgBroadPhaseBodyNode* const node = body->GetBroadPhase();
+	if (m_rootNode && node) {
+		dgAssert(!node->GetLeft());
+		dgAssert(!node->GetRight());
+		node->m_minBox = minBox;
+		node->m_maxBox = maxBox;
+		dgVector side0(maxBox - minBox);
+		node->m_surfaceArea = side0.DotProduct(side0.ShiftTripleRight()).GetScalar();
+		UpdateParentBoxes(node);
+		MarkNodeChanged(node);
+	}
+}
+
+void dgBroadPhase::UpdateParentBoxes(dgBroadPhaseNode* const node)
+{
+	if (!m_rootNode->IsLeafNode()) {
+		const dgBroadPhaseNode* const root = (m_rootNode->GetLeft() && m_rootNode->GetRight()) ? NULL : m_rootNode;
+		for (dgBroadPhaseNode* parent = node->m_parent; parent != root; parent = parent->m_parent) {
+			dgScopeSpinPause lock(&parent->m_criticalSectionLock);
+			if (!parent->IsAggregate()) {
+				dgVector minBox;
+				dgVector maxBox;
+				dgFloat32 area = CalculateSurfaceArea(parent->GetLeft(), parent->GetRight(), minBox, maxBox);
+				if (dgBoxInclusionTest(minBox, maxBox, parent->m_minBox, parent->m_maxBox)) {
+					break;
 				}
+				parent->m_minBox = minBox;
+				parent->m_maxBox = maxBox;
+				parent->m_surfaceArea = area;
+			} else {
+				dgBroadPhaseAggregate* const aggregate = (dgBroadPhaseAggregate*)parent;
+				aggregate->m_minBox = aggregate->m_root->m_minBox;
+				aggregate->m_maxBox = aggregate->m_root->m_maxBox;
+				aggregate->m_surfaceArea = aggregate->m_root->m_surfaceArea;
 			}
 		}
 	}
@@ -777,6 +798,7 @@ dgBroadPhaseNode* dgBroadPhase::BuildTopDown(dgBroadPhaseNode** const leafArray,
 		*nextNode = (*nextNode)->GetNext();
 
 		parent->SetAABB(info.m_p0, info.m_p1);
+		parent->m_lru = m_lru;
 
 		parent->m_left = BuildTopDown(leafArray, firstBox, firstBox + info.m_axis - 1, nextNode);
 		parent->m_left->m_parent = parent;
@@ -825,12 +847,25 @@ dgBroadPhaseNode* dgBroadPhase::BuildTopDownBig(dgBroadPhaseNode** const leafArr
 		dgVector minP (parent->m_left->m_minBox.GetMin(parent->m_right->m_minBox));
 		dgVector maxP (parent->m_left->m_maxBox.GetMax(parent->m_right->m_maxBox));
 		parent->SetAABB(minP, maxP);
+		parent->m_lru = m_lru;
 
 		return parent;
 	}
 }
 
 
+dgInt32 dgBroadPhase::CompareContacts(dgContact* const* const contactA, dgContact* const* const contactB, void* const)
+{
+	const CacheEntryTag keyA((*contactA)->GetBody0()->m_uniqueID, (*contactA)->GetBody1()->m_uniqueID);
+	const CacheEntryTag keyB((*contactB)->GetBody0()->m_uniqueID, (*contactB)->GetBody1()->m_uniqueID);
+	if (keyA.m_tag < keyB.m_tag) {
+		return -1;
+	} else if (keyA.m_tag > keyB.m_tag) {
+		return 1;
+	}
+	return 0;
+}
+
 dgInt32 dgBroadPhase::CompareNodes(const dgBroadPhaseNode* const nodeA, const dgBroadPhaseNode* const nodeB, void* const)
 {
 	dgFloat32 areaA = nodeA->m_surfaceArea;
@@ -875,6 +910,7 @@ void dgBroadPhase::ImproveFitness(dgFitnessList& fitness, dgFloat64& oldEntropy,
 					dgBody* const rightBody = rightNode->GetBody();
 					if (rightBody) {
 						rightNode->SetAABB(rightBody->m_minAABB, rightBody->m_maxAABB);
+						rightNode->m_lru = m_lru;
 						leafArray[leafNodesCount] = rightNode;
 						leafNodesCount++;
 					} else if (rightNode->IsAggregate()) {
@@ -895,9 +931,176 @@ void dgBroadPhase::ImproveFitness(dgFitnessList& fitness, dgFloat64& oldEntropy,
 			oldEntropy = entropy;
 		}
 		(*root)->m_parent = parent;
+		MarkNodeChanged(parent);
+	}
+}
+
+
+dgInt32 dgBroadPhase::CompareTreeNodeIndex(const dgTreeNodeIndex* const indexA, const dgTreeNodeIndex* const indexB, void* const)
+{
+	if (indexA->m_node < indexB->m_node) {
+		return -1;
+	} else if (indexA->m_node > indexB->m_node) {
+		return 1;
+	}
+	return 0;
+}
+
+dgInt32 dgBroadPhase::GetTreeStateSize(const dgFitnessList& fitness) const
+{
+	return sizeof (dgTreeState) + fitness.GetCount() * sizeof (dgTreeStateNode);
+}
+
+dgUnsigned8* dgBroadPhase::SaveTreeState(dgUnsigned8* const buffer, const dgFitnessList& fitness, dgFloat64 entropy, const dgBroadPhaseNode* const root, bool needsUpdate) const
+{
+	// tree nodes are saved in fitness list order and linked by index, leaves are saved by body
+	const dgInt32 count = fitness.GetCount();
+	dgStack<dgTreeNodeIndex> indexPool (count + 1);
+	dgTreeNodeIndex* const indexArray = &indexPool[0];
+
+	dgInt32 index = 0;
+	for (dgFitnessList::dgListNode* node = fitness.GetFirst(); node; node = node->GetNext()) {
+		indexArray[index].m_node = node->GetInfo();
+		indexArray[index].m_index = index;
+		index ++;
+	}
+	dgSort (indexArray, count, CompareTreeNodeIndex);
+
+	class dgNodeIndex
+	{
+		public:
+		dgNodeIndex (const dgTreeNodeIndex* const array, dgInt32 count)
+			:m_array(array)
+			,m_count(count)
+		{
+		}
+
+		dgInt32 Find (const dgBroadPhaseNode* const node) const
+		{
+			dgInt32 i0 = 0;
+			dgInt32 i1 = m_count - 1;
+			while (i0 < i1) {
+				const dgInt32 mid = (i0 + i1) >> 1;
+				if (m_array[mid].m_node < node) {
+					i0 = mid + 1;
+				} else {
+					i1 = mid;
+				}
+			}
+			dgAssert (m_array[i0].m_node == node);
+			return m_array[i0].m_index;
+		}
+
+		const dgTreeNodeIndex* m_array;
+		dgInt32 m_count;
+	};
+	const dgNodeIndex nodeIndex (indexArray, count);
+
+	dgTreeState* const state = (dgTreeState*) buffer;
+	state->m_entropy = entropy;
+	state->m_prevCost = fitness.m_prevCost;
+	state->m_index = fitness.m_index;
+	state->m_nodeCount = count;
+	state->m_needsUpdate = needsUpdate ? 1 : 0;
+	state->m_rootBody = (root && root->IsLeafNode()) ? root->GetBody() : NULL;
+	state->m_root = (root && !root->IsLeafNode()) ? nodeIndex.Find (root) : -1;
+
+	dgTreeStateNode* const nodeArray = (dgTreeStateNode*) &state[1];
+	index = 0;
+	for (dgFitnessList::dgListNode* node = fitness.GetFirst(); node; node = node->GetNext()) {
+		const dgBroadPhaseTreeNode* const treeNode = node->GetInfo();
+		const dgBroadPhaseNode* const left = treeNode->m_left;
+		const dgBroadPhaseNode* const right = treeNode->m_right;
+		dgTreeStateNode& entry = nodeArray[index];
+		entry.m_minBox = treeNode->m_minBox;
+		entry.m_maxBox = treeNode->m_maxBox;
+		entry.m_surfaceArea = treeNode->m_surfaceArea;
+		entry.m_leftBody = left->IsLeafNode() ? left->GetBody() : NULL;
+		entry.m_rightBody = right->IsLeafNode() ? right->GetBody() : NULL;
+		entry.m_left = left->IsLeafNode() ? -1 : nodeIndex.Find (left);
+		entry.m_right = right->IsLeafNode() ? -1 : nodeIndex.Find (right);
+		index ++;
+	}
+	return (dgUnsigned8*) &nodeArray[count];
+}
+
+const dgUnsigned8* dgBroadPhase::CheckTreeState(const dgUnsigned8* const buffer, const dgFitnessList& fitness) const
+{
+	const dgTreeState* const state = (dgTreeState*) buffer;
+	const dgInt32 count = state->m_nodeCount;
+	if (count != fitness.GetCount()) {
+		return NULL;
+	}
+
+	// every leaf must still be a body leaf, the bodies themselves are validated by the world
+	class dgCheckChild
+	{
+		public:
+		static bool IsValid (const dgBody* const body, dgInt32 index, dgInt32 count)
+		{
+			if (body) {
+				const dgBroadPhaseNode* const leaf = body->GetBroadPhase();
+				return leaf && !body->GetBroadPhaseAggregate() && (leaf->GetBody() == body);
+			}
+			return (index >= 0) && (index < count);
+		}
+	};
+
+	if ((state->m_rootBody || (state->m_root >= 0)) && !dgCheckChild::IsValid (state->m_rootBody, state->m_root, count)) {
+		return NULL;
 	}
+	const dgTreeStateNode* const nodeArray = (dgTreeStateNode*) &state[1];
+	for (dgInt32 i = 0; i < count; i ++) {
+		const dgTreeStateNode& entry = nodeArray[i];
+		if (!dgCheckChild::IsValid (entry.m_leftBody, entry.m_left, count) || !dgCheckChild::IsValid (entry.m_rightBody, entry.m_right, count)) {
+			return NULL;
+		}
+	}
+	return (dgUnsigned8*) &nodeArray[count];
 }
 
+const dgUnsigned8* dgBroadPhase::RestoreTreeState(const dgUnsigned8* const buffer, dgFitnessList& fitness, dgFloat64& entropy, dgBroadPhaseNode** const root, dgBroadPhaseNode* const rootParent, bool& needsUpdate)
+{
+	// the tree nodes are interchangeable, the one at each fitness list position takes the place of the saved node at that position
+	const dgTreeState* const state = (dgTreeState*) buffer;
+	const dgInt32 count = state->m_nodeCount;
+	dgAssert (count == fitness.GetCount());
+	m_queryGeneration ++;
+
+	dgStack<dgBroadPhaseTreeNode*> nodePool (count + 1);
+	dgBroadPhaseTreeNode** const nodes = &nodePool[0];
+	dgInt32 index = 0;
+	for (dgFitnessList::dgListNode* node = fitness.GetFirst(); node; node = node->GetNext()) {
+		nodes[index] = node->GetInfo();
+		index ++;
+	}
+
+	const dgTreeStateNode* const nodeArray = (dgTreeStateNode*) &state[1];
+	for (dgInt32 i = 0; i < count; i ++) {
+		const dgTreeStateNode& entry = nodeArray[i];
+		dgBroadPhaseTreeNode* const treeNode = nodes[i];
+		dgBroadPhaseNode* const left = entry.m_leftBody ? (dgBroadPhaseNode*)entry.m_leftBody->GetBroadPhase() : nodes[entry.m_left];
+		dgBroadPhaseNode* const right = entry.m_rightBody ? (dgBroadPhaseNode*)entry.m_rightBody->GetBroadPhase() : nodes[entry.m_right];
+		treeNode->m_minBox = entry.m_minBox;
+		treeNode->m_maxBox = entry.m_maxBox;
+		treeNode->m_surfaceArea = entry.m_surfaceArea;
+		treeNode->m_left = left;
+		treeNode->m_right = right;
+		left->m_parent = treeNode;
+		right->m_parent = treeNode;
+	}
+
+	*root = state->m_rootBody ? (dgBroadPhaseNode*)state->m_rootBody->GetBroadPhase() : ((state->m_root >= 0) ? nodes[state->m_root] : NULL);
+	if (*root) {
+		(*root)->m_parent = rootParent;
+	}
+
+	entropy = state->m_entropy;
+	fitness.m_prevCost = state->m_prevCost;
+	fitness.m_index = state->m_index;
+	needsUpdate = state->m_needsUpdate ? true : false;
+	return (dgUnsigned8*) &nodeArray[count];
+}
 
 void dgBroadPhase::RotateLeft (dgBroadPhaseTreeNode* const node, dgBroadPhaseNode** const root)
 {
@@ -918,6 +1121,7 @@ void dgBroadPhase::RotateLeft (dgBroadPhaseTreeNode* const node, dgBroadPhaseNod
 		node->m_minBox = parent->m_minBox;
 		node->m_maxBox = parent->m_maxBox;
 		node->m_surfaceArea = parent->m_surfaceArea;
+		node->m_lru = parent->m_lru;
 
 		dgBroadPhaseTreeNode* const grandParent = (dgBroadPhaseTreeNode*) parent->m_parent;
 		if (grandParent) {
@@ -940,12 +1144,14 @@ void dgBroadPhase::RotateLeft (dgBroadPhaseTreeNode* const node, dgBroadPhaseNod
 		parent->m_minBox = cost1P0;
 		parent->m_maxBox = cost1P1;
 		parent->m_surfaceArea = cost1;
+		parent->m_lru = dgMax(parent->m_left->m_lru, parent->m_right->m_lru);
 
 	} else if ((cost2 <= cost0) && (cost2 <= cost1)) {
 		//dgBroadPhaseNode* const parent = node->m_parent;
 		node->m_minBox = parent->m_minBox;
 		node->m_maxBox = parent->m_maxBox;
 		node->m_surfaceArea = parent->m_surfaceArea;
+		node->m_lru = parent->m_lru;
 
 		dgBroadPhaseTreeNode* const grandParent = (dgBroadPhaseTreeNode*) parent->m_parent;
 		if (grandParent) {
@@ -968,6 +1174,7 @@ void dgBroadPhase::RotateLeft (dgBroadPhaseTreeNode* const node, dgBroadPhaseNod
 		parent->m_minBox = cost2P0;
 		parent->m_maxBox = cost2P1;
 		parent->m_surfaceArea = cost2;
+		parent->m_lru = dgMax(parent->m_left->m_lru, parent->m_right->m_lru);
 	}
 }
 
@@ -991,6 +1198,7 @@ void dgBroadPhase::RotateRight (dgBroadPhaseTreeNode* const node, dgBroadPhaseNo
 		node->m_minBox = parent->m_minBox;
 		node->m_maxBox = parent->m_maxBox;
 		node->m_surfaceArea = parent->m_surfaceArea;
+		node->m_lru = parent->m_lru;
 
 		dgBroadPhaseTreeNode* const grandParent = (dgBroadPhaseTreeNode*) parent->m_parent;
 		if (grandParent) {
@@ -1013,12 +1221,14 @@ void dgBroadPhase::RotateRight (dgBroadPhaseTreeNode* const node, dgBroadPhaseNo
 		parent->m_minBox = cost1P0;
 		parent->m_maxBox = cost1P1;
 		parent->m_surfaceArea = cost1;
+		parent->m_lru = dgMax(parent->m_left->m_lru, parent->m_right->m_lru);
 
 	} else if ((cost2 <= cost0) && (cost2 <= cost1)) {
 		//dgBroadPhaseNode* const parent = node->m_parent;
 		node->m_minBox = parent->m_minBox;
 		node->m_maxBox = parent->m_maxBox;
 		node->m_surfaceArea = parent->m_surfaceArea;
+		node->m_lru = parent->m_lru;
 
 		dgBroadPhaseTreeNode* const grandParent = (dgBroadPhaseTreeNode*) parent->m_parent;
 		if (parent->m_parent) {
@@ -1041,6 +1251,7 @@ void dgBroadPhase::RotateRight (dgBroadPhaseTreeNode* const node, dgBroadPhaseNo
 		parent->m_minBox = cost2P0;
 		parent->m_maxBox = cost2P1;
 		parent->m_surfaceArea = cost2;
+		parent->m_lru = dgMax(parent->m_left->m_lru, parent->m_right->m_lru);
 	}
 }
 
@@ -1196,17 +1407,8 @@ void dgBroadPhase::AddPair (dgBody* const body0, dgBody* const body1, const dgFl
 			const bool isCollidable = bilateral ? bilateral->IsCollidable() : true;
 
 			if (isCollidable) {
-				dgUnsigned32 group0_ID = dgUnsigned32 (body0->m_bodyGroupId);
-				dgUnsigned32 group1_ID = dgUnsigned32 (body1->m_bodyGroupId);
-
-				if (group1_ID < group0_ID) {
-					dgSwap (group0_ID, group1_ID);
-				}
-
-				dgUnsigned32 key = (group1_ID << 16) + group0_ID;
 				const dgBodyMaterialList* const materialList = m_world;  
-				dgAssert (materialList->Find (key));
-				const dgContactMaterial* const material = &materialList->Find (key)->GetInfo();
+				const dgContactMaterial* const material = materialList->GetPairMaterial (dgUnsigned32 (body0->m_bodyGroupId), dgUnsigned32 (body1->m_bodyGroupId));
 
 				if (material->m_flags & dgContactMaterial::m_collisionEnable) {
 
@@ -1219,15 +1421,14 @@ void dgBroadPhase::AddPair (dgBody* const body0, dgBody* const body1, const dgFl
 						const dgInt32 isSofBody0 = body0->m_collision->IsType(dgCollision::dgCollisionLumpedMass_RTTI);
 						const dgInt32 isSofBody1 = body1->m_collision->IsType(dgCollision::dgCollisionLumpedMass_RTTI);
 
-						if (isSofBody0 || isSofBody1) {
-							m_pendingSoftBodyCollisions[m_pendingSoftBodyPairsCount].m_body0 = body0;
-							m_pendingSoftBodyCollisions[m_pendingSoftBodyPairsCount].m_body1 = body1;
-							m_pendingSoftBodyPairsCount++;
-						} else {
+						// soft bodies resolve their own collisions while integrating the particles, they get no contact joints
+						if (!(isSofBody0 || isSofBody1)) {
 							dgContactList& contactList = *m_world;
 							dgAtomicExchangeAndAdd(&contactList.m_contactCountReset, 1);
 							if (contactList.m_contactCount < contactList.GetElementsCapacity()) {
-								contact = new (m_world->m_allocator) dgContact(m_world, material, body0, body1);
+								// which body finds the pair depends on the shape of the tree, order them by id instead
+								const bool inOrder = body0->m_uniqueID < body1->m_uniqueID;
+								contact = new (m_world->m_allocator) dgContact(m_world, material, inOrder ? body0 : body1, inOrder ? body1 : body0);
 								dgAssert(contact);
 								contactList.Push(contact);
 							}
@@ -1462,15 +1663,6 @@ void dgBroadPhase::AddGeneratedBodiesContactsKernel (void* const context, void*
 	broadPhase->FindGeneratedBodiesCollidingPairs (descriptor, threadID);
 }
 
-void dgBroadPhase::UpdateSoftBodyContactKernel(void* const context, void* const worldContext, dgInt32 threadID)
-{
-	D_TRACKTIME();
-	dgBroadphaseSyncDescriptor* const descriptor = (dgBroadphaseSyncDescriptor*)context;
-	dgWorld* const world = descriptor->m_world;
-	dgBroadPhase* const broadPhase = world->GetBroadPhase();
-	broadPhase->UpdateSoftBodyContacts(descriptor, descriptor->m_timestep, threadID);
-}
-
 void dgBroadPhase::UpdateRigidBodyContactKernel(void* const context, void* const , dgInt32 threadID)
 {
 	D_TRACKTIME();
@@ -1480,28 +1672,6 @@ void dgBroadPhase::UpdateRigidBodyContactKernel(void* const context, void* const
 	broadPhase->UpdateRigidBodyContacts(descriptor, descriptor->m_timestep, threadID);
 }
 
-void dgBroadPhase::UpdateSoftBodyContacts(dgBroadphaseSyncDescriptor* const descriptor, dgFloat32 timeStep, dgInt32 threadID)
-{
-	dgAssert(0);
-/*
-	const dgInt32 count = m_pendingSoftBodyPairsCount;
-	for (dgInt32 i = dgAtomicExchangeAndAdd(&descriptor->m_pairsAtomicCounter, 1); i < count; i = dgAtomicExchangeAndAdd(&descriptor->m_pairsAtomicCounter, 1)) {
-		dgPendingCollisionSoftBodies& pair = m_pendingSoftBodyCollisions[i];
-		if (pair.m_body0->m_collision->IsType(dgCollision::dgCollisionLumpedMass_RTTI)) {
-			dgCollisionLumpedMassParticles* const lumpedMassShape = (dgCollisionLumpedMassParticles*)pair.m_body0->m_collision->GetChildShape();
-			dgAssert(pair.m_body0->IsRTTIType(dgBody::m_dynamicBodyRTTI));
-			dgAssert (pair.m_body0 == lumpedMassShape->GetOwner ());
-			lumpedMassShape->RegisterCollision(pair.m_body1);
-		} else if (pair.m_body1->m_collision->IsType(dgCollision::dgCollisionLumpedMass_RTTI)) {
-			dgCollisionLumpedMassParticles* const lumpedMassShape = (dgCollisionLumpedMassParticles*)pair.m_body1->m_collision->GetChildShape();
-			dgAssert(pair.m_body1->IsRTTIType(dgBody::m_dynamicBodyRTTI));
-			dgAssert (pair.m_body1 == lumpedMassShape->GetOwner ());
-			lumpedMassShape->RegisterCollision(pair.m_body0);
-		}
-	}
-*/
-}
-
 void dgBroadPhase::UpdateRigidBodyContacts(dgBroadphaseSyncDescriptor* const descriptor, dgFloat32 timeStep, dgInt32 threadID)
 {
 	DG_TRACKTIME();
@@ -1510,6 +1680,7 @@ void dgBroadPhase::UpdateRigidBodyContacts(dgBroadphaseSyncDescriptor* const des
 	const dgFloat32 timestep = descriptor->m_timestep;
 	const dgInt32 threadCount = m_world->GetThreadCount();
 	const dgUnsigned32 lru = m_lru - DG_CONTACT_DELAY_FRAMES;
+	const bool deterministic = m_world->m_deterministicMode ? true : false;
 
 	const dgInt32 contactCount = contactList.m_contactCount;
 	dgContact** const contactArray = &contactList[0];
@@ -1522,6 +1693,19 @@ void dgBroadPhase::UpdateRigidBodyContacts(dgBroadphaseSyncDescriptor* const des
 		dgBody* const body0 = contact->GetBody0();
 		dgBody* const body1 = contact->GetBody1();
 
+		if (contact->m_isTrigger) {
+			// trigger pairs only live while the two boxes overlap, they never reach the narrow phase or the solver
+			if (!contact->m_killContact) {
+				if (dgOverlapTest(body0->m_minAABB, body0->m_maxAABB, body1->m_minAABB, body1->m_maxAABB)) {
+					contact->m_isActive = 1;
+					contact->m_broadphaseLru = m_lru;
+				} else {
+					contact->m_killContact = 1;
+				}
+			}
+			continue;
+		}
+
 		if (!(contact->m_killContact | (body0->m_equilibrium & body1->m_equilibrium))) {
 			dgAssert(!contact->m_killContact);
 
@@ -1571,11 +1755,15 @@ void dgBroadPhase::UpdateRigidBodyContacts(dgBroadphaseSyncDescriptor* const des
 			}
 
 			if (isActive ^ contact->m_isActive) {
-				if (body0->GetInvMass().m_w) {
-					body0->m_equilibrium = false;
-				}
-				if (body1->GetInvMass().m_w) {
-					body1->m_equilibrium = false;
+				if (deterministic) {
+					contact->m_activationChanged = 1;
+				} else {
+					if (body0->GetInvMass().m_w) {
+						body0->m_equilibrium = false;
+					}
+					if (body1->GetInvMass().m_w) {
+						body1->m_equilibrium = false;
+					}
 				}
 			}
 
@@ -1583,7 +1771,42 @@ void dgBroadPhase::UpdateRigidBodyContacts(dgBroadphaseSyncDescriptor* const des
 			contact->m_broadphaseLru = m_lru;
 		}
 
-		contact->m_killContact = contact->m_killContact | (body0->m_equilibrium & body1->m_equilibrium & !contact->m_isActive);
+		if (!deterministic) {
+			contact->m_killContact = contact->m_killContact | (body0->m_equilibrium & body1->m_equilibrium & !contact->m_isActive);
+		}
+	}
+}
+
+void dgBroadPhase::ApplyContactActivation()
+{
+	// other threads clearing the equilibrium flag of a shared body while the contacts are still
+	// being read makes the outcome depend on the thread timing, in deterministic mode the clears
+	// are deferred to here and applied in contact order
+	dgContactList& contactList = *m_world;
+	const dgInt32 contactCount = contactList.m_contactCount;
+	dgContact** const contactArray = &contactList[0];
+	for (dgInt32 i = 0; i < contactCount; i++) {
+		dgContact* const contact = contactArray[i];
+		if (contact->m_activationChanged) {
+			dgBody* const body0 = contact->GetBody0();
+			dgBody* const body1 = contact->GetBody1();
+			if (body0->GetInvMass().m_w) {
+				body0->m_equilibrium = false;
+			}
+			if (body1->GetInvMass().m_w) {
+				body1->m_equilibrium = false;
+			}
+			contact->m_activationChanged = 0;
+		}
+	}
+
+	for (dgInt32 i = 0; i < contactCount; i++) {
+		dgContact* const contact = contactArray[i];
+		if (!contact->m_isTrigger) {
+			const dgBody* const body0 = contact->GetBody0();
+			const dgBody* const body1 = contact->GetBody1();
+			contact->m_killContact = contact->m_killContact | (body0->m_equilibrium & body1->m_equilibrium & !contact->m_isActive);
+		}
 	}
 }
 
@@ -1636,15 +1859,34 @@ void dgBroadPhase::AttachNewContact(dgInt32 startCount)
 {
 	DG_TRACKTIME();
 	dgContactList& contactList = *m_world;
+	dgContact** contactArray = &contactList[0];
 	if (contactList.m_contactCountReset > contactList.m_contactCount) {
+		if (m_world->m_deterministicMode) {
+			// which pairs made it into the full array depends on thread timing,
+			// drop them all and let the next step find them again with the larger array
+			for (dgInt32 i = startCount; i < contactList.m_contactCount; i++) {
+				delete contactArray[i];
+			}
+			contactList.m_contactCount = startCount;
+		}
 		contactList.Resize(contactList.GetElementsCapacity() * 2);
+		contactArray = &contactList[0];
+	}
+
+	// threads push new contacts in the order they find them, and that order also depends on the shape of the tree,
+	// sorting them by body pair makes the contact array, and with it the solver order, reproducible.
+	const dgInt32 newCount = contactList.m_contactCount - startCount;
+	if (newCount > 1) {
+		dgSort(&contactArray[startCount], newCount, CompareContacts);
 	}
 
-	dgContact** const contactArray = &contactList[0];
 	for (dgInt32 i = contactList.m_contactCount - 1; i >= startCount; i--) {
 		dgContact* const contact = contactArray[i];
 		if (m_contactCache.AddContactJoint(contact)) {
 			m_world->AttachContact(contact);
+			if (contact->m_isTrigger) {
+				contactList.AddTriggerEvent(contact, 1);
+			}
 		} else {
 			contactList.m_contactCount--;
 			contactArray[i] = contactList[contactList.m_contactCount];
@@ -1663,6 +1905,13 @@ void dgBroadPhase::DeleteDeadContact(dgFloat32 timestep)
 	for (dgInt32 i = contactList.m_contactCount - 1; i >= 0; i--) {
 		dgContact* const contact = contactArray[i];
 		if (contact->m_killContact) {
+			if (!(contact->m_body0->m_isdead | contact->m_body1->m_isdead)) {
+				if (contact->m_isTrigger) {
+					contactList.AddTriggerEvent(contact, 0);
+				} else if (contact->m_wasTouching && (contactList.m_contactEventMask & dgContactEvent::m_endEvent)) {
+					contactList.AddContactEndEvent(contact);
+				}
+			}
 			m_contactCache.RemoveContactJoint(contact);
 			m_world->RemoveContact(contact);
 			contactList.m_contactCount--;
@@ -1671,7 +1920,7 @@ void dgBroadPhase::DeleteDeadContact(dgFloat32 timestep)
 		} else if (contact->m_isActive && contact->m_maxDOF){
 			constraintArray[activeCount].m_joint = contact;
 			activeCount++;
-		} else if (contact->m_body0->m_continueCollisionMode | contact->m_body1->m_continueCollisionMode){
+		} else if (!contact->m_isTrigger && (contact->m_body0->m_continueCollisionMode | contact->m_body1->m_continueCollisionMode)){
 			if (contact->EstimateCCD(timestep)) {
 				constraintArray[activeCount].m_joint = contact;
 				activeCount++;
@@ -1687,7 +1936,6 @@ void dgBroadPhase::UpdateContacts(dgFloat32 timestep)
 {
 	D_TRACKTIME();
     m_lru = m_lru + 1;
-	m_pendingSoftBodyPairsCount = 0;
 
 	const dgInt32 threadsCount = m_world->GetThreadCount();
 
@@ -1748,13 +1996,8 @@ void dgBroadPhase::UpdateContacts(dgFloat32 timestep)
 		m_world->QueueJob(UpdateRigidBodyContactKernel, &syncPoints, NULL, "dgBroadPhase::UpdateRigidBodyContact");
 	}
 	m_world->SynchronizationBarrier();
-
-	if (m_pendingSoftBodyPairsCount) {
-		dgAssert (0);
-		//for (dgInt32 i = 0; i < threadsCount; i++) {
-		//	m_world->QueueJob(UpdateSoftBodyContactKernel, &syncPoints, contactListNode, "dgBroadPhase::UpdateSoftBodyContact");
-		//}
-		//m_world->SynchronizationBarrier();
+	if (m_world->m_deterministicMode) {
+		ApplyContactActivation();
 	}
 
 	//	m_recursiveChunks = false;
@@ -50,6 +50,15 @@ class dgConvexCastReturnInfo
 	dgFloat32 m_penetration;                // contact penetration at collision point
 };
 
+class dgShapeQuery
+{
+	public:
+	dgFloat32 m_matrix[16];					// shape matrix in global space
+	dgFloat32 m_target[4];					// end of the sweep for convex casts
+	const dgCollisionInstance* m_shape;		// query shape
+	void* m_userData;						// passed to the prefilter callback
+};
+
 
 DG_MSC_VECTOR_ALIGMENT
 class dgBroadPhaseNode
@@ -62,6 +71,7 @@ class dgBroadPhaseNode
 		,m_parent(parent)
 		,m_surfaceArea(dgFloat32(1.0e20f))
 		,m_criticalSectionLock(0)
+		,m_lru(0)
 	{
 	}
 
@@ -123,6 +133,7 @@ class dgBroadPhaseNode
 	dgBroadPhaseNode* m_parent;
 	dgFloat32 m_surfaceArea;
 	dgInt32 m_criticalSectionLock;
+	dgUnsigned32 m_lru;		// broad phase lru of the last change to a leaf box below this node
 
 	static dgVector m_broadPhaseScale;
 	static dgVector m_broadInvPhaseScale;
@@ -445,6 +456,39 @@ class dgBroadPhase
 		dgFloat64 m_prevCost;
 	};
 
+	DG_MSC_VECTOR_ALIGMENT
+	class dgTreeState
+	{
+		public:
+		dgFloat64 m_entropy;
+		dgFloat64 m_prevCost;
+		dgBody* m_rootBody;
+		dgInt32 m_root;
+		dgInt32 m_index;
+		dgInt32 m_nodeCount;
+		dgInt32 m_needsUpdate;
+	} DG_GCC_VECTOR_ALIGMENT;
+
+	DG_MSC_VECTOR_ALIGMENT
+	class dgTreeStateNode
+	{
+		public:
+		dgVector m_minBox;
+		dgVector m_maxBox;
+		dgBody* m_leftBody;
+		dgBody* m_rightBody;
+		dgInt32 m_left;
+		dgInt32 m_right;
+		dgFloat32 m_surfaceArea;
+	} DG_GCC_VECTOR_ALIGMENT;
+
+	class dgTreeNodeIndex
+	{
+		public:
+		const dgBroadPhaseNode* m_node;
+		dgInt32 m_index;
+	};
+
 	public:
 	enum dgContactCode
 	{
@@ -500,7 +544,14 @@ class dgBroadPhase
 	virtual dgInt32 ConvexCast (dgCollisionInstance* const shape, const dgMatrix& matrix, const dgVector& target, dgFloat32* const param, OnRayPrecastAction prefilter, void* const userData, dgConvexCastReturnInfo* const info, dgInt32 maxContacts, dgInt32 threadIndex) const = 0;
 	virtual void FindCollidingPairs (dgBroadphaseSyncDescriptor* const descriptor, dgList<dgBroadPhaseNode*>::dgListNode* const node, dgInt32 threadID) = 0;
 
+	// shape of the trees for world snapshots, zero size means the trees can not be saved
+	virtual dgInt32 GetStateSize() const = 0;
+	virtual void SaveState(void* const buffer) const = 0;
+	virtual bool CheckState(const void* const buffer) const = 0;
+	virtual void RestoreState(const void* const buffer) = 0;
+
 	void UpdateBody(dgBody* const body, dgInt32 threadIndex);
+	void SetBodyNodeBox(dgBody* const body, const dgVector& minBox, const dgVector& maxBox);
 	void AddInternallyGeneratedBody(dgBody* const body)
 	{
 		m_generatedBodies.Append(body);
@@ -516,14 +567,29 @@ class dgBroadPhase
 	virtual void UnlinkAggregate (dgBroadPhaseAggregate* const aggregate) = 0; 
 
 	bool DoNeedUpdate(dgBodyMasterList::dgListNode* const node) const;
+	void UpdateParentBoxes(dgBroadPhaseNode* const node);
 	dgFloat64 CalculateEntropy (dgFitnessList& fitness, dgBroadPhaseNode** const root);
 	dgBroadPhaseTreeNode* InsertNode (dgBroadPhaseNode* const root, dgBroadPhaseNode* const node);
 
+	DG_INLINE void MarkNodeChanged(dgBroadPhaseNode* node) const
+	{
+		// a parent is never stamped older than its children, so stop at the first node already stamped this frame
+		const dgUnsigned32 lru = m_lru;
+		for (; node && (node->m_lru != lru); node = node->m_parent) {
+			node->m_lru = lru;
+		}
+	}
+
 	void RotateLeft(dgBroadPhaseTreeNode* const node, dgBroadPhaseNode** const root);
 	void RotateRight(dgBroadPhaseTreeNode* const node, dgBroadPhaseNode** const root);
 	void ImproveNodeFitness(dgBroadPhaseTreeNode* const node, dgBroadPhaseNode** const root);
 	void ImproveFitness(dgFitnessList& fitness, dgFloat64& oldEntropy, dgBroadPhaseNode** const root);
 
+	dgInt32 GetTreeStateSize(const dgFitnessList& fitness) const;
+	dgUnsigned8* SaveTreeState(dgUnsigned8* const buffer, const dgFitnessList& fitness, dgFloat64 entropy, const dgBroadPhaseNode* const root, bool needsUpdate) const;
+	const dgUnsigned8* CheckTreeState(const dgUnsigned8* const buffer, const dgFitnessList& fitness) const;
+	const dgUnsigned8* RestoreTreeState(const dgUnsigned8* const buffer, dgFitnessList& fitness, dgFloat64& entropy, dgBroadPhaseNode** const root, dgBroadPhaseNode* const rootParent, bool& needsUpdate);
+
 	void CalculatePairContacts (dgPair* const pair, dgInt32 threadID);
 	void AddPair (dgContact* const contact, dgFloat32 timestep, dgInt32 threadIndex);
 	void AddPair (dgBody* const body0, dgBody* const body1, dgFloat32 timestep, dgInt32 threadID);	
@@ -550,8 +616,8 @@ class dgBroadPhase
 	void KinematicBodyActivation (dgContact* const contatJoint) const;
 	
 	void FindGeneratedBodiesCollidingPairs (dgBroadphaseSyncDescriptor* const descriptor, dgInt32 threadID);
-	void UpdateSoftBodyContacts(dgBroadphaseSyncDescriptor* const descriptor, dgFloat32 timeStep, dgInt32 threadID);
 	void UpdateRigidBodyContacts (dgBroadphaseSyncDescriptor* const descriptor, dgFloat32 timeStep, dgInt32 threadID);
+	void ApplyContactActivation();
 	void SubmitPairs (dgBroadPhaseNode* const body, dgBroadPhaseNode* const node, dgFloat32 timestep, dgInt32 threaCount, dgInt32 threadID);
 
 	bool SanityCheck() const;
@@ -566,15 +632,9 @@ class dgBroadPhase
 	static void UpdateAggregateEntropyKernel(void* const descriptor, void* const worldContext, dgInt32 threadID);
 	static void AddGeneratedBodiesContactsKernel(void* const descriptor, void* const worldContext, dgInt32 threadID);
 	static void UpdateRigidBodyContactKernel(void* const descriptor, void* const worldContext, dgInt32 threadID);
-	static void UpdateSoftBodyContactKernel(void* const descriptor, void* const worldContext, dgInt32 threadID);
 	static dgInt32 CompareNodes(const dgBroadPhaseNode* const nodeA, const dgBroadPhaseNode* const nodeB, void* const notUsed);
-
-	class dgPendingCollisionSoftBodies
-	{
-		public:
-		dgBody* m_body0;
-		dgBody* m_body1;
-	};
+	static dgInt32 CompareContacts(dgContact* const* const contactA, dgContact* const* const contactB, void* const notUsed);
+	static dgInt32 CompareTreeNodeIndex(const dgTreeNodeIndex* const indexA, const dgTreeNodeIndex* const indexB, void* const notUsed);
 
 	dgWorld* m_world;
 	dgBroadPhaseNode* m_rootNode;
@@ -582,9 +642,8 @@ class dgBroadPhase
 	dgList<dgBroadPhaseNode*> m_updateList;
 	dgList<dgBroadPhaseAggregate*> m_aggregateList;
 	dgUnsigned32 m_lru;
+	dgUnsigned32 m_queryGeneration;	// changes when nodes leave the trees, query caches holding nodes must start over
 	dgContactCache m_contactCache;
-	dgArray<dgPendingCollisionSoftBodies> m_pendingSoftBodyCollisions;
-	dgInt32 m_pendingSoftBodyPairsCount;
 	dgInt32 m_criticalSectionLock;
 
 	static dgVector m_velocTol;
@@ -596,6 +655,7 @@ class dgBroadPhase
 	friend class dgDeadBodies;
 	friend class dgWorldDynamicUpdate;
 	friend class dgBroadPhaseAggregate;
+	friend class dgBroadPhaseQueryCache;
 	friend class dgCollisionCompoundFractured;
 };
 
@@ -106,6 +106,7 @@ void dgBroadPhaseAggregate::AddBody(dgBody* const body)
 		ptr->m_parent->m_maxBox = maxBox;
 		ptr->m_parent->m_surfaceArea = area;
 	}
+	m_broadPhase->MarkNodeChanged(newNode);
 }
 
 void dgBroadPhaseAggregate::RemoveBody(dgBody* const body)
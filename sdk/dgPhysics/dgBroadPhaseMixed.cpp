@@ -64,6 +64,28 @@ void dgBroadPhaseMixed::InvalidateCache()
 	m_contactCache.Flush();
 }
 
+dgInt32 dgBroadPhaseMixed::GetStateSize() const
+{
+	// aggregates have their own trees, those are not saved
+	return m_aggregateList.GetCount() ? 0 : GetTreeStateSize(m_fitness);
+}
+
+void dgBroadPhaseMixed::SaveState(void* const buffer) const
+{
+	SaveTreeState((dgUnsigned8*)buffer, m_fitness, m_treeEntropy, m_rootNode, false);
+}
+
+bool dgBroadPhaseMixed::CheckState(const void* const buffer) const
+{
+	return !m_aggregateList.GetCount() && CheckTreeState((dgUnsigned8*)buffer, m_fitness);
+}
+
+void dgBroadPhaseMixed::RestoreState(const void* const buffer)
+{
+	bool needsUpdate;
+	RestoreTreeState((dgUnsigned8*)buffer, m_fitness, m_treeEntropy, &m_rootNode, NULL, needsUpdate);
+}
+
 void dgBroadPhaseMixed::ForEachBodyInAABB(const dgVector& minBox, const dgVector& maxBox, OnBodiesInAABB callback, void* const userData) const
 {
 	if (m_rootNode) {
@@ -163,6 +185,7 @@ void dgBroadPhaseMixed::Add(dgBody* const body)
 	dgBroadPhaseBodyNode* const bodyNode = new (m_world->GetAllocator()) dgBroadPhaseBodyNode(body);
 	bodyNode->m_updateNode = m_updateList.Append(bodyNode);
 	AddNode(bodyNode);
+	MarkNodeChanged(bodyNode);
 }
 
 dgBroadPhaseAggregate* dgBroadPhaseMixed::CreateAggregate()
@@ -175,6 +198,7 @@ dgBroadPhaseAggregate* dgBroadPhaseMixed::CreateAggregate()
 void dgBroadPhaseMixed::LinkAggregate(dgBroadPhaseAggregate* const aggregate)
 {
 	AddNode(aggregate);
+	MarkNodeChanged(aggregate);
 	aggregate->m_broadPhase = this;
 	aggregate->m_updateNode = m_updateList.Append(aggregate);
 	aggregate->m_myAggregateNode = m_aggregateList.Append(aggregate);
@@ -182,6 +206,7 @@ void dgBroadPhaseMixed::LinkAggregate(dgBroadPhaseAggregate* const aggregate)
 
 void dgBroadPhaseMixed::RemoveNode(dgBroadPhaseNode* const node)
 {
+	m_queryGeneration ++;
 	if (node->m_parent) {
 		if (!node->m_parent->IsAggregate()) {
 			dgBroadPhaseTreeNode* const parent = (dgBroadPhaseTreeNode*)node->m_parent;
@@ -270,6 +295,7 @@ void dgBroadPhaseMixed::RemoveNode(dgBroadPhaseNode* const node)
 
 void dgBroadPhaseMixed::UnlinkAggregate(dgBroadPhaseAggregate* const aggregate)
 {
+	m_queryGeneration ++;
 	dgAssert (m_rootNode);
 	if (m_rootNode == aggregate) {
 		m_rootNode = NULL;
@@ -0,0 +1,182 @@
+/* Copyright (c) <2003-2019> <Julio Jerez, Newton Game Dynamics>
+* 
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* 
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "dgPhysicsStdafx.h"
+#include "dgBody.h"
+#include "dgWorld.h"
+#include "dgCollisionInstance.h"
+#include "dgBroadPhaseAggregate.h"
+#include "dgBroadPhaseQueryCache.h"
+
+dgBroadPhaseQueryCache::dgBroadPhaseQueryCache(dgWorld* const world, dgFloat32 padding)
+	:m_minBox(dgFloat32(0.0f))
+	,m_maxBox(dgFloat32(0.0f))
+	,m_padding(dgAbs(padding))
+	,m_world(world)
+	,m_broadPhase(NULL)
+	,m_leaves(world->GetAllocator())
+	,m_leafCount(0)
+	,m_lru(0)
+	,m_generation(0)
+{
+	m_padding = m_padding & dgVector::m_triplexMask;
+}
+
+dgBroadPhaseQueryCache::~dgBroadPhaseQueryCache()
+{
+}
+
+void dgBroadPhaseQueryCache::AddLeaves(dgUnsigned32 lru)
+{
+	// only branches stamped at or after lru can hold leaves the cache does not know about
+	const dgBroadPhaseNode* stackPool[DG_BROADPHASE_MAX_STACK_DEPTH];
+	dgInt32 stack = 0;
+	if (m_broadPhase->m_rootNode) {
+		stackPool[0] = m_broadPhase->m_rootNode;
+		stack = 1;
+	}
+
+	while (stack) {
+		stack--;
+		const dgBroadPhaseNode* const rootNode = stackPool[stack];
+		if ((rootNode->m_lru >= lru) && dgOverlapTest(rootNode->m_minBox, rootNode->m_maxBox, m_minBox, m_maxBox)) {
+			if (rootNode->GetBody()) {
+				m_leaves[m_leafCount] = rootNode;
+				m_leafCount++;
+			} else if (rootNode->IsAggregate()) {
+				const dgBroadPhaseAggregate* const aggregate = (dgBroadPhaseAggregate*)rootNode;
+				if (aggregate->m_root) {
+					stackPool[stack] = aggregate->m_root;
+					stack++;
+					dgAssert(stack < DG_BROADPHASE_MAX_STACK_DEPTH);
+				}
+			} else {
+				dgAssert(!rootNode->IsLeafNode());
+				const dgBroadPhaseTreeNode* const node = (dgBroadPhaseTreeNode*)rootNode;
+				if (node->m_left) {
+					stackPool[stack] = node->m_left;
+					stack++;
+					dgAssert(stack < DG_BROADPHASE_MAX_STACK_DEPTH);
+				}
+				if (node->m_right) {
+					stackPool[stack] = node->m_right;
+					stack++;
+					dgAssert(stack < DG_BROADPHASE_MAX_STACK_DEPTH);
+				}
+			}
+		}
+	}
+}
+
+void dgBroadPhaseQueryCache::Rebuild(const dgVector& minBox, const dgVector& maxBox)
+{
+	m_minBox = (minBox - m_padding) & dgVector::m_triplexMask;
+	m_maxBox = (maxBox + m_padding) & dgVector::m_triplexMask;
+	m_leafCount = 0;
+	AddLeaves(0);
+}
+
+void dgBroadPhaseQueryCache::Revalidate()
+{
+	// drop the leaves that moved since the last update, the search adds them back if they still overlap
+	dgInt32 count = 0;
+	for (dgInt32 i = 0; i < m_leafCount; i++) {
+		const dgBroadPhaseNode* const node = m_leaves[i];
+		if (node->m_lru < m_lru) {
+			m_leaves[count] = node;
+			count++;
+		}
+	}
+	m_leafCount = count;
+	AddLeaves(m_lru);
+}
+
+void dgBroadPhaseQueryCache::Update(const dgVector& minBox, const dgVector& maxBox)
+{
+	const dgBroadPhase* const broadPhase = m_world->GetBroadPhase();
+	if ((broadPhase != m_broadPhase) || (broadPhase->m_queryGeneration != m_generation) || !dgBoxInclusionTest(minBox, maxBox, m_minBox, m_maxBox)) {
+		m_broadPhase = broadPhase;
+		m_generation = broadPhase->m_queryGeneration;
+		Rebuild(minBox, maxBox);
+	} else {
+		Revalidate();
+	}
+	m_lru = broadPhase->m_lru;
+}
+
+void dgBroadPhaseQueryCache::ForEachBodyInAABB(const dgVector& minBox, const dgVector& maxBox, OnBodiesInAABB callback, void* const userData)
+{
+	Update(minBox, maxBox);
+	for (dgInt32 i = 0; i < m_leafCount; i++) {
+		const dgBroadPhaseNode* const node = m_leaves[i];
+		if (dgOverlapTest(node->m_minBox, node->m_maxBox, minBox, maxBox)) {
+			dgBody* const body = node->GetBody();
+			if (!body->m_isdead && dgOverlapTest(body->m_minAABB, body->m_maxAABB, minBox, maxBox)) {
+				if (!callback(body, userData)) {
+					break;
+				}
+			}
+		}
+	}
+}
+
+dgInt32 dgBroadPhaseQueryCache::ConvexCast(dgCollisionInstance* const shape, const dgMatrix& matrix, const dgVector& target, dgFloat32* const param, OnRayPrecastAction prefilter, void* const userData, dgConvexCastReturnInfo* const info, dgInt32 maxContacts, dgInt32 threadIndex)
+{
+	dgVector boxP0;
+	dgVector boxP1;
+	dgAssert(matrix.TestOrthogonal());
+	shape->CalcAABB(matrix, boxP0, boxP1);
+
+	const dgVector velocA((target - matrix.m_posit) & dgVector::m_triplexMask);
+	const dgVector velocB(dgFloat32(0.0f));
+	Update(boxP0.GetMin(boxP0 + velocA), boxP1.GetMax(boxP1 + velocA));
+
+	*param = dgFloat32(1.0f);
+	if (!m_leafCount) {
+		return 0;
+	}
+
+	dgStack<dgFloat32> distance(m_leafCount);
+	dgStack<const dgBroadPhaseNode*> stackPool(m_leafCount);
+	dgFastRayTest ray(dgVector(dgFloat32(0.0f)), velocA);
+
+	// same ordering as the tree traversal, the closest leaf goes at the top of the stack
+	dgInt32 stack = 0;
+	for (dgInt32 i = 0; i < m_leafCount; i++) {
+		const dgBroadPhaseNode* const node = m_leaves[i];
+		const dgFloat32 dist = ray.BoxIntersect(node->m_minBox - boxP1, node->m_maxBox - boxP0);
+		if (dist < dgFloat32(1.0f)) {
+			dgInt32 j = stack;
+			for (; j && (dist > distance[j - 1]); j--) {
+				stackPool[j] = stackPool[j - 1];
+				distance[j] = distance[j - 1];
+			}
+			stackPool[j] = node;
+			distance[j] = dist;
+			stack++;
+		}
+	}
+
+	if (!stack) {
+		return 0;
+	}
+	return m_broadPhase->ConvexCast(&stackPool[0], &distance[0], stack, velocA, velocB, ray, shape, matrix, target, param, prefilter, userData, info, maxContacts, threadIndex);
+}
@@ -0,0 +1,64 @@
+/* Copyright (c) <2003-2019> <Julio Jerez, Newton Game Dynamics>
+* 
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* 
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef __DG_BROADPHASE_QUERY_CACHE_H__
+#define __DG_BROADPHASE_QUERY_CACHE_H__
+
+#include "dgPhysicsStdafx.h"
+#include "dgBroadPhase.h"
+
+// keeps the body leaves overlapping a padded box around the last query,
+// the next query inside that box only revisits the branches with a newer lru
+DG_MSC_VECTOR_ALIGMENT
+class dgBroadPhaseQueryCache
+{
+	public:
+	DG_CLASS_ALLOCATOR(allocator)
+
+	dgBroadPhaseQueryCache(dgWorld* const world, dgFloat32 padding);
+	~dgBroadPhaseQueryCache();
+
+	dgWorld* GetWorld() const
+	{
+		return m_world;
+	}
+
+	void ForEachBodyInAABB(const dgVector& minBox, const dgVector& maxBox, OnBodiesInAABB callback, void* const userData);
+	dgInt32 ConvexCast(dgCollisionInstance* const shape, const dgMatrix& matrix, const dgVector& target, dgFloat32* const param, OnRayPrecastAction prefilter, void* const userData, dgConvexCastReturnInfo* const info, dgInt32 maxContacts, dgInt32 threadIndex);
+
+	private:
+	void Update(const dgVector& minBox, const dgVector& maxBox);
+	void Rebuild(const dgVector& minBox, const dgVector& maxBox);
+	void Revalidate();
+	void AddLeaves(dgUnsigned32 lru);
+
+	dgVector m_minBox;
+	dgVector m_maxBox;
+	dgVector m_padding;
+	dgWorld* m_world;
+	const dgBroadPhase* m_broadPhase;
+	dgArray<const dgBroadPhaseNode*> m_leaves;
+	dgInt32 m_leafCount;
+	dgUnsigned32 m_lru;
+	dgUnsigned32 m_generation;
+} DG_GCC_VECTOR_ALIGMENT;
+
+#endif
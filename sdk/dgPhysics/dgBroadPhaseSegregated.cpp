@@ -107,6 +107,7 @@ void dgBroadPhaseSegregated::AddStaticBody(dgBody* const body)
 		root->m_right = bodyNode;
 		root->m_right->m_parent = root;
 	}
+	MarkNodeChanged(bodyNode);
 }
 
 void dgBroadPhaseSegregated::AddDynamicBody(dgBody* const body)
@@ -123,6 +124,7 @@ void dgBroadPhaseSegregated::AddDynamicBody(dgBody* const body)
 		root->m_left->m_parent = root;
 	}
 	newNode->m_updateNode = m_updateList.Append(newNode);
+	MarkNodeChanged(newNode);
 }
 
 
@@ -160,6 +162,7 @@ void dgBroadPhaseSegregated::LinkAggregate(dgBroadPhaseAggregate* const aggregat
 	}
 	aggregate->m_updateNode = m_updateList.Append(aggregate);
 	aggregate->m_myAggregateNode = m_aggregateList.Append(aggregate);
+	MarkNodeChanged(aggregate);
 }
 
 void dgBroadPhaseSegregated::DestroyAggregate(dgBroadPhaseAggregate* const aggregate)
@@ -171,6 +174,7 @@ void dgBroadPhaseSegregated::DestroyAggregate(dgBroadPhaseAggregate* const aggre
 
 void dgBroadPhaseSegregated::RemoveNode(dgBroadPhaseNode* const node)
 {
+	m_queryGeneration ++;
 	dgAssert (node->m_parent);
 
 	if (node->m_parent->IsSegregatedRoot()) {
@@ -310,6 +314,7 @@ void dgBroadPhaseSegregated::RemoveNode(dgBroadPhaseNode* const node)
 
 void dgBroadPhaseSegregated::UnlinkAggregate (dgBroadPhaseAggregate* const aggregate)
 {
+	m_queryGeneration ++;
 	dgBroadPhaseSegregatedRootNode* const root = (dgBroadPhaseSegregatedRootNode*)m_rootNode;
 	dgAssert (root && root->m_left);
 	if (aggregate->m_parent == root) {
@@ -376,6 +381,37 @@ void dgBroadPhaseSegregated::InvalidateCache()
 	m_contactCache.Flush();
 }
 
+dgInt32 dgBroadPhaseSegregated::GetStateSize() const
+{
+	// aggregates have their own trees, those are not saved
+	return m_aggregateList.GetCount() ? 0 : GetTreeStateSize(m_staticFitness) + GetTreeStateSize(m_dynamicsFitness);
+}
+
+void dgBroadPhaseSegregated::SaveState(void* const buffer) const
+{
+	const dgBroadPhaseSegregatedRootNode* const root = (dgBroadPhaseSegregatedRootNode*)m_rootNode;
+	dgUnsigned8* const dynamicsBuffer = SaveTreeState((dgUnsigned8*)buffer, m_staticFitness, m_staticEntropy, root->m_right, m_staticNeedsUpdate);
+	SaveTreeState(dynamicsBuffer, m_dynamicsFitness, m_dynamicsEntropy, root->m_left, false);
+}
+
+bool dgBroadPhaseSegregated::CheckState(const void* const buffer) const
+{
+	if (m_aggregateList.GetCount()) {
+		return false;
+	}
+	const dgUnsigned8* const dynamicsBuffer = CheckTreeState((dgUnsigned8*)buffer, m_staticFitness);
+	return dynamicsBuffer && CheckTreeState(dynamicsBuffer, m_dynamicsFitness);
+}
+
+void dgBroadPhaseSegregated::RestoreState(const void* const buffer)
+{
+	bool needsUpdate;
+	dgBroadPhaseSegregatedRootNode* const root = (dgBroadPhaseSegregatedRootNode*)m_rootNode;
+	const dgUnsigned8* const dynamicsBuffer = RestoreTreeState((dgUnsigned8*)buffer, m_staticFitness, m_staticEntropy, &root->m_right, root, m_staticNeedsUpdate);
+	RestoreTreeState(dynamicsBuffer, m_dynamicsFitness, m_dynamicsEntropy, &root->m_left, root, needsUpdate);
+	root->SetBox ();
+}
+
 void dgBroadPhaseSegregated::UpdateFitness()
 {
 	dgBroadPhaseSegregatedRootNode* const root = (dgBroadPhaseSegregatedRootNode*)m_rootNode;
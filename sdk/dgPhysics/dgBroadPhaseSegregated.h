@@ -47,6 +47,11 @@ class dgBroadPhaseSegregated : public dgBroadPhase
 	virtual void UnlinkAggregate(dgBroadPhaseAggregate* const aggregate);
 	virtual void FindCollidingPairs (dgBroadphaseSyncDescriptor* const descriptor, dgList<dgBroadPhaseNode*>::dgListNode* const node, dgInt32 threadID);
 
+	virtual dgInt32 GetStateSize() const;
+	virtual void SaveState(void* const buffer) const;
+	virtual bool CheckState(const void* const buffer) const;
+	virtual void RestoreState(const void* const buffer);
+
 	virtual void ResetEntropy();
 	virtual void UpdateFitness();
 	virtual void ForEachBodyInAABB(const dgVector& minBox, const dgVector& maxBox, OnBodiesInAABB callback, void* const userData) const;
@@ -285,6 +285,10 @@ class dgCollision
 	const dgCollision* AddRef () const;
 	dgInt32 GetRefCount() const;
 	virtual dgInt32 Release () const;
+
+	// called when an instance of the shape is created or destroyed in a world other than the one that owns it
+	virtual void AttachWorld (dgWorld* const world) const {}
+	virtual void DetachWorld (dgWorld* const world) const {}
 	
 	const dgVector& GetObbOrigin() const; 
 	virtual dgVector GetObbSize() const; 
@@ -344,9 +348,10 @@ DG_INLINE const dgCollision* dgCollision::AddRef () const
 
 DG_INLINE dgInt32 dgCollision::Release () const
 {
-	dgAtomicExchangeAndAdd (&m_refCount, -1);
-	if (m_refCount) {
-		return m_refCount;
+	// shapes can be shared by worlds running on different threads, only the thread that drops the last reference deletes it
+	dgInt32 refCount = dgAtomicExchangeAndAdd (&m_refCount, -1) - 1;
+	if (refCount) {
+		return refCount;
 	}
 	delete this;
 	return 0;
@@ -30,8 +30,11 @@ dgCollisionBVH::dgCollisionBVH(dgWorld* const world)
 	,m_trianglesCount(0)
 {
 	m_rtti |= dgCollisionBVH_RTTI;
+	m_world = world;
 	m_builder = NULL;
 	m_userRayCastCallback = NULL;
+	m_reportProgress = NULL;
+	m_reportProgressUserData = NULL;
 }
 
 dgCollisionBVH::dgCollisionBVH (dgWorld* const world, dgDeserialize deserialization, void* const userData, dgInt32 revisionNumber)
@@ -40,8 +43,11 @@ dgCollisionBVH::dgCollisionBVH (dgWorld* const world, dgDeserialize deserializat
 	,m_trianglesCount(0)
 {
 	dgAssert (m_rtti | dgCollisionBVH_RTTI);
+	m_world = world;
 	m_builder = NULL;;
 	m_userRayCastCallback = NULL;
+	m_reportProgress = NULL;
+	m_reportProgressUserData = NULL;
 
 	dgAABBPolygonSoup::Deserialize (deserialization, userData, revisionNumber);
 
@@ -83,12 +89,44 @@ void dgCollisionBVH::AddFace(dgInt32 vertexCount, const dgFloat32* const vertexP
 	m_builder->AddMesh (vertexPtr, vertexCount, strideInBytes, 1, &faceArray, indexList, &faceAttribute, dgGetIdentityMatrix());
 }
 
+void dgCollisionBVH::SerializeImage (dgSerialize callback, void* const userData) const
+{
+	dgAABBPolygonSoup::SerializeImage (callback, userData, m_trianglesCount);
+}
+
+bool dgCollisionBVH::AttachImage (const void* const image, dgInt64 imageSizeInBytes)
+{
+	dgAssert (!m_builder);
+	if (!dgAABBPolygonSoup::AttachImage (image, imageSizeInBytes, m_trianglesCount)) {
+		return false;
+	}
+
+	dgVector p0; 
+	dgVector p1; 
+	GetAABB (p0, p1);
+	SetCollisionBBox(p0, p1);
+	return true;
+}
+
 void dgCollisionBVH::SetCollisionRayCastCallback (dgCollisionBVHUserRayCastCallback rayCastCallback)
 {
 	m_userRayCastCallback = rayCastCallback;
 }
 
-void dgCollisionBVH::EndBuild(dgInt32 optimize)
+void dgCollisionBVH::SetBuildProgressCallback (dgReportProgress reportProgress, void* const reportProgressUserData)
+{
+	m_reportProgress = reportProgress;
+	m_reportProgressUserData = reportProgressUserData;
+}
+
+bool dgCollisionBVH::ReportOptimizeProgress (dgFloat32 progress, void* const userData)
+{
+	// merging faces takes the first half of the build
+	dgCollisionBVH* const me = (dgCollisionBVH*) userData;
+	return me->m_reportProgress (progress * dgFloat32 (0.5f), me->m_reportProgressUserData);
+}
+
+void dgCollisionBVH::EndBuild(dgInt32 optimize, dgInt32 nodeLayout)
 {
 	dgVector p0;
 	dgVector p1;
@@ -103,9 +141,22 @@ void dgCollisionBVH::EndBuild(dgInt32 optimize)
 	}
 #endif
 
-	m_builder->End(state);
-	Create (*m_builder, state);
-	CalculateAdjacendy();
+	// the world worker threads are free to use only while the world is not updating
+	dgThreadHive* const threadPool = m_world->AcquireIdleThreadPool();
+
+	m_builder->End(state, threadPool, m_reportProgress ? ReportOptimizeProgress : NULL, this);
+	if (m_reportProgress) {
+		m_reportProgress (state ? dgFloat32 (0.5f) : dgFloat32 (0.1f), m_reportProgressUserData);
+	}
+	Create (*m_builder, state, threadPool);
+	if (m_reportProgress) {
+		m_reportProgress (state ? dgFloat32 (0.7f) : dgFloat32 (0.4f), m_reportProgressUserData);
+	}
+	CalculateAdjacendy(threadPool);
+	m_world->ReleaseIdleThreadPool(threadPool);
+	if (nodeLayout == m_wideQuantizedNodes) {
+		BuildWideNodes();
+	}
 	
 	GetAABB (p0, p1);
 	SetCollisionBBox (p0, p1);
@@ -122,6 +173,10 @@ void dgCollisionBVH::EndBuild(dgInt32 optimize)
 	dgFastAABBInfo box (dgGetIdentityMatrix(), dgVector (dgFloat32 (1.0e15f)));
 	ForAllSectors (box, zero, dgFloat32 (1.0f), GetTriangleCount, &data);
 	m_trianglesCount = data.m_triangleCount;
+
+	if (m_reportProgress) {
+		m_reportProgress (dgFloat32 (1.0f), m_reportProgressUserData);
+	}
 }
 
 
@@ -56,8 +56,11 @@ class dgCollisionBVH: public dgCollisionMesh, public dgAABBPolygonSoup
 
 	void BeginBuild();
 	void AddFace (dgInt32 vertexCount, const dgFloat32* const vertexPtr, dgInt32 strideInBytes, dgInt32 faceAttribute);
-	void EndBuild(dgInt32 optimize);
+	void EndBuild(dgInt32 optimize, dgInt32 nodeLayout = m_binaryNodes);
 
+	void SetBuildProgressCallback (dgReportProgress reportProgress, void* const reportProgressUserData);
+	void SerializeImage (dgSerialize callback, void* const userData) const;
+	bool AttachImage (const void* const image, dgInt64 imageSizeInBytes);
 	void SetCollisionRayCastCallback (dgCollisionBVHUserRayCastCallback rayCastCallback);
 	dgCollisionBVHUserRayCastCallback GetDebugRayCastCallback() const { return m_userRayCastCallback;} 
 	void GetVertexListIndexList (const dgVector& p0, const dgVector& p1, dgMeshVertexListIndexList &data) const;
@@ -69,6 +72,7 @@ class dgCollisionBVH: public dgCollisionMesh, public dgAABBPolygonSoup
 	static dgFloat32 RayHitUser (void* const context, const dgFloat32* const polygon, dgInt32 strideInBytes, const dgInt32* const indexArray, dgInt32 indexCount);
 	static dgIntersectStatus GetPolygon (void* const context, const dgFloat32* const polygon, dgInt32 strideInBytes, const dgInt32* const indexArray, dgInt32 indexCount, dgFloat32 hitDistance);
 	static dgIntersectStatus ShowDebugPolygon (void* const context, const dgFloat32* const polygon, dgInt32 strideInBytes, const dgInt32* const indexArray, dgInt32 indexCount, dgFloat32 hitDistance);
+	static bool ReportOptimizeProgress (dgFloat32 progress, void* const userData);
 	static dgIntersectStatus GetTriangleCount (void* const context, const dgFloat32* const polygon, dgInt32 strideInBytes, const dgInt32* const indexArray, dgInt32 indexCount, dgFloat32 hitDistance);
 	static dgIntersectStatus CollectVertexListIndexList (void* const context, const dgFloat32* const polygon, dgInt32 strideInBytes, const dgInt32* const indexArray, dgInt32 indexCount, dgFloat32 hitDistance);
 
@@ -86,8 +90,11 @@ class dgCollisionBVH: public dgCollisionMesh, public dgAABBPolygonSoup
 	virtual dgVector SupportVertexSpecial (const dgVector& dir, dgFloat32 skinThickness, dgInt32* const vertexIndex) const;
 	virtual dgVector SupportVertexSpecialProjectPoint (const dgVector& point, const dgVector& dir) const {return point;}
 
+	dgWorld* m_world;
 	dgPolygonSoupDatabaseBuilder* m_builder;
 	dgCollisionBVHUserRayCastCallback m_userRayCastCallback;
+	dgReportProgress m_reportProgress;
+	void* m_reportProgressUserData;
 
 	dgInt32 m_trianglesCount;
 	friend class dgCollisionCompound;
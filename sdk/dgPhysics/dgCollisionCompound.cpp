@@ -34,6 +34,7 @@
 //////////////////////////////////////////////////////////////////////
 
 #define DG_MAX_MIN_VOLUME				dgFloat32 (1.0e-3f)
+#define DG_COMPOUND_MESH_CLUSTER_PADDING	dgFloat32 (1.0f / 32.0f)
 
 
 dgVector dgCollisionCompound::m_padding (dgFloat32 (1.0e-3f)); 
@@ -46,6 +47,15 @@ class dgCollisionCompound::dgHeapNodePair
 	dgNodeBase* m_nodeB;
 };
 
+DG_MSC_VECTOR_ALIGMENT
+class dgCollisionCompound::dgMeshLeaf
+{
+	public:
+	dgVector m_p0;
+	dgVector m_p1;
+	dgNodeBase* m_node;
+} DG_GCC_VECTOR_ALIGMENT;
+
 
 dgCollisionCompound::dgTreeArray::dgTreeArray (dgMemoryAllocator* const allocator)
 	:dgTree<dgNodeBase*, dgInt32>(allocator)
@@ -159,7 +169,10 @@ dgCollisionCompound::dgOOBBTestData::dgOOBBTestData (const dgMatrix& matrix, con
 
 
 dgCollisionCompound::dgNodeBase::dgNodeBase () 
-	:m_left(NULL) 
+	:m_massOrigin(dgFloat32 (0.0f))
+	,m_massInertia(dgFloat32 (0.0f))
+	,m_massCrossInertia(dgFloat32 (0.0f))
+	,m_left(NULL) 
 	,m_right(NULL)
 	,m_parent(NULL)
 	,m_shape(NULL)
@@ -172,6 +185,9 @@ dgCollisionCompound::dgNodeBase::dgNodeBase (const dgNodeBase& copyFrom)
 	,m_p1(copyFrom.m_p1)
 	,m_size(copyFrom.m_size)
 	,m_origin(copyFrom.m_origin)
+	,m_massOrigin(copyFrom.m_massOrigin)
+	,m_massInertia(copyFrom.m_massInertia)
+	,m_massCrossInertia(copyFrom.m_massCrossInertia)
 	,m_area(copyFrom.m_area)
 	,m_type(copyFrom.m_type)
 	,m_left(NULL)
@@ -185,7 +201,10 @@ dgCollisionCompound::dgNodeBase::dgNodeBase (const dgNodeBase& copyFrom)
 
 
 dgCollisionCompound::dgNodeBase::dgNodeBase (dgCollisionInstance* const instance)
-	:m_type(m_leaf)
+	:m_massOrigin(dgFloat32 (0.0f))
+	,m_massInertia(dgFloat32 (0.0f))
+	,m_massCrossInertia(dgFloat32 (0.0f))
+	,m_type(m_leaf)
 	,m_left(NULL) 
 	,m_right(NULL)
 	,m_parent(NULL)
@@ -197,7 +216,10 @@ dgCollisionCompound::dgNodeBase::dgNodeBase (dgCollisionInstance* const instance
 
 
 dgCollisionCompound::dgNodeBase::dgNodeBase (dgNodeBase* const left, dgNodeBase* const right)
-	:m_type(m_node)
+	:m_massOrigin(dgFloat32 (0.0f))
+	,m_massInertia(dgFloat32 (0.0f))
+	,m_massCrossInertia(dgFloat32 (0.0f))
+	,m_type(m_node)
 	,m_left(left)
 	,m_right(right)
 	,m_parent(NULL)
@@ -464,10 +486,14 @@ dgCollisionCompound::dgCollisionCompound(dgWorld* const world)
 	,m_root(NULL)
 	,m_myInstance(NULL)
 	,m_array (world->GetAllocator())
+	,m_massOrigin(dgFloat32 (0.0f))
+	,m_massInertia(dgFloat32 (0.0f))
+	,m_massCrossInertia(dgFloat32 (0.0f))
 	,m_treeEntropy (dgFloat32 (0.0f))
 	,m_boxMinRadius(dgFloat32(0.0f))
 	,m_boxMaxRadius(dgFloat32(0.0f))
 	,m_idIndex(0)
+	,m_changeCount(0)
 	,m_criticalSectionLock(0)
 {
 	m_rtti |= dgCollisionCompound_RTTI;
@@ -479,10 +505,14 @@ dgCollisionCompound::dgCollisionCompound (const dgCollisionCompound& source, con
 	,m_root(NULL)
 	,m_myInstance(myInstance)
 	,m_array (source.GetAllocator())
+	,m_massOrigin(source.m_massOrigin)
+	,m_massInertia(source.m_massInertia)
+	,m_massCrossInertia(source.m_massCrossInertia)
 	,m_treeEntropy(source.m_treeEntropy)
 	,m_boxMinRadius(source.m_boxMinRadius)
 	,m_boxMaxRadius(source.m_boxMaxRadius)
 	,m_idIndex(source.m_idIndex)
+	,m_changeCount(source.m_changeCount)
 	,m_criticalSectionLock(0)
 {
 	m_rtti |= dgCollisionCompound_RTTI;
@@ -491,6 +521,9 @@ dgCollisionCompound::dgCollisionCompound (const dgCollisionCompound& source, con
 	for (iter.Begin(); iter; iter ++) {
 		dgNodeBase* const node = iter.GetNode()->GetInfo();
 		dgNodeBase* const newNode = new (m_allocator) dgNodeBase (node->GetShape());
+		newNode->m_massOrigin = node->m_massOrigin;
+		newNode->m_massInertia = node->m_massInertia;
+		newNode->m_massCrossInertia = node->m_massCrossInertia;
 		m_array.AddNode(newNode, iter.GetNode()->GetKey(), m_myInstance);
 	}
 
@@ -560,10 +593,14 @@ dgCollisionCompound::dgCollisionCompound (dgWorld* const world, dgDeserialize de
 	,m_root(NULL)
 	,m_myInstance(myInstance)
 	,m_array (world->GetAllocator())
+	,m_massOrigin(dgFloat32 (0.0f))
+	,m_massInertia(dgFloat32 (0.0f))
+	,m_massCrossInertia(dgFloat32 (0.0f))
 	,m_treeEntropy(dgFloat32(0.0f))
 	,m_boxMinRadius(dgFloat32(0.0f))
 	,m_boxMaxRadius(dgFloat32(0.0f))
 	,m_idIndex(0)
+	,m_changeCount(0)
 	,m_criticalSectionLock(0)
 {
 	dgAssert (m_rtti | dgCollisionCompound_RTTI);
@@ -839,32 +876,61 @@ void dgCollisionCompound::MassProperties ()
 #endif
 
 
-	dgFloat32 volume = dgFloat32 (0.0f);
-	dgVector origin (dgFloat32 (0.0f));
-	dgVector inertiaII (dgFloat32 (0.0f));
-	dgVector inertiaIJ (dgFloat32 (0.0f));
-	dgTreeArray::Iterator iter (m_array);
-	for (iter.Begin(); iter; iter ++) {
-		dgCollisionInstance* const collision = iter.GetNode()->GetInfo()->GetShape();
-		dgMatrix shapeInertia (collision->CalculateInertia());
-		dgFloat32 shapeVolume = collision->GetVolume();
-
-		volume += shapeVolume;
-		origin += shapeInertia.m_posit.Scale(shapeVolume);
-		inertiaII += dgVector (shapeInertia[0][0], shapeInertia[1][1], shapeInertia[2][2], dgFloat32 (0.0f)).Scale (shapeVolume);
-		inertiaIJ += dgVector (shapeInertia[1][2], shapeInertia[0][2], shapeInertia[0][1], dgFloat32 (0.0f)).Scale (shapeVolume);
-	}
+	// the children contributions are accumulated as they are added, removed or moved
+	dgFloat32 volume = m_massOrigin.m_w;
 	if (volume > dgFloat32 (0.0f)) { 
 		dgFloat32 invVolume = dgFloat32 (1.0f)/volume;
-		m_inertia = inertiaII.Scale (invVolume);
-		m_crossInertia = inertiaIJ.Scale (invVolume);
-		m_centerOfMass = origin.Scale (invVolume);
+		m_inertia = m_massInertia.Scale (invVolume);
+		m_crossInertia = m_massCrossInertia.Scale (invVolume);
+		m_centerOfMass = m_massOrigin.Scale (invVolume);
 		m_centerOfMass.m_w = volume;
 	}
 
 	dgCollision::MassProperties ();
 }
 
+void dgCollisionCompound::AddChildMass (dgNodeBase* const leaf)
+{
+	dgAssert (leaf->m_type == m_leaf);
+	if (!IsType (dgCollisionScene_RTTI)) {
+		dgCollisionInstance* const collision = leaf->GetShape();
+		dgMatrix shapeInertia (collision->CalculateInertia());
+		dgFloat32 shapeVolume = collision->GetVolume();
+
+		leaf->m_massOrigin = shapeInertia.m_posit.Scale(shapeVolume);
+		leaf->m_massOrigin.m_w = shapeVolume;
+		leaf->m_massInertia = dgVector (shapeInertia[0][0], shapeInertia[1][1], shapeInertia[2][2], dgFloat32 (0.0f)).Scale (shapeVolume);
+		leaf->m_massCrossInertia = dgVector (shapeInertia[1][2], shapeInertia[0][2], shapeInertia[0][1], dgFloat32 (0.0f)).Scale (shapeVolume);
+
+		m_massOrigin += leaf->m_massOrigin;
+		m_massInertia += leaf->m_massInertia;
+		m_massCrossInertia += leaf->m_massCrossInertia;
+	}
+}
+
+void dgCollisionCompound::RemoveChildMass (dgNodeBase* const leaf)
+{
+	dgAssert (leaf->m_type == m_leaf);
+	m_massOrigin -= leaf->m_massOrigin;
+	m_massInertia -= leaf->m_massInertia;
+	m_massCrossInertia -= leaf->m_massCrossInertia;
+	leaf->m_massOrigin = dgVector::m_zero;
+	leaf->m_massInertia = dgVector::m_zero;
+	leaf->m_massCrossInertia = dgVector::m_zero;
+}
+
+void dgCollisionCompound::CalculateChildrenMass ()
+{
+	// recalculate the sums from scratch, this also drops the round off accumulated by the incremental updates
+	m_massOrigin = dgVector::m_zero;
+	m_massInertia = dgVector::m_zero;
+	m_massCrossInertia = dgVector::m_zero;
+	dgTreeArray::Iterator iter (m_array);
+	for (iter.Begin(); iter; iter ++) {
+		AddChildMass (iter.GetNode()->GetInfo());
+	}
+}
+
 void dgCollisionCompound::ApplyScale (const dgVector& scale)
 {
 	dgTreeArray::Iterator iter (m_array);
@@ -994,6 +1060,15 @@ void dgCollisionCompound::EndAddRemove (bool flushCache)
 		//dgThreadHiveScopeLock lock (world, &m_criticalSectionLock);
 		dgScopeSpinLock lock(&m_criticalSectionLock);
 
+		// each change already refit and rotated the nodes on its path, and updated the mass sums, 
+		// the whole tree is only rebalanced after a large fraction of the children changed.
+		// an update with no changes still rebuilds everything, in case the children were edited directly
+		if (m_changeCount && (m_treeEntropy > dgFloat32 (0.0f)) && ((m_changeCount * 4) <= m_array.GetCount())) {
+			UpdateRootBox (flushCache);
+			return;
+		}
+		m_changeCount = 0;
+
 		dgTreeArray::Iterator iter (m_array);
 		for (iter.Begin(); iter; iter ++) {
 			dgNodeBase* const node = iter.GetNode()->GetInfo();
@@ -1051,26 +1126,56 @@ void dgCollisionCompound::EndAddRemove (bool flushCache)
 			m_treeEntropy = dgFloat32 (2.0f);
 		}
 
-		dgAssert (m_root->m_size.m_w == dgFloat32 (0.0f));
-		m_boxMinRadius = dgMin(m_root->m_size.m_x, m_root->m_size.m_y, m_root->m_size.m_z);
-		m_boxMaxRadius = dgSqrt (m_root->m_size.DotProduct(m_root->m_size).GetScalar());
+		CalculateChildrenMass ();
+		UpdateRootBox (flushCache);
+	}
+}
+
+void dgCollisionCompound::UpdateRootBox (bool flushCache)
+{
+	dgAssert (m_root->m_size.m_w == dgFloat32 (0.0f));
+	m_boxMinRadius = dgMin(m_root->m_size.m_x, m_root->m_size.m_y, m_root->m_size.m_z);
+	m_boxMaxRadius = dgSqrt (m_root->m_size.DotProduct(m_root->m_size).GetScalar());
 
-		m_boxSize = m_root->m_size;
-		m_boxOrigin = m_root->m_origin;
-		MassProperties ();
+	m_boxSize = m_root->m_size;
+	m_boxOrigin = m_root->m_origin;
+	MassProperties ();
 
-		if (flushCache) {
-			m_world->FlushCache ();
+	if (flushCache) {
+		m_world->FlushCache ();
+	}
+}
+
+void dgCollisionCompound::RefitNode (dgNodeBase* const node)
+{
+	for (dgNodeBase* parent = node; parent; parent = parent->m_parent) {
+		if (parent->m_type == m_node) {
+			dgVector minBox;
+			dgVector maxBox;
+			CalculateSurfaceArea (parent->m_left, parent->m_right, minBox, maxBox);
+			parent->SetBox (minBox, maxBox);
 		}
 	}
+
+	// the boxes on the path are tight again, rotating the path nodes keeps the tree fit until the next rebuild
+	dgNodeBase* parent = (node->m_type == m_node) ? node : node->m_parent;
+	while (parent && parent->m_parent) {
+		ImproveNodeFitness (parent);
+		parent = parent->m_parent;
+	}
+	while (m_root->m_parent) {
+		m_root = m_root->m_parent;
+	}
 }
 
 dgTree<dgCollisionCompound::dgNodeBase*, dgInt32>::dgTreeNode* dgCollisionCompound::AddCollision (dgCollisionInstance* const shape)
 {
 	dgNodeBase* const newNode = new (m_allocator) dgNodeBase (shape);
 	m_array.AddNode(newNode, m_idIndex, m_myInstance);
+	AddChildMass (newNode);
 
 	m_idIndex ++;
+	m_changeCount ++;
 
 	if (!m_root) {
 		m_root = newNode;
@@ -1123,6 +1228,7 @@ dgTree<dgCollisionCompound::dgNodeBase*, dgInt32>::dgTreeNode* dgCollisionCompou
 				node->m_parent = parent;
 			}
 		}
+		RefitNode (newNode);
 	}
 
 	return newNode->m_myNode;
@@ -1134,7 +1240,9 @@ void dgCollisionCompound::RemoveCollision (dgTreeArray::dgTreeNode* const node)
 	if (node) {
 		dgCollisionInstance* const instance = node->GetInfo()->GetShape();
 		instance->AddRef();
+		RemoveChildMass (node->GetInfo());
 		RemoveCollision (node->GetInfo());
+		m_changeCount ++;
 		instance->Release();
 		m_array.Remove(node);
 	}
@@ -1163,6 +1271,10 @@ void dgCollisionCompound::SetCollisionMatrix (dgTreeArray::dgTreeNode* const nod
 		//dgThreadHiveScopeLock lock (world, &m_criticalSectionLock);
 		dgScopeSpinLock lock(&m_criticalSectionLock);
 
+		RemoveChildMass (baseNode);
+		AddChildMass (baseNode);
+		m_changeCount ++;
+
 		baseNode->SetBox (p0, p1);
 		for (dgNodeBase* parent = baseNode->m_parent; parent; parent = parent->m_parent) {
 			dgVector minBox;
@@ -1176,6 +1288,36 @@ void dgCollisionCompound::SetCollisionMatrix (dgTreeArray::dgTreeNode* const nod
 	}
 }
 
+void dgCollisionCompound::SetCollisionMatrixArray (dgTreeArray::dgTreeNode** const nodeArray, const dgMatrix* const matrixArray, dgInt32 count)
+{
+	dgScopeSpinLock lock(&m_criticalSectionLock);
+
+	for (dgInt32 i = 0; i < count; i ++) {
+		dgNodeBase* const baseNode = nodeArray[i]->GetInfo();
+		dgCollisionInstance* const instance = baseNode->GetShape();
+
+		dgVector scale;
+		dgMatrix localMatrix;
+		matrixArray[i].PolarDecomposition(localMatrix, scale, instance->m_aligmentMatrix);
+		instance->SetLocalMatrix(localMatrix);
+		instance->SetScale(scale);
+
+		dgVector p0;
+		dgVector p1;
+		instance->CalcAABB(instance->GetLocalMatrix (), p0, p1);
+		baseNode->SetBox (p0, p1);
+
+		RemoveChildMass (baseNode);
+		AddChildMass (baseNode);
+	}
+	m_changeCount += count;
+
+	// all leafs have their new box now, refit each path bottom up
+	for (dgInt32 i = 0; i < count; i ++) {
+		RefitNode (nodeArray[i]->GetInfo());
+	}
+}
+
 
 void dgCollisionCompound::RemoveCollision (dgNodeBase* const treeNode)
 {
@@ -1219,6 +1361,7 @@ void dgCollisionCompound::RemoveCollision (dgNodeBase* const treeNode)
 			root->m_right->m_parent = root;
 		}
 		delete (treeNode->m_parent);
+		RefitNode (root);
 	}
 }
 
@@ -1900,13 +2043,177 @@ dgInt32 dgCollisionCompound::CalculateContactsToCompound (dgBroadPhase::dgPair*
 	return contactCount;
 }
 
-dgInt32 dgCollisionCompound::CalculateContactsToHeightField (dgBroadPhase::dgPair* const pair, dgCollisionParamProxy& proxy) const
+dgInt32 dgCollisionCompound::CompareMeshLeafIndex (const dgMeshLeaf* const leafA, const dgMeshLeaf* const leafB, void* const context)
+{
+	dgInt32 indexA = leafA->m_node->m_myNode->GetKey();
+	dgInt32 indexB = leafB->m_node->m_myNode->GetKey();
+	if (indexA < indexB) {
+		return -1;
+	}
+	if (indexA > indexB) {
+		return 1;
+	}
+	return 0;
+}
+
+dgInt32 dgCollisionCompound::RemoveDuplicatedLeafs (dgMeshLeaf* const leafArray, dgInt32 leafCount) const
+{
+	if (leafCount > 1) {
+		dgSort (leafArray, leafCount, CompareMeshLeafIndex);
+		dgInt32 count = 1;
+		for (dgInt32 i = 1; i < leafCount; i ++) {
+			if (leafArray[i].m_node != leafArray[count - 1].m_node) {
+				leafArray[count] = leafArray[i];
+				count ++;
+			}
+		}
+		leafCount = count;
+	}
+	return leafCount;
+}
+
+dgInt32 dgCollisionCompound::CalculateContactsToMeshLeafs (dgBroadPhase::dgPair* const pair, dgCollisionParamProxy& proxy, dgMeshLeaf* const leafArray, dgInt32 leafCount) const
 {
 	dgContactPoint* const contacts = proxy.m_contacts;
 
+	dgInt32 contactCount = 0;
+	dgContact* const contactJoint = pair->m_contact;
+	dgBody* const myBody = contactJoint->GetBody0();
+	dgBody* const meshBody = contactJoint->GetBody1();
+
+	dgCollisionInstance* const meshInstance = proxy.m_instance1;
+	const dgMatrix& myMatrix = myBody->m_collision->GetGlobalMatrix();
+	const dgContactMaterial* const material = contactJoint->GetMaterial();
+
+	dgAssert ((contacts != NULL) ^ proxy.m_intersectionTestOnly);
+	dgAssert (meshInstance->IsType (dgCollision::dgCollisionMesh_RTTI));
+
+	// building the faces of a height field is expensive, so children close to each other share one face query.
+	// a tree query is about as cheap as selecting the faces from a shared query, so tree children query directly.
+	dgCollisionHeightField* const heightField = meshInstance->IsType (dgCollision::dgCollisionHeightField_RTTI) ? (dgCollisionHeightField*) meshInstance->GetChildShape() : NULL;
+	const bool shareFaces = heightField && !(proxy.m_continueCollision || material->m_contactGeneration);
+
+	dgFloat32 timestep = pair->m_timestep;
+	dgFloat32 closestDist = dgFloat32 (1.0e10f);
+
+	dgInt32 count = 0;
+	for (dgInt32 i = 0; i < leafCount; i ++) {
+		dgNodeBase* const me = leafArray[i].m_node;
+		dgCollisionInstance* const subShape = me->GetShape();
+		if (subShape->GetCollisionMode()) {
+			bool processContacts = true;
+			if (material->m_compoundAABBOverlap) {
+				processContacts = material->m_compoundAABBOverlap (*contactJoint, timestep, myBody, me->m_myNode, meshBody, NULL, proxy.m_threadIndex);
+			}
+			if (processContacts) {
+				if (shareFaces) {
+					dgCollisionInstance childInstance (*subShape, subShape->GetChildShape());
+					childInstance.m_globalMatrix = childInstance.GetLocalMatrix() * myMatrix;
+					proxy.m_instance0 = &childInstance;
+					dgPolygonMeshDesc data (proxy, NULL);
+					data.GetQueryAABB (leafArray[count].m_p0, leafArray[count].m_p1);
+					childInstance.m_material.m_userData = NULL;
+					proxy.m_instance0 = NULL;
+				}
+				leafArray[count].m_node = me;
+				count ++;
+			}
+		}
+	}
+	leafCount = count;
+
+	dgInt32 stack = leafCount ? 1 : 0;
+	dgInt32 stackPool[DG_COMPOUND_STACK_DEPTH][2];
+	stackPool[0][0] = 0;
+	stackPool[0][1] = leafCount;
+	while (stack) {
+		stack --;
+		const dgInt32 start = stackPool[stack][0];
+		const dgInt32 clusterCount = stackPool[stack][1];
+
+		dgVector p0 (dgVector::m_zero);
+		dgVector p1 (dgVector::m_zero);
+		const bool useCluster = shareFaces && (clusterCount > 1);
+		if (useCluster) {
+			p0 = leafArray[start].m_p0;
+			p1 = leafArray[start].m_p1;
+			for (dgInt32 i = 1; i < clusterCount; i ++) {
+				p0 = p0.GetMin (leafArray[start + i].m_p0);
+				p1 = p1.GetMax (leafArray[start + i].m_p1);
+			}
+			const dgVector padding (meshInstance->GetInvScale().Scale (proxy.m_skinThickness + DG_COMPOUND_MESH_CLUSTER_PADDING) & dgVector::m_triplexMask);
+			p0 -= padding;
+			p1 += padding;
+
+			// a group that would gather more faces than the descriptor can hold is split in two, 
+			// the leafs come in tree order so each half is still a compact group.
+			dgVector size (p1 - p0);
+			dgFloat32 cells = (size.m_x * heightField->m_horizontalScaleInv_x + dgFloat32 (2.0f)) * (size.m_z * heightField->m_horizontalScaleInv_z + dgFloat32 (2.0f));
+			if ((dgFloat32 (2.0f) * cells) >= dgFloat32 (DG_MAX_COLLIDING_FACES / 2)) {
+				const dgInt32 leftCount = clusterCount / 2;
+
+				dgAssert ((stack + 2) <= DG_COMPOUND_STACK_DEPTH);
+				stackPool[stack][0] = start + leftCount;
+				stackPool[stack][1] = clusterCount - leftCount;
+				stack ++;
+				stackPool[stack][0] = start;
+				stackPool[stack][1] = leftCount;
+				stack ++;
+				continue;
+			}
+		}
+
+		dgPolygonMeshDesc cluster (proxy, p0, p1);
+		if (useCluster) {
+			heightField->GetCollidingFaces (&cluster);
+			if (!cluster.m_faceCount) {
+				// no child of this group touches the height field
+				continue;
+			}
+		}
+
+		for (dgInt32 i = 0; i < clusterCount; i ++) {
+			dgNodeBase* const me = leafArray[start + i].m_node;
+			dgCollisionInstance* const subShape = me->GetShape();
+			dgCollisionInstance childInstance (*subShape, subShape->GetChildShape());
+			childInstance.m_globalMatrix = childInstance.GetLocalMatrix() * myMatrix;
+			proxy.m_instance0 = &childInstance; 
+
+			proxy.m_maxContacts = DG_MAX_CONTATCS - contactCount;
+			proxy.m_contacts = contacts ? &contacts[contactCount] : contacts;
+
+			dgInt32 count = m_world->CalculateConvexToNonConvexContacts (proxy, useCluster ? &cluster : NULL);
+			closestDist = dgMin(closestDist, contactJoint->m_closestDistance);
+
+			childInstance.m_material.m_userData = NULL;
+			proxy.m_instance0 = NULL;
+
+			if (!proxy.m_intersectionTestOnly) {
+				for (dgInt32 j = 0; j < count; j ++) {
+					dgAssert (contacts[contactCount + j].m_collision0 == &childInstance);
+					contacts[contactCount + j].m_collision0 = subShape;
+				}
+				contactCount += count;
+				if (contactCount > (DG_MAX_CONTATCS - 2 * (DG_CONSTRAINT_MAX_ROWS / 3))) {
+					contactCount = m_world->PruneContacts(contactCount, contacts, proxy.m_contactJoint->GetPruningTolerance(), 16);
+				}
+			} else if (count == -1) {
+				contactCount = -1;
+				stack = 0;
+				break;
+			}
+		}
+	}
+
+	contactJoint->m_closestDistance = closestDist;
+	proxy.m_contacts = contacts;	
+	return contactCount;
+}
+
+dgInt32 dgCollisionCompound::CalculateContactsToHeightField (dgBroadPhase::dgPair* const pair, dgCollisionParamProxy& proxy) const
+{
 	const dgNodeBase* stackPool[DG_COMPOUND_STACK_DEPTH];
 
-	dgInt32 contactCount = 0;
 	dgContact* const contactJoint = pair->m_contact;
 	dgBody* const myBody = contactJoint->GetBody0();
 	dgBody* const terrainBody = contactJoint->GetBody1();
@@ -1932,12 +2239,9 @@ dgInt32 dgCollisionCompound::CalculateContactsToHeightField (dgBroadPhase::dgPai
 	dgNodeBase nodeProxi;
 	nodeProxi.m_left = NULL;
 	nodeProxi.m_right = NULL;
-	const dgContactMaterial* const material = contactJoint->GetMaterial();
 
-	dgAssert ((contacts != NULL) ^ proxy.m_intersectionTestOnly);
-
-	dgFloat32 timestep = pair->m_timestep;
-	dgFloat32 closestDist = dgFloat32 (1.0e10f);
+	dgInt32 leafCount = 0;
+	dgStack<dgMeshLeaf> leafArray (m_array.GetCount() + 1);
 
 	const dgVector heighFieldScale(terrainInstance->GetScale());
 	const dgVector heighFieldInvScale(terrainInstance->GetInvScale());
@@ -1956,43 +2260,9 @@ dgInt32 dgCollisionCompound::CalculateContactsToHeightField (dgBroadPhase::dgPai
 		nodeProxi.m_origin = dgVector::m_half * (nodeProxi.m_p1 + nodeProxi.m_p0);
 		if (me->BoxTest (data, &nodeProxi)) {
 			if (me->m_type == m_leaf) {
-				dgCollisionInstance* const subShape = me->GetShape();
-				if (subShape->GetCollisionMode()) {
-					bool processContacts = true;
-					if (material->m_compoundAABBOverlap) {
-						processContacts = material->m_compoundAABBOverlap (*contactJoint, timestep, myBody, me->m_myNode, terrainBody, NULL, proxy.m_threadIndex);
-					}
-					if (processContacts) {
-						dgCollisionInstance childInstance (*subShape, subShape->GetChildShape());
-						childInstance.m_globalMatrix = childInstance.GetLocalMatrix() * compoundMatrix;
-						proxy.m_instance0 = &childInstance; 
-
-						proxy.m_maxContacts = DG_MAX_CONTATCS - contactCount;
-						proxy.m_contacts = contacts ? &contacts[contactCount] : contacts;
-
-						dgInt32 count = 0;
-						count += m_world->CalculateConvexToNonConvexContacts (proxy);
-						closestDist = dgMin(closestDist, contactJoint->m_closestDistance);
-
-						if (!proxy.m_intersectionTestOnly) {
-							for (dgInt32 i = 0; i < count; i ++) {
-								dgAssert (contacts[contactCount + i].m_collision0 == &childInstance);
-								contacts[contactCount + i].m_collision0 = subShape;
-							}
-							contactCount += count;
-
-							if (contactCount > (DG_MAX_CONTATCS - 2 * (DG_CONSTRAINT_MAX_ROWS / 3))) {
-								contactCount = m_world->PruneContacts(contactCount, contacts, proxy.m_contactJoint->GetPruningTolerance(), 16);
-							}
-						} else if (count == -1) {
-							contactCount = -1;
-							break;
-						}
-						childInstance.m_material.m_userData = NULL;
-						proxy.m_instance0 = NULL;
-					}
-				}
-
+				dgAssert (leafCount < leafArray.GetElementsCount());
+				leafArray[leafCount].m_node = (dgNodeBase*) me;
+				leafCount ++;
 			} else {
 				dgAssert (me->m_type == m_node);
 				stackPool[stack] = me->m_left;
@@ -2004,9 +2274,7 @@ dgInt32 dgCollisionCompound::CalculateContactsToHeightField (dgBroadPhase::dgPai
 		}
 	}
 
-	contactJoint->m_closestDistance = closestDist;
-	proxy.m_contacts = contacts;	
-	return contactCount;
+	return CalculateContactsToMeshLeafs (pair, proxy, &leafArray[0], leafCount);
 }
 
 
@@ -2212,12 +2480,8 @@ dgInt32 dgCollisionCompound::CalculateContactsToSingle (dgBroadPhase::dgPair* co
 
 dgInt32 dgCollisionCompound::CalculateContactsToCollisionTree (dgBroadPhase::dgPair* const pair, dgCollisionParamProxy& proxy) const
 {
-	dgContactPoint* const contacts = proxy.m_contacts;
-
 	dgNodePairs stackPool[4 * DG_COMPOUND_STACK_DEPTH];
 
-	dgInt32 contactCount = 0;
-
 	dgContact* const contactJoint = pair->m_contact;
 	dgBody* const myBody = contactJoint->GetBody0();
 	dgBody* const treeBody = contactJoint->GetBody1();
@@ -2245,13 +2509,10 @@ dgInt32 dgCollisionCompound::CalculateContactsToCollisionTree (dgBroadPhase::dgP
 	nodeProxi.m_left = NULL;
 	nodeProxi.m_right = NULL;
 
-	const dgContactMaterial* const material = contactJoint->GetMaterial();
 	const dgVector& treeScale = treeCollisionInstance->GetScale();
 
-	dgAssert ((contacts != NULL) ^ proxy.m_intersectionTestOnly);
-
-	dgFloat32 timestep = pair->m_timestep;
-	dgFloat32 closestDist = dgFloat32 (1.0e10f);
+	dgInt32 leafCount = 0;
+	dgStack<dgMeshLeaf> leafArray (2 * m_array.GetCount() + 1);
 	while (stack) {
 
 		stack --;
@@ -2276,87 +2537,14 @@ dgInt32 dgCollisionCompound::CalculateContactsToCollisionTree (dgBroadPhase::dgP
 		nodeProxi.m_area = nodeProxi.m_size.ShiftTripleRight().DotProduct(nodeProxi.m_size).GetScalar();
 
 		if (me->BoxTest (data, &nodeProxi)) {
-			if ((me->m_type == m_leaf) && treeNodeIsLeaf) {
-				dgCollisionInstance* const subShape = me->GetShape();
-				if (subShape->GetCollisionMode()) {
-					bool processContacts = true;
-					if (material->m_compoundAABBOverlap) {
-						processContacts = material->m_compoundAABBOverlap (*contactJoint, timestep, myBody, me->m_myNode, treeBody, NULL, proxy.m_threadIndex);
-					}
-					if (processContacts) {
-						dgCollisionInstance childInstance (*subShape, subShape->GetChildShape());
-						childInstance.m_globalMatrix = childInstance.GetLocalMatrix() * myMatrix;
-						proxy.m_instance0 = &childInstance; 
-
-						proxy.m_maxContacts = DG_MAX_CONTATCS - contactCount;
-						proxy.m_contacts = contacts ? &contacts[contactCount] : contacts;
-
-						dgInt32 count = m_world->CalculateConvexToNonConvexContacts (proxy);
-						closestDist = dgMin(closestDist, contactJoint->m_closestDistance);
-
-						if (!proxy.m_intersectionTestOnly) {
-							for (dgInt32 i = 0; i < count; i ++) {
-								dgAssert (contacts[contactCount + i].m_collision0 == &childInstance);
-								contacts[contactCount + i].m_collision0 = subShape;
-							}
-							contactCount += count;
-							if (contactCount > (DG_MAX_CONTATCS - 2 * (DG_CONSTRAINT_MAX_ROWS / 3))) {
-								contactCount = m_world->PruneContacts(contactCount, contacts, proxy.m_contactJoint->GetPruningTolerance(), 16);
-							}
-						} else if (count == -1) {
-							contactCount = -1;
-							break;
-						}
-						//childInstance.SetUserData(NULL);
-
-						childInstance.m_material.m_userData = NULL;
-						proxy.m_instance0 = NULL; 
-					}
-				}
-
-			} else if (me->m_type == m_leaf) {
-				void* const frontNode = treeCollision->GetFrontNode(other);
-				void* const backNode = treeCollision->GetBackNode(other);
-				if (backNode && frontNode) {
-					stackPool[stack].m_myNode = me;
-					stackPool[stack].m_treeNode = backNode;
-					stackPool[stack].m_treeNodeIsLeaf = 0;
-					stack++;
-
-					stackPool[stack].m_myNode = me;
-					stackPool[stack].m_treeNode = frontNode;
-					stackPool[stack].m_treeNodeIsLeaf = 0;
-					stack++;
-
-				} else if (backNode && !frontNode) {
-					stackPool[stack].m_myNode = me;
-					stackPool[stack].m_treeNode = backNode;
-					stackPool[stack].m_treeNodeIsLeaf = 0;
-
-					stack++;
-
-					stackPool[stack].m_myNode = me;
-					stackPool[stack].m_treeNode = other;
-					stackPool[stack].m_treeNodeIsLeaf = 1;
-					stack++;
-
-				} else if (!backNode && frontNode) {
-					stackPool[stack].m_myNode = me;
-					stackPool[stack].m_treeNode = frontNode;
-					stackPool[stack].m_treeNodeIsLeaf = 0;
-					stack++;
-
-					stackPool[stack].m_myNode = me;
-					stackPool[stack].m_treeNode = other;
-					stackPool[stack].m_treeNodeIsLeaf = 1;
-					stack++;
-
-				} else {
-					stackPool[stack].m_myNode = me;
-					stackPool[stack].m_treeNode = other;
-					stackPool[stack].m_treeNodeIsLeaf = 1;
-					stack++;
+			if (me->m_type == m_leaf) {
+				// a leaf can overlap more than one mesh node, the duplicates are removed before the contacts are calculated
+				if (leafCount >= leafArray.GetElementsCount()) {
+					leafCount = RemoveDuplicatedLeafs (&leafArray[0], leafCount);
 				}
+				dgAssert (leafCount < leafArray.GetElementsCount());
+				leafArray[leafCount].m_node = me;
+				leafCount ++;
 
 			} else if (treeNodeIsLeaf) {
 				stackPool[stack].m_myNode = me->m_left;
@@ -2439,9 +2627,7 @@ dgInt32 dgCollisionCompound::CalculateContactsToCollisionTree (dgBroadPhase::dgP
 		}
 	}
 
-	contactJoint->m_closestDistance = closestDist;
-	proxy.m_contacts = contacts;	
-	return contactCount;
+	return CalculateContactsToMeshLeafs (pair, proxy, &leafArray[0], RemoveDuplicatedLeafs (&leafArray[0], leafCount));
 }
 
 
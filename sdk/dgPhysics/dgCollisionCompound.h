@@ -112,6 +112,9 @@ class dgCollisionCompound: public dgCollision
 		dgVector m_p1;
 		dgVector m_size;
 		dgVector m_origin;
+		dgVector m_massOrigin;
+		dgVector m_massInertia;
+		dgVector m_massCrossInertia;
 		dgFloat32 m_area;
 		dgInt32 m_type;
 		dgNodeBase* m_left;
@@ -130,6 +133,7 @@ class dgCollisionCompound: public dgCollision
 		dgInt32 m_treeNodeIsLeaf;
 	};
 
+	class dgMeshLeaf;
 	class dgSpliteInfo;
 	class dgHeapNodePair;
 
@@ -145,6 +149,7 @@ class dgCollisionCompound: public dgCollision
 	virtual dgTreeArray::dgTreeNode* AddCollision (dgCollisionInstance* const part);
 	virtual void RemoveCollision (dgTreeArray::dgTreeNode* const node);
 	virtual void SetCollisionMatrix (dgTreeArray::dgTreeNode* const node, const dgMatrix& matrix);
+	virtual void SetCollisionMatrixArray (dgTreeArray::dgTreeNode** const nodeArray, const dgMatrix* const matrixArray, dgInt32 count);
 	virtual void EndAddRemove (bool flushCache = true);
 
 	void ApplyScale (const dgVector& scale);
@@ -193,6 +198,8 @@ class dgCollisionCompound: public dgCollision
 	dgInt32 CalculateContactsToCollisionTreeContinue (dgBroadPhase::dgPair* const pair, dgCollisionParamProxy& proxy) const;
 	dgInt32 CalculateContactsToHeightField (dgBroadPhase::dgPair* const pair, dgCollisionParamProxy& proxy) const;
 	dgInt32 CalculateContactsUserDefinedCollision (dgBroadPhase::dgPair* const pair, dgCollisionParamProxy& proxy) const;
+	dgInt32 CalculateContactsToMeshLeafs (dgBroadPhase::dgPair* const pair, dgCollisionParamProxy& proxy, dgMeshLeaf* const leafArray, dgInt32 leafCount) const;
+	dgInt32 RemoveDuplicatedLeafs (dgMeshLeaf* const leafArray, dgInt32 leafCount) const;
 	dgInt32 ClosestDistance (dgCollisionParamProxy& proxy) const;
 	dgInt32 ClosestDistanceToConvex (dgCollisionParamProxy& proxy) const;
 	dgInt32 ClosestDistanceToCompound (dgCollisionParamProxy& proxy) const;
@@ -207,6 +214,11 @@ class dgCollisionCompound: public dgCollision
 	dgFloat64 CalculateEntropy (dgList<dgNodeBase*>& list);
 
 	void ImproveNodeFitness (dgNodeBase* const node) const;
+	void RefitNode (dgNodeBase* const node);
+	void UpdateRootBox (bool flushCache);
+	void AddChildMass (dgNodeBase* const leaf);
+	void RemoveChildMass (dgNodeBase* const leaf);
+	void CalculateChildrenMass ();
 	DG_INLINE dgFloat32 CalculateSurfaceArea (dgNodeBase* const node0, dgNodeBase* const node1, dgVector& minBox, dgVector& maxBox) const;
 
 	dgInt32 CalculatePlaneIntersection (const dgVector& normal, const dgVector& point, dgVector* const contactsOut) const;
@@ -214,16 +226,21 @@ class dgCollisionCompound: public dgCollision
 	void PushNode (const dgMatrix& matrix, dgUpHeap<dgHeapNodePair, dgFloat32>& heap, dgNodeBase* const myNode, dgNodeBase* const otehrNode) const;
 
 	static dgInt32 CompareNodes (const dgNodeBase* const nodeA, const dgNodeBase* const nodeB, void* notUsed);
+	static dgInt32 CompareMeshLeafIndex (const dgMeshLeaf* const leafA, const dgMeshLeaf* const leafB, void* const context);
 
 
 	dgWorld* m_world;	
 	dgNodeBase* m_root;
 	const dgCollisionInstance* m_myInstance;
 	dgTreeArray m_array;
+	dgVector m_massOrigin;
+	dgVector m_massInertia;
+	dgVector m_massCrossInertia;
 	dgFloat64 m_treeEntropy;
 	dgFloat32 m_boxMinRadius;
 	dgFloat32 m_boxMaxRadius;
 	dgInt32 m_idIndex;
+	dgInt32 m_changeCount;
 	dgInt32 m_criticalSectionLock;
 
 	static dgVector m_padding;
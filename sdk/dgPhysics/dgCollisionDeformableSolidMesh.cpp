@@ -212,9 +212,8 @@ dgFloat32 kVolumetricStiffness = dgFloat32(20000000.0f);
 //	dgFloat32* const spring_B01 = dgAlloca(dgFloat32, m_linksCount);
 //	dgFloat32* const frictionCoeffecient = dgAlloca(dgFloat32, m_particlesCount);
 
-	dgWorld* const world = m_body->GetWorld();
-	world->m_solverJacobiansMemory.ResizeIfNecessary (GetMemoryBufferSizeInBytes() + 1024);
-	dgVector* const dx = (dgVector*)&world->m_solverJacobiansMemory[0];
+	m_scratchMemory.ResizeIfNecessary (GetMemoryBufferSizeInBytes() + 1024);
+	dgVector* const dx = (dgVector*)&m_scratchMemory[0];
 	dgVector* const dv = &dx[m_linksCount];
 	dgVector* const dpdv = &dv[m_linksCount];
 	dgVector* const normalAccel = &dpdv[m_linksCount];
@@ -30,6 +30,7 @@
 dgVector dgCollisionHeightField::m_yMask (0xffffffff, 0, 0xffffffff, 0);
 dgVector dgCollisionHeightField::m_padding (dgFloat32 (0.25f), dgFloat32 (0.25f), dgFloat32 (0.25f), dgFloat32 (0.0f));
 dgVector dgCollisionHeightField::m_elevationPadding (dgFloat32 (0.0f), dgFloat32 (1.0e10f), dgFloat32 (0.0f), dgFloat32 (0.0f));
+dgVector dgCollisionHeightField::m_pyramidPadding (dgFloat32 (1.0e-3f), dgFloat32 (1.0e-3f), dgFloat32 (1.0e-3f), dgFloat32 (0.0f));
 
 dgInt32 dgCollisionHeightField::m_cellIndices[][4] =
 {
@@ -69,6 +70,7 @@ dgCollisionHeightField::dgCollisionHeightField(
 	,m_horizontalScaleInv_z(dgFloat32(1.0f) / m_horizontalScale_z)
 	,m_userRayCastCallback(NULL)
 	,m_elevationDataType(elevationDataType)
+	,m_tileCache(NULL)
 {
 	m_rtti |= dgCollisionHeightField_RTTI;
 
@@ -227,27 +229,59 @@ dgCollisionHeightField::dgCollisionHeightField(
 	}
 	memcpy (m_atributeMap, atributeMap, m_width * m_height * sizeof (dgInt8));
 
-	dgTree<void*, unsigned>::dgTreeNode* nodeData = world->m_perInstanceData.Find(DG_HIGHTFIELD_DATA_ID);
-	if (!nodeData) {
-		m_instanceData = (dgPerIntanceData*) new dgPerIntanceData();
-		m_instanceData->m_refCount = 0;
-		m_instanceData->m_world = world;
-		for (dgInt32 i = 0 ; i < DG_MAX_THREADS_HIVE_COUNT; i ++) {
-			m_instanceData->m_vertex[i] = NULL;
-			m_instanceData->m_vertexCount[i] = 0;
-			m_instanceData->m_vertex[i].SetAllocator(world->GetAllocator());
-			AllocateVertex(world, i);
-		}
-		nodeData = world->m_perInstanceData.Insert (m_instanceData, DG_HIGHTFIELD_DATA_ID);
-	}
-	m_instanceData = (dgPerIntanceData*) nodeData->GetInfo();
+	AttachPerInstanceData(world);
 
-	m_instanceData->m_refCount ++;
+	AllocateElevationPyramid();
+	BuildElevationPyramid();
 
 	CalculateAABB();
 	SetCollisionBBox(m_minBox, m_maxBox);
 }
 
+dgCollisionHeightField::dgCollisionHeightField(
+	dgWorld* const world, dgInt32 width, dgInt32 height, dgInt32 tileSize, dgInt32 maxResidentTiles, dgInt32 contructionMode, 
+	dgElevationType elevationDataType, dgFloat32 minElevation, dgFloat32 maxElevation, dgFloat32 verticalScale, 
+	dgFloat32 horizontalScale_x, dgFloat32 horizontalScale_z, dgCollisionHeightFieldTilePageInCallback pageInCallback, void* const pageInUserData)
+	:dgCollisionMesh (world, m_heightField)
+	,m_width(width)
+	,m_height(height)
+	,m_diagonalMode (dgCollisionHeightFieldGridConstruction  (dgClamp (contructionMode, dgInt32 (m_normalDiagonals), dgInt32 (m_starInvertexDiagonals))))
+	,m_atributeMap(NULL)
+	,m_diagonals(NULL)
+	,m_elevationMap(NULL)
+	,m_verticalScale(verticalScale)
+	,m_horizontalScale_x(horizontalScale_x)
+	,m_horizontalScaleInv_x (dgFloat32 (1.0f) / m_horizontalScale_x)
+	,m_horizontalScale_z(horizontalScale_z)
+	,m_horizontalScaleInv_z(dgFloat32(1.0f) / m_horizontalScale_z)
+	,m_userRayCastCallback(NULL)
+	,m_elevationDataType(elevationDataType)
+	,m_elevationPyramid(NULL)
+	,m_pyramidLevels(0)
+	,m_pyramidSize(0)
+	,m_tileCache(NULL)
+{
+	m_rtti |= dgCollisionHeightField_RTTI;
+
+	// tiles start at an even row and column so that the alternating diagonal patterns line up across tiles
+	tileSize = dgMax ((tileSize + 1) & -2, 2);
+
+	m_tileCache = new (world->GetAllocator()) dgTileCache (world->GetAllocator());
+	m_tileCache->m_pageInCallback = pageInCallback;
+	m_tileCache->m_pageInUserData = pageInUserData;
+	m_tileCache->m_tileSize = tileSize;
+	m_tileCache->m_tileCountX = (m_width - 1 + tileSize - 1) / tileSize;
+	m_tileCache->m_tileCountZ = (m_height - 1 + tileSize - 1) / tileSize;
+	m_tileCache->m_maxResidentTiles = dgMax (maxResidentTiles, 1);
+
+	AttachPerInstanceData(world);
+
+	// the elevation range can not be scanned without loading the entire map, so the application provides it 
+	m_minBox = dgVector (dgFloat32 (0.0f), minElevation * m_verticalScale, dgFloat32 (0.0f), dgFloat32 (0.0f)); 
+	m_maxBox = dgVector (dgFloat32 (m_width - 1) * m_horizontalScale_x, maxElevation * m_verticalScale, dgFloat32 (m_height - 1) * m_horizontalScale_z, dgFloat32 (0.0f)); 
+	SetCollisionBBox(m_minBox, m_maxBox);
+}
+
 dgCollisionHeightField::dgCollisionHeightField (dgWorld* const world, dgDeserialize deserialization, void* const userData, dgInt32 revisionNumber)
 	:dgCollisionMesh (world, deserialization, userData, revisionNumber)
 {
@@ -268,62 +302,315 @@ dgCollisionHeightField::dgCollisionHeightField (dgWorld* const world, dgDeserial
 
 	m_elevationDataType = dgElevationType (elevationDataType);
 
-	dgInt32 attibutePaddedMapSize = (m_width * m_height + 4) & -4; 
-	m_atributeMap = (dgInt8 *)dgMallocStack(attibutePaddedMapSize * sizeof (dgInt8));
-	m_diagonals = (dgInt8 *)dgMallocStack(attibutePaddedMapSize * sizeof (dgInt8));
+	dgInt32 tileSize = 0;
+	dgInt32 maxResidentTiles = 0;
+	if (revisionNumber >= m_collisionAccelerationRevision) {
+		deserialization (userData, &tileSize, sizeof (dgInt32));
+		deserialization (userData, &maxResidentTiles, sizeof (dgInt32));
+	}
 
-	switch (m_elevationDataType) 
-	{
-		case m_float32Bit:
+	m_tileCache = NULL;
+	if (tileSize) {
+		// the elevation of a tiled height field is not part of the stream, 
+		// the application has to set the page in callback again before the tiles can be loaded 
+		m_atributeMap = NULL;
+		m_diagonals = NULL;
+		m_elevationMap = NULL;
+		m_elevationPyramid = NULL;
+		m_pyramidSize = 0;
+		m_pyramidLevels = 0;
+		m_tileCache = new (world->GetAllocator()) dgTileCache (world->GetAllocator());
+		m_tileCache->m_tileSize = tileSize;
+		m_tileCache->m_tileCountX = (m_width - 1 + tileSize - 1) / tileSize;
+		m_tileCache->m_tileCountZ = (m_height - 1 + tileSize - 1) / tileSize;
+		m_tileCache->m_maxResidentTiles = dgMax (maxResidentTiles, 1);
+	} else {
+		dgInt32 attibutePaddedMapSize = (m_width * m_height + 4) & -4; 
+		m_atributeMap = (dgInt8 *)dgMallocStack(attibutePaddedMapSize * sizeof (dgInt8));
+		m_diagonals = (dgInt8 *)dgMallocStack(attibutePaddedMapSize * sizeof (dgInt8));
+
+		switch (m_elevationDataType) 
 		{
-			m_elevationMap = dgMallocStack(m_width * m_height * sizeof (dgFloat32));
-			deserialization (userData, m_elevationMap, m_width * m_height * sizeof (dgFloat32));
-			break;
+			case m_float32Bit:
+			{
+				m_elevationMap = dgMallocStack(m_width * m_height * sizeof (dgFloat32));
+				deserialization (userData, m_elevationMap, m_width * m_height * sizeof (dgFloat32));
+				break;
+			}
+
+			case m_unsigned16Bit:
+			{
+				m_elevationMap = dgMallocStack(m_width * m_height * sizeof (dgUnsigned16));
+				deserialization (userData, m_elevationMap, m_width * m_height * sizeof (dgUnsigned16));
+				break;
+			}
 		}
+		deserialization (userData, m_atributeMap, attibutePaddedMapSize * sizeof (dgInt8));
+		deserialization (userData, m_diagonals, attibutePaddedMapSize * sizeof (dgInt8));
 
-		case m_unsigned16Bit:
-		{
-			m_elevationMap = dgMallocStack(m_width * m_height * sizeof (dgUnsigned16));
-			deserialization (userData, m_elevationMap, m_width * m_height * sizeof (dgUnsigned16));
-			break;
+		AllocateElevationPyramid();
+		if (revisionNumber >= m_collisionAccelerationRevision) {
+			deserialization (userData, m_elevationPyramid, 2 * m_pyramidSize * sizeof (dgFloat32));
+		} else {
+			BuildElevationPyramid();
 		}
 	}
-	deserialization (userData, m_atributeMap, attibutePaddedMapSize * sizeof (dgInt8));
-	deserialization (userData, m_diagonals, attibutePaddedMapSize * sizeof (dgInt8));
 
 	m_horizontalScaleInv_x = dgFloat32 (1.0f) / m_horizontalScale_x;
 	m_horizontalScaleInv_z = dgFloat32 (1.0f) / m_horizontalScale_z;
 
+	AttachPerInstanceData(world);
+	SetCollisionBBox(m_minBox, m_maxBox);
+}
+
+dgCollisionHeightField::~dgCollisionHeightField(void)
+{
+	if (m_tileCache) {
+		// tiles hold a reference to the per instance data, so they must go first
+		delete m_tileCache;
+	} else {
+		dgFreeStack(m_elevationMap);
+		dgFreeStack(m_atributeMap);
+		dgFreeStack(m_diagonals);
+		dgFreeStack(m_elevationPyramid);
+	}
+
+	ReleasePerInstanceData (m_instanceData);
+}
+
+// the vertex scratch buffers are per world and per thread, all height fields of a world share them
+dgCollisionHeightField::dgPerIntanceData* dgCollisionHeightField::AcquirePerInstanceData(dgWorld* const world)
+{
 	dgTree<void*, unsigned>::dgTreeNode* nodeData = world->m_perInstanceData.Find(DG_HIGHTFIELD_DATA_ID);
 	if (!nodeData) {
-		m_instanceData = (dgPerIntanceData*) new dgPerIntanceData();
-		m_instanceData->m_refCount = 0;
-		m_instanceData->m_world = world;
-		for (dgInt32 i = 0; i < DG_MAX_THREADS_HIVE_COUNT; i++) {
-			m_instanceData->m_vertex[i] = NULL;
-			m_instanceData->m_vertexCount[i] = 0;
-			m_instanceData->m_vertex[i].SetAllocator(world->GetAllocator());
-			AllocateVertex(world, i);
+		dgPerIntanceData* const instanceData = (dgPerIntanceData*) new dgPerIntanceData();
+		instanceData->m_refCount = 0;
+		instanceData->m_lock = 0;
+		instanceData->m_world = world;
+		for (dgInt32 i = 0 ; i < DG_MAX_THREADS_HIVE_COUNT; i ++) {
+			instanceData->m_vertex[i] = NULL;
+			instanceData->m_vertexCount[i] = 0;
+			instanceData->m_vertex[i].SetAllocator(world->GetAllocator());
+			instanceData->m_tileVertex[i].SetAllocator(world->GetAllocator());
+			instanceData->m_tileIndices[i].SetAllocator(world->GetAllocator());
+			AllocateVertex(instanceData, i);
 		}
-		nodeData = world->m_perInstanceData.Insert(m_instanceData, DG_HIGHTFIELD_DATA_ID);
+		nodeData = world->m_perInstanceData.Insert (instanceData, DG_HIGHTFIELD_DATA_ID);
 	}
-	m_instanceData = (dgPerIntanceData*)nodeData->GetInfo();
-
-	m_instanceData->m_refCount ++;
-	SetCollisionBBox(m_minBox, m_maxBox);
+	dgPerIntanceData* const instanceData = (dgPerIntanceData*) nodeData->GetInfo();
+	dgAtomicExchangeAndAdd (&instanceData->m_refCount, 1);
+	return instanceData;
 }
 
-dgCollisionHeightField::~dgCollisionHeightField(void)
+void dgCollisionHeightField::ReleasePerInstanceData(dgPerIntanceData* const instanceData)
 {
-	m_instanceData->m_refCount --;
-	if (!m_instanceData->m_refCount) {
-		dgWorld* const world = m_instanceData->m_world;
-		delete m_instanceData;
+	// shared height fields can be released by other worlds threads
+	if (dgAtomicExchangeAndAdd (&instanceData->m_refCount, -1) == 1) {
+		dgWorld* const world = instanceData->m_world;
+		delete instanceData;
 		world->m_perInstanceData.Remove(DG_HIGHTFIELD_DATA_ID);
 	}
-	dgFreeStack(m_elevationMap);
-	dgFreeStack(m_atributeMap);
-	dgFreeStack(m_diagonals);
+}
+
+void dgCollisionHeightField::AttachPerInstanceData(dgWorld* const world)
+{
+	m_instanceData = AcquirePerInstanceData (world);
+}
+
+void dgCollisionHeightField::AttachWorld (dgWorld* const world) const
+{
+	AcquirePerInstanceData (world);
+}
+
+void dgCollisionHeightField::DetachWorld (dgWorld* const world) const
+{
+	dgTree<void*, unsigned>::dgTreeNode* const nodeData = world->m_perInstanceData.Find(DG_HIGHTFIELD_DATA_ID);
+	dgAssert (nodeData);
+	ReleasePerInstanceData ((dgPerIntanceData*) nodeData->GetInfo());
+}
+
+dgCollisionHeightField::dgPerIntanceData* dgCollisionHeightField::GetPerInstanceData (const dgWorld* const world) const
+{
+	if (world == m_instanceData->m_world) {
+		return m_instanceData;
+	}
+	// the shape is shared with other worlds, the buffers were allocated when the instance was created in this world
+	dgTree<void*, unsigned>::dgTreeNode* const nodeData = world->m_perInstanceData.Find(DG_HIGHTFIELD_DATA_ID);
+	dgAssert (nodeData);
+	return (dgPerIntanceData*) nodeData->GetInfo();
+}
+
+dgCollisionHeightField::dgTileCache::dgTileCache(dgMemoryAllocator* const allocator)
+	:m_residentList(allocator)
+	,m_tileMap(allocator)
+	,m_pageInCallback(NULL)
+	,m_pageInUserData(NULL)
+	,m_tileSize(0)
+	,m_tileCountX(0)
+	,m_tileCountZ(0)
+	,m_maxResidentTiles(0)
+{
+}
+
+dgCollisionHeightField::dgTileCache::~dgTileCache()
+{
+	for (dgList<dgTile>::dgListNode* node = m_residentList.GetFirst(); node; node = node->GetNext()) {
+		dgAssert (!node->GetInfo().m_useCount);
+		node->GetInfo().m_shape->Release();
+	}
+}
+
+void dgCollisionHeightField::SetTilePageInCallback (dgCollisionHeightFieldTilePageInCallback pageInCallback, void* const userData)
+{
+	if (m_tileCache) {
+		dgScopeSpinPause lock (&m_instanceData->m_lock);
+		m_tileCache->m_pageInCallback = pageInCallback;
+		m_tileCache->m_pageInUserData = userData;
+	}
+}
+
+dgInt32 dgCollisionHeightField::GetResidentTileCount() const
+{
+	return m_tileCache ? m_tileCache->m_residentList.GetCount() : 0;
+}
+
+void dgCollisionHeightField::FlushTiles()
+{
+	if (m_tileCache) {
+		dgScopeSpinPause lock (&m_instanceData->m_lock);
+		dgList<dgTile>::dgListNode* nextNode;
+		for (dgList<dgTile>::dgListNode* node = m_tileCache->m_residentList.GetFirst(); node; node = nextNode) {
+			nextNode = node->GetNext();
+			dgTile& tile = node->GetInfo();
+			if (!tile.m_useCount) {
+				tile.m_shape->Release();
+				m_tileCache->m_tileMap.Remove(tile.m_key);
+				m_tileCache->m_residentList.Remove(node);
+			}
+		}
+	}
+}
+
+dgCollisionHeightField::dgTile* dgCollisionHeightField::AcquireTile (dgInt32 tileX, dgInt32 tileZ) const
+{
+	dgTileCache* const cache = m_tileCache;
+	dgAssert (tileX >= 0);
+	dgAssert (tileZ >= 0);
+	dgAssert (tileX < cache->m_tileCountX);
+	dgAssert (tileZ < cache->m_tileCountZ);
+	const dgInt32 key = tileZ * cache->m_tileCountX + tileX;
+
+	// all height fields of a world share this lock, so it only guards the cache bookkeeping,
+	// the user page in and the construction of the tile shape run with the lock released
+	dgWorld* const world = m_instanceData->m_world;
+	dgCollisionHeightField* evicted[8];
+	dgInt32 evictedCount = 0;
+	dgCollisionHeightFieldTilePageInCallback pageInCallback = NULL;
+	void* pageInUserData = NULL;
+	dgTile* tile = NULL;
+	{
+		dgScopeSpinPause lock (&m_instanceData->m_lock);
+		dgTree<dgList<dgTile>::dgListNode*, dgInt32>::dgTreeNode* const mapNode = cache->m_tileMap.Find(key);
+		if (mapNode) {
+			dgList<dgTile>::dgListNode* const node = mapNode->GetInfo();
+			cache->m_residentList.RotateToBegin(node);
+			tile = &node->GetInfo();
+			dgAtomicExchangeAndAdd(&tile->m_useCount, 1);
+		} else {
+			if (!cache->m_pageInCallback) {
+				return NULL;
+			}
+
+			// evict the least recently used tiles that no other thread is reading 
+			dgList<dgTile>::dgListNode* prevNode;
+			for (dgList<dgTile>::dgListNode* node = cache->m_residentList.GetLast(); node && (evictedCount < dgInt32 (sizeof (evicted) / sizeof (evicted[0]))) && (cache->m_residentList.GetCount() >= cache->m_maxResidentTiles); node = prevNode) {
+				prevNode = node->GetPrev();
+				dgTile& residentTile = node->GetInfo();
+				if (!residentTile.m_useCount) {
+					dgAssert (residentTile.m_shape);
+					evicted[evictedCount] = residentTile.m_shape;
+					evictedCount ++;
+					cache->m_tileMap.Remove(residentTile.m_key);
+					cache->m_residentList.Remove(node);
+				}
+			}
+
+			// publish a place holder with a null shape, so that other threads wait for this one to page the tile in
+			dgList<dgTile>::dgListNode* const node = cache->m_residentList.Addtop();
+			tile = &node->GetInfo();
+			tile->m_shape = NULL;
+			tile->m_key = key;
+			tile->m_x0 = tileX * cache->m_tileSize;
+			tile->m_z0 = tileZ * cache->m_tileSize;
+			tile->m_useCount = 1;
+			cache->m_tileMap.Insert(node, key);
+			pageInCallback = cache->m_pageInCallback;
+			pageInUserData = cache->m_pageInUserData;
+		}
+	}
+
+	for (dgInt32 i = 0; i < evictedCount; i ++) {
+		evicted[i]->Release();
+	}
+
+	if (!pageInCallback) {
+		// another thread is paging this tile in
+		for (;;) {
+			{
+				dgScopeSpinPause lock (&m_instanceData->m_lock);
+				if (tile->m_shape) {
+					break;
+				}
+			}
+			dgThreadYield();
+		}
+		return tile;
+	}
+
+	const dgInt32 x0 = tile->m_x0;
+	const dgInt32 z0 = tile->m_z0;
+	const dgInt32 width = dgMin (cache->m_tileSize, m_width - 1 - x0) + 1;
+	const dgInt32 height = dgMin (cache->m_tileSize, m_height - 1 - z0) + 1;
+	const dgInt32 elevationSize = (m_elevationDataType == m_float32Bit) ? sizeof (dgFloat32) : sizeof (dgUnsigned16);
+
+	dgStack<dgInt8> elevation (width * height * elevationSize);
+	dgStack<dgInt8> atributes (width * height);
+	memset (&atributes[0], 0, width * height * sizeof (dgInt8));
+	pageInCallback (pageInUserData, x0, z0, width, height, &elevation[0], &atributes[0]);
+	dgCollisionHeightField* const shape = new (world->GetAllocator()) dgCollisionHeightField (world, width, height, m_diagonalMode, &elevation[0], m_elevationDataType, m_verticalScale, &atributes[0], m_horizontalScale_x, m_horizontalScale_z);
+
+	dgScopeSpinPause lock (&m_instanceData->m_lock);
+	tile->m_shape = shape;
+	return tile;
+}
+
+void dgCollisionHeightField::ReleaseTile (dgTile* const tile) const
+{
+	dgAssert (tile->m_useCount > 0);
+	dgAtomicExchangeAndAdd(&tile->m_useCount, -1);
+}
+
+void dgCollisionHeightField::TiledMinAndMaxElevation(dgInt32 x0, dgInt32 x1, dgInt32 z0, dgInt32 z1, dgFloat32& minHeight, dgFloat32& maxHeight) const
+{
+	const dgInt32 tileSize = m_tileCache->m_tileSize;
+	const dgInt32 tileX0 = dgMin (x0 / tileSize, m_tileCache->m_tileCountX - 1);
+	const dgInt32 tileX1 = dgMin (x1 / tileSize, m_tileCache->m_tileCountX - 1);
+	const dgInt32 tileZ0 = dgMin (z0 / tileSize, m_tileCache->m_tileCountZ - 1);
+	const dgInt32 tileZ1 = dgMin (z1 / tileSize, m_tileCache->m_tileCountZ - 1);
+	for (dgInt32 tileZ = tileZ0; tileZ <= tileZ1; tileZ ++) {
+		for (dgInt32 tileX = tileX0; tileX <= tileX1; tileX ++) {
+			dgTile* const tile = AcquireTile (tileX, tileZ);
+			if (tile) {
+				const dgCollisionHeightField* const shape = tile->m_shape;
+				const dgInt32 i0 = dgMax (x0 - tile->m_x0, 0);
+				const dgInt32 i1 = dgMin (x1 - tile->m_x0, shape->m_width - 1);
+				const dgInt32 j0 = dgMax (z0 - tile->m_z0, 0);
+				const dgInt32 j1 = dgMin (z1 - tile->m_z0, shape->m_height - 1);
+				shape->CalculateMinAndMaxElevation(i0, i1, j0, j1, minHeight, maxHeight);
+				ReleaseTile (tile);
+			}
+		}
+	}
 }
 
 void dgCollisionHeightField::Serialize(dgSerialize callback, void* const userData) const
@@ -342,6 +629,14 @@ void dgCollisionHeightField::Serialize(dgSerialize callback, void* const userDat
 	callback (userData, &m_minBox.m_x, sizeof (dgVector)); 
 	callback (userData, &m_maxBox.m_x, sizeof (dgVector)); 
 
+	dgInt32 tileSize = m_tileCache ? m_tileCache->m_tileSize : 0;
+	dgInt32 maxResidentTiles = m_tileCache ? m_tileCache->m_maxResidentTiles : 0;
+	callback (userData, &tileSize, sizeof (dgInt32));
+	callback (userData, &maxResidentTiles, sizeof (dgInt32));
+	if (m_tileCache) {
+		return;
+	}
+
 	switch (m_elevationDataType) 
 	{
 		case m_float32Bit:
@@ -359,6 +654,7 @@ void dgCollisionHeightField::Serialize(dgSerialize callback, void* const userDat
 	dgInt32 attibutePaddedMapSize = (m_width * m_height + 4) & -4; 
 	callback (userData, m_atributeMap, attibutePaddedMapSize * sizeof (dgInt8));
 	callback (userData, m_diagonals, attibutePaddedMapSize * sizeof (dgInt8));
+	callback (userData, m_elevationPyramid, 2 * m_pyramidSize * sizeof (dgFloat32));
 }
 
 void dgCollisionHeightField::SetCollisionRayCastCallback (dgCollisionHeightFieldRayCastCallback rayCastCallback)
@@ -366,10 +662,10 @@ void dgCollisionHeightField::SetCollisionRayCastCallback (dgCollisionHeightField
 	m_userRayCastCallback = rayCastCallback;
 }
 
-void dgCollisionHeightField::AllocateVertex(dgWorld* const world, dgInt32 threadIndex) const
+void dgCollisionHeightField::AllocateVertex(dgPerIntanceData* const instanceData, dgInt32 threadIndex)
 {
-	m_instanceData->m_vertex[threadIndex].Resize (m_instanceData->m_vertex[threadIndex].GetElementsCapacity() * 2);
-	m_instanceData->m_vertexCount[threadIndex] = m_instanceData->m_vertex[threadIndex].GetElementsCapacity();
+	instanceData->m_vertex[threadIndex].Resize (instanceData->m_vertex[threadIndex].GetElementsCapacity() * 2);
+	instanceData->m_vertexCount[threadIndex] = instanceData->m_vertex[threadIndex].GetElementsCapacity();
 }
 
 DG_INLINE void dgCollisionHeightField::CalculateMinExtend2d(const dgVector& p0, const dgVector& p1, dgVector& boxP0, dgVector& boxP1) const
@@ -419,29 +715,10 @@ DG_INLINE void dgCollisionHeightField::CalculateMinExtend3d(const dgVector& p0,
 
 void dgCollisionHeightField::CalculateAABB()
 {
-	dgFloat32 y0 = dgFloat32 (dgFloat32 (1.0e10f));
-	dgFloat32 y1 = dgFloat32 (-dgFloat32 (1.0e10f));
-	switch (m_elevationDataType) 
-	{
-		case m_float32Bit:
-		{
-			const dgFloat32* const elevation = (dgFloat32*)m_elevationMap;
-			for (dgInt32 i = 0; i < m_width * m_height; i ++) {
-				y0 = dgMin(y0, elevation[i]);
-				y1 = dgMax(y1, elevation[i]);
-			}
-			break;
-		}
-
-		case m_unsigned16Bit:
-		{
-			const dgUnsigned16* const elevation = (dgUnsigned16*)m_elevationMap;
-			for (dgInt32 i = 0; i < m_width * m_height; i ++) {
-				y0 = dgMin(y0, dgFloat32 (elevation[i]));
-				y1 = dgMax(y1, dgFloat32 (elevation[i]));
-			}
-		}
-	}
+	// the root of the pyramid holds the elevation range of the entire grid
+	const dgFloat32* const root = &m_elevationPyramid[2 * m_pyramidOffset[m_pyramidLevels - 1]];
+	const dgFloat32 y0 = root[0];
+	const dgFloat32 y1 = root[1];
 
 	m_minBox = dgVector (dgFloat32 (dgFloat32 (0.0f)),                  y0 * m_verticalScale, dgFloat32 (dgFloat32 (0.0f)),               dgFloat32 (0.0f)); 
 	m_maxBox = dgVector (dgFloat32 (m_width - 1) * m_horizontalScale_x, y1 * m_verticalScale, dgFloat32 (m_height-1) * m_horizontalScale_z, dgFloat32 (0.0f)); 
@@ -561,105 +838,193 @@ dgFloat32 dgCollisionHeightField::RayCastCell (const dgFastRayTest& ray, dgInt32
 	return t;
 }
 
-dgFloat32 dgCollisionHeightField::RayCast (const dgVector& q0, const dgVector& q1, dgFloat32 maxT, dgContactPoint& contactOut, const dgBody* const body, void* const userData, OnRayPrecastAction preFilter) const
+dgFloat32 dgCollisionHeightField::RayCastPyramid (const dgFastRayTest& ray, dgFloat32 maxT, dgVector& normalOut, dgInt32& hitX, dgInt32& hitZ) const
 {
-	dgVector boxP0;
-	dgVector boxP1;
+	const dgVector scale (m_horizontalScale_x, m_verticalScale, m_horizontalScale_z, dgFloat32 (0.0f));
+
+	// visit the children of each node front to back along the ray direction
+	const dgInt32 xFlip = (ray.m_diff.m_x < dgFloat32 (0.0f)) ? 1 : 0;
+	const dgInt32 zFlip = (ray.m_diff.m_z < dgFloat32 (0.0f)) ? 1 : 0;
+
+	hitX = -1;
+	hitZ = -1;
+
+	// walk the elevation pyramid skipping every node whose box is not crossed by the ray closer than the best hit so far
+	dgInt32 stack = 1;
+	dgInt32 stackPool[4 * DG_HEIGHTFIELD_PYRAMID_MAX_LEVELS][3];
+	stackPool[0][0] = m_pyramidLevels - 1;
+	stackPool[0][1] = 0;
+	stackPool[0][2] = 0;
+	while (stack) {
+		stack --;
+		const dgInt32 level = stackPool[stack][0];
+		const dgInt32 x = stackPool[stack][1];
+		const dgInt32 z = stackPool[stack][2];
+
+		const dgInt32 shift = level + DG_HEIGHTFIELD_PYRAMID_LEAF_SHIFT;
+		const dgInt32 nodeX0 = x << shift;
+		const dgInt32 nodeZ0 = z << shift;
+		const dgInt32 nodeX1 = dgMin ((x + 1) << shift, m_width - 1);
+		const dgInt32 nodeZ1 = dgMin ((z + 1) << shift, m_height - 1);
+		const dgFloat32* const range = &m_elevationPyramid[2 * (m_pyramidOffset[level] + z * GetPyramidWidth(level) + x)];
+
+		const dgVector boxP0 (dgVector (dgFloat32 (nodeX0), range[0], dgFloat32 (nodeZ0), dgFloat32 (0.0f)) * scale - m_pyramidPadding);
+		const dgVector boxP1 (dgVector (dgFloat32 (nodeX1), range[1], dgFloat32 (nodeZ1), dgFloat32 (0.0f)) * scale + m_pyramidPadding);
+		if (ray.BoxIntersect (boxP0, boxP1) >= maxT) {
+			continue;
+		}
 
-	// calculate the ray bounding box
-	CalculateMinExtend2d (q0, q1, boxP0, boxP1);
-
-	dgVector p0 (q0);
-	dgVector p1 (q1);
-
-	// clip the line against the bounding box
-	if (dgRayBoxClip (p0, p1, boxP0, boxP1)) { 
-		dgVector dp (p1 - p0);
-		dgVector normalOut (dgFloat32 (0.0f), dgFloat32 (0.0f), dgFloat32 (0.0f), dgFloat32 (0.0f));
-
-		dgFloat32 scale_x = m_horizontalScale_x;
-		dgFloat32 invScale_x = m_horizontalScaleInv_x;
-		dgFloat32 scale_z = m_horizontalScale_z;
-		dgFloat32 invScale_z = m_horizontalScaleInv_z;
-		dgInt32 ix0 = dgFastInt (p0.m_x * invScale_x);
-		dgInt32 iz0 = dgFastInt (p0.m_z * invScale_z);
-
-		// implement a 3ddda line algorithm 
-		dgInt32 xInc;
-		dgFloat32 tx;
-		dgFloat32 stepX;
-		if (dp.m_x > dgFloat32 (0.0f)) {
-			xInc = 1;
-			dgFloat32 val = dgFloat32 (1.0f) / dp.m_x;
-			stepX = scale_x * val;
-			tx = (scale_x * (ix0 + dgFloat32 (1.0f)) - p0.m_x) * val;
-		} else if (dp.m_x < dgFloat32 (0.0f)) {
-			xInc = -1;
-			dgFloat32 val = -dgFloat32 (1.0f) / dp.m_x;
-			stepX = scale_x * val;
-			tx = -(scale_x * ix0 - p0.m_x) * val;
+		if (level == 0) {
+			for (dgInt32 zIndex = nodeZ0; zIndex < nodeZ1; zIndex ++) {
+				for (dgInt32 xIndex = nodeX0; xIndex < nodeX1; xIndex ++) {
+					const dgVector cellP0 (boxP0.Select (dgVector (dgFloat32 (xIndex), dgFloat32 (0.0f), dgFloat32 (zIndex), dgFloat32 (0.0f)) * scale - m_pyramidPadding, m_yMask));
+					const dgVector cellP1 (boxP1.Select (dgVector (dgFloat32 (xIndex + 1), dgFloat32 (0.0f), dgFloat32 (zIndex + 1), dgFloat32 (0.0f)) * scale + m_pyramidPadding, m_yMask));
+					if (ray.BoxIntersect (cellP0, cellP1) < maxT) {
+						dgVector normal;
+						dgFloat32 t = RayCastCell (ray, xIndex, zIndex, normal, maxT);
+						if (t < maxT) {
+							maxT = t;
+							hitX = xIndex;
+							hitZ = zIndex;
+							normalOut = normal;
+						}
+					}
+				}
+			}
 		} else {
-			xInc = 0;
-			stepX = dgFloat32 (0.0f);
-			tx = dgFloat32 (1.0e10f);
+			const dgInt32 width = GetPyramidWidth(level - 1);
+			const dgInt32 height = GetPyramidHeight(level - 1);
+			for (dgInt32 j = 1; j >= 0; j --) {
+				const dgInt32 zChild = 2 * z + (j ^ zFlip);
+				if (zChild < height) {
+					for (dgInt32 i = 1; i >= 0; i --) {
+						const dgInt32 xChild = 2 * x + (i ^ xFlip);
+						if (xChild < width) {
+							dgAssert (stack < dgInt32 (sizeof (stackPool) / sizeof (stackPool[0])));
+							stackPool[stack][0] = level - 1;
+							stackPool[stack][1] = xChild;
+							stackPool[stack][2] = zChild;
+							stack ++;
+						}
+					}
+				}
+			}
 		}
+	}
 
-		dgInt32 zInc;
-		dgFloat32 tz;
-		dgFloat32 stepZ;
-		if (dp.m_z > dgFloat32 (0.0f)) {
-			zInc = 1;
-			dgFloat32 val = dgFloat32 (1.0f) / dp.m_z;
-			stepZ = scale_z * val;
-			tz = (scale_z * (iz0 + dgFloat32 (1.0f)) - p0.m_z) * val;
-		} else if (dp.m_z < dgFloat32 (0.0f)) {
-			zInc = -1;
-			dgFloat32 val = -dgFloat32 (1.0f) / dp.m_z;
-			stepZ = scale_z * val;
-			tz = -(scale_z * iz0 - p0.m_z) * val;
-		} else {
-			zInc = 0;
-			stepZ = dgFloat32 (0.0f);
-			tz = dgFloat32 (1.0e10f);
+	return (hitX >= 0) ? maxT : dgFloat32 (1.2f);
+}
+
+dgFloat32 dgCollisionHeightField::RayCast (const dgVector& q0, const dgVector& q1, dgFloat32 maxT, dgContactPoint& contactOut, const dgBody* const body, void* const userData, OnRayPrecastAction preFilter) const
+{
+	if (m_tileCache) {
+		return TiledRayCast (q0, q1, maxT, contactOut, body, userData);
+	}
+
+	dgInt32 hitX;
+	dgInt32 hitZ;
+	dgVector normalOut (dgFloat32 (0.0f));
+	dgFastRayTest ray (q0, q1); 
+	dgFloat32 t = RayCastPyramid (ray, maxT, normalOut, hitX, hitZ);
+	if (t < maxT) {
+		// copy the data of the closest intersection into the descriptor
+		dgAssert (normalOut.m_w == dgFloat32 (0.0f));
+		contactOut.m_normal = normalOut.Normalize();
+		contactOut.m_shapeId0 = m_atributeMap[hitZ * m_width + hitX];
+		contactOut.m_shapeId1 = m_atributeMap[hitZ * m_width + hitX];
+
+		if (m_userRayCastCallback) {
+			dgVector normal (body->GetCollision()->GetGlobalMatrix().RotateVector (contactOut.m_normal));
+			m_userRayCastCallback (body, this, t, hitX, hitZ, &normal, dgInt32 (contactOut.m_shapeId0), userData);
 		}
+		return t;
+	}
 
-		dgFloat32 txAcc = tx;
-		dgFloat32 tzAcc = tz;
-		dgInt32 xIndex0 = ix0;
-		dgInt32 zIndex0 = iz0;
-		dgFastRayTest ray (q0, q1); 
-
-		// for each cell touched by the line
-		do {
-			dgFloat32 t = RayCastCell (ray, xIndex0, zIndex0, normalOut, maxT);
-			if (t < maxT) {
-				// bail out at the first intersection and copy the data into the descriptor
-				dgAssert (normalOut.m_w == dgFloat32 (0.0f));
-				contactOut.m_normal = normalOut.Normalize();
-				contactOut.m_shapeId0 = m_atributeMap[zIndex0 * m_width + xIndex0];
-				contactOut.m_shapeId1 = m_atributeMap[zIndex0 * m_width + xIndex0];
-
-				if (m_userRayCastCallback) {
-					dgVector normal (body->GetCollision()->GetGlobalMatrix().RotateVector (contactOut.m_normal));
-					m_userRayCastCallback (body, this, t, xIndex0, zIndex0, &normal, dgInt32 (contactOut.m_shapeId0), userData);
-				}
+	// if no cell was hit, return a large value
+	return dgFloat32 (1.2f);
+}
 
-				return t;
-			}
+dgFloat32 dgCollisionHeightField::TiledRayCast (const dgVector& q0, const dgVector& q1, dgFloat32 maxT, dgContactPoint& contactOut, const dgBody* const body, void* const userData) const
+{
+	dgFastRayTest ray (q0, q1); 
+	dgFloat32 t = ray.BoxIntersect (m_minBox - m_pyramidPadding, m_maxBox + m_pyramidPadding);
+	if (t >= maxT) {
+		return dgFloat32 (1.2f);
+	}
 
-			if (txAcc < tzAcc) {
-				xIndex0 += xInc;
-				tx = txAcc;
-				txAcc += stepX;
-			} else {
-				zIndex0 += zInc;
-				tz = tzAcc;
-				tzAcc += stepZ;
+	// walk the tiles crossed by the ray in the xz plane nearest first, so only those tiles are visited
+	const dgInt32 tileSize = m_tileCache->m_tileSize;
+	const dgInt32 tileCountX = m_tileCache->m_tileCountX;
+	const dgInt32 tileCountZ = m_tileCache->m_tileCountZ;
+	const dgFloat32 tileScale_x = m_horizontalScale_x * tileSize;
+	const dgFloat32 tileScale_z = m_horizontalScale_z * tileSize;
+	const dgVector entry (q0 + ray.m_diff.Scale (t));
+	dgInt32 tileX = dgClamp (dgFastInt (entry.m_x / tileScale_x), 0, tileCountX - 1);
+	dgInt32 tileZ = dgClamp (dgFastInt (entry.m_z / tileScale_z), 0, tileCountZ - 1);
+
+	const dgFloat32 dx = ray.m_diff.m_x;
+	const dgFloat32 dz = ray.m_diff.m_z;
+	const dgInt32 stepX = (dx > dgFloat32 (0.0f)) ? 1 : -1;
+	const dgInt32 stepZ = (dz > dgFloat32 (0.0f)) ? 1 : -1;
+	const bool crossX = dgAbs (dx) > dgFloat32 (1.0e-10f);
+	const bool crossZ = dgAbs (dz) > dgFloat32 (1.0e-10f);
+	const dgFloat32 deltaX = crossX ? tileScale_x / dgAbs (dx) : dgFloat32 (1.0e10f);
+	const dgFloat32 deltaZ = crossZ ? tileScale_z / dgAbs (dz) : dgFloat32 (1.0e10f);
+	dgFloat32 nextX = crossX ? ((tileX + (stepX > 0 ? 1 : 0)) * tileScale_x - q0.m_x) / dx : dgFloat32 (1.0e10f);
+	dgFloat32 nextZ = crossZ ? ((tileZ + (stepZ > 0 ? 1 : 0)) * tileScale_z - q0.m_z) / dz : dgFloat32 (1.0e10f);
+
+	dgInt32 hitX = -1;
+	dgInt32 hitZ = -1;
+	dgInt32 atribute = 0;
+	dgVector normalOut (dgFloat32 (0.0f));
+	while ((t < maxT) && (tileX >= 0) && (tileX < tileCountX) && (tileZ >= 0) && (tileZ < tileCountZ)) {
+		// skip the tiles the ray crosses above or below the elevation range
+		const dgVector boxP0 (dgVector (tileX * tileScale_x, m_minBox.m_y, tileZ * tileScale_z, dgFloat32 (0.0f)) - m_pyramidPadding);
+		const dgVector boxP1 (dgVector ((tileX + 1) * tileScale_x, m_maxBox.m_y, (tileZ + 1) * tileScale_z, dgFloat32 (0.0f)) + m_pyramidPadding);
+		if (ray.BoxIntersect (boxP0, boxP1) < maxT) {
+			dgTile* const tile = AcquireTile (tileX, tileZ);
+			if (tile) {
+				const dgCollisionHeightField* const shape = tile->m_shape;
+				const dgVector origin (tile->m_x0 * m_horizontalScale_x, dgFloat32 (0.0f), tile->m_z0 * m_horizontalScale_z, dgFloat32 (0.0f));
+				dgFastRayTest localRay (q0 - origin, q1 - origin);
+				dgInt32 x;
+				dgInt32 z;
+				dgVector normal;
+				dgFloat32 dist = shape->RayCastPyramid (localRay, maxT, normal, x, z);
+				if (dist < maxT) {
+					maxT = dist;
+					hitX = tile->m_x0 + x;
+					hitZ = tile->m_z0 + z;
+					atribute = shape->m_atributeMap[z * shape->m_width + x];
+					normalOut = normal;
+				}
+				ReleaseTile (tile);
 			}
-		} while ((tx <= dgFloat32 (1.0f)) || (tz <= dgFloat32 (1.0f)));
+		}
+
+		if (nextX < nextZ) {
+			t = nextX;
+			nextX += deltaX;
+			tileX += stepX;
+		} else {
+			t = nextZ;
+			nextZ += deltaZ;
+			tileZ += stepZ;
+		}
 	}
 
-	// if no cell was hit, return a large value
+	if (hitX >= 0) {
+		dgAssert (normalOut.m_w == dgFloat32 (0.0f));
+		contactOut.m_normal = normalOut.Normalize();
+		contactOut.m_shapeId0 = atribute;
+		contactOut.m_shapeId1 = atribute;
+
+		if (m_userRayCastCallback) {
+			dgVector normal (body->GetCollision()->GetGlobalMatrix().RotateVector (contactOut.m_normal));
+			m_userRayCastCallback (body, this, maxT, hitX, hitZ, &normal, atribute, userData);
+		}
+		return maxT;
+	}
 	return dgFloat32 (1.2f);
 }
 
@@ -679,6 +1044,11 @@ struct dgCollisionHeightFieldShowPolyContext
 
 dgVector dgCollisionHeightField::SupportVertex (const dgVector& dir, dgInt32* const vertexIndex) const
 {
+	if (m_tileCache) {
+		// the samples of a tiled height field are not resident, use the corners of the bounding box
+		return m_minBox.Select (m_maxBox, dir > dgVector::m_zero) & dgVector::m_triplexMask;
+	}
+
 	dgFloat32 maxProject (dgFloat32 (-1.e-20f));
 	dgVector support (dgFloat32 (0.0f));
 	if (m_elevationDataType == m_float32Bit)  {
@@ -722,6 +1092,18 @@ dgVector dgCollisionHeightField::SupportVertexSpecial (const dgVector& dir, dgFl
 
 void dgCollisionHeightField::DebugCollision (const dgMatrix& matrix, dgCollision::OnDebugCollisionMeshCallback callback, void* const userData) const
 {
+	if (m_tileCache) {
+		// only the resident tiles are displayed
+		dgScopeSpinPause lock (&m_instanceData->m_lock);
+		for (dgList<dgTile>::dgListNode* node = m_tileCache->m_residentList.GetFirst(); node; node = node->GetNext()) {
+			const dgTile& tile = node->GetInfo();
+			dgMatrix tileMatrix (matrix);
+			tileMatrix.m_posit = matrix.TransformVector(dgVector (tile.m_x0 * m_horizontalScale_x, dgFloat32 (0.0f), tile.m_z0 * m_horizontalScale_z, dgFloat32 (1.0f)));
+			tile.m_shape->DebugCollision (tileMatrix, callback, userData);
+		}
+		return;
+	}
+
 	dgVector points[4];
 
 	dgInt32 base = 0;
@@ -839,6 +1221,170 @@ void dgCollisionHeightField::CalculateMinAndMaxElevation(dgInt32 x0, dgInt32 x1,
 }
 
 
+void dgCollisionHeightField::AllocateElevationPyramid()
+{
+	m_pyramidSize = 0;
+	m_pyramidLevels = 0;
+	do {
+		dgAssert (m_pyramidLevels < DG_HEIGHTFIELD_PYRAMID_MAX_LEVELS);
+		m_pyramidOffset[m_pyramidLevels] = m_pyramidSize;
+		m_pyramidSize += GetPyramidWidth(m_pyramidLevels) * GetPyramidHeight(m_pyramidLevels);
+		m_pyramidLevels ++;
+	} while ((GetPyramidWidth(m_pyramidLevels - 1) > 1) || (GetPyramidHeight(m_pyramidLevels - 1) > 1));
+	m_elevationPyramid = (dgFloat32*)dgMallocStack(2 * m_pyramidSize * sizeof (dgFloat32));
+}
+
+void dgCollisionHeightField::BuildElevationPyramid()
+{
+	// leaves store the elevation range of the vertices of a block of cells
+	const dgInt32 leafWidth = GetPyramidWidth(0);
+	const dgInt32 leafHeight = GetPyramidHeight(0);
+	dgFloat32* leaf = m_elevationPyramid;
+	for (dgInt32 z = 0; z < leafHeight; z ++) {
+		const dgInt32 z0 = z << DG_HEIGHTFIELD_PYRAMID_LEAF_SHIFT;
+		const dgInt32 z1 = dgMin ((z + 1) << DG_HEIGHTFIELD_PYRAMID_LEAF_SHIFT, m_height - 1);
+		for (dgInt32 x = 0; x < leafWidth; x ++) {
+			const dgInt32 x0 = x << DG_HEIGHTFIELD_PYRAMID_LEAF_SHIFT;
+			const dgInt32 x1 = dgMin ((x + 1) << DG_HEIGHTFIELD_PYRAMID_LEAF_SHIFT, m_width - 1);
+			leaf[0] = dgFloat32 (1.0e10f);
+			leaf[1] = dgFloat32 (-1.0e10f);
+			switch (m_elevationDataType) 
+			{
+				case m_float32Bit:
+				{
+					CalculateMinAndMaxElevation(x0, x1, z0, z1, (dgFloat32*)m_elevationMap, leaf[0], leaf[1]);
+					break;
+				}
+
+				case m_unsigned16Bit:
+				{
+					CalculateMinAndMaxElevation(x0, x1, z0, z1, (dgUnsigned16*)m_elevationMap, leaf[0], leaf[1]);
+					break;
+				}
+			}
+			leaf += 2;
+		}
+	}
+
+	// each parent merges the range of its four children
+	for (dgInt32 level = 1; level < m_pyramidLevels; level ++) {
+		const dgInt32 width = GetPyramidWidth(level);
+		const dgInt32 height = GetPyramidHeight(level);
+		const dgInt32 childWidth = GetPyramidWidth(level - 1);
+		const dgInt32 childHeight = GetPyramidHeight(level - 1);
+		const dgFloat32* const child = &m_elevationPyramid[2 * m_pyramidOffset[level - 1]];
+		dgFloat32* node = &m_elevationPyramid[2 * m_pyramidOffset[level]];
+		for (dgInt32 z = 0; z < height; z ++) {
+			const dgInt32 z1 = dgMin (2 * z + 1, childHeight - 1);
+			for (dgInt32 x = 0; x < width; x ++) {
+				const dgInt32 x1 = dgMin (2 * x + 1, childWidth - 1);
+				node[0] = dgFloat32 (1.0e10f);
+				node[1] = dgFloat32 (-1.0e10f);
+				for (dgInt32 j = 2 * z; j <= z1; j ++) {
+					for (dgInt32 i = 2 * x; i <= x1; i ++) {
+						const dgFloat32* const range = &child[2 * (j * childWidth + i)];
+						node[0] = dgMin (node[0], range[0]);
+						node[1] = dgMax (node[1], range[1]);
+					}
+				}
+				node += 2;
+			}
+		}
+	}
+}
+
+void dgCollisionHeightField::CalculateMinAndMaxElevation(dgInt32 x0, dgInt32 x1, dgInt32 z0, dgInt32 z1, dgFloat32& minHeight, dgFloat32& maxHeight) const
+{
+	if ((x0 > x1) || (z0 > z1)) {
+		return;
+	}
+
+	if (m_tileCache) {
+		TiledMinAndMaxElevation(x0, x1, z0, z1, minHeight, maxHeight);
+		return;
+	}
+
+	if (((x1 - x0) <= (1 << DG_HEIGHTFIELD_PYRAMID_LEAF_SHIFT)) && ((z1 - z0) <= (1 << DG_HEIGHTFIELD_PYRAMID_LEAF_SHIFT))) {
+		// small rectangles are cheaper to scan directly
+		switch (m_elevationDataType) 
+		{
+			case m_float32Bit:
+			{
+				CalculateMinAndMaxElevation(x0, x1, z0, z1, (dgFloat32*)m_elevationMap, minHeight, maxHeight);
+				break;
+			}
+
+			case m_unsigned16Bit:
+			{
+				CalculateMinAndMaxElevation(x0, x1, z0, z1, (dgUnsigned16*)m_elevationMap, minHeight, maxHeight);
+				break;
+			}
+		}
+		return;
+	}
+
+	// descend the pyramid, taking the range of nodes fully inside the rectangle 
+	// and only scanning the samples of leaves that straddle its border
+	dgInt32 stack = 1;
+	dgInt32 stackPool[4 * DG_HEIGHTFIELD_PYRAMID_MAX_LEVELS][3];
+	stackPool[0][0] = m_pyramidLevels - 1;
+	stackPool[0][1] = 0;
+	stackPool[0][2] = 0;
+	while (stack) {
+		stack --;
+		const dgInt32 level = stackPool[stack][0];
+		const dgInt32 x = stackPool[stack][1];
+		const dgInt32 z = stackPool[stack][2];
+
+		const dgInt32 shift = level + DG_HEIGHTFIELD_PYRAMID_LEAF_SHIFT;
+		const dgInt32 nodeX0 = x << shift;
+		const dgInt32 nodeZ0 = z << shift;
+		const dgInt32 nodeX1 = dgMin ((x + 1) << shift, m_width - 1);
+		const dgInt32 nodeZ1 = dgMin ((z + 1) << shift, m_height - 1);
+		if ((nodeX1 < x0) || (nodeX0 > x1) || (nodeZ1 < z0) || (nodeZ0 > z1)) {
+			continue;
+		}
+
+		if ((nodeX0 >= x0) && (nodeX1 <= x1) && (nodeZ0 >= z0) && (nodeZ1 <= z1)) {
+			const dgFloat32* const range = &m_elevationPyramid[2 * (m_pyramidOffset[level] + z * GetPyramidWidth(level) + x)];
+			minHeight = dgMin (minHeight, range[0]);
+			maxHeight = dgMax (maxHeight, range[1]);
+		} else if (level == 0) {
+			const dgInt32 i0 = dgMax (x0, nodeX0);
+			const dgInt32 i1 = dgMin (x1, nodeX1);
+			const dgInt32 j0 = dgMax (z0, nodeZ0);
+			const dgInt32 j1 = dgMin (z1, nodeZ1);
+			switch (m_elevationDataType) 
+			{
+				case m_float32Bit:
+				{
+					CalculateMinAndMaxElevation(i0, i1, j0, j1, (dgFloat32*)m_elevationMap, minHeight, maxHeight);
+					break;
+				}
+
+				case m_unsigned16Bit:
+				{
+					CalculateMinAndMaxElevation(i0, i1, j0, j1, (dgUnsigned16*)m_elevationMap, minHeight, maxHeight);
+					break;
+				}
+			}
+		} else {
+			const dgInt32 width = GetPyramidWidth(level - 1);
+			const dgInt32 height = GetPyramidHeight(level - 1);
+			for (dgInt32 j = 2 * z; j <= dgMin (2 * z + 1, height - 1); j ++) {
+				for (dgInt32 i = 2 * x; i <= dgMin (2 * x + 1, width - 1); i ++) {
+					dgAssert (stack < dgInt32 (sizeof (stackPool) / sizeof (stackPool[0])));
+					stackPool[stack][0] = level - 1;
+					stackPool[stack][1] = i;
+					stackPool[stack][2] = j;
+					stack ++;
+				}
+			}
+		}
+	}
+}
+
+
 void dgCollisionHeightField::GetLocalAABB (const dgVector& q0, const dgVector& q1, dgVector& boxP0, dgVector& boxP1) const
 {
 	// the user data is the pointer to the collision geometry
@@ -859,28 +1405,133 @@ void dgCollisionHeightField::GetLocalAABB (const dgVector& q0, const dgVector& q
 
 	dgFloat32 minHeight = dgFloat32 (1.0e10f);
 	dgFloat32 maxHeight = dgFloat32 (-1.0e10f);
-	//dgInt32 base = z0 * m_width;
-	switch (m_elevationDataType) 
-	{
-		case m_float32Bit:
-		{
-			CalculateMinAndMaxElevation(x0, x1, z0, z1, (dgFloat32*)m_elevationMap, minHeight, maxHeight);
-			break;
-		}
+	CalculateMinAndMaxElevation(x0, x1, z0, z1, minHeight, maxHeight);
 
-		case m_unsigned16Bit:
-		{
-			CalculateMinAndMaxElevation(x0, x1, z0, z1, (dgUnsigned16*)m_elevationMap, minHeight, maxHeight);
-			break;
+	boxP0.m_y = m_verticalScale * minHeight;
+	boxP1.m_y = m_verticalScale * maxHeight;
+}
+
+void dgCollisionHeightField::GetTiledCollidingFaces (dgPolygonMeshDesc* const data) const
+{
+	dgVector boxP0;
+	dgVector boxP1;
+	CalculateMinExtend3d (data->m_p0, data->m_p1, boxP0, boxP1);
+	boxP0 += data->m_boxDistanceTravelInMeshSpace & (data->m_boxDistanceTravelInMeshSpace < dgVector::m_zero);  
+	boxP1 += data->m_boxDistanceTravelInMeshSpace & (data->m_boxDistanceTravelInMeshSpace > dgVector::m_zero);  
+	boxP0 = boxP0.Select(boxP0.GetMax(dgVector::m_zero), m_yMask);
+	boxP1 = boxP1.Select(boxP1.GetMax(dgVector::m_zero), m_yMask);
+
+	const dgInt32 tileSize = m_tileCache->m_tileSize;
+	const dgInt32 x0 = dgFastInt (boxP0.m_x * m_horizontalScaleInv_x);
+	const dgInt32 x1 = dgFastInt (boxP1.m_x * m_horizontalScaleInv_x);
+	const dgInt32 z0 = dgFastInt (boxP0.m_z * m_horizontalScaleInv_z);
+	const dgInt32 z1 = dgFastInt (boxP1.m_z * m_horizontalScaleInv_z);
+	const dgInt32 tileX0 = dgMin (x0 / tileSize, m_tileCache->m_tileCountX - 1);
+	const dgInt32 tileX1 = dgMin (dgMax (x1 - 1, x0) / tileSize, m_tileCache->m_tileCountX - 1);
+	const dgInt32 tileZ0 = dgMin (z0 / tileSize, m_tileCache->m_tileCountZ - 1);
+	const dgInt32 tileZ1 = dgMin (dgMax (z1 - 1, z0) / tileSize, m_tileCache->m_tileCountZ - 1);
+
+	dgInt32 faceStart[DG_MAX_COLLIDING_FACES];
+	dgInt32 faceIndexCount[DG_MAX_COLLIDING_FACES];
+	dgFloat32 hitDistance[DG_MAX_COLLIDING_FACES];
+	dgPerIntanceData* const instanceData = GetPerInstanceData (data->m_objBody->GetWorld());
+	dgArray<dgVector>& vertex = instanceData->m_tileVertex[data->m_threadNumber];
+	dgArray<dgInt32>& indices = instanceData->m_tileIndices[data->m_threadNumber];
+
+	// each tile writes its faces in tile space into the descriptor buffers, 
+	// so they are moved to the thread merge buffers and translated before the next tile overwrites them
+	const dgVector p0 (data->m_p0);
+	const dgVector p1 (data->m_p1);
+	const dgVector posit (data->m_posit);
+
+	dgInt32 faceCount = 0;
+	dgInt32 indexCount = 0;
+	dgInt32 vertexCount = 0;
+	for (dgInt32 tileZ = tileZ0; tileZ <= tileZ1; tileZ ++) {
+		for (dgInt32 tileX = tileX0; (tileX <= tileX1) && (faceCount < DG_MAX_COLLIDING_FACES); tileX ++) {
+			dgTile* const tile = AcquireTile (tileX, tileZ);
+			if (tile) {
+				const dgVector origin (tile->m_x0 * m_horizontalScale_x, dgFloat32 (0.0f), tile->m_z0 * m_horizontalScale_z, dgFloat32 (0.0f));
+				data->m_p0 = p0 - origin;
+				data->m_p1 = p1 - origin;
+				data->m_posit = posit - origin;
+				data->m_faceCount = 0;
+				tile->m_shape->GetCollidingFaces (data);
+
+				const dgInt32 stride = data->m_vertexStrideInBytes / sizeof (dgFloat32);
+				for (dgInt32 i = 0; (i < data->m_faceCount) && (faceCount < DG_MAX_COLLIDING_FACES); i ++) {
+					const dgInt32* const srcIndex = &data->m_faceVertexIndex[data->m_faceIndexStart[i]];
+					const dgInt32 count = data->m_faceIndexCount[i];
+					faceStart[faceCount] = indexCount;
+					faceIndexCount[faceCount] = count;
+					hitDistance[faceCount] = data->m_hitDistance[i];
+
+					for (dgInt32 j = 0; j < count; j ++) {
+						vertex[vertexCount] = (dgVector (&data->m_vertex[srcIndex[j] * stride]) & dgVector::m_triplexMask) + origin;
+						indices[indexCount + j] = vertexCount;
+						vertexCount ++;
+					}
+					indices[indexCount + count] = srcIndex[count];
+					for (dgInt32 j = count + 1; j < (2 * count + 2); j ++) {
+						vertex[vertexCount] = dgVector (&data->m_vertex[srcIndex[j] * stride]) & dgVector::m_triplexMask;
+						indices[indexCount + j] = vertexCount;
+						vertexCount ++;
+					}
+					indices[indexCount + 2 * count + 2] = srcIndex[2 * count + 2];
+					indexCount += data->GetFaceIndexCount(count);
+					faceCount ++;
+				}
+				ReleaseTile (tile);
+			}
 		}
 	}
 
-	boxP0.m_y = m_verticalScale * minHeight;
-	boxP1.m_y = m_verticalScale * maxHeight;
+	data->m_p0 = p0;
+	data->m_p1 = p1;
+	data->m_posit = posit;
+	data->m_faceCount = 0;
+	data->m_separationDistance = dgFloat32 (0.0f);
+
+	if (faceCount) {
+		dgAssert (indexCount <= DG_MAX_COLLIDING_INDICES);
+		memcpy (data->m_globalFaceVertexIndex, &indices[0], indexCount * sizeof (dgInt32));
+		memcpy (data->m_meshData.m_globalFaceIndexStart, faceStart, faceCount * sizeof (dgInt32));
+		memcpy (data->m_meshData.m_globalFaceIndexCount, faceIndexCount, faceCount * sizeof (dgInt32));
+		memcpy (data->m_meshData.m_globalHitDistance, hitDistance, faceCount * sizeof (dgFloat32));
+
+		data->m_faceCount = faceCount;
+		data->m_vertex = &vertex[0].m_x;
+		data->m_faceVertexIndex = data->m_globalFaceVertexIndex;
+		data->m_faceIndexStart = data->m_meshData.m_globalFaceIndexStart;
+		data->m_hitDistance = data->m_meshData.m_globalHitDistance;
+		data->m_faceIndexCount = data->m_meshData.m_globalFaceIndexCount;
+		data->m_vertexStrideInBytes = sizeof (dgVector);
+
+		if (GetDebugCollisionCallback()) { 
+			dgTriplex triplex[3];
+			const dgVector scale = data->m_polySoupInstance->GetScale();
+			dgMatrix matrix(data->m_polySoupInstance->GetLocalMatrix() * data->m_polySoupBody->GetMatrix());
+			for (dgInt32 i = 0; i < data->m_faceCount; i ++) {
+				dgInt32 base = faceStart[i];
+				for (dgInt32 j = 0; j < 3; j ++) {
+					dgVector p (matrix.TransformVector(scale * vertex[data->m_faceVertexIndex[base + j]])); 
+					triplex[j].m_x = p.m_x;
+					triplex[j].m_y = p.m_y;
+					triplex[j].m_z = p.m_z;
+				}
+				GetDebugCollisionCallback() (data->m_polySoupBody, data->m_objBody, data->m_faceVertexIndex[base + 4], 3, &triplex[0].m_x, sizeof (dgTriplex));
+			}
+		}
+	}
 }
 
 void dgCollisionHeightField::GetCollidingFaces (dgPolygonMeshDesc* const data) const
 {
+	if (m_tileCache) {
+		GetTiledCollidingFaces (data);
+		return;
+	}
+
 	dgVector boxP0;
 	dgVector boxP1;
 
@@ -912,21 +1563,7 @@ void dgCollisionHeightField::GetCollidingFaces (dgPolygonMeshDesc* const data) c
 	data->m_separationDistance = dgFloat32 (0.0f);
 	dgFloat32 minHeight = dgFloat32 (1.0e10f);
 	dgFloat32 maxHeight = dgFloat32 (-1.0e10f);
-//	dgInt32 base = z0 * m_width;
-	switch (m_elevationDataType) 
-	{
-		case m_float32Bit:
-		{
-			CalculateMinAndMaxElevation(x0, x1, z0, z1, (dgFloat32*)m_elevationMap, minHeight, maxHeight);
-			break;
-		}
-
-		case m_unsigned16Bit:
-		{
-			CalculateMinAndMaxElevation(x0, x1, z0, z1, (dgUnsigned16*)m_elevationMap, minHeight, maxHeight);
-			break;
-		}
-	}
+	CalculateMinAndMaxElevation(x0, x1, z0, z1, minHeight, maxHeight);
 
 	minHeight *= m_verticalScale;
 	maxHeight *= m_verticalScale;
@@ -934,13 +1571,14 @@ void dgCollisionHeightField::GetCollidingFaces (dgPolygonMeshDesc* const data) c
 	if (!((maxHeight < boxP0.m_y) || (minHeight > boxP1.m_y))) {
 		// scan the vertices's intersected by the box extend
 		dgInt32 base = (z1 - z0 + 1) * (x1 - x0 + 1) + 2 * (z1 - z0) * (x1 - x0);
-		while (base > m_instanceData->m_vertexCount[data->m_threadNumber]) {
-			AllocateVertex(world, data->m_threadNumber);
+		dgPerIntanceData* const instanceData = GetPerInstanceData (world);
+		while (base > instanceData->m_vertexCount[data->m_threadNumber]) {
+			AllocateVertex(instanceData, data->m_threadNumber);
 		}
 
 		dgInt32 vertexIndex = 0;
 		base = z0 * m_width;
-		dgVector* const vertex = &m_instanceData->m_vertex[data->m_threadNumber][0];
+		dgVector* const vertex = &instanceData->m_vertex[data->m_threadNumber][0];
 
 		switch (m_elevationDataType) 
 		{
@@ -952,7 +1590,7 @@ void dgCollisionHeightField::GetCollidingFaces (dgPolygonMeshDesc* const data) c
 					for (dgInt32 x = x0; x <= x1; x ++) {
 						vertex[vertexIndex] = dgVector(m_horizontalScale_x * x, m_verticalScale * elevation[base + x], zVal, dgFloat32 (0.0f));
 						vertexIndex ++;
-						dgAssert (vertexIndex <= m_instanceData->m_vertexCount[data->m_threadNumber]); 
+						dgAssert (vertexIndex <= instanceData->m_vertexCount[data->m_threadNumber]); 
 					}
 					base += m_width;
 				}
@@ -967,7 +1605,7 @@ void dgCollisionHeightField::GetCollidingFaces (dgPolygonMeshDesc* const data) c
 					for (dgInt32 x = x0; x <= x1; x ++) {
 						vertex[vertexIndex] = dgVector(m_horizontalScale_x * x, m_verticalScale * dgFloat32 (elevation[base + x]), zVal, dgFloat32 (0.0f));
 						vertexIndex ++;
-						dgAssert (vertexIndex <= m_instanceData->m_vertexCount[data->m_threadNumber]); 
+						dgAssert (vertexIndex <= instanceData->m_vertexCount[data->m_threadNumber]); 
 					}
 					base += m_width;
 				}
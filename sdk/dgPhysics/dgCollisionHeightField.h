@@ -25,8 +25,13 @@
 #include "dgCollision.h"
 #include "dgCollisionMesh.h"
 
+// each leaf of the elevation pyramid covers a block of (1 << DG_HEIGHTFIELD_PYRAMID_LEAF_SHIFT) cells per side
+#define DG_HEIGHTFIELD_PYRAMID_LEAF_SHIFT	2
+#define DG_HEIGHTFIELD_PYRAMID_MAX_LEVELS	32
+
 class dgCollisionHeightField;
 typedef dgFloat32 (*dgCollisionHeightFieldRayCastCallback) (const dgBody* const body, const dgCollisionHeightField* const heightFieldCollision, dgFloat32 interception, dgInt32 row, dgInt32 col, dgVector* const normal, int faceId, void* const usedData);
+typedef void (*dgCollisionHeightFieldTilePageInCallback) (void* const userData, dgInt32 x0, dgInt32 z0, dgInt32 width, dgInt32 height, void* const elevation, dgInt8* const atributes);
 
 
 class dgCollisionHeightField: public dgCollisionMesh
@@ -53,6 +58,10 @@ class dgCollisionHeightField: public dgCollisionMesh
 							const void* const elevationMap, dgElevationType elevationDataType, dgFloat32 verticalScale, 
 							const dgInt8* const atributeMap, dgFloat32 horizontalScale_x, dgFloat32 horizontalScale_z);
 
+	dgCollisionHeightField (dgWorld* const world, dgInt32 width, dgInt32 height, dgInt32 tileSize, dgInt32 maxResidentTiles, dgInt32 contructionMode, 
+							dgElevationType elevationDataType, dgFloat32 minElevation, dgFloat32 maxElevation, dgFloat32 verticalScale, 
+							dgFloat32 horizontalScale_x, dgFloat32 horizontalScale_z, dgCollisionHeightFieldTilePageInCallback pageInCallback, void* const pageInUserData);
+
 	dgCollisionHeightField (dgWorld* const world, dgDeserialize deserialization, void* const userData, dgInt32 revisionNumber);
 
 	virtual ~dgCollisionHeightField(void);
@@ -60,21 +69,77 @@ class dgCollisionHeightField: public dgCollisionMesh
 	void SetCollisionRayCastCallback (dgCollisionHeightFieldRayCastCallback rayCastCallback);
 	dgCollisionHeightFieldRayCastCallback GetDebugRayCastCallback() const { return m_userRayCastCallback;} 
 
+	bool IsTiled() const { return m_tileCache ? true : false; }
+	void SetTilePageInCallback (dgCollisionHeightFieldTilePageInCallback pageInCallback, void* const userData);
+	dgInt32 GetResidentTileCount() const;
+	void FlushTiles();
+
 	private:
 	class dgPerIntanceData
 	{
 		public:
 		dgWorld* m_world;
 		dgInt32 m_refCount;
+		dgInt32 m_lock;
 		dgInt32 m_vertexCount[DG_MAX_THREADS_HIVE_COUNT];
 		dgArray<dgVector> m_vertex[DG_MAX_THREADS_HIVE_COUNT];
+		dgArray<dgVector> m_tileVertex[DG_MAX_THREADS_HIVE_COUNT];
+		dgArray<dgInt32> m_tileIndices[DG_MAX_THREADS_HIVE_COUNT];
+	};
+
+	// a tiled height field keeps only the tiles touched by recent queries resident, 
+	// each one is a small height field covering (tileSize + 1) x (tileSize + 1) samples
+	class dgTile
+	{
+		public:
+		dgCollisionHeightField* m_shape;
+		dgInt32 m_key;
+		dgInt32 m_x0;
+		dgInt32 m_z0;
+		dgInt32 m_useCount;
+	};
+
+	class dgTileCache
+	{
+		public:
+		dgTileCache(dgMemoryAllocator* const allocator);
+		~dgTileCache();
+		DG_CLASS_ALLOCATOR(allocator)
+
+		dgList<dgTile> m_residentList;
+		dgTree<dgList<dgTile>::dgListNode*, dgInt32> m_tileMap;
+		dgCollisionHeightFieldTilePageInCallback m_pageInCallback;
+		void* m_pageInUserData;
+		dgInt32 m_tileSize;
+		dgInt32 m_tileCountX;
+		dgInt32 m_tileCountZ;
+		dgInt32 m_maxResidentTiles;
 	};
 
 	void CalculateAABB();
+	void AttachPerInstanceData(dgWorld* const world);
+	virtual void AttachWorld (dgWorld* const world) const;
+	virtual void DetachWorld (dgWorld* const world) const;
+	dgPerIntanceData* GetPerInstanceData (const dgWorld* const world) const;
+	static dgPerIntanceData* AcquirePerInstanceData (dgWorld* const world);
+	static void ReleasePerInstanceData (dgPerIntanceData* const instanceData);
 	void CalculateMinAndMaxElevation(dgInt32 x0, dgInt32 x1, dgInt32 z0, dgInt32 z1, const dgUnsigned16* const elevation, dgFloat32& minHeight, dgFloat32& maxHeight) const;
 	void CalculateMinAndMaxElevation(dgInt32 x0, dgInt32 x1, dgInt32 z0, dgInt32 z1, const dgFloat32* const elevation, dgFloat32& minHeight, dgFloat32& maxHeight) const;
+	void CalculateMinAndMaxElevation(dgInt32 x0, dgInt32 x1, dgInt32 z0, dgInt32 z1, dgFloat32& minHeight, dgFloat32& maxHeight) const;
+
+	void AllocateElevationPyramid();
+	void BuildElevationPyramid();
+	DG_INLINE dgInt32 GetPyramidWidth(dgInt32 level) const;
+	dgFloat32 RayCastPyramid (const dgFastRayTest& ray, dgFloat32 maxT, dgVector& normalOut, dgInt32& hitX, dgInt32& hitZ) const;
+
+	dgTile* AcquireTile (dgInt32 tileX, dgInt32 tileZ) const;
+	void ReleaseTile (dgTile* const tile) const;
+	void GetTiledCollidingFaces (dgPolygonMeshDesc* const data) const;
+	dgFloat32 TiledRayCast (const dgVector& localP0, const dgVector& localP1, dgFloat32 maxT, dgContactPoint& contactOut, const dgBody* const body, void* const userData) const;
+	void TiledMinAndMaxElevation(dgInt32 x0, dgInt32 x1, dgInt32 z0, dgInt32 z1, dgFloat32& minHeight, dgFloat32& maxHeight) const;
+	DG_INLINE dgInt32 GetPyramidHeight(dgInt32 level) const;
 		
-	void AllocateVertex(dgWorld* const world, dgInt32 thread) const;
+	static void AllocateVertex(dgPerIntanceData* const instanceData, dgInt32 thread);
 	void CalculateMinExtend2d (const dgVector& p0, const dgVector& p1, dgVector& boxP0, dgVector& boxP1) const;
 	void CalculateMinExtend3d (const dgVector& p0, const dgVector& p1, dgVector& boxP0, dgVector& boxP1) const;
 	dgFloat32 RayCastCell (const dgFastRayTest& ray, dgInt32 xIndex0, dgInt32 zIndex0, dgVector& normalOut, dgFloat32 maxT) const;
@@ -118,10 +183,19 @@ class dgCollisionHeightField: public dgCollisionMesh
 	dgCollisionHeightFieldRayCastCallback m_userRayCastCallback;
 	dgElevationType m_elevationDataType;
 
+	// min and max elevation pairs of a quad tree over the grid cells, stored level by level from the leaves up 
+	dgFloat32* m_elevationPyramid;
+	dgInt32 m_pyramidLevels;
+	dgInt32 m_pyramidSize;
+	dgInt32 m_pyramidOffset[DG_HEIGHTFIELD_PYRAMID_MAX_LEVELS];
+
+	dgTileCache* m_tileCache;
+
 	
 	static dgVector m_yMask;
 	static dgVector m_padding;
 	static dgVector m_elevationPadding;
+	static dgVector m_pyramidPadding;
 	static dgInt32 m_cellIndices[][4];
 	static dgInt32 m_verticalEdgeMap[][7];
 	static dgInt32 m_horizontalEdgeMap[][7];
@@ -132,4 +206,16 @@ class dgCollisionHeightField: public dgCollisionMesh
 
 
 
+DG_INLINE dgInt32 dgCollisionHeightField::GetPyramidWidth(dgInt32 level) const
+{
+	const dgInt32 leafWidth = dgMax ((m_width + (1 << DG_HEIGHTFIELD_PYRAMID_LEAF_SHIFT) - 2) >> DG_HEIGHTFIELD_PYRAMID_LEAF_SHIFT, 1);
+	return ((leafWidth - 1) >> level) + 1;
+}
+
+DG_INLINE dgInt32 dgCollisionHeightField::GetPyramidHeight(dgInt32 level) const
+{
+	const dgInt32 leafHeight = dgMax ((m_height + (1 << DG_HEIGHTFIELD_PYRAMID_LEAF_SHIFT) - 2) >> DG_HEIGHTFIELD_PYRAMID_LEAF_SHIFT, 1);
+	return ((leafHeight - 1) >> level) + 1;
+}
+
 #endif
@@ -87,6 +87,9 @@ dgCollisionInstance::dgCollisionInstance(const dgWorld* const world, const dgCol
 {
 	m_material.m_userId = shapeID;
 	m_childShape->AddRef();
+	if (m_childShape->GetAllocator() != world->GetAllocator()) {
+		m_childShape->AttachWorld ((dgWorld*)world);
+	}
 }
 
 dgCollisionInstance::dgCollisionInstance(const dgCollisionInstance& instance)
@@ -126,6 +129,9 @@ dgCollisionInstance::dgCollisionInstance(const dgCollisionInstance& instance)
 		m_childShape = new (m_world->GetAllocator()) dgCollisionDeformableSolidMesh (*deformable);
 	} else {
 		m_childShape->AddRef();
+		if (m_childShape->GetAllocator() != m_world->GetAllocator()) {
+			m_childShape->AttachWorld ((dgWorld*)m_world);
+		}
 	}
 
 	if (m_world->m_onCollisionInstanceCopyConstrutor) {
@@ -133,6 +139,39 @@ dgCollisionInstance::dgCollisionInstance(const dgCollisionInstance& instance)
 	}
 }
 
+// an instance in another world that uses the shape of the shared instance without copying it, 
+// compound and deformable shapes have per instance state and can not be shared
+dgCollisionInstance::dgCollisionInstance(const dgWorld* const world, const dgCollisionInstance& sharedInstance)
+	:m_globalMatrix(sharedInstance.m_globalMatrix)
+	,m_localMatrix (sharedInstance.m_localMatrix)
+	,m_aligmentMatrix (sharedInstance.m_aligmentMatrix)
+	,m_scale(sharedInstance.m_scale)
+	,m_invScale(sharedInstance.m_invScale)
+	,m_maxScale(sharedInstance.m_maxScale)
+	,m_material(sharedInstance.m_material)
+	,m_world(world)
+	,m_childShape (sharedInstance.m_childShape)
+	,m_subCollisionHandle(NULL)
+	,m_parent(NULL)
+	,m_skinThickness(sharedInstance.m_skinThickness)
+	,m_collisionMode(sharedInstance.m_collisionMode)
+	,m_refCount(1)
+	,m_scaleType(sharedInstance.m_scaleType)
+	,m_isExternal(true)
+{
+	dgAssert (!m_childShape->IsType (dgCollision::dgCollisionCompound_RTTI));
+	dgAssert (!m_childShape->IsType (dgCollision::dgCollisionMassSpringDamperSystem_RTTI));
+	dgAssert (!m_childShape->IsType (dgCollision::dgCollisionDeformableSolidMesh_RTTI));
+	m_childShape->AddRef();
+	if (m_childShape->GetAllocator() != m_world->GetAllocator()) {
+		m_childShape->AttachWorld ((dgWorld*)m_world);
+	}
+
+	if (m_world->m_onCollisionInstanceCopyConstrutor) {
+		m_world->m_onCollisionInstanceCopyConstrutor (m_world, this, &sharedInstance);
+	}
+}
+
 dgCollisionInstance::dgCollisionInstance(const dgWorld* const constWorld, dgDeserialize serialize, void* const userData, dgInt32 revisionNumber)
 	:m_globalMatrix(dgGetIdentityMatrix())
 	,m_localMatrix (dgGetIdentityMatrix())
@@ -174,14 +213,8 @@ dgCollisionInstance::dgCollisionInstance(const dgWorld* const constWorld, dgDese
 
 	dgWorld* const world = (dgWorld*) constWorld;
 	if (saved) {
-		const dgCollision* collision = NULL;
-		dgBodyCollisionList::dgTreeNode* node = world->dgBodyCollisionList::Find (dgUnsigned32 (signature));
-
-		if (node) {
-			collision = node->GetInfo();
-			collision->AddRef();
-
-		} else {
+		const dgCollision* collision = world->FindCachedCollision (dgUnsigned32 (signature));
+		if (!collision) {
 
 			dgCollisionID primitiveType = dgCollisionID(primitive);
 
@@ -222,64 +255,56 @@ dgCollisionInstance::dgCollisionInstance(const dgWorld* const constWorld, dgDese
 				case m_sphereCollision:
 				{
 					collision = new (allocator) dgCollisionSphere (world, serialize, userData, revisionNumber);
-					node = world->dgBodyCollisionList::Insert (collision, collision->GetSignature());
-					collision->AddRef();
+					collision = world->AddCachedCollision (collision);
 					break;
 				}
 
 				case m_boxCollision:
 				{
 					collision = new (allocator) dgCollisionBox (world, serialize, userData, revisionNumber);
-					node = world->dgBodyCollisionList::Insert (collision, collision->GetSignature());
-					collision->AddRef();
+					collision = world->AddCachedCollision (collision);
 					break;
 				}
 
 				case m_coneCollision:
 				{
 					collision = new (allocator) dgCollisionCone (world, serialize, userData, revisionNumber);
-					node = world->dgBodyCollisionList::Insert (collision, collision->GetSignature());
-					collision->AddRef();
+					collision = world->AddCachedCollision (collision);
 					break;
 				}
 
 				case m_capsuleCollision:
 				{
 					collision = new (allocator) dgCollisionCapsule (world, serialize, userData, revisionNumber);
-					node = world->dgBodyCollisionList::Insert (collision, collision->GetSignature());
-					collision->AddRef();
+					collision = world->AddCachedCollision (collision);
 					break;
 				}
 
 				case m_cylinderCollision:
 				{
 					collision = new (allocator) dgCollisionCylinder (world, serialize, userData, revisionNumber);
-					node = world->dgBodyCollisionList::Insert (collision, collision->GetSignature());
-					collision->AddRef();
+					collision = world->AddCachedCollision (collision);
 					break;
 				}
 
 				case m_chamferCylinderCollision:
 				{
 					collision = new (allocator) dgCollisionChamferCylinder (world, serialize, userData, revisionNumber);
-					node = world->dgBodyCollisionList::Insert (collision, collision->GetSignature());
-					collision->AddRef();
+					collision = world->AddCachedCollision (collision);
 					break;
 				}
 
 				case m_convexHullCollision:
 				{
 					collision = new (allocator) dgCollisionConvexHull (world, serialize, userData, revisionNumber);
-					node = world->dgBodyCollisionList::Insert (collision, collision->GetSignature());
-					collision->AddRef();
+					collision = world->AddCachedCollision (collision);
 					break;
 				}
 
 				case m_nullCollision:
 				{
 					collision = new (allocator) dgCollisionNull (world, serialize, userData, revisionNumber);
-					node = world->dgBodyCollisionList::Insert (collision, collision->GetSignature());
-					collision->AddRef();
+					collision = world->AddCachedCollision (collision);
 					break;
 				}
 
@@ -304,6 +329,9 @@ dgCollisionInstance::~dgCollisionInstance()
 		m_world->m_onCollisionInstanceDestruction (m_world, this);
 	}
 	dgWorld* const world = (dgWorld*)m_world;
+	if (m_isExternal && (m_childShape->GetAllocator() != world->GetAllocator())) {
+		m_childShape->DetachWorld (world);
+	}
 	world->ReleaseCollision(m_childShape);
 }
 
@@ -41,6 +41,7 @@ dgCollisionLumpedMassParticles::dgCollisionLumpedMassParticles(dgWorld* const wo
 	,m_externalAccel(world->GetAllocator())
 	,m_mass(world->GetAllocator())
 	,m_invMass(world->GetAllocator())
+	,m_scratchMemory(world->GetAllocator())
 	,m_body(NULL)
 	,m_totalMass(dgFloat32(1.0f))	
 	,m_particleRadius(DG_MINIMIM_PARTCLE_RADIUS)
@@ -57,6 +58,7 @@ dgCollisionLumpedMassParticles::dgCollisionLumpedMassParticles (const dgCollisio
 	,m_externalAccel(source.m_externalAccel, source.m_particlesCount)
 	,m_mass(source.m_mass, source.m_particlesCount)
 	,m_invMass(source.m_invMass, source.m_particlesCount)
+	,m_scratchMemory(source.GetAllocator())
 	,m_body(NULL)
 	,m_totalMass(source.m_totalMass)
 	,m_particleRadius(source.m_particleRadius)
@@ -74,6 +76,7 @@ dgCollisionLumpedMassParticles::dgCollisionLumpedMassParticles (dgWorld* const w
 	,m_externalAccel(world->GetAllocator())
 	,m_mass(world->GetAllocator())
 	,m_invMass(world->GetAllocator())
+	,m_scratchMemory(world->GetAllocator())
 	,m_body(NULL)
 	,m_totalMass(dgFloat32(1.0f))	
 	,m_particleRadius (DG_MINIMIM_PARTCLE_RADIUS)
@@ -208,11 +211,6 @@ void dgCollisionLumpedMassParticles::Serialize(dgSerialize callback, void* const
 	dgAssert (0);
 }
 
-void dgCollisionLumpedMassParticles::RegisterCollision(const dgBody* const otherBody)
-{
-//	dgAssert (0);
-}
-
 void dgCollisionLumpedMassParticles::CalcAABB(const dgMatrix& matrix, dgVector& p0, dgVector& p1) const
 {
 	dgVector origin(matrix.TransformVector(m_boxOrigin));
@@ -49,7 +49,6 @@ class dgCollisionLumpedMassParticles: public dgCollisionConvex
 	protected:
 	virtual void FinalizeBuild();
 	virtual dgInt32 CalculateSignature() const;
-	virtual void RegisterCollision(const dgBody* const otherBody);
 	virtual void SetCollisionBBox(const dgVector& p0, const dgVector& p1);
 	virtual void Serialize(dgSerialize callback, void* const userData) const;
 	virtual void CalcAABB(const dgMatrix& matrix, dgVector& p0, dgVector& p1) const;
@@ -70,6 +69,7 @@ class dgCollisionLumpedMassParticles: public dgCollisionConvex
 	dgArray<dgVector> m_externalAccel;
 	dgArray<dgFloat32> m_mass;
 	dgArray<dgFloat32> m_invMass;
+	dgArray<dgUnsigned8> m_scratchMemory;
 	dgDynamicBody* m_body;
 	dgFloat32 m_totalMass;
 	dgFloat32 m_particleRadius;
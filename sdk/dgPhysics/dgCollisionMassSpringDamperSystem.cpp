@@ -261,10 +261,10 @@ void dgCollisionMassSpringDamperSystem::CalculateAcceleration(dgFloat32 timestep
 	//	dgVector* const offDiag = dgAlloca(dgVector, m_particlesCount);
 	//dgVector deltaOmega(m_body->m_invWorldInertiaMatrix.RotateVector(m_body->m_externalTorque.Scale(timestep)));
 
-	dgWorld* const world = m_body->GetWorld();
-	world->m_solverJacobiansMemory.ResizeIfNecessary(GetMemoryBufferSizeInBytes() + 1024);
+	// soft bodies are integrated concurrently, each one has its own scratch buffer
+	m_scratchMemory.ResizeIfNecessary(GetMemoryBufferSizeInBytes() + 1024);
 
-	dgVector* const normalAccel = (dgVector*)&world->m_solverJacobiansMemory[0];
+	dgVector* const normalAccel = (dgVector*)&m_scratchMemory[0];
 	dgVector* const normalDir = &normalAccel[m_particlesCount];
 	dgVector* const diagonal = &normalDir[m_particlesCount];
 	dgFloat32* const frictionCoeffecient = (dgFloat32*)&diagonal[m_particlesCount];
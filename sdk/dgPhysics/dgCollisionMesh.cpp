@@ -107,6 +107,29 @@ dgPolygonMeshDesc::dgPolygonMeshDesc(dgCollisionParamProxy& proxy, void* const u
 	dgAssert (m_posit.m_w == dgFloat32 (1.0f));
 }
 
+dgPolygonMeshDesc::dgPolygonMeshDesc(dgCollisionParamProxy& proxy, const dgVector& boxP0, const dgVector& boxP1)
+	:dgFastAABBInfo(boxP0, boxP1)
+	,m_boxDistanceTravelInMeshSpace(dgFloat32 (0.0f))
+	,m_threadNumber(proxy.m_threadIndex)
+	,m_faceCount(0)
+	,m_vertexStrideInBytes(0)
+	,m_skinThickness(proxy.m_skinThickness)
+	,m_userData (NULL)
+	,m_objBody (proxy.m_body0)
+	,m_polySoupBody(proxy.m_body1)
+	,m_convexInstance(NULL)
+	,m_polySoupInstance(proxy.m_instance1)
+	,m_vertex(NULL)
+	,m_faceIndexCount(NULL)
+	,m_faceVertexIndex(NULL)
+	,m_faceIndexStart(NULL)
+	,m_hitDistance(NULL)
+	,m_maxT(dgFloat32 (1.0f))
+	,m_doContinuesCollisionTest(false)
+{
+	dgAssert (m_polySoupInstance->IsType (dgCollision::dgCollisionMesh_RTTI));
+}
+
 void dgPolygonMeshDesc::SortFaceArray ()
 {
 	dgInt32 stride = 8;
@@ -187,6 +210,134 @@ void dgPolygonMeshDesc::SortFaceArray ()
 #endif
 }
 
+void dgPolygonMeshDesc::SelectClusterFaces (const dgPolygonMeshDesc& cluster)
+{
+	dgAssert (!m_doContinuesCollisionTest);
+	m_me = cluster.m_me;
+	m_vertex = cluster.m_vertex;
+	m_vertexStrideInBytes = cluster.m_vertexStrideInBytes;
+	m_faceVertexIndex = cluster.m_faceVertexIndex;
+	m_faceIndexCount = m_meshData.m_globalFaceIndexCount;
+	m_faceIndexStart = m_meshData.m_globalFaceIndexStart;
+	m_hitDistance = m_meshData.m_globalHitDistance;
+	m_globalIndexCount = 0;
+
+	// the cluster box contains this box, so this is the same face set a direct mesh query would find
+	m_faceCount = 0;
+	m_separationDistance = cluster.m_separationDistance;
+	const dgInt32 stride = m_vertexStrideInBytes / sizeof (dgFloat32);
+	for (dgInt32 i = 0; i < cluster.m_faceCount; i ++) {
+		const dgInt32 start = cluster.m_faceIndexStart[i];
+		const dgInt32 indexCount = cluster.m_faceIndexCount[i];
+		const dgInt32* const indexArray = &m_faceVertexIndex[start];
+
+		// most of the cluster faces are far from this box, reject them before the oriented box test
+		dgVector faceP0 (dgVector (&m_vertex[indexArray[0] * stride]) & dgVector::m_triplexMask);
+		dgVector faceP1 (faceP0);
+		for (dgInt32 j = 1; j < indexCount; j ++) {
+			dgVector p (dgVector (&m_vertex[indexArray[j] * stride]) & dgVector::m_triplexMask);
+			faceP0 = faceP0.GetMin (p);
+			faceP1 = faceP1.GetMax (p);
+		}
+		if (((faceP0 > m_p1) | (faceP1 < m_p0)).GetSignMask() & 0x07) {
+			continue;
+		}
+
+		dgVector faceNormal (&m_vertex[GetNormalIndex (indexArray, indexCount) * stride]);
+		faceNormal = faceNormal & dgVector::m_triplexMask;
+		dgFloat32 dist = PolygonBoxDistance (faceNormal, indexCount, indexArray, stride, m_vertex);
+		if (dist > dgFloat32 (0.0f)) {
+			m_faceIndexStart[m_faceCount] = start;
+			m_faceIndexCount[m_faceCount] = indexCount;
+			m_hitDistance[m_faceCount] = dist;
+			m_faceCount ++;
+			m_separationDistance = dgFloat32 (0.0f);
+		} else {
+			m_separationDistance = dgMin (m_separationDistance[0], -dist);
+		}
+	}
+}
+
+dgFloat32 dgPolygonMeshDesc::CullFacesByObb (const dgMatrix& meshToObbMatrix, const dgVector& obbOrigin, const dgVector& obbSize, dgFloat32 margin)
+{
+	// separating axis test of each face against the box, the axis are the three box axis, the face normal 
+	// and the cross products of each face edge with the box axis. the three box axis and the three cross 
+	// axis of an edge are tested together, one per vector lane.
+	const dgInt32 stride = m_vertexStrideInBytes / sizeof (dgFloat32);
+	const dgVector marginVector (dgVector (margin) & dgVector::m_triplexMask);
+	const dgVector boxP0 (obbOrigin - obbSize);
+	const dgVector boxP1 (obbOrigin + obbSize);
+
+	dgInt32 faceCount = 0;
+	dgFloat32 closestDistance = dgFloat32 (1.0e10f);
+	for (dgInt32 i = 0; i < m_faceCount; i ++) {
+		const dgInt32 indexCount = m_faceIndexCount[i];
+		const dgInt32* const indexArray = &m_faceVertexIndex[m_faceIndexStart[i]];
+		dgAssert (indexCount <= DG_CONVEX_POLYGON_MAX_VERTEX_COUNT);
+
+		dgVector points[DG_CONVEX_POLYGON_MAX_VERTEX_COUNT];
+		points[0] = meshToObbMatrix.TransformVector(dgVector (&m_vertex[indexArray[0] * stride]) & dgVector::m_triplexMask) & dgVector::m_triplexMask;
+		dgVector faceP0 (points[0]);
+		dgVector faceP1 (points[0]);
+		for (dgInt32 j = 1; j < indexCount; j ++) {
+			points[j] = meshToObbMatrix.TransformVector(dgVector (&m_vertex[indexArray[j] * stride]) & dgVector::m_triplexMask) & dgVector::m_triplexMask;
+			faceP0 = faceP0.GetMin (points[j]);
+			faceP1 = faceP1.GetMax (points[j]);
+		}
+
+		dgFloat32 separation = ((faceP0 - boxP1).GetMax (boxP0 - faceP1) & dgVector::m_triplexMask).GetMax();
+		if (separation <= margin) {
+			dgVector normal ((points[1] - points[0]).CrossProduct(points[2] - points[0]));
+			dgFloat32 mag2 = normal.DotProduct(normal).GetScalar();
+			if (mag2 > dgFloat32 (1.0e-12f)) {
+				normal = normal.Scale (dgRsqrt (mag2));
+				dgFloat32 centerDist = normal.DotProduct(obbOrigin - points[0]).GetScalar();
+				separation = dgAbs (centerDist) - normal.Abs().DotProduct(obbSize).GetScalar();
+			}
+		}
+
+		if (separation <= margin) {
+			dgInt32 j0 = indexCount - 1;
+			for (dgInt32 j = 0; (j < indexCount) && (separation <= margin); j ++) {
+				// the projections of a point p over the axis e x X, e x Y and e x Z are the components of p x e
+				const dgVector edge (points[j] - points[j0]);
+				const dgVector absEdge (edge.Abs());
+				const dgVector radius (absEdge.ShiftTripleLeft() * obbSize.ShiftTripleRight() + absEdge.ShiftTripleRight() * obbSize.ShiftTripleLeft());
+				const dgVector center (obbOrigin.CrossProduct(edge));
+
+				dgVector faceMin (points[0].CrossProduct(edge));
+				dgVector faceMax (faceMin);
+				for (dgInt32 k = 1; k < indexCount; k ++) {
+					const dgVector p (points[k].CrossProduct(edge));
+					faceMin = faceMin.GetMin (p);
+					faceMax = faceMax.GetMax (p);
+				}
+
+				const dgVector axisMag (((edge.DotProduct(edge) - edge * edge) & dgVector::m_triplexMask).Sqrt());
+				const dgVector gap ((faceMin - center - radius).GetMax (center - radius - faceMax));
+				if ((gap > marginVector * axisMag).GetSignMask() & 0x07) {
+					for (dgInt32 k = 0; k < 3; k ++) {
+						if (gap[k] > margin * axisMag[k]) {
+							separation = dgMax (separation, gap[k] / axisMag[k]);
+						}
+					}
+				}
+				j0 = j;
+			}
+		}
+
+		if (separation > margin) {
+			closestDistance = dgMin (closestDistance, separation);
+		} else {
+			m_faceIndexStart[faceCount] = m_faceIndexStart[i];
+			m_faceIndexCount[faceCount] = indexCount;
+			m_hitDistance[faceCount] = m_hitDistance[i];
+			faceCount ++;
+		}
+	}
+	m_faceCount = faceCount;
+	return closestDistance;
+}
 
 dgCollisionMesh::dgCollisionMesh(dgWorld* const world, dgCollisionID type)
 	:dgCollision(world->GetAllocator(), 0, type)
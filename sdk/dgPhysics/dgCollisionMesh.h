@@ -60,6 +60,9 @@ class dgPolygonMeshDesc: public dgFastAABBInfo
 
 	dgPolygonMeshDesc(dgCollisionParamProxy& proxy, void* const userData);
 
+	// axis aligned box query in mesh space, used to gather the faces shared by a group of shapes
+	dgPolygonMeshDesc(dgCollisionParamProxy& proxy, const dgVector& boxP0, const dgVector& boxP1);
+
 	DG_INLINE void SetDistanceTravel (const dgVector& distanceInGlobalSpace)
 	{
 		const dgMatrix& soupMatrix = m_polySoupInstance->GetGlobalMatrix();
@@ -104,6 +107,19 @@ class dgPolygonMeshDesc: public dgFastAABBInfo
 
 	void SortFaceArray ();
 
+	// mesh space bounds of the query shape
+	DG_INLINE void GetQueryAABB (dgVector& p0, dgVector& p1) const
+	{
+		p0 = m_p0;
+		p1 = m_p1;
+	}
+
+	// select the faces of a cluster query that touch this descriptor box, without querying the mesh again
+	void SelectClusterFaces (const dgPolygonMeshDesc& cluster);
+
+	// remove the faces separated from an oriented box by more than margin, return a lower bound of the distance to the removed faces
+	dgFloat32 CullFacesByObb (const dgMatrix& meshToObbMatrix, const dgVector& obbOrigin, const dgVector& obbSize, dgFloat32 margin);
+
 	dgVector m_boxDistanceTravelInMeshSpace;
 	dgInt32 m_threadNumber;
 	dgInt32 m_faceCount;
@@ -24,6 +24,25 @@
 #include "dgWorld.h"
 #include "dgCollisionUserMesh.h"
 
+#define DG_USERMESH_DATA_ID 0x2C5A7D13
+
+class dgUserMeshVertexSlot
+{
+	public:
+	static dgInt32 Compare (const dgUserMeshVertexSlot* const A, const dgUserMeshVertexSlot* const B, void* const context)
+	{
+		if (A->m_vertex < B->m_vertex) {
+			return -1;
+		} else if (A->m_vertex > B->m_vertex) {
+			return 1;
+		}
+		return 0;
+	}
+
+	dgInt32 m_vertex;
+	dgInt32 m_slot;
+};
+
 
 dgCollisionUserMesh::dgCollisionUserMesh(dgWorld* const world, const dgVector& boxP0, const dgVector& boxP1, const dgUserMeshCreation& data)
 	:dgCollisionMesh (world, m_userMesh)
@@ -38,6 +57,9 @@ dgCollisionUserMesh::dgCollisionUserMesh(dgWorld* const world, const dgVector& b
 	m_destroyCallback = data.m_destroyCallback;
 	m_serializeCallback = data.m_serializeCallback;
 	m_getAABBOvelapTestCallback = data.m_getAABBOvelapTestCallback;
+	m_instanceData = AcquirePerInstanceData (world);
+	m_regionPadding = dgFloat32 (0.0f);
+	m_regionVersion = 0;
 
 	SetCollisionBBox(boxP0, boxP1);
 }
@@ -47,6 +69,9 @@ dgCollisionUserMesh::dgCollisionUserMesh (dgWorld* const world, dgDeserialize de
 {
 dgAssert (0);
 	m_rtti |= dgCollisionUserMesh_RTTI;
+	m_instanceData = AcquirePerInstanceData (world);
+	m_regionPadding = dgFloat32 (0.0f);
+	m_regionVersion = 0;
 	
 /*
 	dgAABBPolygonSoup::Deserialize (deserialization, userData);
@@ -63,6 +88,93 @@ dgCollisionUserMesh::~dgCollisionUserMesh(void)
 	if (m_destroyCallback) {
 		m_destroyCallback (m_userData);
 	}
+	ReleasePerInstanceData (m_instanceData);
+}
+
+dgCollisionUserMesh::dgFaceRegion::dgFaceRegion (dgMemoryAllocator* const allocator)
+	:m_faces()
+	,m_vertex(allocator)
+	,m_mesh(NULL)
+	,m_lru(0)
+	,m_version(0)
+	,m_valid(false)
+{
+	m_vertex.Resize (DG_MAX_COLLIDING_INDICES);
+}
+
+// the regions are per world and per thread, all user meshes of a world share them
+dgCollisionUserMesh::dgPerIntanceData* dgCollisionUserMesh::AcquirePerInstanceData(dgWorld* const world)
+{
+	dgTree<void*, unsigned>::dgTreeNode* nodeData = world->m_perInstanceData.Find(DG_USERMESH_DATA_ID);
+	if (!nodeData) {
+		dgPerIntanceData* const instanceData = (dgPerIntanceData*) new dgPerIntanceData();
+		instanceData->m_refCount = 0;
+		instanceData->m_world = world;
+		for (dgInt32 i = 0 ; i < DG_MAX_THREADS_HIVE_COUNT; i ++) {
+			instanceData->m_nextRegion[i] = 0;
+			for (dgInt32 j = 0 ; j < DG_USER_MESH_REGIONS_PER_THREAD; j ++) {
+				instanceData->m_regions[i][j] = NULL;
+			}
+		}
+		nodeData = world->m_perInstanceData.Insert (instanceData, DG_USERMESH_DATA_ID);
+	}
+	dgPerIntanceData* const instanceData = (dgPerIntanceData*) nodeData->GetInfo();
+	dgAtomicExchangeAndAdd (&instanceData->m_refCount, 1);
+	return instanceData;
+}
+
+void dgCollisionUserMesh::ReleasePerInstanceData(dgPerIntanceData* const instanceData)
+{
+	if (dgAtomicExchangeAndAdd (&instanceData->m_refCount, -1) == 1) {
+		dgWorld* const world = instanceData->m_world;
+		for (dgInt32 i = 0 ; i < DG_MAX_THREADS_HIVE_COUNT; i ++) {
+			for (dgInt32 j = 0 ; j < DG_USER_MESH_REGIONS_PER_THREAD; j ++) {
+				if (instanceData->m_regions[i][j]) {
+					delete instanceData->m_regions[i][j];
+				}
+			}
+		}
+		delete instanceData;
+		world->m_perInstanceData.Remove(DG_USERMESH_DATA_ID);
+	}
+}
+
+void dgCollisionUserMesh::AttachWorld (dgWorld* const world) const
+{
+	AcquirePerInstanceData (world);
+}
+
+void dgCollisionUserMesh::DetachWorld (dgWorld* const world) const
+{
+	dgTree<void*, unsigned>::dgTreeNode* const nodeData = world->m_perInstanceData.Find(DG_USERMESH_DATA_ID);
+	dgAssert (nodeData);
+	ReleasePerInstanceData ((dgPerIntanceData*) nodeData->GetInfo());
+}
+
+dgCollisionUserMesh::dgPerIntanceData* dgCollisionUserMesh::GetPerInstanceData (const dgWorld* const world) const
+{
+	if (world == m_instanceData->m_world) {
+		return m_instanceData;
+	}
+	dgTree<void*, unsigned>::dgTreeNode* const nodeData = world->m_perInstanceData.Find(DG_USERMESH_DATA_ID);
+	dgAssert (nodeData);
+	return (dgPerIntanceData*) nodeData->GetInfo();
+}
+
+dgFloat32 dgCollisionUserMesh::GetRegionPadding () const
+{
+	return m_regionPadding;
+}
+
+void dgCollisionUserMesh::SetRegionPadding (dgFloat32 padding)
+{
+	m_regionPadding = dgMax (padding, dgFloat32 (0.0f));
+	FlushRegions ();
+}
+
+void dgCollisionUserMesh::FlushRegions ()
+{
+	m_regionVersion ++;
 }
 
 void dgCollisionUserMesh::Serialize(dgSerialize callback, void* const userData) const
@@ -137,6 +249,198 @@ dgVector dgCollisionUserMesh::SupportVertexSpecial (const dgVector& dir, dgFloat
 	return dgVector::m_zero;
 }
 
+void dgCollisionUserMesh::DebugCollidingFaces (dgPolygonMeshDesc* const data) const
+{
+	if (GetDebugCollisionCallback()) {
+		dgTriplex triplex[32];
+		const dgInt32 stride = data->m_vertexStrideInBytes / sizeof(dgFloat32);
+		const dgFloat32* const vertex = data->m_vertex;
+		const dgVector scale = data->m_polySoupInstance->GetScale();
+		dgMatrix matrix(data->m_polySoupInstance->GetLocalMatrix() * data->m_polySoupBody->GetMatrix());
+
+		for (dgInt32 i = 0; i < data->m_faceCount; i++) {
+			dgInt32 base = data->m_faceIndexStart[i];
+			dgInt32 indexCount = data->m_faceIndexCount[i];
+			const dgInt32* const vertexFaceIndex = &data->m_faceVertexIndex[base];
+			for (dgInt32 j = 0; j < indexCount; j++) {
+				dgInt32 index = vertexFaceIndex[j];
+				dgVector q(&vertex[index * stride]);
+				q = q & dgVector::m_triplexMask; 
+				dgVector p(matrix.TransformVector(scale * q));
+				triplex[j].m_x = p.m_x;
+				triplex[j].m_y = p.m_y;
+				triplex[j].m_z = p.m_z;
+			}
+			dgInt32 faceId = data->GetFaceId(vertexFaceIndex, indexCount);
+			GetDebugCollisionCallback() (data->m_polySoupBody, data->m_objBody, faceId, indexCount, &triplex[0].m_x, sizeof(dgTriplex));
+		}
+	}
+}
+
+const dgCollisionUserMesh::dgFaceRegion* dgCollisionUserMesh::FindRegion (const dgPolygonMeshDesc* const data) const
+{
+	const dgWorld* const world = data->m_objBody->GetWorld();
+	const dgPerIntanceData* const instanceData = GetPerInstanceData (world);
+	const dgUnsigned32 lru = world->GetBroadPhase()->GetLRU();
+	for (dgInt32 i = 0; i < DG_USER_MESH_REGIONS_PER_THREAD; i ++) {
+		const dgFaceRegion* const region = instanceData->m_regions[data->m_threadNumber][i];
+		if (region && region->m_valid && (region->m_mesh == this) && (region->m_version == m_regionVersion) && (region->m_lru == lru)) {
+			const dgPolygonMeshDesc& faces = region->m_faces;
+			if (!(((data->m_p0 < faces.m_p0) | (data->m_p1 > faces.m_p1)).GetSignMask() & 0x07)) {
+				return region;
+			}
+		}
+	}
+	return NULL;
+}
+
+// replace the oldest region of the thread
+dgCollisionUserMesh::dgFaceRegion* dgCollisionUserMesh::AllocateRegion (const dgPolygonMeshDesc* const data) const
+{
+	dgPerIntanceData* const instanceData = GetPerInstanceData (data->m_objBody->GetWorld());
+	const dgInt32 index = instanceData->m_nextRegion[data->m_threadNumber];
+	instanceData->m_nextRegion[data->m_threadNumber] = (index + 1) % DG_USER_MESH_REGIONS_PER_THREAD;
+
+	dgFaceRegion* region = instanceData->m_regions[data->m_threadNumber][index];
+	if (!region) {
+		dgMemoryAllocator* const allocator = instanceData->m_world->GetAllocator();
+		region = new (allocator) dgFaceRegion (allocator);
+		instanceData->m_regions[data->m_threadNumber][index] = region;
+	}
+	region->m_valid = false;
+	return region;
+}
+
+// the application vertex array is too large to copy, copy only the vertices used by the faces
+void dgCollisionUserMesh::RemapRegionVertex (dgFaceRegion* const region, dgInt32 indexCount) const
+{
+	dgPolygonMeshDesc& faces = region->m_faces;
+	dgVector* const vertex = &region->m_vertex[0];
+	const dgInt32 faceCount = faces.m_faceCount;
+	const dgInt32* const faceStart = faces.m_meshData.m_globalFaceIndexStart;
+
+	dgStack<dgUserMeshVertexSlot> slotPool (indexCount);
+	dgUserMeshVertexSlot* const slots = &slotPool[0];
+	dgInt32 slotCount = 0;
+	for (dgInt32 i = 0; i < faceCount; i ++) {
+		const dgInt32 start = faceStart[i];
+		const dgInt32 count = faces.m_faceIndexCount[i];
+		for (dgInt32 j = 0; j < count; j ++) {
+			slots[slotCount].m_vertex = faces.m_faceVertexIndex[start + j];
+			slots[slotCount].m_slot = start + j;
+			slotCount ++;
+		}
+		// the face normal and the adjacent edge normals
+		for (dgInt32 j = count + 1; j < 2 * count + 2; j ++) {
+			slots[slotCount].m_vertex = faces.m_faceVertexIndex[start + j];
+			slots[slotCount].m_slot = start + j;
+			slotCount ++;
+		}
+	}
+	dgSort (slots, slotCount, dgUserMeshVertexSlot::Compare);
+
+	const dgInt32 stride = faces.m_vertexStrideInBytes / sizeof (dgFloat32);
+	const dgFloat32* const srcVertex = faces.m_vertex;
+	dgInt32 vertexCount = -1;
+	dgInt32 lastVertex = -1;
+	for (dgInt32 i = 0; i < slotCount; i ++) {
+		if ((vertexCount < 0) || (slots[i].m_vertex != lastVertex)) {
+			vertexCount ++;
+			lastVertex = slots[i].m_vertex;
+			vertex[vertexCount] = dgVector (&srcVertex[lastVertex * stride]) & dgVector::m_triplexMask;
+		}
+		faces.m_faceVertexIndex[slots[i].m_slot] = vertexCount;
+	}
+}
+
+bool dgCollisionUserMesh::QueryRegion (dgFaceRegion* const region, dgPolygonMeshDesc* const data) const
+{
+	dgPolygonMeshDesc& faces = region->m_faces;
+	const dgVector padding (dgVector (m_regionPadding) & dgVector::m_triplexMask);
+	faces.m_p0 = data->m_p0 - padding;
+	faces.m_p1 = data->m_p1 + padding;
+	faces.m_boxDistanceTravelInMeshSpace = dgVector::m_zero;
+	faces.m_threadNumber = data->m_threadNumber;
+	faces.m_skinThickness = data->m_skinThickness;
+	faces.m_userData = m_userData;
+	faces.m_objBody = data->m_objBody;
+	faces.m_polySoupBody = data->m_polySoupBody;
+	faces.m_convexInstance = data->m_convexInstance;
+	faces.m_polySoupInstance = data->m_polySoupInstance;
+	faces.m_doContinuesCollisionTest = false;
+
+	// the application can write the faces to the region buffers, which saves copying them
+	faces.m_faceCount = 0;
+	faces.m_vertex = &region->m_vertex[0].m_x;
+	faces.m_vertexStrideInBytes = sizeof (dgVector);
+	faces.m_faceIndexCount = faces.m_meshData.m_globalFaceIndexCount;
+	faces.m_faceVertexIndex = faces.m_globalFaceVertexIndex;
+	m_collideCallback(&faces.m_p0, NULL);
+
+	region->m_mesh = this;
+	region->m_lru = data->m_objBody->GetWorld()->GetBroadPhase()->GetLRU();
+	region->m_version = m_regionVersion;
+	region->m_valid = false;
+
+	const dgInt32 faceCount = faces.m_faceCount;
+	if (faceCount > DG_MAX_COLLIDING_FACES) {
+		return false;
+	}
+
+	dgInt32 indexCount = 0;
+	dgInt32* const faceStart = faces.m_meshData.m_globalFaceIndexStart;
+	for (dgInt32 i = 0; i < faceCount; i ++) {
+		faceStart[i] = indexCount;
+		indexCount += faces.GetFaceIndexCount (faces.m_faceIndexCount[i]);
+	}
+	if (indexCount > DG_MAX_COLLIDING_INDICES) {
+		return false;
+	}
+
+	if (faces.m_faceIndexCount != faces.m_meshData.m_globalFaceIndexCount) {
+		memcpy (faces.m_meshData.m_globalFaceIndexCount, faces.m_faceIndexCount, faceCount * sizeof (dgInt32));
+		faces.m_faceIndexCount = faces.m_meshData.m_globalFaceIndexCount;
+	}
+	if (faces.m_faceVertexIndex != faces.m_globalFaceVertexIndex) {
+		memcpy (faces.m_globalFaceVertexIndex, faces.m_faceVertexIndex, indexCount * sizeof (dgInt32));
+		faces.m_faceVertexIndex = faces.m_globalFaceVertexIndex;
+	}
+
+	dgVector* const vertex = &region->m_vertex[0];
+	if ((faces.m_vertex != &vertex[0].m_x) || (faces.m_vertexStrideInBytes != sizeof (dgVector))) {
+		// the faces reference the application vertex array, copy the vertices they use to the region
+		dgInt32 maxIndex = 0;
+		for (dgInt32 i = 0; i < faceCount; i ++) {
+			const dgInt32* const indexArray = &faces.m_faceVertexIndex[faceStart[i]];
+			const dgInt32 count = faces.m_faceIndexCount[i];
+			for (dgInt32 j = 0; j < count; j ++) {
+				maxIndex = dgMax (maxIndex, indexArray[j]);
+			}
+			for (dgInt32 j = count + 1; j < 2 * count + 2; j ++) {
+				maxIndex = dgMax (maxIndex, indexArray[j]);
+			}
+		}
+
+		const dgInt32 stride = faces.m_vertexStrideInBytes / sizeof (dgFloat32);
+		const dgFloat32* const srcVertex = faces.m_vertex;
+		if (maxIndex < DG_MAX_COLLIDING_INDICES) {
+			for (dgInt32 i = 0; i <= maxIndex; i ++) {
+				vertex[i] = dgVector (&srcVertex[i * stride]) & dgVector::m_triplexMask;
+			}
+		} else {
+			RemapRegionVertex (region, indexCount);
+		}
+		faces.m_vertex = &vertex[0].m_x;
+		faces.m_vertexStrideInBytes = sizeof (dgVector);
+	}
+
+	faces.m_me = this;
+	faces.m_faceIndexStart = faceStart;
+	faces.m_separationDistance = dgFloat32 (0.0f);
+	region->m_valid = true;
+	return true;
+}
+
 void dgCollisionUserMesh::GetCollidingFacesContinue(dgPolygonMeshDesc* const data) const
 {
 	data->m_me = this;
@@ -220,6 +524,27 @@ void dgCollisionUserMesh::GetCollidingFacesDescrete(dgPolygonMeshDesc* const dat
 	data->m_userData = m_userData;
 	data->m_separationDistance = dgFloat32(0.0f);
 
+	if (m_regionPadding > dgFloat32 (0.0f)) {
+		const dgFaceRegion* const region = FindRegion (data);
+		if (region) {
+			data->SelectClusterFaces (region->m_faces);
+			DebugCollidingFaces (data);
+			return;
+		}
+	}
+
+	dgFaceRegion* const region = AllocateRegion (data);
+	if ((m_regionPadding > dgFloat32 (0.0f)) && QueryRegion (region, data)) {
+		data->SelectClusterFaces (region->m_faces);
+		DebugCollidingFaces (data);
+		return;
+	}
+
+	// the application can write the faces to the thread buffers instead of its own arrays
+	data->m_vertex = &region->m_vertex[0].m_x;
+	data->m_vertexStrideInBytes = sizeof (dgVector);
+	data->m_faceIndexCount = region->m_faces.m_meshData.m_globalFaceIndexCount;
+	data->m_faceVertexIndex = region->m_faces.m_globalFaceVertexIndex;
 	m_collideCallback(&data->m_p0, NULL);
 
 	dgInt32 faceCount0 = 0;
@@ -261,30 +586,7 @@ void dgCollisionUserMesh::GetCollidingFacesDescrete(dgPolygonMeshDesc* const dat
 		data->m_hitDistance = hitDistance;
 		data->m_faceVertexIndex = dstIndices;
 
-		if (GetDebugCollisionCallback()) {
-			dgTriplex triplex[32];
-			//const dgMatrix& matrix = data->m_polySoupInstance->GetGlobalMatrix();
-			const dgVector scale = data->m_polySoupInstance->GetScale();
-			dgMatrix matrix(data->m_polySoupInstance->GetLocalMatrix() * data->m_polySoupBody->GetMatrix());
-
-			for (dgInt32 i = 0; i < data->m_faceCount; i++) {
-				dgInt32 base = address[i];
-				dgInt32 indexCount = faceIndexCountArray[i];
-				const dgInt32* const vertexFaceIndex = &data->m_faceVertexIndex[base];
-				for (dgInt32 j = 0; j < indexCount; j++) {
-					dgInt32 index = vertexFaceIndex[j];
-					dgVector q(&vertex[index * stride]);
-					q = q & dgVector::m_triplexMask; 
-					//dgVector p(matrix.TransformVector(scale * dgVector(&vertex[index * stride])));
-					dgVector p(matrix.TransformVector(scale * q));
-					triplex[j].m_x = p.m_x;
-					triplex[j].m_y = p.m_y;
-					triplex[j].m_z = p.m_z;
-				}
-				dgInt32 faceId = data->GetFaceId(vertexFaceIndex, indexCount);
-				GetDebugCollisionCallback() (data->m_polySoupBody, data->m_objBody, faceId, indexCount, &triplex[0].m_x, sizeof(dgTriplex));
-			}
-		}
+		DebugCollidingFaces (data);
 	}
 }
 
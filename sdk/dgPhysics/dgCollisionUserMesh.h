@@ -25,6 +25,7 @@
 #include "dgCollision.h"
 #include "dgCollisionMesh.h"
 
+#define DG_USER_MESH_REGIONS_PER_THREAD	4
 
 
 class dgCollisionUserMesh: public dgCollisionMesh
@@ -46,9 +47,50 @@ class dgCollisionUserMesh: public dgCollisionMesh
 
 	bool AABBOvelapTest (const dgVector& boxP0, const dgVector& boxP1) const;
 
+	dgFloat32 GetRegionPadding () const;
+	void SetRegionPadding (dgFloat32 padding);
+	void FlushRegions ();
+
 	private:
+	// the faces returned by the last collide callback of a thread, 
+	// queries with a box inside the region are served from here without calling the application
+	class dgFaceRegion
+	{
+		public:
+		dgFaceRegion (dgMemoryAllocator* const allocator);
+		DG_CLASS_ALLOCATOR(allocator)
+
+		dgPolygonMeshDesc m_faces;
+		dgArray<dgVector> m_vertex;
+		const dgCollisionUserMesh* m_mesh;
+		dgUnsigned32 m_lru;
+		dgInt32 m_version;
+		bool m_valid;
+	} DG_GCC_VECTOR_ALIGMENT;
+
+	class dgPerIntanceData
+	{
+		public:
+		dgWorld* m_world;
+		dgInt32 m_refCount;
+		dgInt32 m_nextRegion[DG_MAX_THREADS_HIVE_COUNT];
+		dgFaceRegion* m_regions[DG_MAX_THREADS_HIVE_COUNT][DG_USER_MESH_REGIONS_PER_THREAD];
+	};
+
 	void Serialize(dgSerialize callback, void* const userData) const;
 
+	virtual void AttachWorld (dgWorld* const world) const;
+	virtual void DetachWorld (dgWorld* const world) const;
+	dgPerIntanceData* GetPerInstanceData (const dgWorld* const world) const;
+	static dgPerIntanceData* AcquirePerInstanceData (dgWorld* const world);
+	static void ReleasePerInstanceData (dgPerIntanceData* const instanceData);
+
+	const dgFaceRegion* FindRegion (const dgPolygonMeshDesc* const data) const;
+	dgFaceRegion* AllocateRegion (const dgPolygonMeshDesc* const data) const;
+	bool QueryRegion (dgFaceRegion* const region, dgPolygonMeshDesc* const data) const;
+	void RemapRegionVertex (dgFaceRegion* const region, dgInt32 indexCount) const;
+	void DebugCollidingFaces (dgPolygonMeshDesc* const data) const;
+
 	dgVector SupportVertex (const dgVector& dir, dgInt32* const vertexIndex) const;
 	dgVector SupportVertexSpecial (const dgVector& dir, dgFloat32 skinThickness, dgInt32* const vertexIndex) const;
 	dgVector SupportVertexSpecialProjectPoint (const dgVector& point, const dgVector& dir) const {return point;}
@@ -69,6 +111,9 @@ class dgCollisionUserMesh: public dgCollisionMesh
 	OnUserMeshCollideCallback m_collideCallback;
 	OnUserMeshDestroyCallback m_destroyCallback;
 	OnUserMeshAABBOverlapTest m_getAABBOvelapTestCallback;
+	dgPerIntanceData* m_instanceData;
+	dgFloat32 m_regionPadding;
+	dgInt32 m_regionVersion;
 };
 
 class dgUserMeshCreation
@@ -32,6 +32,51 @@
 //#define MAX_SEPARATING_SPEED			dgFloat32 (4.0f)
 
 
+void dgContactList::AddTriggerEvent (const dgContact* const contact, dgInt32 begin)
+{
+	dgBody* const body0 = contact->GetBody0();
+	dgBody* const body1 = contact->GetBody1();
+	dgTriggerEvent& event = m_triggerEvents[m_triggerEventCount];
+	event.m_trigger = body0->IsTrigger() ? body0 : body1;
+	event.m_body = body0->IsTrigger() ? body1 : body0;
+	event.m_begin = begin;
+	m_triggerEventCount ++;
+}
+
+void dgContactList::AddContactEndEvent (const dgContact* const contact)
+{
+	dgContactEvent& event = m_contactEvents[m_contactEventCount];
+	memset (&event, 0, sizeof (dgContactEvent));
+	event.m_body0 = contact->GetBody0();
+	event.m_body1 = contact->GetBody1();
+	event.m_type = dgContactEvent::m_endEvent;
+	m_contactEventCount ++;
+}
+
+void dgContactList::RemoveDeadEvents ()
+{
+	// the events are handed out after the update, they can not refer to deleted bodies
+	dgInt32 count = 0;
+	for (dgInt32 i = 0; i < m_triggerEventCount; i ++) {
+		const dgTriggerEvent& event = m_triggerEvents[i];
+		if (!(event.m_trigger->m_isdead | event.m_body->m_isdead)) {
+			m_triggerEvents[count] = event;
+			count ++;
+		}
+	}
+	m_triggerEventCount = count;
+
+	count = 0;
+	for (dgInt32 i = 0; i < m_contactEventCount; i ++) {
+		const dgContactEvent& event = m_contactEvents[i];
+		if (!(event.m_body0->m_isdead | event.m_body1->m_isdead)) {
+			m_contactEvents[count] = event;
+			count ++;
+		}
+	}
+	m_contactEventCount = count;
+}
+
 //////////////////////////////////////////////////////////////////////
 // Construction/Destruction
 //////////////////////////////////////////////////////////////////////
@@ -80,6 +125,9 @@ dgContact::dgContact(dgWorld* const world, const dgContactMaterial* const materi
 	,m_isNewContact(1)
 	,m_skeletonIntraCollision(1)
 	,m_skeletonSelftCollision(1)
+	,m_isTrigger(body0->m_isTrigger | body1->m_isTrigger)
+	,m_wasTouching(0)
+	,m_activationChanged(0)
 {
 	dgAssert ((((dgUnsigned64) this) & 15) == 0);
 	m_maxDOF = 0;
@@ -120,6 +168,9 @@ dgContact::dgContact(dgContact* const clone)
 	,m_isNewContact(clone->m_isNewContact)
 	,m_skeletonIntraCollision(clone->m_skeletonIntraCollision)
 	,m_skeletonSelftCollision(clone->m_skeletonSelftCollision)
+	,m_isTrigger(clone->m_isTrigger)
+	,m_wasTouching(clone->m_wasTouching)
+	,m_activationChanged(0)
 {
 	dgAssert((((dgUnsigned64) this) & 15) == 0);
 	m_body0 = clone->m_body0;
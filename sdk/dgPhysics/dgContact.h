@@ -38,14 +38,49 @@ class dgCollisionInstance;
 #define DG_RESTING_CONTACT_PENETRATION	(DG_PENETRATION_TOL + dgFloat32 (1.0f / 1024.0f))
 #define DG_DIAGONAL_PRECONDITIONER		dgFloat32 (25.0f)
 
+class dgTriggerEvent
+{
+	public:
+	dgBody* m_trigger;
+	dgBody* m_body;
+	dgInt32 m_begin;
+};
+
+class dgContactEvent
+{
+	public:
+	enum dgEventType
+	{
+		m_beginEvent = 1<<0,
+		m_persistEvent = 1<<1,
+		m_endEvent = 1<<2,
+	};
+
+	dgFloat32 m_point[4];
+	dgFloat32 m_normal[4];
+	dgBody* m_body0;
+	dgBody* m_body1;
+	dgFloat32 m_normalImpulse;
+	dgFloat32 m_tangentImpulse;
+	dgFloat32 m_maxNormalImpact;
+	dgFloat32 m_penetration;
+	dgInt32 m_pointCount;
+	dgInt32 m_type;
+};
+
 class dgContactList: public dgArray<dgContact*>
 {
 	public:
 	dgContactList(dgMemoryAllocator* const allocator)
 		:dgArray<dgContact*>(allocator)
+		,m_triggerEvents(allocator)
+		,m_contactEvents(allocator)
 		,m_contactCount(0)
 		,m_contactCountReset(0)
 		,m_activeContactCount(0)
+		,m_triggerEventCount(0)
+		,m_contactEventCount(0)
+		,m_contactEventMask(0)
 	{
 		Resize (1024 * 32);
 	}
@@ -61,9 +96,18 @@ class dgContactList: public dgArray<dgContact*>
 		(*this)[index] = contact;
 	}
 
+	void AddTriggerEvent (const dgContact* const contact, dgInt32 begin);
+	void AddContactEndEvent (const dgContact* const contact);
+	void RemoveDeadEvents ();
+
+	dgArray<dgTriggerEvent> m_triggerEvents;
+	dgArray<dgContactEvent> m_contactEvents;
 	dgInt32 m_contactCount;
 	dgInt32 m_contactCountReset;
 	dgInt32 m_activeContactCount;
+	dgInt32 m_triggerEventCount;
+	dgInt32 m_contactEventCount;
+	dgInt32 m_contactEventMask;
 };
 
 DG_MSC_VECTOR_ALIGMENT
@@ -249,6 +293,9 @@ class dgContact: public dgConstraint, public dgList<dgContactMaterial>
 	dgUnsigned32 m_isNewContact				: 1;
 	dgUnsigned32 m_skeletonIntraCollision	: 1;
 	dgUnsigned32 m_skeletonSelftCollision	: 1;
+	dgUnsigned32 m_isTrigger				: 1;
+	dgUnsigned32 m_wasTouching				: 1;
+	dgUnsigned32 m_activationChanged		: 1;
 
     friend class dgBody;
 	friend class dgWorld;
@@ -256,6 +303,7 @@ class dgContact: public dgConstraint, public dgList<dgContactMaterial>
 	friend class dgBroadPhase;
 	friend class dgContactList;
 	friend class dgContactSolver;
+	friend class dgContactEventCollector;
 	friend class dgCollisionScene;
 	friend class dgCollisionConvex;
 	friend class dgCollisionCompound;
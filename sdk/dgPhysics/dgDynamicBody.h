@@ -110,6 +110,7 @@ class dgDynamicBody : public dgBody
 
 	friend class dgWorld;
 	friend class dgSolver;
+	DG_STATIC_SOLVER_FRIENDS
 	friend class dgBroadPhase;
 	friend class dgBodyMasterList;
 	friend class dgSkeletonContainer;
@@ -293,6 +293,15 @@ dgCollisionInstance* dgWorld::CreateBVH ()
 	return instance;
 }
 
+dgCollisionInstance* dgWorld::CreateSharedInstance (const dgCollisionInstance* const sharedInstance)
+{
+	const dgCollision* const shape = sharedInstance->GetChildShape();
+	if (shape->IsType (dgCollision::dgCollisionCompound_RTTI) || shape->IsType (dgCollision::dgCollisionMassSpringDamperSystem_RTTI) || shape->IsType (dgCollision::dgCollisionDeformableSolidMesh_RTTI)) {
+		return NULL;
+	}
+	return new (m_allocator) dgCollisionInstance (this, *sharedInstance);
+}
+
 dgCollisionInstance* dgWorld::CreateStaticUserMesh (const dgVector& boxP0, const dgVector& boxP1, const dgUserMeshCreation& data)
 {
 	dgCollision* const collision = new (m_allocator) dgCollisionUserMesh(this, boxP0, boxP1, data);
@@ -315,6 +324,19 @@ dgCollisionInstance* dgWorld::CreateHeightField(
 	return instance;
 }
 
+dgCollisionInstance* dgWorld::CreateTiledHeightField(
+	dgInt32 width, dgInt32 height, dgInt32 tileSize, dgInt32 maxResidentTiles, dgInt32 contructionMode, dgInt32 elevationDataType, 
+	dgFloat32 minElevation, dgFloat32 maxElevation, dgFloat32 verticalScale, dgFloat32 horizontalScale_x, dgFloat32 horizontalScale_z, 
+	dgCollisionHeightFieldTilePageInCallback pageInCallback, void* const pageInUserData)
+{
+	dgCollision* const collision = new  (m_allocator) dgCollisionHeightField (this, width, height, tileSize, maxResidentTiles, contructionMode, 
+																			  elevationDataType	? dgCollisionHeightField::m_unsigned16Bit : dgCollisionHeightField::m_float32Bit,	
+																			  minElevation, maxElevation, verticalScale, horizontalScale_x, horizontalScale_z, pageInCallback, pageInUserData);
+	dgCollisionInstance* const instance = CreateInstance (collision, 0, dgGetIdentityMatrix()); 
+	collision->Release();
+	return instance;
+}
+
 dgCollisionInstance* dgWorld::CreateInstance (const dgCollision* const child, dgInt32 shapeID, const dgMatrix& offsetMatrix)
 {
 	dgAssert (dgAbs (offsetMatrix[0].DotProduct(offsetMatrix[0]).GetScalar() - dgFloat32 (1.0f)) < dgFloat32 (1.0e-5f));
@@ -345,14 +367,10 @@ dgCollisionInstance* dgWorld::CreateCollisionFromSerialization (dgDeserialize de
 
 dgContactMaterial* dgWorld::GetMaterial (dgUnsigned32 bodyGroupId0, dgUnsigned32 bodyGroupId1)	const
 {
-	if (bodyGroupId0 > bodyGroupId1) {
-		dgSwap (bodyGroupId0, bodyGroupId1);
+	if ((bodyGroupId0 >= m_bodyGroupID) || (bodyGroupId1 >= m_bodyGroupID)) {
+		return NULL;
 	}
-
-	dgUnsigned32 key = (bodyGroupId1 << 16) + bodyGroupId0;
-	dgBodyMaterialList::dgTreeNode *const node = dgBodyMaterialList::Find (key);
-
-	return node ? &node->GetInfo() : NULL;
+	return GetPairMaterial (bodyGroupId0, bodyGroupId1);
 }
 
 dgContactMaterial* dgWorld::GetFirstMaterial () const
@@ -394,14 +412,51 @@ dgUnsigned32 dgWorld::CreateBodyGroupID()
 
 		dgBodyMaterialList::Insert(pairMaterial, key);
 	}
+	AddPairMaterialRow (newId);
 
 	return newId;
 }
 
+void dgBodyMaterialList::AddPairMaterialRow (dgUnsigned32 group)
+{
+	// tree nodes do not move, so the table can point to the materials in the tree
+	const dgInt32 count = m_pairTableCount + dgInt32 (group) + 1;
+	if (count > m_pairTableCapacity) {
+		const dgInt32 capacity = dgMax (count * 2, 64);
+		dgContactMaterial** const table = (dgContactMaterial**) GetAllocator()->Malloc (dgInt32 (capacity * sizeof (dgContactMaterial*)));
+		if (m_pairTable) {
+			memcpy (table, m_pairTable, m_pairTableCount * sizeof (dgContactMaterial*));
+			GetAllocator()->Free (m_pairTable);
+		}
+		m_pairTable = table;
+		m_pairTableCapacity = capacity;
+	}
+
+	for (dgUnsigned32 i = 0; i <= group; i ++) {
+		dgTreeNode* const node = Find ((group << 16) + i);
+		dgAssert (node);
+		m_pairTable[m_pairTableCount] = &node->GetInfo();
+		m_pairTableCount ++;
+	}
+}
+
+void dgBodyMaterialList::RemoveAllPairMaterials ()
+{
+	RemoveAll ();
+	m_pairTableCount = 0;
+}
+
 void dgWorld::ReleaseCollision(const dgCollision* const collision)
 {
+	if (collision->GetAllocator() != m_allocator) {
+		// shape shared from another world, it is not in this world cache
+		collision->Release();
+		return;
+	}
+
 	dgInt32 ref = collision->Release();
 	if (ref == 1) {
+		dgScopeSpinLock lock (&m_cacheLock);
 		dgBodyCollisionList::dgTreeNode* const node = dgBodyCollisionList::Find (collision->m_signature);
 		if (node) {
 			dgAssert (node->GetInfo() == collision);
@@ -411,6 +466,32 @@ void dgWorld::ReleaseCollision(const dgCollision* const collision)
 	}
 }
 
+const dgCollision* dgWorld::FindCachedCollision(dgUnsigned32 signature)
+{
+	dgScopeSpinLock lock (&m_cacheLock);
+	dgBodyCollisionList::dgTreeNode* const node = dgBodyCollisionList::Find (signature);
+	if (node) {
+		const dgCollision* const collision = node->GetInfo();
+		collision->AddRef();
+		return collision;
+	}
+	return NULL;
+}
+
+const dgCollision* dgWorld::AddCachedCollision(const dgCollision* const collision)
+{
+	// scene loaders decode shapes from several threads, when two threads decode the same shape the first one stays in the cache
+	bool wasInCache;
+	dgScopeSpinLock lock (&m_cacheLock);
+	dgBodyCollisionList::dgTreeNode* const node = dgBodyCollisionList::Insert (collision, collision->GetSignature(), wasInCache);
+	const dgCollision* const cached = node->GetInfo();
+	if (wasInCache) {
+		collision->Release();
+	}
+	cached->AddRef();
+	return cached;
+}
+
 // ********************************************************************************
 //
 // separate collision system 
@@ -2092,7 +2173,7 @@ dgInt32 dgWorld::CalculateConvexToConvexContacts(dgCollisionParamProxy& proxy) c
 	return count;
 }
 
-dgInt32 dgWorld::CalculateConvexToNonConvexContacts(dgCollisionParamProxy& proxy) const
+dgInt32 dgWorld::CalculateConvexToNonConvexContacts(dgCollisionParamProxy& proxy, const dgPolygonMeshDesc* const cluster) const
 {
 	dgInt32 count = 0;
 	dgContact* const contactJoint = proxy.m_contactJoint;
@@ -2141,8 +2222,14 @@ dgInt32 dgWorld::CalculateConvexToNonConvexContacts(dgCollisionParamProxy& proxy
 			}
 		}
 
-		dgCollisionMesh* const polysoup = (dgCollisionMesh *)data.m_polySoupInstance->GetChildShape();
-		polysoup->GetCollidingFaces(&data);
+		if (cluster) {
+			// the faces were already gathered for a group of shapes
+			dgAssert (!proxy.m_continueCollision);
+			data.SelectClusterFaces (*cluster);
+		} else {
+			dgCollisionMesh* const polysoup = (dgCollisionMesh *)data.m_polySoupInstance->GetChildShape();
+			polysoup->GetCollidingFaces(&data);
+		}
 
 		if (data.m_faceCount) {
 			proxy.m_polyMeshData = &data;
@@ -2239,6 +2326,14 @@ dgInt32 dgWorld::CalculatePolySoupToHullContactsDescrete (dgCollisionParamProxy&
 	dgContactPoint* const contactOut = proxy.m_contacts;
 	dgContact* const contactJoint = proxy.m_contactJoint;
 	dgInt32* const indexArray = (dgInt32*)data.m_faceVertexIndex;
+
+	// many of the faces returned by the mesh box query only touch the shape aabb,
+	// remove them with a separating axis test against the shape obb before running the contact solver on each one
+	dgVector obbSize;
+	dgVector obbOrigin;
+	proxy.m_instance0->CalcObb (obbOrigin, obbSize);
+	const dgMatrix meshToHullMatrix (polySoupScaledMatrix * proxy.m_instance0->m_globalMatrix.Inverse());
+	closestDist = data.CullFacesByObb (meshToHullMatrix, obbOrigin, obbSize, proxy.m_skinThickness + DG_PENETRATION_TOL * dgFloat32 (8.0f));
 	data.SortFaceArray();
 
 	for (dgInt32 i = data.m_faceCount - 1; (i >= 0) && (count < 32); i --) {
@@ -49,6 +49,8 @@
 #include "dgUniversalConstraint.h"
 #include "dgCorkscrewConstraint.h"
 #include "dgBroadPhaseAggregate.h"
+#include "dgBroadPhaseQueryCache.h"
+#include "dgWorldScheduler.h"
 #include "dgCollisionHeightField.h"
 #include "dgCollisionConvexPolygon.h"
 #include "dgCollisionDeformableMesh.h"
@@ -34,6 +34,20 @@
 
 #include <dg.h>
 
+#ifdef DG_USE_STATIC_SIMD_SOLVERS
+	// solver plugins compiled into the core library need the same access as the core solver
+	namespace dgStaticSse4 { class dgSolver; }
+	namespace dgStaticAvx { class dgSolver; }
+	namespace dgStaticAvx2 { class dgSolver; }
+	namespace dgStaticAvx512 { class dgSolver; }
+	#define DG_STATIC_SOLVER_FRIENDS	\
+		friend class dgStaticSse4::dgSolver; \
+		friend class dgStaticAvx::dgSolver; \
+		friend class dgStaticAvx2::dgSolver; \
+		friend class dgStaticAvx512::dgSolver;
+#else
+	#define DG_STATIC_SOLVER_FRIENDS
+#endif
 
 
 //#define DG_PROFILE_PHYSICS
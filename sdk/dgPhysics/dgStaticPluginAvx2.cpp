@@ -0,0 +1,85 @@
+/* Copyright (c) <2003-2019> <Julio Jerez, Newton Game Dynamics>
+* 
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* 
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "dgPhysicsStdafx.h"
+#include "dgWorldPlugins.h"
+
+#ifdef DG_USE_STATIC_SIMD_SOLVERS
+#include "dgPhysics.h"
+#include "dgWorldDynamicUpdate.h"
+#include "dgWorldDynamicsParallelSolver.h"
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// avx2 solver plugin compiled into the core library
+#define DG_STATIC_SOLVER_PLUGIN
+
+#if defined (__clang__)
+	#pragma clang attribute push (__attribute__((target("avx2,fma"))), apply_to = function)
+#elif defined (__GNUC__)
+	#pragma GCC push_options
+	#pragma GCC target("avx2,fma")
+#endif
+
+namespace dgStaticAvx2
+{
+	#include "../dgNewtonAvx2/dgNewtonPluginStdafx.h"
+	#include "../dgNewtonAvx2/dgSolver.cpp"
+	#include "../dgNewtonAvx2/dgWorldBase.cpp"
+
+	class dgStaticPlugin: public dgWorldBase
+	{
+		public:
+		DG_CLASS_ALLOCATOR(allocator)
+
+		dgStaticPlugin(dgWorld* const world, dgMemoryAllocator* const allocator)
+			:dgWorldBase(world, allocator)
+		{
+			m_score = 4;
+#ifdef _DEBUG
+			sprintf(m_hardwareDeviceName, "Newton avx2_d");
+#else
+			sprintf(m_hardwareDeviceName, "Newton avx2");
+#endif
+		}
+	};
+}
+
+#if defined (__clang__)
+	#pragma clang attribute pop
+#elif defined (__GNUC__)
+	#pragma GCC pop_options
+#endif
+
+dgWorldPlugin* dgCreateAvx2SolverPlugin(dgWorld* const world, dgMemoryAllocator* const allocator)
+{
+#ifdef _MSC_VER
+	// avx2 is bit 5 in reg ebx of leaf 7, fma is bit 12 in reg ecx of leaf 1
+	const bool supported = dgCpuSupportsSimd(7, 1, 5, 0x06) && dgCpuSupportsSimd(1, 2, 12, 0x06);
+#else
+	const bool supported = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+	return supported ? new (allocator) dgStaticAvx2::dgStaticPlugin(world, allocator) : NULL;
+}
+
+#endif
@@ -34,6 +34,7 @@
 #include "dgCollisionCapsule.h"
 #include "dgCollisionInstance.h"
 #include "dgCollisionCompound.h"
+#include "dgWorldScheduler.h"
 #include "dgWorldDynamicUpdate.h"
 #include "dgCollisionConvexHull.h"
 #include "dgBroadPhaseSegregated.h"
@@ -51,6 +52,102 @@
 #define DG_DEFAULT_SOLVER_ITERATION_COUNT	4
 #define DG_SYNC_THREAD	1
 #define DG_ASYNC_THREAD	2
+#define DG_WORLD_SNAPSHOT_MAGIC	0x50414e53
+
+DG_MSC_VECTOR_ALIGMENT
+class dgWorldSnapshotHeader
+{
+	public:
+	dgInt32 m_magic;
+	dgInt32 m_sizeInBytes;
+	dgInt32 m_bodyCount;
+	dgInt32 m_jointCount;
+	dgInt32 m_contactCount;
+	dgInt32 m_contactCountReset;
+	dgInt32 m_contactCapacity;
+	dgInt32 m_contactPointCount;
+	dgInt32 m_broadPhaseSizeInBytes;
+} DG_GCC_VECTOR_ALIGMENT;
+
+DG_MSC_VECTOR_ALIGMENT
+class dgWorldSnapshotBody
+{
+	public:
+	dgMatrix m_matrix;
+	dgMatrix m_invWorldInertiaMatrix;
+	dgQuaternion m_rotation;
+	dgVector m_veloc;
+	dgVector m_omega;
+	dgVector m_accel;
+	dgVector m_alpha;
+	dgVector m_globalCentreOfMass;
+	dgVector m_minAABB;
+	dgVector m_maxAABB;
+	dgVector m_nodeMinBox;
+	dgVector m_nodeMaxBox;
+	dgVector m_impulseForce;
+	dgVector m_impulseTorque;
+	dgVector m_gyroAlpha;
+	dgVector m_gyroTorque;
+	dgQuaternion m_gyroRotation;
+	dgVector m_externalForce;
+	dgVector m_externalTorque;
+	dgVector m_savedExternalForce;
+	dgVector m_savedExternalTorque;
+	dgVector m_cachedDampCoef;
+	dgFloat32 m_cachedTimeStep;
+	dgInt32 m_sleepingCounter;
+	dgInt32 m_uniqueID;
+	union 
+	{
+		dgUnsigned32 m_flags;
+		struct {
+			dgUnsigned32 m_freeze		: 1;
+			dgUnsigned32 m_resting		: 1;
+			dgUnsigned32 m_sleeping		: 1;
+			dgUnsigned32 m_equilibrium	: 1;
+		};
+	};
+} DG_GCC_VECTOR_ALIGMENT;
+
+DG_MSC_VECTOR_ALIGMENT
+class dgWorldSnapshotJoint
+{
+	public:
+	dgForceImpactPair m_jointForce[DG_BILATERAL_CONTRAINT_DOF];
+	dgInt32 m_body0;
+	dgInt32 m_body1;
+} DG_GCC_VECTOR_ALIGMENT;
+
+DG_MSC_VECTOR_ALIGMENT
+class dgWorldSnapshotContact
+{
+	public:
+	dgVector m_positAcc;
+	dgQuaternion m_rotationAcc;
+	dgVector m_separtingVector;
+	dgBody* m_body0;
+	dgBody* m_body1;
+	dgFloat32 m_closestDistance;
+	dgFloat32 m_separationDistance;
+	dgFloat32 m_timeOfImpact;
+	dgFloat32 m_impulseSpeed;
+	dgFloat32 m_contactPruningTolereance;
+	dgUnsigned32 m_broadphaseAge;
+	dgInt32 m_pointCount;
+	union 
+	{
+		dgUnsigned32 m_flags;
+		struct {
+			dgUnsigned32 m_maxDOF					: 6;
+			dgUnsigned32 m_isActive					: 1;
+			dgUnsigned32 m_isNewContact				: 1;
+			dgUnsigned32 m_enableCollision			: 1;
+			dgUnsigned32 m_skeletonIntraCollision	: 1;
+			dgUnsigned32 m_skeletonSelftCollision	: 1;
+		};
+	};
+} DG_GCC_VECTOR_ALIGMENT;
 
 /*
 static dgInt32 TestSort(const dgInt32* const  A, const dgInt32* const B, void* const)
@@ -219,6 +316,8 @@ dgWorld::dgWorld(dgMemoryAllocator* const allocator)
 	,dgDeadJoints(allocator)
 	,dgWorldPluginList(allocator)
 	,m_broadPhase(NULL)
+	,m_scheduler(NULL)
+	,m_userJobThreadPool(NULL)
 	,m_sentinelBody(NULL)
 	,m_pointCollision(NULL)
 	,m_userData(NULL)
@@ -233,6 +332,7 @@ dgWorld::dgWorld(dgMemoryAllocator* const allocator)
 	,m_solverJacobiansMemory (allocator, 64)
 	,m_solverRightHandSideMemory (allocator, 64)
 	,m_solverForceAccumulatorMemory (allocator, 64)
+	,m_solverCompactJacobiansMemory (allocator, 64)
 //	,m_concurrentUpdate(false)
 {
 	//TestAStart();
@@ -240,6 +340,7 @@ dgWorld::dgWorld(dgMemoryAllocator* const allocator)
 
 	dgMutexThread* const myThread = this;
 	SetParentThread (myThread);
+	m_threadPoolSemaphore.Release();
 
 	// avoid small memory fragmentations on initialization
 	m_bodiesMemory.Resize(1024);
@@ -267,12 +368,16 @@ dgWorld::dgWorld(dgMemoryAllocator* const allocator)
 	m_clusterLRU = 0;
 
 	m_useParallelSolver = 1;
+	m_compactJacobianRows = 0;
+	m_deterministicMode = 0;
 
 	m_solverIterations = DG_DEFAULT_SOLVER_ITERATION_COUNT;
 	m_dynamicsLru = 0;
 	m_numberOfSubsteps = 1;
 		
 	m_bodiesUniqueID = 0;
+	m_stateGeneration = 1;
+	m_sceneFileCompression = 0;
 	m_frictiomTheshold = dgFloat32 (0.25f);
 
 	m_userData = NULL;
@@ -327,11 +432,13 @@ dgWorld::dgWorld(dgMemoryAllocator* const allocator)
 	pointCollison->Release();
 
 	AddSentinelBody();
+	LoadStaticPlugins();
 }
 
 dgWorld::~dgWorld()
 {	
 	Sync();
+	SetScheduler(NULL);
 	dgAsyncThread::Terminate();
 	dgMutexThread::Terminate();
 
@@ -390,7 +497,57 @@ void dgWorld::DestroyAllBodies()
 
 void dgWorld::SetThreadsCount (dgInt32 count)
 {
-	dgThreadHive::SetThreadsCount(count);
+	// an attached world runs on the workers of its scheduler
+	if (!m_scheduler) {
+		dgThreadHive::SetThreadsCount(count);
+	}
+}
+
+dgWorldScheduler* dgWorld::GetScheduler() const
+{
+	return m_scheduler;
+}
+
+void dgWorld::SetScheduler (dgWorldScheduler* const scheduler)
+{
+	Sync();
+	if (m_scheduler) {
+		m_scheduler->RemoveWorld(this);
+	}
+	m_scheduler = scheduler;
+	if (m_scheduler) {
+		dgThreadHive::SetThreadsCount(0);
+		m_scheduler->AddWorld(this);
+	}
+}
+
+dgThreadHive* dgWorld::AcquireIdleThreadPool ()
+{
+	if (m_scheduler) {
+		// the steps of an attached world run inside the scheduler update, so an idle scheduler is also an idle world
+		if (m_scheduler->AcquireIdleWorkers()) {
+			SetSharedHive(m_scheduler);
+			return this;
+		}
+	} else if (m_threadPoolSemaphore.TryWait()) {
+		BeginSection();
+		return this;
+	}
+	return NULL;
+}
+
+void dgWorld::ReleaseIdleThreadPool (dgThreadHive* const threadPool)
+{
+	if (threadPool) {
+		dgAssert (threadPool == this);
+		if (m_scheduler) {
+			SetSharedHive(NULL);
+			m_scheduler->ReleaseIdleWorkers();
+		} else {
+			EndSection();
+			m_threadPoolSemaphore.Release();
+		}
+	}
 }
 
 dgUnsigned32 dgWorld::GetPerformanceCount ()
@@ -433,6 +590,26 @@ dgInt32 dgWorld::GetParallelSolverOnLargeIsland() const
 	return m_useParallelSolver ? 1 : 0;
 }
 
+void dgWorld::SetCompactJacobianRows(dgInt32 mode)
+{
+	m_compactJacobianRows = mode ? 1 : 0;
+}
+
+dgInt32 dgWorld::GetCompactJacobianRows() const
+{
+	return m_compactJacobianRows ? 1 : 0;
+}
+
+void dgWorld::SetDeterministicMode(dgInt32 mode)
+{
+	m_deterministicMode = mode ? 1 : 0;
+}
+
+dgInt32 dgWorld::GetDeterministicMode() const
+{
+	return m_deterministicMode ? 1 : 0;
+}
+
 
 void dgWorld::SetFrictionThreshold (dgFloat32 acceleration)
 {
@@ -442,9 +619,7 @@ void dgWorld::SetFrictionThreshold (dgFloat32 acceleration)
 
 void dgWorld::RemoveAllGroupID()
 {
-	while (dgBodyMaterialList::GetCount()) {
-		dgBodyMaterialList::Remove (dgBodyMaterialList::GetRoot());
-	}
+	dgBodyMaterialList::RemoveAllPairMaterials();
 	m_bodyGroupID = 0;
 	m_defualtBodyGroupID = CreateBodyGroupID();
 }
@@ -566,9 +741,22 @@ void dgWorld::DestroyConstraint(dgConstraint* const constraint)
 
 void dgWorld::ExecuteUserJob (dgWorkerThreadTaskCallback userJobKernel, void* const userJobKernelContext, const char* const functionName)
 {
+	// an attached world has no workers of its own, outside of a step the jobs go to the scheduler until they are synchronized
+	if (m_scheduler && !m_userJobThreadPool) {
+		m_userJobThreadPool = AcquireIdleThreadPool();
+	}
 	QueueJob (userJobKernel, this, userJobKernelContext, functionName);
 }
 
+void dgWorld::SyncUserJobs ()
+{
+	SynchronizationBarrier();
+	if (m_userJobThreadPool) {
+		ReleaseIdleThreadPool(m_userJobThreadPool);
+		m_userJobThreadPool = NULL;
+	}
+}
+
 void dgWorld::SetUserData (void* const userData)
 {
 	m_userData = userData;
@@ -956,9 +1144,15 @@ void dgWorld::RunStep ()
 {
 	D_TRACKTIME();
 	
+	// wait for work that borrowed the worker threads outside of the update
+	m_threadPoolSemaphore.Wait();
 	BeginSection();
 	dgUnsigned64 timeAcc = dgGetTimeInMicrosenconds();
 
+	dgContactList& contactList = *this;
+	contactList.m_triggerEventCount = 0;
+	contactList.m_contactEventCount = 0;
+
 	dgFloat32 step = m_savetimestep / m_numberOfSubsteps;
 	for (dgUnsigned32 i = 0; i < m_numberOfSubsteps; i ++) {
 		StepDynamics (step);
@@ -970,6 +1164,10 @@ void dgWorld::RunStep ()
 		bodyList.DestroyBodies (*this);
 	}
 
+	if (contactList.m_contactEventMask) {
+		CollectContactEvents (step);
+	}
+
 	const dgBodyMasterList* const masterList = this;
 	dgBodyMasterList::dgListNode* threadNode = masterList->GetFirst();
 	const dgInt32 threadsCount = GetThreadCount();
@@ -978,6 +1176,7 @@ void dgWorld::RunStep ()
 		threadNode = threadNode ? threadNode->GetNext() : NULL;
 	}
 	SynchronizationBarrier();
+	m_stateGeneration ++;
 
 	if (m_listeners.GetCount()) {
 		for (dgListenerList::dgListNode* node = m_listeners.GetFirst(); node; node = node->GetNext()) {
@@ -994,6 +1193,7 @@ void dgWorld::RunStep ()
 
 	m_lastExecutionTime = (dgGetTimeInMicrosenconds() - timeAcc) * dgFloat32 (1.0e-6f);
 	EndSection();
+	m_threadPoolSemaphore.Release();
 }
 
 void dgWorld::TickCallback(dgInt32 threadID)
@@ -1003,6 +1203,12 @@ void dgWorld::TickCallback(dgInt32 threadID)
 
 void dgWorld::Update (dgFloat32 timestep)
 {
+	if (m_scheduler) {
+		dgWorld* world = this;
+		m_scheduler->Update(&world, 1, timestep);
+		return;
+	}
+
 	m_savetimestep = timestep;
 	#ifdef DG_USE_THREAD_EMULATION
 		dgFloatExceptions exception;
@@ -1175,6 +1381,7 @@ void dgDeadBodies::DestroyBodies(dgWorld& world)
 //	dgScopeSpinLock lock(&m_lock);
 	if (GetCount()) {
 		world.m_broadPhase->DeleteDeadContact(0.0f);
+		world.RemoveDeadEvents();
 		Iterator iter(*this);
 		for (iter.Begin(); iter; iter++) {
 			dgTreeNode* const bodyNode = iter.GetNode();
@@ -1593,7 +1800,7 @@ void dgWorld::SerializeScene(void* const userData, OnBodySerialize bodyCallback,
 
 	dgSortIndirect(array, count, SerializeToFileSort);
 	SerializeBodyArray(userData, bodyCallback ? bodyCallback : OnBodySerializeToFile, array, count, serializeCallback, serializeHandle);
-	SerializeJointArray(count, OnSerializeToFile, serializeHandle);
+	SerializeJointArray(count, serializeCallback, serializeHandle);
 
 	for (dgBodyMasterList::dgListNode* node = me.GetFirst()->GetNext(); node; node = node->GetNext()) {
 		const dgBodyMasterListRow& graphNode = node->GetInfo();
@@ -1605,7 +1812,7 @@ void dgWorld::SerializeScene(void* const userData, OnBodySerialize bodyCallback,
 
 void dgWorld::DeserializeScene(void* const userData, OnBodyDeserialize bodyCallback, dgDeserialize deserializeCallback, void* const serializeHandle)
 {
-	dgTree<dgBody*, dgInt32> bodyMap(GetAllocator());
+	dgArray<dgBody*> bodyMap(GetAllocator());
 	DeserializeBodyArray(userData, bodyCallback ? bodyCallback : OnBodyDeserializeFromFile, bodyMap, deserializeCallback, serializeHandle);
 	DeserializeJointArray(bodyMap, deserializeCallback, serializeHandle);
 
@@ -1620,7 +1827,421 @@ void dgWorld::OnBodyDeserializeFromFile(dgBody& body, void* const userData, dgDe
 {
 }
 
-void dgWorld::DeserializeBodyArray (void* const userData, OnBodyDeserialize bodyCallback, dgTree<dgBody*, dgInt32>&bodyMap, dgDeserialize deserializeCallback, void* const serializeHandle)
+dgInt32 dgWorld::CalculateSnapshotSize() const
+{
+	const dgContactList& contactList = *this;
+	const dgBodyMasterList& masterList = *this;
+	const dgBilateralConstraintList& jointList = *this;
+
+	dgInt32 pointCount = 0;
+	for (dgInt32 i = 0; i < contactList.m_contactCount; i ++) {
+		pointCount += contactList[i]->GetCount();
+	}
+
+	dgInt32 sizeInBytes = sizeof (dgWorldSnapshotHeader);
+	sizeInBytes += (masterList.GetCount() - 1) * sizeof (dgWorldSnapshotBody);
+	sizeInBytes += jointList.GetCount() * sizeof (dgWorldSnapshotJoint);
+	sizeInBytes += contactList.m_contactCount * sizeof (dgWorldSnapshotContact);
+	sizeInBytes += pointCount * sizeof (dgContactMaterial);
+	sizeInBytes += m_broadPhase->GetStateSize();
+	return sizeInBytes;
+}
+
+dgInt32 dgWorld::SaveSnapshot(void* const buffer, dgInt32 bufferSizeInBytes) const
+{
+	dgAssert (!m_inUpdate);
+	const dgInt32 sizeInBytes = CalculateSnapshotSize();
+	if ((sizeInBytes > bufferSizeInBytes) || (((dgUnsigned64)buffer) & 15)) {
+		return 0;
+	}
+
+	const dgContactList& contactList = *this;
+	const dgBodyMasterList& masterList = *this;
+	const dgBilateralConstraintList& jointList = *this;
+
+	dgWorldSnapshotHeader* const header = (dgWorldSnapshotHeader*)buffer;
+	header->m_magic = DG_WORLD_SNAPSHOT_MAGIC;
+	header->m_sizeInBytes = sizeInBytes;
+	header->m_bodyCount = masterList.GetCount() - 1;
+	header->m_jointCount = jointList.GetCount();
+	header->m_contactCount = contactList.m_contactCount;
+	header->m_contactCountReset = contactList.m_contactCountReset;
+	header->m_contactCapacity = contactList.GetElementsCapacity();
+	header->m_contactPointCount = 0;
+	header->m_broadPhaseSizeInBytes = m_broadPhase->GetStateSize();
+
+	dgWorldSnapshotBody* const bodyArray = (dgWorldSnapshotBody*)&header[1];
+	dgWorldSnapshotJoint* const jointArray = (dgWorldSnapshotJoint*)&bodyArray[header->m_bodyCount];
+	dgWorldSnapshotContact* const contactArray = (dgWorldSnapshotContact*)&jointArray[header->m_jointCount];
+	dgContactMaterial* pointArray = (dgContactMaterial*)&contactArray[header->m_contactCount];
+
+	dgInt32 index = 0;
+	for (dgBodyMasterList::dgListNode* node = masterList.GetFirst()->GetNext(); node; node = node->GetNext()) {
+		const dgBody* const body = node->GetInfo().GetBody();
+		dgWorldSnapshotBody& state = bodyArray[index];
+		index ++;
+
+		state.m_matrix = body->m_matrix;
+		state.m_invWorldInertiaMatrix = body->m_invWorldInertiaMatrix;
+		state.m_rotation = body->m_rotation;
+		state.m_veloc = body->m_veloc;
+		state.m_omega = body->m_omega;
+		state.m_accel = body->m_accel;
+		state.m_alpha = body->m_alpha;
+		state.m_globalCentreOfMass = body->m_globalCentreOfMass;
+		state.m_minAABB = body->m_minAABB;
+		state.m_maxAABB = body->m_maxAABB;
+		state.m_impulseForce = body->m_impulseForce;
+		state.m_impulseTorque = body->m_impulseTorque;
+		state.m_gyroAlpha = body->m_gyroAlpha;
+		state.m_gyroTorque = body->m_gyroTorque;
+		state.m_gyroRotation = body->m_gyroRotation;
+
+		const dgBroadPhaseBodyNode* const bodyNode = body->m_broadPhaseNode;
+		state.m_nodeMinBox = bodyNode ? bodyNode->m_minBox : dgVector::m_zero;
+		state.m_nodeMaxBox = bodyNode ? bodyNode->m_maxBox : dgVector::m_zero;
+
+		if (body->IsRTTIType(dgBody::m_dynamicBodyRTTI)) {
+			const dgDynamicBody* const dynamicBody = (dgDynamicBody*)body;
+			state.m_externalForce = dynamicBody->m_externalForce;
+			state.m_externalTorque = dynamicBody->m_externalTorque;
+			state.m_savedExternalForce = dynamicBody->m_savedExternalForce;
+			state.m_savedExternalTorque = dynamicBody->m_savedExternalTorque;
+			state.m_cachedDampCoef = dynamicBody->m_cachedDampCoef;
+			state.m_cachedTimeStep = dynamicBody->m_cachedTimeStep;
+			state.m_sleepingCounter = dynamicBody->m_sleepingCounter;
+		} else {
+			state.m_externalForce = dgVector::m_zero;
+			state.m_externalTorque = dgVector::m_zero;
+			state.m_savedExternalForce = dgVector::m_zero;
+			state.m_savedExternalTorque = dgVector::m_zero;
+			state.m_cachedDampCoef = dgVector::m_zero;
+			state.m_cachedTimeStep = dgFloat32 (0.0f);
+			state.m_sleepingCounter = 0;
+		}
+
+		state.m_uniqueID = body->m_uniqueID;
+		state.m_flags = 0;
+		state.m_freeze = body->m_freeze;
+		state.m_resting = body->m_resting;
+		state.m_sleeping = body->m_sleeping;
+		state.m_equilibrium = body->m_equilibrium;
+	}
+
+	index = 0;
+	for (dgBilateralConstraintList::dgListNode* node = jointList.GetFirst(); node; node = node->GetNext()) {
+		const dgBilateralConstraint* const joint = node->GetInfo();
+		dgWorldSnapshotJoint& state = jointArray[index];
+		index ++;
+
+		memcpy (state.m_jointForce, joint->m_jointForce, sizeof (state.m_jointForce));
+		state.m_body0 = joint->m_body0 ? joint->m_body0->m_uniqueID : -1;
+		state.m_body1 = joint->m_body1 ? joint->m_body1->m_uniqueID : -1;
+	}
+
+	// contacts are saved in the order of the contact array, that is the order the solver sees them
+	const dgUnsigned32 lru = m_broadPhase->m_lru;
+	for (dgInt32 i = 0; i < contactList.m_contactCount; i ++) {
+		const dgContact* const contact = contactList[i];
+		dgWorldSnapshotContact& state = contactArray[i];
+
+		state.m_positAcc = contact->m_positAcc;
+		state.m_rotationAcc = contact->m_rotationAcc;
+		state.m_separtingVector = contact->m_separtingVector;
+		state.m_body0 = contact->m_body0;
+		state.m_body1 = contact->m_body1;
+		state.m_closestDistance = contact->m_closestDistance;
+		state.m_separationDistance = contact->m_separationDistance;
+		state.m_timeOfImpact = contact->m_timeOfImpact;
+		state.m_impulseSpeed = contact->m_impulseSpeed;
+		state.m_contactPruningTolereance = contact->m_contactPruningTolereance;
+		state.m_broadphaseAge = lru - contact->m_broadphaseLru;
+		state.m_pointCount = contact->GetCount();
+		state.m_flags = 0;
+		state.m_maxDOF = contact->m_maxDOF;
+		state.m_isActive = contact->m_isActive;
+		state.m_isNewContact = contact->m_isNewContact;
+		state.m_enableCollision = contact->m_enableCollision;
+		state.m_skeletonIntraCollision = contact->m_skeletonIntraCollision;
+		state.m_skeletonSelftCollision = contact->m_skeletonSelftCollision;
+
+		for (dgContact::dgListNode* node = contact->GetFirst(); node; node = node->GetNext()) {
+			*pointArray = node->GetInfo();
+			pointArray ++;
+		}
+		header->m_contactPointCount += state.m_pointCount;
+	}
+
+	// the shape of the broadphase tree decides when leaf boxes are refit, so it is part of the state
+	if (header->m_broadPhaseSizeInBytes) {
+		m_broadPhase->SaveState(pointArray);
+	}
+	dgAssert (((dgUnsigned8*)pointArray + header->m_broadPhaseSizeInBytes) == ((dgUnsigned8*)buffer + sizeInBytes));
+	return sizeInBytes;
+}
+
+bool dgWorld::RestoreSnapshot(const void* const buffer, dgInt32 bufferSizeInBytes)
+{
+	dgAssert (!m_inUpdate);
+	const dgWorldSnapshotHeader* const header = (const dgWorldSnapshotHeader*)buffer;
+	if ((((dgUnsigned64)buffer) & 15) || (bufferSizeInBytes < dgInt32 (sizeof (dgWorldSnapshotHeader)))) {
+		return false;
+	}
+	if ((header->m_magic != DG_WORLD_SNAPSHOT_MAGIC) || (header->m_sizeInBytes > bufferSizeInBytes)) {
+		return false;
+	}
+
+	dgContactList& contactList = *this;
+	const dgBodyMasterList& masterList = *this;
+	const dgBilateralConstraintList& jointList = *this;
+	if ((header->m_bodyCount != (masterList.GetCount() - 1)) || (header->m_jointCount != jointList.GetCount())) {
+		return false;
+	}
+	if ((header->m_contactCount < 0) || (header->m_contactPointCount < 0) || (header->m_broadPhaseSizeInBytes < 0)) {
+		return false;
+	}
+	if ((header->m_contactCapacity < header->m_contactCount) || (header->m_contactCountReset < header->m_contactCount)) {
+		return false;
+	}
+
+	// the arrays implied by the header must fit in the buffer, the counts are not trusted so the size is added in 64 bits
+	dgInt64 sizeInBytes = sizeof (dgWorldSnapshotHeader);
+	sizeInBytes += dgInt64 (header->m_bodyCount) * sizeof (dgWorldSnapshotBody);
+	sizeInBytes += dgInt64 (header->m_jointCount) * sizeof (dgWorldSnapshotJoint);
+	sizeInBytes += dgInt64 (header->m_contactCount) * sizeof (dgWorldSnapshotContact);
+	sizeInBytes += dgInt64 (header->m_contactPointCount) * sizeof (dgContactMaterial);
+	sizeInBytes += header->m_broadPhaseSizeInBytes;
+	if (sizeInBytes > bufferSizeInBytes) {
+		return false;
+	}
+
+	const dgWorldSnapshotBody* const bodyArray = (dgWorldSnapshotBody*)&header[1];
+	const dgWorldSnapshotJoint* const jointArray = (dgWorldSnapshotJoint*)&bodyArray[header->m_bodyCount];
+	const dgWorldSnapshotContact* const contactArray = (dgWorldSnapshotContact*)&jointArray[header->m_jointCount];
+	const dgContactMaterial* pointArray = (dgContactMaterial*)&contactArray[header->m_contactCount];
+
+	// the snapshot can only be applied to the same bodies and joints it was taken from, 
+	// that also guarantees the body pointers saved with the contacts are still alive
+	dgInt32 index = 0;
+	for (dgBodyMasterList::dgListNode* node = masterList.GetFirst()->GetNext(); node; node = node->GetNext()) {
+		if (node->GetInfo().GetBody()->m_uniqueID != bodyArray[index].m_uniqueID) {
+			return false;
+		}
+		index ++;
+	}
+	index = 0;
+	for (dgBilateralConstraintList::dgListNode* node = jointList.GetFirst(); node; node = node->GetNext()) {
+		const dgBilateralConstraint* const joint = node->GetInfo();
+		const dgInt32 id0 = joint->m_body0 ? joint->m_body0->m_uniqueID : -1;
+		const dgInt32 id1 = joint->m_body1 ? joint->m_body1->m_uniqueID : -1;
+		if ((id0 != jointArray[index].m_body0) || (id1 != jointArray[index].m_body1)) {
+			return false;
+		}
+		index ++;
+	}
+
+	// the contacts read their points one after the other, their counts must add up to the point array in the header
+	dgInt64 pointCount = 0;
+	for (dgInt32 i = 0; i < header->m_contactCount; i ++) {
+		if (contactArray[i].m_pointCount < 0) {
+			return false;
+		}
+		pointCount += contactArray[i].m_pointCount;
+	}
+	if (pointCount != header->m_contactPointCount) {
+		return false;
+	}
+
+	const void* const broadPhaseState = &pointArray[header->m_contactPointCount];
+	if (header->m_broadPhaseSizeInBytes && ((header->m_broadPhaseSizeInBytes != m_broadPhase->GetStateSize()) || !m_broadPhase->CheckState(broadPhaseState))) {
+		return false;
+	}
+
+	index = 0;
+	for (dgBodyMasterList::dgListNode* node = masterList.GetFirst()->GetNext(); node; node = node->GetNext()) {
+		dgBody* const body = node->GetInfo().GetBody();
+		const dgWorldSnapshotBody& state = bodyArray[index];
+		index ++;
+
+		body->m_matrix = state.m_matrix;
+		body->m_invWorldInertiaMatrix = state.m_invWorldInertiaMatrix;
+		body->m_rotation = state.m_rotation;
+		body->m_veloc = state.m_veloc;
+		body->m_omega = state.m_omega;
+		body->m_accel = state.m_accel;
+		body->m_alpha = state.m_alpha;
+		body->m_globalCentreOfMass = state.m_globalCentreOfMass;
+		body->m_minAABB = state.m_minAABB;
+		body->m_maxAABB = state.m_maxAABB;
+		body->m_impulseForce = state.m_impulseForce;
+		body->m_impulseTorque = state.m_impulseTorque;
+		body->m_gyroAlpha = state.m_gyroAlpha;
+		body->m_gyroTorque = state.m_gyroTorque;
+		body->m_gyroRotation = state.m_gyroRotation;
+
+		if (body->IsRTTIType(dgBody::m_dynamicBodyRTTI)) {
+			dgDynamicBody* const dynamicBody = (dgDynamicBody*)body;
+			dynamicBody->m_externalForce = state.m_externalForce;
+			dynamicBody->m_externalTorque = state.m_externalTorque;
+			dynamicBody->m_savedExternalForce = state.m_savedExternalForce;
+			dynamicBody->m_savedExternalTorque = state.m_savedExternalTorque;
+			dynamicBody->m_cachedDampCoef = state.m_cachedDampCoef;
+			dynamicBody->m_cachedTimeStep = state.m_cachedTimeStep;
+			dynamicBody->m_sleepingCounter = state.m_sleepingCounter;
+		}
+
+		body->m_freeze = state.m_freeze;
+		body->m_resting = state.m_resting;
+		body->m_sleeping = state.m_sleeping;
+		body->m_equilibrium = state.m_equilibrium;
+		body->m_transformIsDirty = true;
+		body->m_stateGeneration = m_stateGeneration;
+
+		body->m_collision->SetGlobalMatrix (body->m_collision->GetLocalMatrix() * body->m_matrix);
+		m_broadPhase->SetBodyNodeBox (body, state.m_nodeMinBox, state.m_nodeMaxBox);
+	}
+	if (header->m_broadPhaseSizeInBytes) {
+		m_broadPhase->RestoreState(broadPhaseState);
+	}
+
+	index = 0;
+	for (dgBilateralConstraintList::dgListNode* node = jointList.GetFirst(); node; node = node->GetNext()) {
+		dgBilateralConstraint* const joint = node->GetInfo();
+		memcpy (joint->m_jointForce, jointArray[index].m_jointForce, sizeof (joint->m_jointForce));
+		index ++;
+	}
+
+	// the saved contacts are collected past the end of the live ones, contacts that are
+	// still alive are reused, the others are created, and what is left over is deleted 
+	const dgInt32 liveCount = contactList.m_contactCount;
+	const dgInt32 contactCount = header->m_contactCount;
+	contactList.ResizeIfNecessary (liveCount + contactCount);
+	dgContact** const contacts = &contactList[0];
+	for (dgInt32 i = 0; i < liveCount; i ++) {
+		contacts[i]->m_killContact = 1;
+	}
+
+	const dgUnsigned32 lru = m_broadPhase->m_lru;
+	dgBroadPhase::dgContactCache& contactCache = m_broadPhase->m_contactCache;
+	for (dgInt32 i = 0; i < contactCount; i ++) {
+		const dgWorldSnapshotContact& state = contactArray[i];
+		dgBody* const body0 = state.m_body0;
+		dgBody* const body1 = state.m_body1;
+
+		dgContact* contact = contactCache.FindContactJoint (body0, body1);
+		if (!contact) {
+			const dgContactMaterial* const material = GetMaterial (dgUnsigned32 (body0->m_bodyGroupId), dgUnsigned32 (body1->m_bodyGroupId));
+			dgAssert (material);
+			contact = new (m_allocator) dgContact (this, material, body0, body1);
+			contactCache.AddContactJoint (contact);
+			AttachContact (contact);
+		}
+		dgAssert (contact->m_body0 == body0);
+		dgAssert (contact->m_body1 == body1);
+
+		contact->m_positAcc = state.m_positAcc;
+		contact->m_rotationAcc = state.m_rotationAcc;
+		contact->m_separtingVector = state.m_separtingVector;
+		contact->m_closestDistance = state.m_closestDistance;
+		contact->m_separationDistance = state.m_separationDistance;
+		contact->m_timeOfImpact = state.m_timeOfImpact;
+		contact->m_impulseSpeed = state.m_impulseSpeed;
+		contact->m_contactPruningTolereance = state.m_contactPruningTolereance;
+		contact->m_broadphaseLru = lru - state.m_broadphaseAge;
+		contact->m_maxDOF = state.m_maxDOF;
+		contact->m_isActive = state.m_isActive;
+		contact->m_isNewContact = state.m_isNewContact;
+		contact->m_enableCollision = state.m_enableCollision;
+		contact->m_skeletonIntraCollision = state.m_skeletonIntraCollision;
+		contact->m_skeletonSelftCollision = state.m_skeletonSelftCollision;
+		contact->m_killContact = 0;
+
+		dgContact::dgListNode* pointNode = contact->GetFirst();
+		for (dgInt32 j = 0; j < state.m_pointCount; j ++) {
+			if (!pointNode) {
+				pointNode = contact->Append();
+			}
+			pointNode->GetInfo() = pointArray[j];
+			pointNode = pointNode->GetNext();
+		}
+		while (pointNode) {
+			dgContact::dgListNode* const nextNode = pointNode->GetNext();
+			contact->Remove (pointNode);
+			pointNode = nextNode;
+		}
+		pointArray += state.m_pointCount;
+		contacts[liveCount + i] = contact;
+	}
+
+	for (dgInt32 i = 0; i < liveCount; i ++) {
+		dgContact* const contact = contacts[i];
+		if (contact->m_killContact) {
+			contactCache.RemoveContactJoint (contact);
+			RemoveContact (contact);
+			delete contact;
+		}
+	}
+	memmove (contacts, &contacts[liveCount], contactCount * sizeof (dgContact*));
+	contactList.m_contactCount = contactCount;
+
+	// pairs that do not fit the contact array are dropped until the next update grows it, 
+	// so the capacity and the pending growth are part of the state
+	contactList.m_contactCountReset = header->m_contactCountReset;
+	if (contactList.GetElementsCapacity() != header->m_contactCapacity) {
+		contactList.Resize (header->m_contactCapacity);
+	}
+
+	// trigger and contact events describe the update that made them, not the restored state
+	contactList.m_triggerEventCount = 0;
+	contactList.m_contactEventCount = 0;
+	return true;
+}
+
+dgBody* dgWorld::CreateDeserializedBody (dgInt32 bodyType, const dgTree<const dgCollision*, dgInt32>& shapeMap, dgDeserialize deserializeCallback, void* const serializeHandle, dgInt32 revision)
+{
+	dgBody* body = NULL;
+	switch (bodyType) 
+	{
+		case dgBody::m_dynamicBody:
+		{
+			body = new (m_allocator)dgDynamicBody(this, &shapeMap, deserializeCallback, serializeHandle, revision);
+			break;
+		}
+		case dgBody::m_kinematicBody:
+		{
+			body = new (m_allocator)dgKinematicBody(this, &shapeMap, deserializeCallback, serializeHandle, revision);
+			break;
+		}
+
+		case dgBody::m_dynamicBodyAsymatric:
+		{
+			body = new (m_allocator)dgDynamicBodyAsymetric(this, &shapeMap, deserializeCallback, serializeHandle, revision);
+			break;
+		}
+	}
+	dgAssert(body);
+	return body;
+}
+
+void dgWorld::InsertDeserializedBody (dgBody* const body)
+{
+	m_bodiesUniqueID++;
+	body->m_freeze = false;
+	body->m_sleeping = false;
+	body->m_equilibrium = false;
+	body->m_spawnnedFromCallback = false;
+	body->m_uniqueID = dgInt32(m_bodiesUniqueID);
+
+	dgBodyMasterList::AddBody(body);
+	body->SetMatrix(body->GetMatrix());
+	m_broadPhase->Add(body);
+	if (body->IsRTTIType(dgBody::m_dynamicBodyRTTI)) {
+		dgDynamicBody* const dynBody = (dgDynamicBody*)body;
+		dynBody->SetMassMatrix(dynBody->m_mass.m_w, dynBody->CalculateLocalInertiaMatrix());
+	}
+}
+
+void dgWorld::DeserializeBodyArray (void* const userData, OnBodyDeserialize bodyCallback, dgArray<dgBody*>& bodyMap, dgDeserialize deserializeCallback, void* const serializeHandle)
 {
 	dgInt32 revision = dgDeserializeMarker(deserializeCallback, serializeHandle);
 
@@ -1645,49 +2266,13 @@ void dgWorld::DeserializeBodyArray (void* const userData, OnBodyDeserialize body
 	for (dgInt32 i = 0; i < bodyCount; i++) {
 		dgInt32 bodyType;
 		deserializeCallback(serializeHandle, &bodyType, sizeof (bodyType));
-		dgBody* body = NULL;
-
-		switch (bodyType) 
-		{
-			case dgBody::m_dynamicBody:
-			{
-				body = new (m_allocator)dgDynamicBody(this, &shapeMap, deserializeCallback, serializeHandle, revision);
-				break;
-			}
-			case dgBody::m_kinematicBody:
-			{
-				body = new (m_allocator)dgKinematicBody(this, &shapeMap, deserializeCallback, serializeHandle, revision);
-				break;
-			}
-
-			case dgBody::m_dynamicBodyAsymatric:
-			{
-				body = new (m_allocator)dgDynamicBodyAsymetric(this, &shapeMap, deserializeCallback, serializeHandle, revision);
-				break;
-			}
-
-		}
-
-		dgAssert(body);
-		m_bodiesUniqueID++;
-		body->m_freeze = false;
-		body->m_sleeping = false;
-		body->m_equilibrium = false;
-		body->m_spawnnedFromCallback = false;
-		body->m_uniqueID = dgInt32(m_bodiesUniqueID);
-
-		dgBodyMasterList::AddBody(body);
-		body->SetMatrix(body->GetMatrix());
-		m_broadPhase->Add(body);
-		if (body->IsRTTIType(dgBody::m_dynamicBodyRTTI)) {
-			dgDynamicBody* const dynBody = (dgDynamicBody*)body;
-			dynBody->SetMassMatrix(dynBody->m_mass.m_w, dynBody->CalculateLocalInertiaMatrix());
-		}
+		dgBody* const body = CreateDeserializedBody(bodyType, shapeMap, deserializeCallback, serializeHandle, revision);
+		InsertDeserializedBody(body);
 
 		// load user related data 
 		bodyCallback(*body, userData, deserializeCallback, serializeHandle);
 
-		bodyMap.Insert(body, body->m_serializedEnum);
+		bodyMap[body->m_serializedEnum] = body;
 
 		// sync to next body
 		dgDeserializeMarker(deserializeCallback, serializeHandle);
@@ -1700,7 +2285,7 @@ void dgWorld::DeserializeBodyArray (void* const userData, OnBodyDeserialize body
 	}
 }
 
-void dgWorld::DeserializeJointArray (const dgTree<dgBody*, dgInt32>&bodyMap, dgDeserialize serializeCallback, void* const userData)
+void dgWorld::DeserializeJointArray (const dgArray<dgBody*>& bodyMap, dgDeserialize serializeCallback, void* const userData)
 {
 	dgInt32 count = 0;
 
@@ -1715,8 +2300,8 @@ void dgWorld::DeserializeJointArray (const dgTree<dgBody*, dgInt32>&bodyMap, dgD
 			serializeCallback(userData, &bodyIndex0, sizeof (bodyIndex0));
 			serializeCallback(userData, &bodyIndex1, sizeof (bodyIndex1));
 
-			dgBody* const body0 = (bodyIndex0 != -1) ? bodyMap.Find (bodyIndex0)->GetInfo() : NULL;
-			dgBody* const body1 = (bodyIndex1 != -1) ? bodyMap.Find (bodyIndex1)->GetInfo() : NULL;
+			dgBody* const body0 = (bodyIndex0 != -1) ? bodyMap[bodyIndex0] : NULL;
+			dgBody* const body1 = (bodyIndex1 != -1) ? bodyMap[bodyIndex1] : NULL;
 			m_onDeserializeJointCallback (body0, body1, serializeCallback, userData);
 		}
 		dgDeserializeMarker(serializeCallback, userData);
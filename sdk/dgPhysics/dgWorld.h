@@ -28,6 +28,7 @@
 #include "dgBroadPhase.h"
 #include "dgWorldPlugins.h"
 #include "dgCollisionScene.h"
+#include "dgCollisionHeightField.h"
 #include "dgBodyMasterList.h"
 #include "dgWorldDynamicUpdate.h"
 #include "dgBilateralConstraint.h"
@@ -50,6 +51,7 @@ class dgHingeConstraint;
 class dgUserMeshCreation;
 class dgSlidingConstraint;
 class dgCollisionInstance;
+class dgWorldScheduler;
 class dgSkeletonContainer;
 class dgUpVectorConstraint;
 class dgUniversalConstraint;
@@ -62,8 +64,11 @@ class dgBodyCollisionList: public dgTree<const dgCollision*, dgUnsigned32>
 	public:
 	dgBodyCollisionList (dgMemoryAllocator* const allocator)
 		:dgTree<const dgCollision*, dgUnsigned32>(allocator)
+		,m_cacheLock(0)
 	{
 	}
+
+	dgInt32 m_cacheLock;
 };
 
 class dgBodyMaterialList: public dgTree<dgContactMaterial, dgUnsigned32>
@@ -71,8 +76,36 @@ class dgBodyMaterialList: public dgTree<dgContactMaterial, dgUnsigned32>
 	public:
 	dgBodyMaterialList (dgMemoryAllocator* const allocator)
 		:dgTree<dgContactMaterial, dgUnsigned32>(allocator)
+		,m_pairTable(NULL)
+		,m_pairTableCount(0)
+		,m_pairTableCapacity(0)
 	{
 	}
+
+	~dgBodyMaterialList ()
+	{
+		if (m_pairTable) {
+			GetAllocator()->Free (m_pairTable);
+		}
+	}
+
+	DG_INLINE dgContactMaterial* GetPairMaterial (dgUnsigned32 group0, dgUnsigned32 group1) const
+	{
+		if (group0 > group1) {
+			dgSwap (group0, group1);
+		}
+		// the pairs of group1 with all groups up to group1 are a row of a lower triangular table 
+		const dgUnsigned32 index = ((group1 * (group1 + 1)) >> 1) + group0;
+		dgAssert (index < dgUnsigned32 (m_pairTableCount));
+		return m_pairTable[index];
+	}
+
+	void AddPairMaterialRow (dgUnsigned32 group);
+	void RemoveAllPairMaterials ();
+
+	dgContactMaterial** m_pairTable;
+	dgInt32 m_pairTableCount;
+	dgInt32 m_pairTableCapacity;
 };
 
 class dgSkeletonList: public dgList<dgSkeletonContainer*>
@@ -91,6 +124,7 @@ class dgSkeletonList: public dgList<dgSkeletonContainer*>
 
 class dgWorld;
 class dgCollisionInstance;
+class dgPolygonMeshDesc;
 class dgCollisionParamProxy;
 
 class dgSolverProgressiveSleepEntry
@@ -169,6 +203,7 @@ class dgWorld
 
 	typedef void (dgApi *OnJointSerializationCallback) (const dgUserConstraint* const joint, dgSerialize funt, void* const serilalizeObject);
 	typedef void (dgApi *OnJointDeserializationCallback) (const dgBody* const body0, const dgBody* const body1, dgDeserialize funt, void* const serilalizeObject);
+	typedef void (dgApi *OnBodyStateDecode) (void* const userData, dgInt32 bodyID, const dgFloat32* const matrix, const dgFloat32* const veloc, const dgFloat32* const omega);
 
 	enum dgBroadPhaseType
 	{
@@ -239,6 +274,12 @@ class dgWorld
 	void EnableParallelSolverOnLargeIsland(dgInt32 mode);
 	dgInt32 GetParallelSolverOnLargeIsland() const;
 
+	void SetCompactJacobianRows(dgInt32 mode);
+	dgInt32 GetCompactJacobianRows() const;
+
+	void SetDeterministicMode(dgInt32 mode);
+	dgInt32 GetDeterministicMode() const;
+
 	void FlushCache();
 
 	virtual dgUnsigned64 GetTimeInMicrosenconds() const;
@@ -269,6 +310,10 @@ class dgWorld
 						  const dgCollisionInstance* const collisionB, const dgMatrix& matrixB, 
 						  dgTriplex& contactA, dgTriplex& contactB, dgTriplex& normalAB, dgInt32 threadIndex);
 
+	void CollideBatch (const dgShapeQuery* const queries, dgInt32 count, OnRayPrecastAction prefilter, dgConvexCastReturnInfo* const info, dgInt32 maxContacts, dgInt32* const contactCounts, dgInt32 threadIndex);
+	void ConvexCastBatch (const dgShapeQuery* const queries, dgInt32 count, OnRayPrecastAction prefilter, dgConvexCastReturnInfo* const info, dgInt32 maxContacts, dgInt32* const contactCounts, dgFloat32* const params, dgInt32 threadIndex);
+	void ClosestPointBatch (const dgShapeQuery* const queriesA, const dgShapeQuery* const queriesB, dgInt32 count, dgTriplex* const contactsA, dgTriplex* const contactsB, dgTriplex* const normalsAB, dgInt32* const results, dgInt32 threadIndex);
+
 	void SetFrictionThreshold (dgFloat32 acceletion);
 
 	void ListenersDebug(void* const debugContext);
@@ -328,8 +373,10 @@ class dgWorld
 	dgCollisionInstance* CreateMassSpringDamperSystem (dgInt32 shapeID, dgInt32 pointCount, const dgFloat32* const points, dgInt32 srideInBytes, const dgFloat32* const pointsMass, dgInt32 linksCount, const dgInt32* const links, const dgFloat32* const linksSpring, const dgFloat32* const LinksDamper);
 
 	dgCollisionInstance* CreateBVH ();	
+	dgCollisionInstance* CreateSharedInstance (const dgCollisionInstance* const sharedInstance);
 	dgCollisionInstance* CreateStaticUserMesh (const dgVector& boxP0, const dgVector& boxP1, const dgUserMeshCreation& data);
 	dgCollisionInstance* CreateHeightField (dgInt32 width, dgInt32 height, dgInt32 contructionMode, dgInt32 elevationDataType, const void* const elevationMap, const dgInt8* const atributeMap, dgFloat32 verticalScale, dgFloat32 horizontalScale_x, dgFloat32 horizontalScale_z);
+	dgCollisionInstance* CreateTiledHeightField (dgInt32 width, dgInt32 height, dgInt32 tileSize, dgInt32 maxResidentTiles, dgInt32 contructionMode, dgInt32 elevationDataType, dgFloat32 minElevation, dgFloat32 maxElevation, dgFloat32 verticalScale, dgFloat32 horizontalScale_x, dgFloat32 horizontalScale_z, dgCollisionHeightFieldTilePageInCallback pageInCallback, void* const pageInUserData);
 	dgCollisionInstance* CreateScene ();	
 
 	dgBroadPhaseAggregate* CreateAggreGate() const; 
@@ -350,15 +397,40 @@ class dgWorld
 	void SerializeScene(void* const userData, OnBodySerialize bodyCallback, dgSerialize serializeCallback, void* const serializeHandle) const;
 	void DeserializeScene(void* const userData, OnBodyDeserialize bodyCallback, dgDeserialize deserializeCallback, void* const serializeHandle);
 
+	dgInt32 CalculateSnapshotSize() const;
+	dgInt32 SaveSnapshot(void* const buffer, dgInt32 bufferSizeInBytes) const;
+	bool RestoreSnapshot(const void* const buffer, dgInt32 bufferSizeInBytes);
+
+	const dgTriggerEvent* GetTriggerEvents(dgInt32& count) const;
+	const dgContactEvent* GetContactEvents(dgInt32& count) const;
+	dgInt32 GetContactEventMask() const;
+	void SetContactEventMask(dgInt32 mask);
+
+	dgUnsigned32 GetStateGeneration() const;
+	dgBody* GetFirstChangedBody(dgUnsigned32 generation) const;
+	dgBody* GetNextChangedBody(const dgBody* const body, dgUnsigned32 generation) const;
+	dgInt32 EncodeBodyStates(dgUnsigned32 generation, dgFloat32 positionStep, dgFloat32 velocityStep, const void* const baseline, dgInt32 baselineSizeInBytes, void* const buffer, dgInt32 bufferSizeInBytes) const;
+	static dgInt32 DecodeBodyStates(const void* const baseline, dgInt32 baselineSizeInBytes, const void* const packet, dgInt32 packetSizeInBytes, OnBodyStateDecode callback, void* const userData);
+	static dgInt32 MergeBodyStates(const void* const baseline, dgInt32 baselineSizeInBytes, const void* const packet, dgInt32 packetSizeInBytes, void* const buffer, dgInt32 bufferSizeInBytes);
+
 	void SerializeBodyArray (void* const userData, OnBodySerialize bodyCallback, dgBody** const array, dgInt32 count, dgSerialize serializeCallback, void* const serializeHandle) const;
-	void DeserializeBodyArray (void* const userData, OnBodyDeserialize bodyCallback, dgTree<dgBody*, dgInt32>&bodyMap, dgDeserialize deserializeCallback, void* const serializeHandle);
+	void DeserializeBodyArray (void* const userData, OnBodyDeserialize bodyCallback, dgArray<dgBody*>& bodyMap, dgDeserialize deserializeCallback, void* const serializeHandle);
+	dgBody* CreateDeserializedBody (dgInt32 bodyType, const dgTree<const dgCollision*, dgInt32>& shapeMap, dgDeserialize deserializeCallback, void* const serializeHandle, dgInt32 revision);
+	void InsertDeserializedBody (dgBody* const body);
 
 	void SerializeJointArray (dgInt32 count, dgSerialize serializeCallback, void* const serializeHandle) const;
-	void DeserializeJointArray (const dgTree<dgBody*, dgInt32>&bodyMap, dgDeserialize serializeCallback, void* const serializeHandle);
+	void DeserializeJointArray (const dgArray<dgBody*>& bodyMap, dgDeserialize serializeCallback, void* const serializeHandle);
+
+	bool SaveSceneFile (void* const fileHandle, void* const userData, OnBodySerialize bodyCallback) const;
+	bool LoadSceneFile (void* const fileHandle, void* const userData, OnBodyDeserialize bodyCallback);
+	void SetSceneFileCompression (dgInt32 level);
+	dgInt32 GetSceneFileCompression () const;
 
 	void SerializeCollision (dgCollisionInstance* const shape, dgSerialize deserialization, void* const userData) const;
 	dgCollisionInstance* CreateCollisionFromSerialization (dgDeserialize deserialization, void* const userData);
 	void ReleaseCollision(const dgCollision* const collision);
+	const dgCollision* FindCachedCollision(dgUnsigned32 signature);
+	const dgCollision* AddCachedCollision(const dgCollision* const collision);
 	
 	dgUpVectorConstraint* CreateUpVectorConstraint (const dgVector& pin, dgBody *body);
 	
@@ -384,9 +456,18 @@ class dgWorld
 	dgContact* FindContactJoint (const dgBody* body0, const dgBody* body1) const;
 
 	void SetThreadsCount (dgInt32 count);
+
+	dgWorldScheduler* GetScheduler() const;
+	void SetScheduler (dgWorldScheduler* const scheduler);
+
+	// lends the worker threads to work started outside of an update, NULL while the world is stepping.
+	// an attached world lends the workers of its scheduler while the scheduler is not stepping
+	dgThreadHive* AcquireIdleThreadPool ();
+	void ReleaseIdleThreadPool (dgThreadHive* const threadPool);
 	
 	//Parallel Job dispatcher for user related stuff
 	void ExecuteUserJob (dgWorkerThreadTaskCallback userJobKernel, void* const userJobKernelContext, const char* const functionName);
+	void SyncUserJobs ();
 
 	void BodyEnableSimulation (dgBody* const body);
 	void BodyDisableSimulation (dgBody* const body);
@@ -423,7 +504,7 @@ class dgWorld
 	dgInt32 CalculatePolySoupToHullContactsDescrete (dgCollisionParamProxy& proxy) const;
 	dgInt32 CalculateConvexToNonConvexContactsContinue (dgCollisionParamProxy& proxy) const;
 	dgInt32 CalculateUserContacts (dgCollisionParamProxy& proxy) const;
-	dgInt32 CalculateConvexToNonConvexContacts (dgCollisionParamProxy& proxy) const;
+	dgInt32 CalculateConvexToNonConvexContacts (dgCollisionParamProxy& proxy, const dgPolygonMeshDesc* const cluster = NULL) const;
 	dgInt32 CalculateConvexToConvexContacts (dgCollisionParamProxy& proxy) const;
 	dgInt32 PruneContactsByRank(dgInt32 count, dgCollisionParamProxy& proxy, dgInt32 maxCount) const;
 	
@@ -446,6 +527,7 @@ class dgWorld
 	
 	void UpdateSkeletons();
 	void UpdateBroadphase(dgFloat32 timestep);
+	void CollectContactEvents(dgFloat32 timestep);
 	
 	void AddSentinelBody();
 	void InitConvexCollision ();
@@ -475,7 +557,11 @@ class dgWorld
 	dgUnsigned32 m_defualtBodyGroupID;
 	dgUnsigned32 m_bodiesUniqueID;
 	dgUnsigned32 m_useParallelSolver;
+	dgUnsigned32 m_compactJacobianRows;
+	dgUnsigned32 m_deterministicMode;
 	dgUnsigned32 m_genericLRUMark;
+	dgUnsigned32 m_stateGeneration;
+	dgInt32 m_sceneFileCompression;
 	dgInt32 m_clusterLRU;
 
 	dgFloat32 m_freezeAccel2;
@@ -490,11 +576,14 @@ class dgWorld
 	dgSolverProgressiveSleepEntry m_sleepTable[DG_SLEEP_ENTRIES];
 	
 	dgBroadPhase* m_broadPhase; 
+	dgWorldScheduler* m_scheduler;
+	dgThreadHive* m_userJobThreadPool;
 	dgDynamicBody* m_sentinelBody;
 	dgCollisionInstance* m_pointCollision;
 
 	void* m_userData;
 	dgMemoryAllocator* m_allocator;
+	dgThread::dgSemaphore m_threadPoolSemaphore;
 
 	
 	OnClusterUpdate m_onClusterUpdate;
@@ -514,21 +603,26 @@ class dgWorld
 	dgArray<dgUnsigned8> m_solverJacobiansMemory;  
 	dgArray<dgUnsigned8> m_solverRightHandSideMemory;
 	dgArray<dgUnsigned8> m_solverForceAccumulatorMemory;
+	dgArray<dgUnsigned8> m_solverCompactJacobiansMemory;
 	
 	friend class dgBody;
 	friend class dgSolver;
+	DG_STATIC_SOLVER_FRIENDS
 	friend class dgContact;
 	friend class dgBroadPhase;
 	friend class dgDeadBodies;
 	friend class dgDeadJoints;
 	friend class dgWorldPlugin;
+	friend class dgWorldScheduler;
 	friend class dgContactList;
 	friend class dgUserConstraint;
 	friend class dgBodyMasterList;
 	friend class dgJacobianMemory;
+	friend class dgCollisionBVH;
 	friend class dgCollisionScene;
 	friend class dgCollisionConvex;
 	friend class dgBroadPhaseMixed;
+	friend class dgShapeQueryBatch;
 	friend class dgCollisionInstance;
 	friend class dgCollisionCompound;
 	friend class dgParallelBodySolver;
@@ -536,6 +630,7 @@ class dgWorld
 	friend class dgParallelSolverClear;	
 	friend class dgParallelSolverSolve;
 	friend class dgCollisionHeightField;
+	friend class dgCollisionUserMesh;
 	friend class dgSolverWorlkerThreads;
 	friend class dgBroadPhaseSegregated;
 	friend class dgCollisionConvexPolygon;
@@ -609,6 +704,37 @@ inline dgInt32 dgWorld::GetSolverIterations() const
 	return m_solverIterations;
 }
 
+inline dgUnsigned32 dgWorld::GetStateGeneration() const
+{
+	return m_stateGeneration;
+}
+
+inline const dgTriggerEvent* dgWorld::GetTriggerEvents(dgInt32& count) const
+{
+	const dgContactList& contactList = *this;
+	count = contactList.m_triggerEventCount;
+	return count ? &contactList.m_triggerEvents[0] : NULL;
+}
+
+inline const dgContactEvent* dgWorld::GetContactEvents(dgInt32& count) const
+{
+	const dgContactList& contactList = *this;
+	count = contactList.m_contactEventCount;
+	return count ? &contactList.m_contactEvents[0] : NULL;
+}
+
+inline dgInt32 dgWorld::GetContactEventMask() const
+{
+	const dgContactList& contactList = *this;
+	return contactList.m_contactEventMask;
+}
+
+inline void dgWorld::SetContactEventMask(dgInt32 mask)
+{
+	dgContactList& contactList = *this;
+	contactList.m_contactEventMask = mask & (dgContactEvent::m_beginEvent | dgContactEvent::m_persistEvent | dgContactEvent::m_endEvent);
+}
+
 DG_INLINE dgBody* dgWorld::FindRoot(dgBody* const body) const
 {
 	dgBody* node = body;
@@ -0,0 +1,243 @@
+/* Copyright (c) <2003-2019> <Julio Jerez, Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "dgPhysicsStdafx.h"
+#include "dgBody.h"
+#include "dgWorld.h"
+#include "dgBroadPhase.h"
+#include "dgCollisionInstance.h"
+
+// queries are handed to the threads in small runs of consecutive entries,
+// after sorting large batches along a morton curve the queries of a run are close to each other
+// and traverse mostly the same broad phase nodes.
+#define DG_SHAPE_QUERY_RUN_SIZE		16
+#define DG_SHAPE_QUERY_SORT_COUNT	256
+
+class dgShapeQueryKey
+{
+	public:
+	dgInt32 m_key;
+	dgInt32 m_index;
+};
+
+class dgShapeQueryBatch
+{
+	public:
+	enum dgQueryType
+	{
+		m_collide,
+		m_convexCast,
+		m_closestPoint,
+	};
+
+	dgShapeQueryBatch(dgWorld* const world, dgQueryType type, const dgShapeQuery* const queries, dgInt32 count)
+		:m_world(world)
+		,m_queries(queries)
+		,m_queriesB(NULL)
+		,m_order(NULL)
+		,m_prefilter(NULL)
+		,m_info(NULL)
+		,m_contactCounts(NULL)
+		,m_params(NULL)
+		,m_contactsA(NULL)
+		,m_contactsB(NULL)
+		,m_normalsAB(NULL)
+		,m_type(type)
+		,m_count(count)
+		,m_maxContacts(0)
+		,m_atomicCounter(0)
+	{
+	}
+
+	static dgInt32 GetRadixKey(const dgShapeQueryKey* const entry, void* const context)
+	{
+		return entry->m_key;
+	}
+
+	static dgInt32 SpreadBits(dgInt32 x)
+	{
+		x = (x | (x << 8)) & 0x00f00f;
+		x = (x | (x << 4)) & 0x0c30c3;
+		x = (x | (x << 2)) & 0x249249;
+		return x;
+	}
+
+	dgVector GetQueryCenter(const dgShapeQuery& query) const
+	{
+		dgVector origin(query.m_matrix[12], query.m_matrix[13], query.m_matrix[14], dgFloat32(0.0f));
+		if (m_type == m_convexCast) {
+			dgVector target(query.m_target[0], query.m_target[1], query.m_target[2], dgFloat32(0.0f));
+			origin = (origin + target) * dgVector::m_half;
+		}
+		return origin;
+	}
+
+	void SortQueries(dgShapeQueryKey* const order, dgShapeQueryKey* const tmpOrder)
+	{
+		dgVector minBox(dgFloat32(1.0e15f));
+		dgVector maxBox(dgFloat32(-1.0e15f));
+		for (dgInt32 i = 0; i < m_count; i++) {
+			const dgVector center(GetQueryCenter(m_queries[i]));
+			minBox = minBox.GetMin(center);
+			maxBox = maxBox.GetMax(center);
+		}
+
+		const dgVector size((maxBox - minBox).GetMax(dgVector(dgFloat32(1.0e-3f))));
+		const dgVector gridSize(dgFloat32(255.0f));
+		const dgVector scale((gridSize * size.Reciproc()) & dgVector::m_triplexMask);
+		for (dgInt32 i = 0; i < m_count; i++) {
+			const dgVector grid(((GetQueryCenter(m_queries[i]) - minBox) * scale).GetMin(gridSize).GetInt());
+			order[i].m_key = SpreadBits(dgInt32(grid.m_ix)) | (SpreadBits(dgInt32(grid.m_iy)) << 1) | (SpreadBits(dgInt32(grid.m_iz)) << 2);
+			order[i].m_index = i;
+		}
+		dgRadixSort(order, tmpOrder, m_count, 3, GetRadixKey);
+		m_order = order;
+	}
+
+	void RunQuery(dgInt32 index, dgInt32 threadIndex)
+	{
+		const dgShapeQuery& query = m_queries[index];
+		dgCollisionInstance* const shape = (dgCollisionInstance*)query.m_shape;
+		const dgMatrix matrix(query.m_matrix);
+		switch (m_type)
+		{
+			case m_collide:
+			{
+				dgConvexCastReturnInfo* const info = m_info ? &m_info[index * m_maxContacts] : NULL;
+				m_contactCounts[index] = m_world->GetBroadPhase()->Collide(shape, matrix, m_prefilter, query.m_userData, info, m_maxContacts, threadIndex);
+				break;
+			}
+
+			case m_convexCast:
+			{
+				const dgVector target(query.m_target[0], query.m_target[1], query.m_target[2], dgFloat32(0.0f));
+				dgConvexCastReturnInfo* const info = m_info ? &m_info[index * m_maxContacts] : NULL;
+				m_params[index] = dgFloat32(1.0f);
+				const dgInt32 count = m_world->GetBroadPhase()->ConvexCast(shape, matrix, target, &m_params[index], m_prefilter, query.m_userData, info, m_maxContacts, threadIndex);
+				if (m_contactCounts) {
+					m_contactCounts[index] = count;
+				}
+				break;
+			}
+
+			case m_closestPoint:
+			{
+				const dgShapeQuery& queryB = m_queriesB[index];
+				m_contactCounts[index] = m_world->ClosestPoint(query.m_shape, matrix, queryB.m_shape, dgMatrix(queryB.m_matrix), m_contactsA[index], m_contactsB[index], m_normalsAB[index], threadIndex);
+				break;
+			}
+		}
+	}
+
+	void RunQueries(dgInt32 threadIndex)
+	{
+		for (dgInt32 i = dgAtomicExchangeAndAdd(&m_atomicCounter, DG_SHAPE_QUERY_RUN_SIZE); i < m_count; i = dgAtomicExchangeAndAdd(&m_atomicCounter, DG_SHAPE_QUERY_RUN_SIZE)) {
+			const dgInt32 count = dgMin(m_count - i, DG_SHAPE_QUERY_RUN_SIZE);
+			for (dgInt32 j = 0; j < count; j++) {
+				RunQuery(m_order ? m_order[i + j].m_index : i + j, threadIndex);
+			}
+		}
+	}
+
+	static void QueryKernel(void* const context, void* const worldContext, dgInt32 threadID)
+	{
+		dgShapeQueryBatch* const me = (dgShapeQueryBatch*)context;
+		me->RunQueries(threadID);
+	}
+
+	void Execute(dgInt32 threadIndex)
+	{
+		if ((m_type == m_closestPoint) || (m_count < DG_SHAPE_QUERY_SORT_COUNT)) {
+			Dispatch(threadIndex);
+		} else {
+			dgStack<dgShapeQueryKey> order(m_count);
+			dgStack<dgShapeQueryKey> tmpOrder(m_count);
+			SortQueries(&order[0], &tmpOrder[0]);
+			Dispatch(threadIndex);
+		}
+	}
+
+	void Dispatch(dgInt32 threadIndex)
+	{
+		// from inside an update the thread pool is busy, the queries run on the calling thread
+		dgThreadHive* const threadPool = (m_count > DG_SHAPE_QUERY_RUN_SIZE) ? m_world->AcquireIdleThreadPool() : NULL;
+		const dgInt32 threadCount = threadPool ? threadPool->GetThreadCount() : 1;
+		if (threadCount > 1) {
+			for (dgInt32 i = 0; i < threadCount; i++) {
+				threadPool->QueueJob(QueryKernel, this, NULL, "dgWorld::BatchQuery");
+			}
+			threadPool->SynchronizationBarrier();
+		} else {
+			RunQueries(threadIndex);
+		}
+		m_world->ReleaseIdleThreadPool(threadPool);
+	}
+
+	dgWorld* m_world;
+	const dgShapeQuery* m_queries;
+	const dgShapeQuery* m_queriesB;
+	const dgShapeQueryKey* m_order;
+	OnRayPrecastAction m_prefilter;
+	dgConvexCastReturnInfo* m_info;
+	dgInt32* m_contactCounts;
+	dgFloat32* m_params;
+	dgTriplex* m_contactsA;
+	dgTriplex* m_contactsB;
+	dgTriplex* m_normalsAB;
+	dgQueryType m_type;
+	dgInt32 m_count;
+	dgInt32 m_maxContacts;
+	dgInt32 m_atomicCounter;
+};
+
+void dgWorld::CollideBatch(const dgShapeQuery* const queries, dgInt32 count, OnRayPrecastAction prefilter, dgConvexCastReturnInfo* const info, dgInt32 maxContacts, dgInt32* const contactCounts, dgInt32 threadIndex)
+{
+	dgAssert(contactCounts);
+	dgShapeQueryBatch batch(this, dgShapeQueryBatch::m_collide, queries, count);
+	batch.m_prefilter = prefilter;
+	batch.m_info = info;
+	batch.m_maxContacts = info ? maxContacts : 0;
+	batch.m_contactCounts = contactCounts;
+	batch.Execute(threadIndex);
+}
+
+void dgWorld::ConvexCastBatch(const dgShapeQuery* const queries, dgInt32 count, OnRayPrecastAction prefilter, dgConvexCastReturnInfo* const info, dgInt32 maxContacts, dgInt32* const contactCounts, dgFloat32* const params, dgInt32 threadIndex)
+{
+	dgAssert(params);
+	dgShapeQueryBatch batch(this, dgShapeQueryBatch::m_convexCast, queries, count);
+	batch.m_prefilter = prefilter;
+	batch.m_info = info;
+	batch.m_maxContacts = info ? maxContacts : 0;
+	batch.m_contactCounts = contactCounts;
+	batch.m_params = params;
+	batch.Execute(threadIndex);
+}
+
+void dgWorld::ClosestPointBatch(const dgShapeQuery* const queriesA, const dgShapeQuery* const queriesB, dgInt32 count, dgTriplex* const contactsA, dgTriplex* const contactsB, dgTriplex* const normalsAB, dgInt32* const results, dgInt32 threadIndex)
+{
+	dgShapeQueryBatch batch(this, dgShapeQueryBatch::m_closestPoint, queriesA, count);
+	batch.m_queriesB = queriesB;
+	batch.m_contactsA = contactsA;
+	batch.m_contactsB = contactsB;
+	batch.m_normalsAB = normalsAB;
+	batch.m_contactCounts = results;
+	batch.Execute(threadIndex);
+}
@@ -0,0 +1,176 @@
+/* Copyright (c) <2003-2019> <Julio Jerez, Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#include "dgPhysicsStdafx.h"
+#include "dgBody.h"
+#include "dgWorld.h"
+#include "dgContact.h"
+
+// each thread summarizes a contiguous block of the contact array into the same slots of the event array, 
+// packing the blocks afterward keeps the events in contact order for any number of threads.
+class dgContactEventCollector
+{
+	public:
+	dgContactEventCollector(dgWorld* const world, dgFloat32 timestep)
+		:m_world(world)
+		,m_events(NULL)
+		,m_contacts(NULL)
+		,m_timestep(timestep)
+		,m_contactCount(0)
+		,m_threadCount(world->GetThreadCount())
+		,m_mask(0)
+	{
+		dgContactList& contactList = *world;
+		m_contactCount = contactList.m_contactCount;
+		m_mask = contactList.m_contactEventMask;
+		if (m_contactCount) {
+			const dgInt32 eventCount = contactList.m_contactEventCount;
+			contactList.m_contactEvents.ResizeIfNecessary(eventCount + m_contactCount);
+			m_events = &contactList.m_contactEvents[eventCount];
+			m_contacts = &contactList[0];
+		}
+	}
+
+	void Summarize(dgContact* const contact, dgContactEvent& event) const
+	{
+		dgVector point(dgFloat32(0.0f));
+		dgVector normal(dgFloat32(0.0f));
+		dgFloat32 normalForce = dgFloat32(0.0f);
+		dgFloat32 tangentForce = dgFloat32(0.0f);
+		dgFloat32 maxImpact = dgFloat32(0.0f);
+		dgFloat32 penetration = dgFloat32(0.0f);
+		for (dgContact::dgListNode* node = contact->GetFirst(); node; node = node->GetNext()) {
+			const dgContactMaterial& material = node->GetInfo();
+			point += material.m_point & dgVector::m_triplexMask;
+			normal += material.m_normal & dgVector::m_triplexMask;
+			normalForce += material.m_normal_Force.m_force;
+			tangentForce += dgSqrt(material.m_dir0_Force.m_force * material.m_dir0_Force.m_force + material.m_dir1_Force.m_force * material.m_dir1_Force.m_force);
+			maxImpact = dgMax(maxImpact, material.m_normal_Force.m_impact);
+			penetration = dgMax(penetration, material.m_penetration);
+		}
+
+		const dgInt32 count = contact->GetCount();
+		dgAssert(count);
+		point = point.Scale(dgFloat32(1.0f) / dgFloat32(count));
+		const dgFloat32 mag2 = normal.DotProduct(normal).GetScalar();
+		if (mag2 > dgFloat32(1.0e-12f)) {
+			normal = normal.Scale(dgRsqrt(mag2));
+		}
+
+		event.m_point[0] = point.m_x;
+		event.m_point[1] = point.m_y;
+		event.m_point[2] = point.m_z;
+		event.m_point[3] = dgFloat32(0.0f);
+		event.m_normal[0] = normal.m_x;
+		event.m_normal[1] = normal.m_y;
+		event.m_normal[2] = normal.m_z;
+		event.m_normal[3] = dgFloat32(0.0f);
+		event.m_normalImpulse = normalForce * m_timestep;
+		event.m_tangentImpulse = tangentForce * m_timestep;
+		event.m_maxNormalImpact = maxImpact;
+		event.m_penetration = penetration;
+		event.m_pointCount = count;
+	}
+
+	void Collect(dgInt32 block)
+	{
+		const dgInt32 start = dgInt32((dgInt64(m_contactCount) * block) / m_threadCount);
+		const dgInt32 end = dgInt32((dgInt64(m_contactCount) * (block + 1)) / m_threadCount);
+
+		dgInt32 count = 0;
+		dgContactEvent* const events = &m_events[start];
+		for (dgInt32 i = start; i < end; i++) {
+			dgContact* const contact = m_contacts[i];
+			if (!contact->m_isTrigger) {
+				const dgUnsigned32 isTouching = (contact->IsActive() && contact->GetMaxDOF() && contact->GetCount()) ? 1 : 0;
+				dgInt32 type = 0;
+				if (isTouching) {
+					type = contact->m_wasTouching ? dgContactEvent::m_persistEvent : dgContactEvent::m_beginEvent;
+				} else if (contact->m_wasTouching) {
+					type = dgContactEvent::m_endEvent;
+				}
+				contact->m_wasTouching = isTouching;
+
+				if (type & m_mask) {
+					dgContactEvent& event = events[count];
+					if (isTouching) {
+						Summarize(contact, event);
+					} else {
+						memset(&event, 0, sizeof(dgContactEvent));
+					}
+					event.m_body0 = contact->GetBody0();
+					event.m_body1 = contact->GetBody1();
+					event.m_type = type;
+					count++;
+				}
+			}
+		}
+		m_blockCount[block] = count;
+	}
+
+	static void CollectKernel(void* const context, void* const worldContext, dgInt32 threadID)
+	{
+		D_TRACKTIME();
+		dgContactEventCollector* const me = (dgContactEventCollector*)context;
+		me->Collect(threadID);
+	}
+
+	void Execute()
+	{
+		if (!m_contactCount) {
+			return;
+		}
+
+		for (dgInt32 i = 0; i < m_threadCount; i++) {
+			m_world->QueueJob(CollectKernel, this, NULL, "dgWorld::CollectContactEvents");
+		}
+		m_world->SynchronizationBarrier();
+
+		dgContactList& contactList = *m_world;
+		dgContactEvent* const events = &contactList.m_contactEvents[0];
+		dgInt32 eventCount = contactList.m_contactEventCount;
+		for (dgInt32 i = 0; i < m_threadCount; i++) {
+			const dgInt32 start = contactList.m_contactEventCount + dgInt32((dgInt64(m_contactCount) * i) / m_threadCount);
+			if (m_blockCount[i] && (start != eventCount)) {
+				memmove(&events[eventCount], &events[start], m_blockCount[i] * sizeof(dgContactEvent));
+			}
+			eventCount += m_blockCount[i];
+		}
+		contactList.m_contactEventCount = eventCount;
+	}
+
+	dgWorld* m_world;
+	dgContactEvent* m_events;
+	dgContact** m_contacts;
+	dgFloat32 m_timestep;
+	dgInt32 m_contactCount;
+	dgInt32 m_threadCount;
+	dgInt32 m_mask;
+	dgInt32 m_blockCount[DG_MAX_THREADS_HIVE_COUNT];
+};
+
+void dgWorld::CollectContactEvents(dgFloat32 timestep)
+{
+	D_TRACKTIME();
+	dgContactEventCollector collector(this, timestep);
+	collector.Execute();
+}
@@ -61,6 +61,12 @@ void dgJacobianMemory::Init(dgWorld* const world, dgInt32 rowsCount, dgInt32 bod
 
 	world->m_solverForceAccumulatorMemory.ResizeIfNecessary((bodyCount + 8) * sizeof(dgJacobian));
 	m_internalForcesBuffer = (dgJacobian*)&world->m_solverForceAccumulatorMemory[0];
+
+	m_compactJacobianBuffer = NULL;
+	if (world->m_compactJacobianRows) {
+		world->m_solverCompactJacobiansMemory.ResizeIfNecessary((rowsCount + 1) * sizeof(dgJacobianPair));
+		m_compactJacobianBuffer = (dgJacobianPair*)&world->m_solverCompactJacobiansMemory[0];
+	}
 	dgAssert(bodyCount <= (((world->m_solverForceAccumulatorMemory.GetBytesCapacity() - 16) / dgInt32(sizeof(dgJacobian))) & (-8)));
 
 	dgAssert((dgUnsigned64(m_leftHandSizeBuffer) & 0x01f) == 0);
@@ -140,16 +146,14 @@ void dgWorldDynamicUpdate::UpdateDynamics(dgFloat32 timestep)
 		world->SynchronizationBarrier();
 	}
 
-	dgBodyInfo* const bodyArrayPtr = &world->m_bodiesMemory[0];
-	for (dgInt32 i = 0; i < m_softBodiesCount; i++) {
-		dgBodyCluster* const cluster = &m_clusterData[i];
-//		IntegrateExternalForce(cluster, timestep, 0);
-		dgBodyInfo* const bodyArray = &bodyArrayPtr[cluster->m_bodyStart];
-		dgAssert (cluster->m_bodyCount == 2);
-		dgDynamicBody* const body = (dgDynamicBody*)bodyArray[1].m_body;
-		dgAssert (body->m_collision->IsType(dgCollision::dgCollisionLumpedMass_RTTI));
-		body->IntegrateOpenLoopExternalForce(timestep);
-		IntegrateVelocity(cluster, DG_SOLVER_MAX_ERROR, timestep, 0);
+	if (m_softBodiesCount) {
+		descriptor.m_atomicCounter = 0;
+		descriptor.m_firstCluster = 0;
+		descriptor.m_clusterCount = m_softBodiesCount;
+		for (dgInt32 i = 0; i < threadCount; i ++) {
+			world->QueueJob (IntegrateSoftBodiesKernel, &descriptor, world, "dgWorldDynamicUpdate::IntegrateSoftBodies");
+		}
+		world->SynchronizationBarrier();
 	}
 
 	m_clusterData = NULL;
@@ -172,7 +176,19 @@ dgInt32 dgWorldDynamicUpdate::CompareKey(dgInt32 highA, dgInt32 lowA, dgInt32 hi
 
 dgInt32 dgWorldDynamicUpdate::CompareJointInfos(const dgJointInfo* const infoA, const dgJointInfo* const infoB, void*)
 {
-	return CompareKey(infoA->m_jointCount, infoA->m_setId, infoB->m_jointCount, infoB->m_setId);
+	const dgInt32 test = CompareKey(infoA->m_jointCount, infoA->m_setId, infoB->m_jointCount, infoB->m_setId);
+	if (test || !infoA->m_jointCount) {
+		return test;
+	}
+	// all joints of a cluster share the key, without a tie break their order would depend on how the sort was split between threads
+	const dgUnsigned32 indexA = infoA->m_joint->m_index;
+	const dgUnsigned32 indexB = infoB->m_joint->m_index;
+	if (indexA < indexB) {
+		return -1;
+	} else if (indexA > indexB) {
+		return 1;
+	}
+	return 0;
 }
 
 dgInt32 dgWorldDynamicUpdate::CompareClusterInfos(const dgBodyCluster* const clusterA, const dgBodyCluster* const clusterB, void* notUsed)
@@ -313,6 +329,7 @@ void dgWorldDynamicUpdate::BuildClusters(dgFloat32 timestep)
 				clustersCount++;
 				bodyInfoCount += root->m_disjointInfo.m_bodyCount + 1;
 			}
+			constraint->m_index = i;
 			jointInfo->m_setId = root->m_index;
 			jointInfo->m_pairCount = constraint->m_maxDOF;
 			jointInfo->m_bodyCount = root->m_disjointInfo.m_bodyCount;
@@ -456,6 +473,29 @@ void dgWorldDynamicUpdate::CalculateClusterReactionForcesKernel (void* const con
 	}
 }
 
+void dgWorldDynamicUpdate::IntegrateSoftBodiesKernel (void* const context, void* const worldContext, dgInt32 threadID)
+{
+	D_TRACKTIME();
+	dgWorldDynamicUpdateSyncDescriptor* const descriptor = (dgWorldDynamicUpdateSyncDescriptor*) context;
+
+	dgFloat32 timestep = descriptor->m_timestep;
+	dgWorld* const world = (dgWorld*) worldContext;
+	dgInt32 count = descriptor->m_clusterCount;
+	dgBodyCluster* const clusters = &world->m_clusterData[descriptor->m_firstCluster];
+	dgBodyInfo* const bodyArrayPtr = &world->m_bodiesMemory[0];
+
+	// each soft body is a cluster of its own, so they can be integrated independently
+	for (dgInt32 i = dgAtomicExchangeAndAdd(&descriptor->m_atomicCounter, 1); i < count; i = dgAtomicExchangeAndAdd(&descriptor->m_atomicCounter, 1)) {
+		dgBodyCluster* const cluster = &clusters[i]; 
+		dgBodyInfo* const bodyArray = &bodyArrayPtr[cluster->m_bodyStart];
+		dgAssert (cluster->m_bodyCount == 2);
+		dgDynamicBody* const body = (dgDynamicBody*)bodyArray[1].m_body;
+		dgAssert (body->m_collision->IsType(dgCollision::dgCollisionLumpedMass_RTTI));
+		body->IntegrateOpenLoopExternalForce(timestep);
+		world->IntegrateVelocity(cluster, DG_SOLVER_MAX_ERROR, timestep, threadID);
+	}
+}
+
 dgInt32 dgWorldDynamicUpdate::GetJacobianDerivatives(dgContraintDescritor& constraintParam, dgJointInfo* const jointInfo, dgConstraint* const constraint, dgLeftHandSide* const leftHandSide, dgRightHandSide* const rightHandSide, dgInt32 rowCount) const
 {
 	dgInt32 dof = dgInt32(constraint->m_maxDOF);
@@ -226,6 +226,7 @@ class dgJacobianMemory
 	dgJacobian* m_internalForcesBuffer;
 	dgLeftHandSide* m_leftHandSizeBuffer;
 	dgRightHandSide* m_righHandSizeBuffer;
+	dgJacobianPair* m_compactJacobianBuffer;
 };
 
 class dgWorldDynamicUpdate
@@ -255,6 +256,7 @@ class dgWorldDynamicUpdate
 	static dgInt32 CompareBodyJacobianPair(const dgBodyJacobianPair* const infoA, const dgBodyJacobianPair* const infoB, void* notUsed);
 	static void IntegrateClustersParallelKernel (void* const context, void* const worldContext, dgInt32 threadID);
 	static void CalculateClusterReactionForcesKernel (void* const context, void* const worldContext, dgInt32 threadID);
+	static void IntegrateSoftBodiesKernel (void* const context, void* const worldContext, dgInt32 threadID);
 
 	void BuildJacobianMatrix (dgBodyCluster* const cluster, dgInt32 threadID, dgFloat32 timestep) const;
 	void ResolveClusterForces (dgBodyCluster* const cluster, dgInt32 threadID, dgFloat32 timestep) const;
@@ -266,6 +268,9 @@ class dgWorldDynamicUpdate
 	void CalculateReactionForcesParallel(const dgBodyCluster* const clusters, dgInt32 clustersCount, dgFloat32 timestep);
 
 	dgFloat32 CalculateJointForce(const dgJointInfo* const jointInfo, const dgBodyInfo* const bodyArray, dgJacobian* const internalForces, const dgLeftHandSide* const matrixRow, dgRightHandSide* const rightHandSide) const;
+	dgFloat32 CalculateJointForceCompact(const dgJointInfo* const jointInfo, const dgBodyInfo* const bodyArray, dgJacobian* const internalForces, const dgJacobianPair* const jacobianRow, dgRightHandSide* const rightHandSide) const;
+	template <class dgJacobianRows>
+	dgFloat32 CalculateJointForceRows(const dgJointInfo* const jointInfo, const dgBodyInfo* const bodyArray, dgJacobian* const internalForces, const dgJacobianRows& rows, dgRightHandSide* const rightHandSide) const;
 	dgFloat32 CalculateJointForce_3_13(const dgJointInfo* const jointInfo, const dgBodyInfo* const bodyArray, dgJacobian* const internalForces, const dgLeftHandSide* const matrixRow, dgRightHandSide* const rightHandSide) const;
 	dgJacobian IntegrateForceAndToque(dgDynamicBody* const body, const dgVector& force, const dgVector& torque, const dgVector& timestep) const ;
 
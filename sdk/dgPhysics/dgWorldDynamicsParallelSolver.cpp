@@ -58,7 +58,8 @@ void dgWorldDynamicUpdate::CalculateReactionForcesParallel(const dgBodyCluster*
 	dgBodyInfo* const bodyArray = &world->m_bodiesMemory[m_bodies];
 	dgJointInfo* const jointArray = &world->m_jointsMemory[m_joints];
 
-	if (world->GetCurrentPlugin()) {
+	// the simd plugins accumulate body forces in thread order, deterministic worlds use the core solver
+	if (world->GetCurrentPlugin() && !world->m_deterministicMode) {
 		dgWorldPlugin* const plugin = world->GetCurrentPlugin()->GetInfo().m_plugin;
 		plugin->CalculateJointForces(cluster, bodyArray, jointArray, timestep);
 	} else {
@@ -201,6 +202,10 @@ void dgParallelBodySolver::InitWeights()
 			m_skeletonCount ++;
 		}
 	}
+	if (m_skeletonCount > 1) {
+		// skeletons are handed out dynamically, so start with the most expensive ones
+		dgSort(&m_skeletonArray[0], m_skeletonCount, CompareSkeletons);
+	}
 	const dgInt32 conectivity = 7;
 	m_solverPasses += 2 * dgInt32(extraPasses) / conectivity + 1;
 }
@@ -274,6 +279,12 @@ void dgParallelBodySolver::UpdateRowAccelerationKernel(void* const context, void
 	me->UpdateRowAcceleration(threadID);
 }
 
+void dgParallelBodySolver::GatherInternalForcesKernel(void* const context, void* const, dgInt32 threadID)
+{
+	dgParallelBodySolver* const me = (dgParallelBodySolver*)context;
+	me->GatherInternalForces(threadID);
+}
+
 DG_INLINE void dgParallelBodySolver::TransposeRow(dgSolverSoaElement* const row, const dgJointInfo* const jointInfoArray, dgInt32 index)
 {
 	const dgLeftHandSide* const leftHandSide = &m_world->m_solverMemory.m_leftHandSizeBuffer[0];
@@ -389,7 +400,7 @@ void dgParallelBodySolver::TransposeMassMatrix(dgInt32 threadID)
 	}
 }
 
-DG_INLINE void dgParallelBodySolver::BuildJacobianMatrix(dgJointInfo* const jointInfo, dgLeftHandSide* const leftHandSide, dgRightHandSide* const rightHandSide, dgJacobian* const internalForces)
+DG_INLINE void dgParallelBodySolver::BuildJacobianMatrix(dgJointInfo* const jointInfo, dgLeftHandSide* const leftHandSide, dgRightHandSide* const rightHandSide, dgJacobian* const internalForces, dgInt32 jointIndex)
 {
 	const dgInt32 m0 = jointInfo->m_m0;
 	const dgInt32 m1 = jointInfo->m_m1;
@@ -473,15 +484,21 @@ DG_INLINE void dgParallelBodySolver::BuildJacobianMatrix(dgJointInfo* const join
 		forceAcc1 = forceAcc1.MulAdd(JtM1, f1);
 	}
 
-	if (m0) {
-		dgWorkGroupFloat& out = (dgWorkGroupFloat&)internalForces[m0];
-		dgScopeSpinPause lock(&m_bodyProxyArray[m0].m_lock);
-		out = out + forceAcc0;
-	}
-	if (m1) {
-		dgWorkGroupFloat& out = (dgWorkGroupFloat&)internalForces[m1];
-		dgScopeSpinPause lock(&m_bodyProxyArray[m1].m_lock);
-		out = out + forceAcc1;
+	if (m_deterministic) {
+		dgJacobian* const jointForces = &m_jointForces[jointIndex * 2];
+		(dgWorkGroupFloat&)jointForces[0] = forceAcc0;
+		(dgWorkGroupFloat&)jointForces[1] = forceAcc1;
+	} else {
+		if (m0) {
+			dgWorkGroupFloat& out = (dgWorkGroupFloat&)internalForces[m0];
+			dgScopeSpinPause lock(&m_bodyProxyArray[m0].m_lock);
+			out = out + forceAcc0;
+		}
+		if (m1) {
+			dgWorkGroupFloat& out = (dgWorkGroupFloat&)internalForces[m1];
+			dgScopeSpinPause lock(&m_bodyProxyArray[m1].m_lock);
+			out = out + forceAcc1;
+		}
 	}
 }
 
@@ -544,10 +561,22 @@ void dgParallelBodySolver::InitJacobianMatrix(dgInt32 threadID)
 		dgAssert(jointInfo->m_m0 != jointInfo->m_m1);
 		const dgInt32 rowBase = dgAtomicExchangeAndAdd(&m_jacobianMatrixRowAtomicIndex, jointInfo->m_pairCount);
 		m_world->GetJacobianDerivatives(constraintParams, jointInfo, constraint, leftHandSide, rightHandSide, rowBase);
-		BuildJacobianMatrix(jointInfo, leftHandSide, rightHandSide, internalForces);
+		BuildJacobianMatrix(jointInfo, leftHandSide, rightHandSide, internalForces, i);
 	}
 }
 
+dgInt32 dgParallelBodySolver::CompareSkeletons(dgSkeletonContainer* const* const skeletonA, dgSkeletonContainer* const* const skeletonB, void* notUsed)
+{
+	const dgInt32 costA = (*skeletonA)->m_nodeCount + (*skeletonA)->m_loopCount * 4;
+	const dgInt32 costB = (*skeletonB)->m_nodeCount + (*skeletonB)->m_loopCount * 4;
+	if (costA > costB) {
+		return -1;
+	} else if (costA < costB) {
+		return 1;
+	}
+	return 0;
+}
+
 dgInt32 dgParallelBodySolver::CompareJointInfos(const dgJointInfo* const infoA, const dgJointInfo* const infoB, void* notUsed)
 {
 	const dgInt32 restingA = (infoA->m_joint->m_body0->m_resting & infoA->m_joint->m_body1->m_resting) ? 1 : 0;
@@ -562,6 +591,15 @@ dgInt32 dgParallelBodySolver::CompareJointInfos(const dgJointInfo* const infoA,
 	if (countA > countB) {
 		return -1;
 	}
+
+	// joints with the same row count keep the cluster order, so the work groups do not depend on how the sort was split
+	const dgUnsigned32 indexA = infoA->m_joint->m_index;
+	const dgUnsigned32 indexB = infoB->m_joint->m_index;
+	if (indexA < indexB) {
+		return -1;
+	} else if (indexA > indexB) {
+		return 1;
+	}
 	return 0;
 }
 
@@ -570,12 +608,34 @@ void dgParallelBodySolver::InitJacobianMatrix()
 	m_jacobianMatrixRowAtomicIndex = 0;
 	dgJacobian* const internalForces = &m_world->m_solverMemory.m_internalForcesBuffer[0];
 	memset(internalForces, 0, m_cluster->m_bodyCount * sizeof (dgJacobian));
+	if (m_deterministic) {
+		m_jointForces.ResizeIfNecessary(m_jointCount * DG_WORK_GROUP_SIZE * 2);
+		m_groupAccelNorm.ResizeIfNecessary(m_jointCount);
+	}
 
 	for (dgInt32 i = 0; i < m_threadCounts; i++) {
 		m_world->QueueJob(InitJacobianMatrixKernel, this, NULL, "dgParallelBodySolver::InitJacobianMatrix");
 	}
 	m_world->SynchronizationBarrier();
 
+	if (m_deterministic) {
+		const dgJacobian* const jointForces = &m_jointForces[0];
+		const dgInt32 jointCount = m_cluster->m_jointCount;
+		for (dgInt32 i = 0; i < jointCount; i++) {
+			const dgJointInfo* const jointInfo = &m_jointArray[i];
+			const dgInt32 m0 = jointInfo->m_m0;
+			const dgInt32 m1 = jointInfo->m_m1;
+			if (m0) {
+				internalForces[m0].m_linear += jointForces[i * 2].m_linear;
+				internalForces[m0].m_angular += jointForces[i * 2].m_angular;
+			}
+			if (m1) {
+				internalForces[m1].m_linear += jointForces[i * 2 + 1].m_linear;
+				internalForces[m1].m_angular += jointForces[i * 2 + 1].m_angular;
+			}
+		}
+	}
+
 #ifdef D_USE_SOA_SOLVER
 	dgJointInfo* const jointArray = m_jointArray;
 //	dgSort(jointArray, m_cluster->m_jointCount, CompareJointInfos);
@@ -613,6 +673,10 @@ void dgParallelBodySolver::InitJacobianMatrix()
 	}
 	m_massMatrix.ResizeIfNecessary(size);
 
+	if (m_deterministic) {
+		InitBodyJointLists();
+	}
+
 	m_soaRowsCount = 0;
 	for (dgInt32 i = 0; i < m_threadCounts; i++) {
 		m_world->QueueJob(TransposeMassMatrixKernel, this, NULL, "dgParallelBodySolver::TransposeMassMatrix");
@@ -801,12 +865,94 @@ void dgParallelBodySolver::CalculateJointsForce()
 	dgJacobian* const internalForces = &m_world->m_solverMemory.m_internalForcesBuffer[0];
 	dgJacobian* const tempInternalForces = &m_world->m_solverMemory.m_internalForcesBuffer[bodyCount];
 
-	memset(tempInternalForces, 0, bodyCount * sizeof(dgJacobian));
+	if (!m_deterministic) {
+		memset(tempInternalForces, 0, bodyCount * sizeof(dgJacobian));
+	}
 	for (dgInt32 i = 0; i < m_threadCounts; i++) {
 		m_world->QueueJob(CalculateJointsForceKernel, this, NULL, "dgParallelBodySolver::CalculateJointsForce");
 	}
 	m_world->SynchronizationBarrier();
-	memcpy(internalForces, tempInternalForces, bodyCount * sizeof(dgJacobian));
+
+	if (m_deterministic) {
+		GatherInternalForces();
+	} else {
+		memcpy(internalForces, tempInternalForces, bodyCount * sizeof(dgJacobian));
+	}
+}
+
+void dgParallelBodySolver::InitBodyJointLists()
+{
+	// list the joint force slots of each body in joint order
+	const dgInt32 bodyCount = m_cluster->m_bodyCount;
+	const dgInt32 jointCount = m_jointCount * DG_WORK_GROUP_SIZE;
+	m_bodyJointStart.ResizeIfNecessary(bodyCount + 1);
+	m_bodyJointList.ResizeIfNecessary(m_cluster->m_jointCount * 2);
+	dgInt32* const start = &m_bodyJointStart[0];
+	dgInt32* const list = &m_bodyJointList[0];
+
+	memset(start, 0, (bodyCount + 1) * sizeof(dgInt32));
+	for (dgInt32 i = 0; i < jointCount; i++) {
+		const dgJointInfo* const jointInfo = &m_jointArray[i];
+		if (jointInfo->m_joint) {
+			start[jointInfo->m_m0] ++;
+			start[jointInfo->m_m1] ++;
+		}
+	}
+	start[0] = 0;
+
+	dgInt32 acc = 0;
+	for (dgInt32 i = 0; i < bodyCount; i++) {
+		acc += start[i];
+		start[i] = acc;
+	}
+	start[bodyCount] = acc;
+
+	for (dgInt32 i = jointCount - 1; i >= 0; i--) {
+		const dgJointInfo* const jointInfo = &m_jointArray[i];
+		if (jointInfo->m_joint) {
+			const dgInt32 m0 = jointInfo->m_m0;
+			const dgInt32 m1 = jointInfo->m_m1;
+			if (m1) {
+				start[m1] --;
+				list[start[m1]] = i * 2 + 1;
+			}
+			if (m0) {
+				start[m0] --;
+				list[start[m0]] = i * 2;
+			}
+		}
+	}
+}
+
+void dgParallelBodySolver::GatherInternalForces()
+{
+	for (dgInt32 i = 0; i < m_threadCounts; i++) {
+		m_world->QueueJob(GatherInternalForcesKernel, this, NULL, "dgParallelBodySolver::GatherInternalForces");
+	}
+	m_world->SynchronizationBarrier();
+}
+
+void dgParallelBodySolver::GatherInternalForces(dgInt32 threadID)
+{
+	const dgInt32* const start = &m_bodyJointStart[0];
+	const dgInt32* const list = &m_bodyJointList[0];
+	const dgJacobian* const jointForces = &m_jointForces[0];
+	dgJacobian* const internalForces = &m_world->m_solverMemory.m_internalForcesBuffer[0];
+
+	const dgInt32 step = m_threadCounts;
+	const dgInt32 bodyCount = m_cluster->m_bodyCount;
+	for (dgInt32 i = threadID; i < bodyCount; i += step) {
+		dgVector force(dgVector::m_zero);
+		dgVector torque(dgVector::m_zero);
+		const dgInt32 end = start[i + 1];
+		for (dgInt32 j = start[i]; j < end; j++) {
+			const dgJacobian& jointForce = jointForces[list[j]];
+			force += jointForce.m_linear;
+			torque += jointForce.m_angular;
+		}
+		internalForces[i].m_linear = force;
+		internalForces[i].m_angular = torque;
+	}
 }
 
 void dgParallelBodySolver::CalculateJointsAcceleration()
@@ -831,10 +977,9 @@ void dgParallelBodySolver::InitSkeletons(dgInt32 threadID)
 	const dgLeftHandSide* const leftHandSide = &m_world->m_solverMemory.m_leftHandSizeBuffer[0];
 
 	const dgInt32 count = m_skeletonCount;
-	const dgInt32 threadCounts = m_world->GetThreadCount();
 	dgSkeletonContainer** const skeletonArray = &m_skeletonArray[0];
 
-	for (dgInt32 i = threadID; i < count; i += threadCounts) {
+	for (dgInt32 i = dgAtomicExchangeAndAdd(&m_skeletonAtomicIndex, 1); i < count; i = dgAtomicExchangeAndAdd(&m_skeletonAtomicIndex, 1)) {
 		dgSkeletonContainer* const skeleton = skeletonArray[i];
 		skeleton->InitMassMatrix(m_jointArray, leftHandSide, rightHandSide);
 	}
@@ -843,11 +988,10 @@ void dgParallelBodySolver::InitSkeletons(dgInt32 threadID)
 void dgParallelBodySolver::UpdateSkeletons(dgInt32 threadID)
 {
 	const dgInt32 count = m_skeletonCount;
-	const dgInt32 threadCounts = m_world->GetThreadCount();
 	dgSkeletonContainer** const skeletonArray = &m_skeletonArray[0];
 	dgJacobian* const internalForces = &m_world->m_solverMemory.m_internalForcesBuffer[0];
 
-	for (dgInt32 i = threadID; i < count; i += threadCounts) {
+	for (dgInt32 i = dgAtomicExchangeAndAdd(&m_skeletonAtomicIndex, 1); i < count; i = dgAtomicExchangeAndAdd(&m_skeletonAtomicIndex, 1)) {
 		dgSkeletonContainer* const skeleton = skeletonArray[i];
 		skeleton->CalculateJointForce(m_jointArray, m_bodyArray, internalForces);
 	}
@@ -868,6 +1012,7 @@ void dgParallelBodySolver::UpdateSkeletonsKernel(void* const context, void* cons
 void dgParallelBodySolver::InitSkeletons()
 {
 	const dgInt32 threadCounts = m_world->GetThreadCount();
+	m_skeletonAtomicIndex = 0;
 	for (dgInt32 i = 0; i < threadCounts; i++) {
 		m_world->QueueJob(InitSkeletonsKernel, this, NULL, "dgParallelBodySolver::InitSkeletonsKernel");
 	}
@@ -877,6 +1022,7 @@ void dgParallelBodySolver::InitSkeletons()
 void dgParallelBodySolver::UpdateSkeletons()
 {
 	const dgInt32 threadCounts = m_world->GetThreadCount();
+	m_skeletonAtomicIndex = 0;
 	for (dgInt32 i = 0; i < threadCounts; i++) {
 		m_world->QueueJob(UpdateSkeletonsKernel, this, NULL, "dgParallelBodySolver::UpdateSkeletons");
 	}
@@ -1152,18 +1298,27 @@ void dgParallelBodySolver::CalculateJointsForce(dgInt32 threadID)
 				const dgInt32 m0 = jointInfo[j].m_m0;
 				const dgInt32 m1 = jointInfo[j].m_m1;
 
-				if (m0) {
-					dgScopeSpinPause lock(&bodyProxyArray[m0].m_lock);
-					tempInternalForces[m0].m_linear += m_body0Force.m_linear;
-					tempInternalForces[m0].m_angular += m_body0Force.m_angular;
-				}
-				if (m1) {
-					dgScopeSpinPause lock(&bodyProxyArray[m1].m_lock);
-					tempInternalForces[m1].m_linear += m_body1Force.m_linear;
-					tempInternalForces[m1].m_angular += m_body1Force.m_angular;
+				if (m_deterministic) {
+					dgJacobian* const jointForces = &m_jointForces[(i * DG_WORK_GROUP_SIZE + j) * 2];
+					jointForces[0] = m_body0Force;
+					jointForces[1] = m_body1Force;
+				} else {
+					if (m0) {
+						dgScopeSpinPause lock(&bodyProxyArray[m0].m_lock);
+						tempInternalForces[m0].m_linear += m_body0Force.m_linear;
+						tempInternalForces[m0].m_angular += m_body0Force.m_angular;
+					}
+					if (m1) {
+						dgScopeSpinPause lock(&bodyProxyArray[m1].m_lock);
+						tempInternalForces[m1].m_linear += m_body1Force.m_linear;
+						tempInternalForces[m1].m_angular += m_body1Force.m_angular;
+					}
 				}
 			}
 		}
+		if (m_deterministic) {
+			m_groupAccelNorm[i] = accel2;
+		}
 		accNorm += accel2;
 	}
 	m_accelNorm[threadID] = accNorm;
@@ -1344,8 +1499,16 @@ void dgParallelBodySolver::CalculateForces()
 		for (dgInt32 k = 0; (k < passes) && (accNorm > DG_SOLVER_MAX_ERROR); k++) {
 			CalculateJointsForce();
 			accNorm = dgFloat32(0.0f);
-			for (dgInt32 i = 0; i < threadCounts; i++) {
-				accNorm = dgMax(accNorm, m_accelNorm[i]);
+			if (m_deterministic) {
+				// the per thread sums change with the thread count, add the work groups in order instead
+				const dgFloat32* const groupAccelNorm = &m_groupAccelNorm[0];
+				for (dgInt32 i = 0; i < m_jointCount; i++) {
+					accNorm += groupAccelNorm[i];
+				}
+			} else {
+				for (dgInt32 i = 0; i < threadCounts; i++) {
+					accNorm = dgMax(accNorm, m_accelNorm[i]);
+				}
 			}
 		}
 		UpdateSkeletons();
@@ -1379,6 +1542,7 @@ void dgParallelBodySolver::CalculateJointForces(const dgBodyCluster& cluster, dg
 
 	m_solverPasses = m_world->GetSolverIterations();
 	m_threadCounts = m_world->GetThreadCount();
+	m_deterministic = m_world->GetDeterministicMode();
 	m_jointCount = ((m_cluster->m_jointCount + DG_WORK_GROUP_SIZE - 1) & -dgInt32(DG_WORK_GROUP_SIZE - 1)) / DG_WORK_GROUP_SIZE;
 
 	m_soaRowStart = dgAlloca(dgInt32, m_jointCount);
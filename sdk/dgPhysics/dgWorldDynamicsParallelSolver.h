@@ -223,6 +223,8 @@ class dgParallelBodySolver
 	void UpdateKinematicFeedback();
 	void CalculateJointsAcceleration();
 	void CalculateBodiesAcceleration();
+	void InitBodyJointLists();
+	void GatherInternalForces();
 	
 	void InitBodyArray(dgInt32 threadID);
 	void InitSkeletons(dgInt32 threadID);
@@ -236,6 +238,7 @@ class dgParallelBodySolver
 	void UpdateKinematicFeedback(dgInt32 threadID);
 	void CalculateJointsAcceleration(dgInt32 threadID);
 	void CalculateBodiesAcceleration(dgInt32 threadID);
+	void GatherInternalForces(dgInt32 threadID);
 	
 	static void InitSkeletonsKernel(void* const context, void* const, dgInt32 threadID);
 	static void InitBodyArrayKernel(void* const context, void* const, dgInt32 threadID);
@@ -249,13 +252,15 @@ class dgParallelBodySolver
 	static void UpdateKinematicFeedbackKernel(void* const context, void* const, dgInt32 threadID);
 	static void CalculateBodiesAccelerationKernel(void* const context, void* const, dgInt32 threadID);
 	static void CalculateJointsAccelerationKernel(void* const context, void* const, dgInt32 threadID);
+	static void GatherInternalForcesKernel(void* const context, void* const, dgInt32 threadID);
 
 	static dgInt32 CompareJointInfos(const dgJointInfo* const infoA, const dgJointInfo* const infoB, void* notUsed);
+	static dgInt32 CompareSkeletons(dgSkeletonContainer* const* const skeletonA, dgSkeletonContainer* const* const skeletonB, void* notUsed);
 
 	dgFloat32 CalculateJointForce(const dgJointInfo* const jointInfo, dgSolverSoaElement* const massMatrix, const dgJacobian* const internalForces) const;
 	DG_INLINE void SortWorkGroup (dgInt32 base) const; 
 	DG_INLINE void TransposeRow (dgSolverSoaElement* const row, const dgJointInfo* const jointInfoArray, dgInt32 index);
-	DG_INLINE void BuildJacobianMatrix(dgJointInfo* const jointInfo, dgLeftHandSide* const leftHandSide, dgRightHandSide* const righHandSide, dgJacobian* const internalForces);
+	DG_INLINE void BuildJacobianMatrix(dgJointInfo* const jointInfo, dgLeftHandSide* const leftHandSide, dgRightHandSide* const righHandSide, dgJacobian* const internalForces, dgInt32 jointIndex);
 
 	protected:
 	dgWorld* m_world;
@@ -279,6 +284,8 @@ class dgParallelBodySolver
 	dgInt32 m_soaRowsCount;
 	dgInt32 m_skeletonCount;
 	dgInt32 m_jacobianMatrixRowAtomicIndex;
+	dgInt32 m_skeletonAtomicIndex;
+	dgInt32 m_deterministic;
 	dgInt32* m_soaRowStart;
 	dgInt32* m_bodyRowStart;
 
@@ -287,6 +294,13 @@ class dgParallelBodySolver
 	dgWorkGroupFloat m_zero;
 
 	dgArray<dgSolverSoaElement> m_massMatrix;
+
+	// deterministic mode: each joint writes the forces on its two bodies to its own slots, 
+	// and the bodies add them up in joint order instead of taking a lock per joint.
+	dgArray<dgJacobian> m_jointForces;
+	dgArray<dgInt32> m_bodyJointStart;
+	dgArray<dgInt32> m_bodyJointList;
+	dgArray<dgFloat32> m_groupAccelNorm;
 	friend class dgWorldDynamicUpdate;
 };
 
@@ -309,11 +323,17 @@ DG_INLINE dgParallelBodySolver::dgParallelBodySolver(dgMemoryAllocator* const al
 	,m_soaRowsCount(0)
 	,m_skeletonCount(0)
 	,m_jacobianMatrixRowAtomicIndex(0)
+	,m_skeletonAtomicIndex(0)
+	,m_deterministic(0)
 	,m_soaRowStart(NULL)
 	,m_bodyRowStart(NULL)
 	,m_massMatrix(allocator)
 	,m_one(dgFloat32 (1.0f))
 	,m_zero(dgFloat32 (0.0f))
+	,m_jointForces(allocator)
+	,m_bodyJointStart(allocator)
+	,m_bodyJointList(allocator)
+	,m_groupAccelNorm(allocator)
 {
 	m_skeletonArray[32] = NULL;
 }
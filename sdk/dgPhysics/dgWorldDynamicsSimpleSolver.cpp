@@ -1087,7 +1087,53 @@ dgFloat32 dgWorldDynamicUpdate::CalculateJointForce_3_13(const dgJointInfo* cons
 	return accNorm.GetScalar() * accNorm.GetScalar();
 }
 
-dgFloat32 dgWorldDynamicUpdate::CalculateJointForce(const dgJointInfo* const jointInfo, const dgBodyInfo* const bodyArray, dgJacobian* const internalForces, const dgLeftHandSide* const matrixRow, dgRightHandSide* const rightHandSide) const
+// the row layouts the joint solver can iterate, both hand out the jacobian and the jacobian times the inverse mass of a row
+class dgFullJacobianRows
+{
+	public:
+	dgFullJacobianRows(const dgLeftHandSide* const rows)
+		:m_rows(rows)
+	{
+	}
+
+	DG_INLINE const dgJacobianPair& GetJt(dgInt32 row) const
+	{
+		return m_rows[row].m_Jt;
+	}
+
+	DG_INLINE const dgJacobianPair& GetJMinv(dgInt32 row) const
+	{
+		return m_rows[row].m_JMinv;
+	}
+
+	const dgLeftHandSide* m_rows;
+};
+
+class dgCompactJacobianRows
+{
+	public:
+	dgCompactJacobianRows(const dgJacobianPair* const Jt, const dgJacobianPair* const JMinv)
+		:m_Jt(Jt)
+		,m_JMinv(JMinv)
+	{
+	}
+
+	DG_INLINE const dgJacobianPair& GetJt(dgInt32 row) const
+	{
+		return m_Jt[row];
+	}
+
+	DG_INLINE const dgJacobianPair& GetJMinv(dgInt32 row) const
+	{
+		return m_JMinv[row];
+	}
+
+	const dgJacobianPair* m_Jt;
+	const dgJacobianPair* m_JMinv;
+};
+
+template <class dgJacobianRows>
+dgFloat32 dgWorldDynamicUpdate::CalculateJointForceRows(const dgJointInfo* const jointInfo, const dgBodyInfo* const bodyArray, dgJacobian* const internalForces, const dgJacobianRows& rows, dgRightHandSide* const rightHandSide) const
 {
 	dgVector accNorm(dgVector::m_zero);
 	dgFloat32 normalForce[DG_CONSTRAINT_MAX_ROWS + 4];
@@ -1112,11 +1158,12 @@ dgFloat32 dgWorldDynamicUpdate::CalculateJointForce(const dgJointInfo* const joi
 		const dgInt32 rowStart = jointInfo->m_pairStart;
 		for (dgInt32 j = 0; j < rowsCount; j++) {
 			dgRightHandSide* const rhs = &rightHandSide[rowStart + j];
-			const dgLeftHandSide* const row = &matrixRow[rowStart + j];
-			dgVector a (row->m_JMinv.m_jacobianM0.m_linear * linearM0);
-			a = a.MulAdd(row->m_JMinv.m_jacobianM0.m_angular, angularM0);
-			a = a.MulAdd(row->m_JMinv.m_jacobianM1.m_linear, linearM1);
-			a = a.MulAdd(row->m_JMinv.m_jacobianM1.m_angular, angularM1);
+			const dgJacobianPair& Jt = rows.GetJt(j);
+			const dgJacobianPair& JMinv = rows.GetJMinv(j);
+			dgVector a (JMinv.m_jacobianM0.m_linear * linearM0);
+			a = a.MulAdd(JMinv.m_jacobianM0.m_angular, angularM0);
+			a = a.MulAdd(JMinv.m_jacobianM1.m_linear, linearM1);
+			a = a.MulAdd(JMinv.m_jacobianM1.m_angular, angularM1);
 			a = dgVector(rhs->m_coordenateAccel - rhs->m_force * rhs->m_diagDamp) - a.AddHorizontal();
 
 			dgVector f(rhs->m_force + rhs->m_invJinvMJt * a.GetScalar());
@@ -1139,10 +1186,10 @@ dgFloat32 dgWorldDynamicUpdate::CalculateJointForce(const dgJointInfo* const joi
 
 			dgVector deltaforce0(preconditioner0 * deltaForce);
 			dgVector deltaforce1(preconditioner1 * deltaForce);
-			linearM0 = linearM0.MulAdd(row->m_Jt.m_jacobianM0.m_linear, deltaforce0);
-			angularM0 = angularM0.MulAdd(row->m_Jt.m_jacobianM0.m_angular, deltaforce0);
-			linearM1 = linearM1.MulAdd(row->m_Jt.m_jacobianM1.m_linear, deltaforce1);
-			angularM1 = angularM1.MulAdd(row->m_Jt.m_jacobianM1.m_angular, deltaforce1);
+			linearM0 = linearM0.MulAdd(Jt.m_jacobianM0.m_linear, deltaforce0);
+			angularM0 = angularM0.MulAdd(Jt.m_jacobianM0.m_angular, deltaforce0);
+			linearM1 = linearM1.MulAdd(Jt.m_jacobianM1.m_linear, deltaforce1);
+			angularM1 = angularM1.MulAdd(Jt.m_jacobianM1.m_angular, deltaforce1);
 		}
 
 		dgVector maxAccel(accNorm);
@@ -1152,11 +1199,12 @@ dgFloat32 dgWorldDynamicUpdate::CalculateJointForce(const dgJointInfo* const joi
 			maxAccel = dgVector::m_zero;
 			for (dgInt32 j = 0; j < rowsCount; j++) {
 				dgRightHandSide* const rhs = &rightHandSide[rowStart + j];
-				const dgLeftHandSide* const row = &matrixRow[rowStart + j];
-				dgVector a(row->m_JMinv.m_jacobianM0.m_linear * linearM0);
-				a = a.MulAdd(row->m_JMinv.m_jacobianM0.m_angular, angularM0);
-				a = a.MulAdd(row->m_JMinv.m_jacobianM1.m_linear, linearM1);
-				a = a.MulAdd(row->m_JMinv.m_jacobianM1.m_angular, angularM1);
+				const dgJacobianPair& Jt = rows.GetJt(j);
+				const dgJacobianPair& JMinv = rows.GetJMinv(j);
+				dgVector a(JMinv.m_jacobianM0.m_linear * linearM0);
+				a = a.MulAdd(JMinv.m_jacobianM0.m_angular, angularM0);
+				a = a.MulAdd(JMinv.m_jacobianM1.m_linear, linearM1);
+				a = a.MulAdd(JMinv.m_jacobianM1.m_angular, angularM1);
 				a = dgVector(rhs->m_coordenateAccel - rhs->m_force * rhs->m_diagDamp) - a.AddHorizontal();
 
 				dgVector f(rhs->m_force + rhs->m_invJinvMJt * a.GetScalar());
@@ -1179,10 +1227,10 @@ dgFloat32 dgWorldDynamicUpdate::CalculateJointForce(const dgJointInfo* const joi
 
 				dgVector deltaforce0(preconditioner0 * deltaForce);
 				dgVector deltaforce1(preconditioner1 * deltaForce);
-				linearM0 = linearM0.MulAdd(row->m_Jt.m_jacobianM0.m_linear, deltaforce0);
-				angularM0 = angularM0.MulAdd(row->m_Jt.m_jacobianM0.m_angular, deltaforce0);
-				linearM1 = linearM1.MulAdd(row->m_Jt.m_jacobianM1.m_linear, deltaforce1);
-				angularM1 = angularM1.MulAdd(row->m_Jt.m_jacobianM1.m_angular, deltaforce1);
+				linearM0 = linearM0.MulAdd(Jt.m_jacobianM0.m_linear, deltaforce0);
+				angularM0 = angularM0.MulAdd(Jt.m_jacobianM0.m_angular, deltaforce0);
+				linearM1 = linearM1.MulAdd(Jt.m_jacobianM1.m_linear, deltaforce1);
+				angularM1 = angularM1.MulAdd(Jt.m_jacobianM1.m_angular, deltaforce1);
 			}
 		}
 
@@ -1199,6 +1247,41 @@ dgFloat32 dgWorldDynamicUpdate::CalculateJointForce(const dgJointInfo* const joi
 	return accNorm.GetScalar();
 }
 
+dgFloat32 dgWorldDynamicUpdate::CalculateJointForce(const dgJointInfo* const jointInfo, const dgBodyInfo* const bodyArray, dgJacobian* const internalForces, const dgLeftHandSide* const matrixRow, dgRightHandSide* const rightHandSide) const
+{
+	return CalculateJointForceRows(jointInfo, bodyArray, internalForces, dgFullJacobianRows(&matrixRow[jointInfo->m_pairStart]), rightHandSide);
+}
+
+dgFloat32 dgWorldDynamicUpdate::CalculateJointForceCompact(const dgJointInfo* const jointInfo, const dgBodyInfo* const bodyArray, dgJacobian* const internalForces, const dgJacobianPair* const jacobianRow, dgRightHandSide* const rightHandSide) const
+{
+	dgJacobianPair JMinv[DG_CONSTRAINT_MAX_ROWS];
+
+	const dgInt32 m0 = jointInfo->m_m0;
+	const dgInt32 m1 = jointInfo->m_m1;
+	const dgBody* const body0 = bodyArray[m0].m_body;
+	const dgBody* const body1 = bodyArray[m1].m_body;
+	if (body0->m_resting & body1->m_resting) {
+		return dgFloat32(0.0f);
+	}
+
+	const dgInt32 rowsCount = jointInfo->m_pairCount;
+	const dgJacobianPair* const Jt = &jacobianRow[jointInfo->m_pairStart];
+	dgAssert(rowsCount <= DG_CONSTRAINT_MAX_ROWS);
+
+	// same expressions as BuildJacobianMatrix, so the result is identical to the full row solver
+	const dgVector invMass0(body0->m_invMass[3]);
+	const dgMatrix& invInertia0 = body0->m_invWorldInertiaMatrix;
+	const dgVector invMass1(body1->m_invMass[3]);
+	const dgMatrix& invInertia1 = body1->m_invWorldInertiaMatrix;
+	for (dgInt32 j = 0; j < rowsCount; j++) {
+		JMinv[j].m_jacobianM0.m_linear = Jt[j].m_jacobianM0.m_linear * invMass0;
+		JMinv[j].m_jacobianM0.m_angular = invInertia0.RotateVector(Jt[j].m_jacobianM0.m_angular);
+		JMinv[j].m_jacobianM1.m_linear = Jt[j].m_jacobianM1.m_linear * invMass1;
+		JMinv[j].m_jacobianM1.m_angular = invInertia1.RotateVector(Jt[j].m_jacobianM1.m_angular);
+	}
+	return CalculateJointForceRows(jointInfo, bodyArray, internalForces, dgCompactJacobianRows(Jt, JMinv), rightHandSide);
+}
+
 
 dgJacobian dgWorldDynamicUpdate::IntegrateForceAndToque(dgDynamicBody* const body, const dgVector& force, const dgVector& torque, const dgVector& timestep) const
 {
@@ -1302,6 +1385,22 @@ void dgWorldDynamicUpdate::CalculateClusterReactionForces(const dgBodyCluster* c
 		}
 	}
 
+	const dgJacobianPair* compactRows = NULL;
+	if (m_solverMemory.m_compactJacobianBuffer && !skeletonCount) {
+		// skeletons still read the full rows, otherwise the solver only streams the jacobians 
+		// and rebuilds JMinv from the body inverse mass matrix
+		dgJacobianPair* const jacobianRows = &m_solverMemory.m_compactJacobianBuffer[cluster->m_rowStart];
+		for (dgInt32 i = 0; i < jointCount; i++) {
+			const dgJointInfo* const jointInfo = &constraintArray[i];
+			const dgInt32 first = jointInfo->m_pairStart;
+			const dgInt32 count = jointInfo->m_pairCount;
+			for (dgInt32 j = 0; j < count; j++) {
+				jacobianRows[first + j] = leftHandSide[first + j].m_Jt;
+			}
+		}
+		compactRows = jacobianRows;
+	}
+
 	const dgInt32 passes = world->m_solverIterations;
 	const dgFloat32 maxAccNorm = DG_SOLVER_MAX_ERROR * DG_SOLVER_MAX_ERROR;
 	for (dgInt32 step = 0; step < derivativesEvaluationsRK4; step++) {
@@ -1326,7 +1425,9 @@ void dgWorldDynamicUpdate::CalculateClusterReactionForces(const dgBodyCluster* c
 				//if (!jointInfo->m_joint->IsSkeleton()) 
 				{
 					//dgFloat32 accel2 = CalculateJointForce_3_13(jointInfo, bodyArray, internalForces, leftHandSide);
-					dgFloat32 accel2 = CalculateJointForce(jointInfo, bodyArray, internalForces, leftHandSide, rightHandSide);
+					dgFloat32 accel2 = compactRows ? 
+						CalculateJointForceCompact(jointInfo, bodyArray, internalForces, compactRows, rightHandSide) :
+						CalculateJointForce(jointInfo, bodyArray, internalForces, leftHandSide, rightHandSide);
 					accNorm += accel2;
 				}
 			}
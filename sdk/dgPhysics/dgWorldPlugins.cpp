@@ -27,6 +27,29 @@
 #include <dlfcn.h>
 #include <dirent.h>
 #endif
+
+#if defined (DG_USE_STATIC_SIMD_SOLVERS) && defined (_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+
+bool dgCpuSupportsSimd(dgInt32 leaf, dgInt32 reg, dgInt32 bit, dgUnsigned64 xcr0Mask)
+{
+	int info[4];
+	__cpuidex(info, 0, 0);
+	if (info[0] < leaf) {
+		return false;
+	}
+
+	// osxsave is bit 27 in reg ecx, without it xgetbv is not available and the os does not save the wide registers
+	__cpuidex(info, 1, 0);
+	if (!(info[2] & (1 << 27)) || ((_xgetbv(0) & xcr0Mask) != xcr0Mask)) {
+		return false;
+	}
+
+	__cpuidex(info, leaf, 0);
+	return (info[reg] & (1 << bit)) ? true : false;
+}
+#endif
 	
 
 dgWorldPluginList::dgWorldPluginList(dgMemoryAllocator* const allocator)
@@ -38,6 +61,47 @@ dgWorldPluginList::dgWorldPluginList(dgMemoryAllocator* const allocator)
 
 dgWorldPluginList::~dgWorldPluginList()
 {
+	while (GetFirst()) {
+		dgListNode* const node = GetFirst();
+		dgAssert (!node->GetInfo().m_module);
+		delete node->GetInfo().m_plugin;
+		Remove(node);
+	}
+}
+
+void dgWorldPluginList::AddStaticPlugin(dgWorldPlugin* const plugin)
+{
+	if (plugin) {
+		// static plugins are owned by the list, a null module tells them apart from the shared library ones
+		dgWorldPluginModulePair entry(plugin, NULL);
+		Append(entry);
+	}
+}
+
+void dgWorldPluginList::SelectStaticPlugin()
+{
+	dgInt32 score = 0;
+	m_preferedPlugin = NULL;
+	for (dgListNode* node = GetFirst(); node; node = node->GetNext()) {
+		dgInt32 pluginValue = node->GetInfo().m_plugin->GetScore();
+		if (pluginValue > score) {
+			score = pluginValue;
+			m_preferedPlugin = node;
+		}
+	}
+	m_currentPlugin = m_preferedPlugin;
+}
+
+void dgWorldPluginList::LoadStaticPlugins()
+{
+#ifdef DG_USE_STATIC_SIMD_SOLVERS
+	dgWorld* const world = (dgWorld*) this;
+	AddStaticPlugin(dgCreateAvx512SolverPlugin(world, GetAllocator()));
+	AddStaticPlugin(dgCreateAvx2SolverPlugin(world, GetAllocator()));
+	AddStaticPlugin(dgCreateAvxSolverPlugin(world, GetAllocator()));
+	AddStaticPlugin(dgCreateSse4SolverPlugin(world, GetAllocator()));
+#endif
+	SelectStaticPlugin();
 }
 
 void dgWorldPluginList::LoadVisualStudioPlugins(const char* const plugInPath)
@@ -46,7 +110,7 @@ void dgWorldPluginList::LoadVisualStudioPlugins(const char* const plugInPath)
 	char rootPathInPath[2048];
 	sprintf(rootPathInPath, "%s/*.dll", plugInPath);
 
-	dgInt32 score = 0;
+	dgInt32 score = m_preferedPlugin ? m_preferedPlugin->GetInfo().m_plugin->GetScore() : 0;
 	dgWorld* const world = (dgWorld*) this;
 
 	// scan for all plugins in this folder
@@ -106,7 +170,7 @@ void dgWorldPluginList::LoadLinuxPlugins(const char* const plugInPath)
 	dirent* dirEntry;
 	directory = opendir(plugInPath);
 
-	dgInt32 score = 0;
+	dgInt32 score = m_preferedPlugin ? m_preferedPlugin->GetInfo().m_plugin->GetScore() : 0;
 	dgWorld* const world = (dgWorld*) this;
 	
 	if(directory != NULL) {
@@ -152,21 +216,21 @@ void dgWorldPluginList::LoadPlugins(const char* const path)
 
 void dgWorldPluginList::UnloadPlugins()
 {
-#ifdef _MSC_VER
 	dgWorldPluginList& pluginsList = *this;
-	for (dgWorldPluginList::dgListNode* node = pluginsList.GetFirst(); node; node = node->GetNext()) {
-		HMODULE module = (HMODULE)node->GetInfo().m_module;
-		FreeLibrary(module);
-	}
+	dgWorldPluginList::dgListNode* nextNode;
+	for (dgWorldPluginList::dgListNode* node = pluginsList.GetFirst(); node; node = nextNode) {
+		nextNode = node->GetNext();
+		void* const module = node->GetInfo().m_module;
+		if (module) {
+#ifdef _MSC_VER
+			FreeLibrary((HMODULE)module);
 #elif __linux__
-	dgWorldPluginList& pluginsList = *this;
-	for (dgWorldPluginList::dgListNode* node = pluginsList.GetFirst(); node; node = node->GetNext()) {
-		void* module = node->GetInfo().m_module;
-		dlclose(module);
-	}
+			dlclose(module);
 #endif
-	m_currentPlugin = NULL;
-	m_preferedPlugin = NULL;
+			Remove(node);
+		}
+	}
+	SelectStaticPlugin();
 }
 
 dgWorldPluginList::dgListNode* dgWorldPluginList::GetCurrentPlugin()
@@ -44,6 +44,22 @@ class dgWorldPlugin
 	friend class dgWorld;
 };
 
+#ifdef DG_USE_STATIC_SIMD_SOLVERS
+// solver plugins compiled into the core library, the instruction set is only enabled 
+// for the plugin functions so the rest of the library still runs on any cpu.
+// each one returns NULL when the cpu does not support it.
+dgWorldPlugin* dgCreateSse4SolverPlugin(dgWorld* const world, dgMemoryAllocator* const allocator);
+dgWorldPlugin* dgCreateAvxSolverPlugin(dgWorld* const world, dgMemoryAllocator* const allocator);
+dgWorldPlugin* dgCreateAvx2SolverPlugin(dgWorld* const world, dgMemoryAllocator* const allocator);
+dgWorldPlugin* dgCreateAvx512SolverPlugin(dgWorld* const world, dgMemoryAllocator* const allocator);
+
+#ifdef _MSC_VER
+// true if cpuid reports the feature bit in register reg (0 eax to 3 edx) of the leaf, 
+// and the os saves the register state selected by the xcr0 mask (0x06 ymm, 0xe6 zmm)
+bool dgCpuSupportsSimd(dgInt32 leaf, dgInt32 reg, dgInt32 bit, dgUnsigned64 xcr0Mask);
+#endif
+#endif
+
 #ifdef __cplusplus 
 extern "C"
 {
@@ -72,6 +88,7 @@ class dgWorldPluginList: public dgList<dgWorldPluginModulePair>
 
 	void LoadPlugins(const char* const path);
 	void UnloadPlugins();
+	void LoadStaticPlugins();
 
 	dgListNode* GetFirstPlugin();
 	dgListNode* GetCurrentPlugin();
@@ -83,6 +100,8 @@ class dgWorldPluginList: public dgList<dgWorldPluginModulePair>
 	private:
 	void LoadVisualStudioPlugins(const char* const path);
 	void LoadLinuxPlugins(const char* const path);
+	void AddStaticPlugin(dgWorldPlugin* const plugin);
+	void SelectStaticPlugin();
 
 	dgListNode* m_currentPlugin;
 	dgListNode* m_preferedPlugin;
@@ -0,0 +1,672 @@
+/* Copyright (c) <2003-2019> <Julio Jerez, Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "dgPhysicsStdafx.h"
+#include "dgBody.h"
+#include "dgWorld.h"
+#include "dgCollisionInstance.h"
+
+#ifdef DG_USE_ZLIB
+#include <zlib.h>
+#endif
+
+// scene file: header, table of contents, then the chunks.
+// every chunk is a self contained serialization stream that starts with a marker,
+// so shape and body chunks can be decompressed and decoded independently of each other.
+#define DG_SCENE_FILE_MAGIC			0x4e435344
+#define DG_SCENE_FILE_VERSION		1
+#define DG_SCENE_SHAPES_PER_CHUNK	256
+#define DG_SCENE_BODIES_PER_CHUNK	2048
+
+class dgSceneFileHeader
+{
+	public:
+	dgInt32 m_magic;
+	dgInt32 m_version;
+	dgInt32 m_chunkCount;
+	dgInt32 m_shapeCount;
+	dgInt32 m_bodyCount;
+	dgInt32 m_reserved[3];
+};
+
+class dgSceneFileChunk
+{
+	public:
+	enum dgChunkType
+	{
+		m_serialShapes,
+		m_shapes,
+		m_bodies,
+		m_joints,
+		m_chunkTypes,
+	};
+
+	dgInt64 m_offset;
+	dgInt32 m_type;
+	dgInt32 m_firstItem;
+	dgInt32 m_itemCount;
+	dgInt32 m_storedSize;
+	dgInt32 m_rawSize;
+	dgInt32 m_compressed;
+};
+
+class dgSceneChunkWriter
+{
+	public:
+	dgSceneChunkWriter(dgMemoryAllocator* const allocator, dgInt32 type, dgInt32 firstItem)
+		:m_data(allocator)
+		,m_packed(allocator)
+		,m_type(type)
+		,m_firstItem(firstItem)
+		,m_itemCount(0)
+		,m_size(0)
+		,m_packedSize(0)
+	{
+		dgSerializeMarker(Write, this);
+	}
+
+	static void Write(void* const handle, const void* const buffer, dgInt32 size)
+	{
+		dgSceneChunkWriter* const me = (dgSceneChunkWriter*)handle;
+		me->m_data.ResizeIfNecessary(me->m_size + size);
+		memcpy(&me->m_data[me->m_size], buffer, size);
+		me->m_size += size;
+	}
+
+	void Patch(dgInt32 offset, dgInt32 value)
+	{
+		memcpy(&m_data[offset], &value, sizeof(value));
+	}
+
+	void Compress(dgInt32 level)
+	{
+		m_packedSize = 0;
+#ifdef DG_USE_ZLIB
+		uLongf packedSize = compressBound(uLong(m_size));
+		m_packed.ResizeIfNecessary(dgInt32(packedSize));
+		if (compress2(&m_packed[0], &packedSize, &m_data[0], uLong(m_size), level) == Z_OK) {
+			// keep the chunk raw when it does not shrink
+			if (packedSize < uLongf(m_size)) {
+				m_packedSize = dgInt32(packedSize);
+			}
+		}
+#endif
+	}
+
+	dgArray<dgUnsigned8> m_data;
+	dgArray<dgUnsigned8> m_packed;
+	dgInt32 m_type;
+	dgInt32 m_firstItem;
+	dgInt32 m_itemCount;
+	dgInt32 m_size;
+	dgInt32 m_packedSize;
+
+	DG_CLASS_ALLOCATOR(allocator)
+};
+
+class dgSceneChunkReader
+{
+	public:
+	dgSceneChunkReader(const dgUnsigned8* const data, dgInt32 size)
+		:m_data(data)
+		,m_size(size)
+		,m_position(0)
+		,m_error(false)
+	{
+	}
+
+	static void Read(void* const handle, void* const buffer, dgInt32 size)
+	{
+		dgSceneChunkReader* const me = (dgSceneChunkReader*)handle;
+		if ((me->m_position + size) > me->m_size) {
+			// a truncated chunk reads as end markers, so marker searches stop instead of running off the buffer
+			me->m_error = true;
+			dgInt32* const ptr = (dgInt32*)buffer;
+			for (dgInt32 i = 0; i < size / dgInt32(sizeof(dgInt32)); i++) {
+				ptr[i] = 0x646e6520;
+			}
+			me->m_position = me->m_size;
+			return;
+		}
+		memcpy(buffer, &me->m_data[me->m_position], size);
+		me->m_position += size;
+	}
+
+	const dgUnsigned8* m_data;
+	dgInt32 m_size;
+	dgInt32 m_position;
+	bool m_error;
+};
+
+class dgSceneShapeEntry
+{
+	public:
+	dgCollisionInstance* m_instance;
+	dgInt32 m_id;
+};
+
+class dgSceneBodyEntry
+{
+	public:
+	dgBody* m_body;
+	dgInt32 m_chunk;
+	dgInt32 m_userDataOffset;
+	dgInt32 m_userDataSize;
+};
+
+class dgSceneFileLoader
+{
+	public:
+	dgSceneFileLoader(dgWorld* const world, const dgSceneFileChunk* const toc, const dgSceneFileHeader& header)
+		:m_world(world)
+		,m_toc(toc)
+		,m_chunkData(world->GetAllocator())
+		,m_packedData(world->GetAllocator())
+		,m_shapes(world->GetAllocator())
+		,m_bodies(world->GetAllocator())
+		,m_shapeMap(world->GetAllocator())
+		,m_chunkCount(header.m_chunkCount)
+		,m_shapeCount(header.m_shapeCount)
+		,m_bodyCount(header.m_bodyCount)
+		,m_phase(0)
+		,m_atomicCounter(0)
+		,m_error(0)
+	{
+		m_chunkData.ResizeIfNecessary(m_chunkCount);
+		m_packedData.ResizeIfNecessary(m_chunkCount);
+		m_shapes.ResizeIfNecessary(m_shapeCount);
+		m_bodies.ResizeIfNecessary(m_bodyCount);
+		for (dgInt32 i = 0; i < m_chunkCount; i++) {
+			m_chunkData[i] = NULL;
+			m_packedData[i] = NULL;
+		}
+		for (dgInt32 i = 0; i < m_shapeCount; i++) {
+			m_shapes[i].m_instance = NULL;
+		}
+		for (dgInt32 i = 0; i < m_bodyCount; i++) {
+			m_bodies[i].m_body = NULL;
+		}
+	}
+
+	~dgSceneFileLoader()
+	{
+		dgMemoryAllocator* const allocator = m_world->GetAllocator();
+		for (dgInt32 i = 0; i < m_shapeCount; i++) {
+			if (m_shapes[i].m_instance) {
+				m_shapes[i].m_instance->Release();
+			}
+		}
+		for (dgInt32 i = 0; i < m_bodyCount; i++) {
+			// bodies that never made it into the world
+			dgBody* const body = m_bodies[i].m_body;
+			if (body) {
+				body->GetCollision()->Release();
+				delete body;
+			}
+		}
+		dgTree<const dgCollision*, dgInt32>::Iterator iter(m_shapeMap);
+		for (iter.Begin(); iter; iter++) {
+			iter.GetNode()->GetInfo()->Release();
+		}
+		for (dgInt32 i = 0; i < m_chunkCount; i++) {
+			if (m_chunkData[i]) {
+				allocator->FreeLow(m_chunkData[i]);
+			}
+			if (m_packedData[i]) {
+				allocator->FreeLow(m_packedData[i]);
+			}
+		}
+	}
+
+	bool ReadChunks(FILE* const file, long start)
+	{
+		dgMemoryAllocator* const allocator = m_world->GetAllocator();
+		for (dgInt32 i = 0; i < m_chunkCount; i++) {
+			const dgSceneFileChunk& chunk = m_toc[i];
+			if ((chunk.m_type < 0) || (chunk.m_type >= dgSceneFileChunk::m_chunkTypes) || (chunk.m_rawSize <= 0) || (chunk.m_storedSize <= 0)) {
+				return false;
+			}
+			if ((chunk.m_firstItem < 0) || (chunk.m_itemCount < 0)) {
+				return false;
+			}
+			if ((chunk.m_type == dgSceneFileChunk::m_bodies) && ((chunk.m_firstItem + chunk.m_itemCount) > m_bodyCount)) {
+				return false;
+			}
+			if ((chunk.m_type <= dgSceneFileChunk::m_shapes) && ((chunk.m_firstItem + chunk.m_itemCount) > m_shapeCount)) {
+				return false;
+			}
+#ifndef DG_USE_ZLIB
+			if (chunk.m_compressed) {
+				return false;
+			}
+#endif
+			m_chunkData[i] = (dgUnsigned8*)allocator->MallocLow(chunk.m_rawSize);
+			dgUnsigned8* const dst = chunk.m_compressed ? (m_packedData[i] = (dgUnsigned8*)allocator->MallocLow(chunk.m_storedSize)) : m_chunkData[i];
+			if (fseek(file, long(start + chunk.m_offset), SEEK_SET) || (fread(dst, chunk.m_storedSize, 1, file) != 1)) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void DecodeChunk(dgInt32 index)
+	{
+		const dgSceneFileChunk& chunk = m_toc[index];
+		if (m_phase == -1) {
+#ifdef DG_USE_ZLIB
+			if (chunk.m_compressed) {
+				uLongf rawSize = uLongf(chunk.m_rawSize);
+				if ((uncompress(m_chunkData[index], &rawSize, m_packedData[index], uLong(chunk.m_storedSize)) != Z_OK) || (rawSize != uLongf(chunk.m_rawSize))) {
+					m_error = 1;
+				}
+			}
+#endif
+			return;
+		}
+
+		if (chunk.m_type != m_phase) {
+			return;
+		}
+
+		dgSceneChunkReader reader(m_chunkData[index], chunk.m_rawSize);
+		const dgInt32 revision = dgDeserializeMarker(dgSceneChunkReader::Read, &reader);
+		switch (chunk.m_type)
+		{
+			case dgSceneFileChunk::m_serialShapes:
+			case dgSceneFileChunk::m_shapes:
+			{
+				dgMemoryAllocator* const allocator = m_world->GetAllocator();
+				for (dgInt32 i = 0; (i < chunk.m_itemCount) && !reader.m_error; i++) {
+					dgSceneShapeEntry& entry = m_shapes[chunk.m_firstItem + i];
+					dgSceneChunkReader::Read(&reader, &entry.m_id, sizeof(entry.m_id));
+					entry.m_instance = new (allocator) dgCollisionInstance(m_world, dgSceneChunkReader::Read, &reader, revision);
+					dgDeserializeMarker(dgSceneChunkReader::Read, &reader);
+				}
+				break;
+			}
+
+			case dgSceneFileChunk::m_bodies:
+			{
+				for (dgInt32 i = 0; (i < chunk.m_itemCount) && !reader.m_error; i++) {
+					dgInt32 bodyType;
+					dgSceneBodyEntry& entry = m_bodies[chunk.m_firstItem + i];
+					dgSceneChunkReader::Read(&reader, &bodyType, sizeof(bodyType));
+					if ((bodyType != dgBody::m_dynamicBody) && (bodyType != dgBody::m_kinematicBody) && (bodyType != dgBody::m_dynamicBodyAsymatric)) {
+						reader.m_error = true;
+						break;
+					}
+					entry.m_body = m_world->CreateDeserializedBody(bodyType, m_shapeMap, dgSceneChunkReader::Read, &reader, revision);
+					dgSceneChunkReader::Read(&reader, &entry.m_userDataSize, sizeof(entry.m_userDataSize));
+					entry.m_chunk = index;
+					entry.m_userDataOffset = reader.m_position;
+					if ((entry.m_userDataSize < 0) || ((reader.m_position + entry.m_userDataSize) > reader.m_size)) {
+						reader.m_error = true;
+						break;
+					}
+					reader.m_position += entry.m_userDataSize;
+					dgDeserializeMarker(dgSceneChunkReader::Read, &reader);
+				}
+				break;
+			}
+
+			default:;
+		}
+
+		if (reader.m_error) {
+			m_error = 1;
+		}
+	}
+
+	static void DecodeChunksKernel(void* const context, void* const worldContext, dgInt32 threadID)
+	{
+		dgSceneFileLoader* const me = (dgSceneFileLoader*)context;
+		for (dgInt32 i = dgAtomicExchangeAndAdd(&me->m_atomicCounter, 1); i < me->m_chunkCount; i = dgAtomicExchangeAndAdd(&me->m_atomicCounter, 1)) {
+			me->DecodeChunk(i);
+		}
+	}
+
+	bool DecodeChunks(dgInt32 phase, bool parallel)
+	{
+		m_phase = phase;
+		m_atomicCounter = 0;
+		dgThreadHive* const threadPool = parallel ? m_world->AcquireIdleThreadPool() : NULL;
+		const dgInt32 threadCount = threadPool ? threadPool->GetThreadCount() : 1;
+		if (threadCount > 1) {
+			for (dgInt32 i = 0; i < threadCount; i++) {
+				threadPool->QueueJob(DecodeChunksKernel, this, NULL, "dgWorld::LoadSceneFile");
+			}
+			threadPool->SynchronizationBarrier();
+		} else {
+			DecodeChunksKernel(this, NULL, 0);
+		}
+		m_world->ReleaseIdleThreadPool(threadPool);
+		return !m_error;
+	}
+
+	void BuildShapeMap()
+	{
+		for (dgInt32 i = 0; i < m_shapeCount; i++) {
+			dgSceneShapeEntry& entry = m_shapes[i];
+			if (entry.m_instance) {
+				const dgCollision* const shape = entry.m_instance->GetChildShape();
+				if (m_shapeMap.Insert(shape, entry.m_id)) {
+					shape->AddRef();
+				}
+				entry.m_instance->Release();
+				entry.m_instance = NULL;
+			}
+		}
+	}
+
+	bool HasChunk(dgInt32 type) const
+	{
+		for (dgInt32 i = 0; i < m_chunkCount; i++) {
+			if (m_toc[i].m_type == type) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	dgWorld* m_world;
+	const dgSceneFileChunk* m_toc;
+	dgArray<dgUnsigned8*> m_chunkData;
+	dgArray<dgUnsigned8*> m_packedData;
+	dgArray<dgSceneShapeEntry> m_shapes;
+	dgArray<dgSceneBodyEntry> m_bodies;
+	dgTree<const dgCollision*, dgInt32> m_shapeMap;
+	dgInt32 m_chunkCount;
+	dgInt32 m_shapeCount;
+	dgInt32 m_bodyCount;
+	dgInt32 m_phase;
+	dgInt32 m_atomicCounter;
+	dgInt32 m_error;
+};
+
+class dgSceneFileCompressor
+{
+	public:
+	dgSceneChunkWriter** m_chunks;
+	dgInt32 m_chunkCount;
+	dgInt32 m_level;
+	dgInt32 m_atomicCounter;
+
+	static void CompressChunksKernel(void* const context, void* const worldContext, dgInt32 threadID)
+	{
+		dgSceneFileCompressor* const me = (dgSceneFileCompressor*)context;
+		for (dgInt32 i = dgAtomicExchangeAndAdd(&me->m_atomicCounter, 1); i < me->m_chunkCount; i = dgAtomicExchangeAndAdd(&me->m_atomicCounter, 1)) {
+			me->m_chunks[i]->Compress(me->m_level);
+		}
+	}
+};
+
+static bool dgSceneShapeIsThreadSafe(const dgCollision* const shape)
+{
+	// analytic convex shapes share static edge tables that are built on first use, and compounds
+	// and scenes can contain them, so only self contained shapes are decoded by the worker threads.
+	switch (shape->GetCollisionPrimityType())
+	{
+		case m_convexHullCollision:
+		case m_boundingBoxHierachy:
+		case m_heightField:
+			return true;
+		default:
+			return false;
+	}
+}
+
+void dgWorld::SetSceneFileCompression(dgInt32 level)
+{
+	m_sceneFileCompression = dgClamp(level, 0, 9);
+}
+
+dgInt32 dgWorld::GetSceneFileCompression() const
+{
+	return m_sceneFileCompression;
+}
+
+bool dgWorld::SaveSceneFile(void* const fileHandle, void* const userData, OnBodySerialize bodyCallback) const
+{
+	FILE* const file = (FILE*)fileHandle;
+	bodyCallback = bodyCallback ? bodyCallback : OnBodySerializeToFile;
+
+	dgInt32 count = 0;
+	dgArray<dgBody*> bodyArray(GetAllocator());
+	const dgBodyMasterList& me = *this;
+	bodyArray.ResizeIfNecessary(GetBodiesCount());
+	for (dgBodyMasterList::dgListNode* node = me.GetFirst()->GetNext(); node; node = node->GetNext()) {
+		dgBody* const body = node->GetInfo().GetBody();
+		body->m_serializedEnum = count;
+		bodyArray[count] = body;
+		count++;
+	}
+	dgSortIndirect(&bodyArray[0], count, SerializeToFileSort);
+
+	dgInt32 shapeCount = 0;
+	dgTree<dgInt32, const dgCollision*> shapeMap(GetAllocator());
+	for (dgInt32 i = 0; i < count; i++) {
+		const dgCollision* const collision = bodyArray[i]->GetCollision()->GetChildShape();
+		if (shapeMap.Insert(shapeCount, collision)) {
+			shapeCount++;
+		}
+	}
+
+	dgInt32 chunkCount = 0;
+	dgArray<dgSceneChunkWriter*> chunks(GetAllocator());
+
+	dgInt32 shapeIndex = 0;
+	for (dgInt32 type = dgSceneFileChunk::m_serialShapes; type <= dgSceneFileChunk::m_shapes; type++) {
+		dgSceneChunkWriter* chunk = NULL;
+		dgTree<dgInt32, const dgCollision*>::Iterator iter(shapeMap);
+		for (iter.Begin(); iter; iter++) {
+			const dgCollision* const collision = iter.GetKey();
+			if (dgSceneShapeIsThreadSafe(collision) != (type == dgSceneFileChunk::m_shapes)) {
+				continue;
+			}
+			if (!chunk || (chunk->m_itemCount == DG_SCENE_SHAPES_PER_CHUNK)) {
+				chunk = new (GetAllocator()) dgSceneChunkWriter(GetAllocator(), type, shapeIndex);
+				chunks[chunkCount] = chunk;
+				chunkCount++;
+			}
+			dgInt32 id = iter.GetNode()->GetInfo();
+			dgCollisionInstance instance(this, collision, 0, dgMatrix(dgGetIdentityMatrix()));
+			dgSceneChunkWriter::Write(chunk, &id, sizeof(id));
+			instance.Serialize(dgSceneChunkWriter::Write, chunk);
+			dgSerializeMarker(dgSceneChunkWriter::Write, chunk);
+			chunk->m_itemCount++;
+			shapeIndex++;
+		}
+	}
+
+	dgSceneChunkWriter* bodyChunk = NULL;
+	for (dgInt32 i = 0; i < count; i++) {
+		if (!bodyChunk || (bodyChunk->m_itemCount == DG_SCENE_BODIES_PER_CHUNK)) {
+			bodyChunk = new (GetAllocator()) dgSceneChunkWriter(GetAllocator(), dgSceneFileChunk::m_bodies, i);
+			chunks[chunkCount] = bodyChunk;
+			chunkCount++;
+		}
+		dgBody* const body = bodyArray[i];
+		dgInt32 bodyType = body->GetType();
+		dgSceneChunkWriter::Write(bodyChunk, &bodyType, sizeof(bodyType));
+		body->Serialize(shapeMap, dgSceneChunkWriter::Write, bodyChunk);
+
+		// the size of the user data lets the loader decode bodies without calling back into the application
+		dgInt32 userDataSize = 0;
+		dgSceneChunkWriter::Write(bodyChunk, &userDataSize, sizeof(userDataSize));
+		const dgInt32 userDataOffset = bodyChunk->m_size;
+		bodyCallback(*body, userData, dgSceneChunkWriter::Write, bodyChunk);
+		bodyChunk->Patch(userDataOffset - sizeof(userDataSize), bodyChunk->m_size - userDataOffset);
+
+		dgSerializeMarker(dgSceneChunkWriter::Write, bodyChunk);
+		bodyChunk->m_itemCount++;
+	}
+
+	dgSceneChunkWriter* const jointChunk = new (GetAllocator()) dgSceneChunkWriter(GetAllocator(), dgSceneFileChunk::m_joints, 0);
+	chunks[chunkCount] = jointChunk;
+	chunkCount++;
+	SerializeJointArray(count, dgSceneChunkWriter::Write, jointChunk);
+
+	for (dgBodyMasterList::dgListNode* node = me.GetFirst()->GetNext(); node; node = node->GetNext()) {
+		node->GetInfo().GetBody()->m_serializedEnum = -1;
+	}
+
+#ifdef DG_USE_ZLIB
+	if (m_sceneFileCompression) {
+		dgSceneFileCompressor compressor;
+		compressor.m_chunks = &chunks[0];
+		compressor.m_chunkCount = chunkCount;
+		compressor.m_level = m_sceneFileCompression;
+		compressor.m_atomicCounter = 0;
+		dgWorld* const world = (dgWorld*)this;
+		dgThreadHive* const threadPool = world->AcquireIdleThreadPool();
+		if (threadPool) {
+			const dgInt32 threadCount = threadPool->GetThreadCount();
+			for (dgInt32 i = 0; i < threadCount; i++) {
+				threadPool->QueueJob(dgSceneFileCompressor::CompressChunksKernel, &compressor, NULL, "dgWorld::SaveSceneFile");
+			}
+			threadPool->SynchronizationBarrier();
+		} else {
+			dgSceneFileCompressor::CompressChunksKernel(&compressor, NULL, 0);
+		}
+		world->ReleaseIdleThreadPool(threadPool);
+	}
+#endif
+
+	dgSceneFileHeader header;
+	memset(&header, 0, sizeof(header));
+	header.m_magic = DG_SCENE_FILE_MAGIC;
+	header.m_version = DG_SCENE_FILE_VERSION;
+	header.m_chunkCount = chunkCount;
+	header.m_shapeCount = shapeCount;
+	header.m_bodyCount = count;
+
+	dgStack<dgSceneFileChunk> toc(chunkCount);
+	dgInt64 offset = sizeof(dgSceneFileHeader) + chunkCount * sizeof(dgSceneFileChunk);
+	for (dgInt32 i = 0; i < chunkCount; i++) {
+		const dgSceneChunkWriter* const chunk = chunks[i];
+		toc[i].m_offset = offset;
+		toc[i].m_type = chunk->m_type;
+		toc[i].m_firstItem = chunk->m_firstItem;
+		toc[i].m_itemCount = chunk->m_itemCount;
+		toc[i].m_rawSize = chunk->m_size;
+		toc[i].m_compressed = chunk->m_packedSize ? 1 : 0;
+		toc[i].m_storedSize = chunk->m_packedSize ? chunk->m_packedSize : chunk->m_size;
+		offset += toc[i].m_storedSize;
+	}
+
+	bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+	ok = ok && (fwrite(&toc[0], sizeof(dgSceneFileChunk) * chunkCount, 1, file) == 1);
+	for (dgInt32 i = 0; i < chunkCount; i++) {
+		dgSceneChunkWriter* const chunk = chunks[i];
+		const dgUnsigned8* const data = chunk->m_packedSize ? &chunk->m_packed[0] : &chunk->m_data[0];
+		ok = ok && (fwrite(data, toc[i].m_storedSize, 1, file) == 1);
+		delete chunk;
+	}
+	return ok;
+}
+
+bool dgWorld::LoadSceneFile(void* const fileHandle, void* const userData, OnBodyDeserialize bodyCallback)
+{
+	FILE* const file = (FILE*)fileHandle;
+	bodyCallback = bodyCallback ? bodyCallback : OnBodyDeserializeFromFile;
+
+	dgSceneFileHeader header;
+	const long start = ftell(file);
+	if ((fread(&header, sizeof(header), 1, file) != 1) || (header.m_magic != DG_SCENE_FILE_MAGIC)) {
+		// files saved before the chunked format are a plain serialization stream
+		fseek(file, start, SEEK_SET);
+		DeserializeScene(userData, bodyCallback, OnDeserializeFromFile, file);
+		return true;
+	}
+
+	if ((header.m_version != DG_SCENE_FILE_VERSION) || (header.m_chunkCount <= 0) || (header.m_shapeCount < 0) || (header.m_bodyCount < 0)) {
+		return false;
+	}
+
+	dgStack<dgSceneFileChunk> toc(header.m_chunkCount);
+	if (fread(&toc[0], sizeof(dgSceneFileChunk) * header.m_chunkCount, 1, file) != 1) {
+		return false;
+	}
+
+	dgSceneFileLoader loader(this, &toc[0], header);
+	if (!loader.ReadChunks(file, start)) {
+		return false;
+	}
+
+	// decompression and the self contained shapes go wide, everything that touches shared state stays on this thread
+	if (!loader.DecodeChunks(-1, true)) {
+		return false;
+	}
+	if (!loader.DecodeChunks(dgSceneFileChunk::m_serialShapes, false)) {
+		return false;
+	}
+	if (!loader.DecodeChunks(dgSceneFileChunk::m_shapes, true)) {
+		return false;
+	}
+	loader.BuildShapeMap();
+	if (!loader.DecodeChunks(dgSceneFileChunk::m_bodies, true)) {
+		return false;
+	}
+
+	// every body must fill a distinct slot of the body map before any of them goes into the world, 
+	// a failed load leaves the world untouched and the loader deletes the decoded bodies
+	dgArray<dgBody*> bodyMap(GetAllocator());
+	bodyMap.ResizeIfNecessary(header.m_bodyCount);
+	for (dgInt32 i = 0; i < header.m_bodyCount; i++) {
+		bodyMap[i] = NULL;
+	}
+	for (dgInt32 i = 0; i < header.m_bodyCount; i++) {
+		dgBody* const body = loader.m_bodies[i].m_body;
+		if (!body) {
+			return false;
+		}
+		const dgInt32 index = body->m_serializedEnum;
+		if ((index < 0) || (index >= header.m_bodyCount) || bodyMap[index]) {
+			return false;
+		}
+		bodyMap[index] = body;
+	}
+
+	for (dgInt32 i = 0; i < header.m_bodyCount; i++) {
+		dgSceneBodyEntry& entry = loader.m_bodies[i];
+		dgBody* const body = entry.m_body;
+		entry.m_body = NULL;
+		InsertDeserializedBody(body);
+
+		// user data reads are clipped to the user data of this body
+		dgSceneChunkReader reader(loader.m_chunkData[entry.m_chunk] + entry.m_userDataOffset, entry.m_userDataSize);
+		bodyCallback(*body, userData, dgSceneChunkReader::Read, &reader);
+	}
+
+	for (dgInt32 i = 0; i < header.m_chunkCount; i++) {
+		if (toc[i].m_type == dgSceneFileChunk::m_joints) {
+			dgSceneChunkReader reader(loader.m_chunkData[i], toc[i].m_rawSize);
+			dgDeserializeMarker(dgSceneChunkReader::Read, &reader);
+			DeserializeJointArray(bodyMap, dgSceneChunkReader::Read, &reader);
+		}
+	}
+
+	const dgBodyMasterList& me = *this;
+	for (dgBodyMasterList::dgListNode* node = me.GetFirst()->GetNext(); node; node = node->GetNext()) {
+		node->GetInfo().GetBody()->m_serializedEnum = -1;
+	}
+	return true;
+}
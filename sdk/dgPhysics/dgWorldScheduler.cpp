@@ -0,0 +1,246 @@
+/* Copyright (c) <2003-2019> <Julio Jerez, Newton Game Dynamics>
+* 
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* 
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "dgPhysicsStdafx.h"
+#include "dgWorld.h"
+#include "dgWorldScheduler.h"
+
+// worlds below this many bodies and contacts are never split across workers,
+// the barriers between the stages would cost more than the work they share
+#define DG_SCHEDULER_MIN_SPLIT_COST		256
+
+dgWorldScheduler::dgWorldScheduler(dgMemoryAllocator* const allocator, dgInt32 threadCount)
+	:dgMutexThread("newtonSchedulerThread", 0)
+	,dgThreadHive(allocator)
+	,m_allocator(allocator)
+	,m_worlds(allocator)
+	,m_entries(allocator, 64)
+	,m_updateWorlds(NULL)
+	,m_updateCount(0)
+	,m_packedStart(0)
+	,m_lock(0)
+	,m_updateSemaphore()
+{
+	dgMutexThread* const myThread = this;
+	SetParentThread(myThread);
+	SetThreadsCount(threadCount);
+	m_updateSemaphore.Release();
+}
+
+dgWorldScheduler::~dgWorldScheduler()
+{
+	dgMutexThread::Terminate();
+	for (dgList<dgWorld*>::dgListNode* node = m_worlds.GetFirst(); node; node = node->GetNext()) {
+		dgWorld* const world = node->GetInfo();
+		world->m_scheduler = NULL;
+	}
+	m_worlds.RemoveAll();
+}
+
+void dgWorldScheduler::AddWorld(dgWorld* const world)
+{
+	dgScopeSpinPause lock(&m_lock);
+	m_worlds.Append(world);
+}
+
+void dgWorldScheduler::RemoveWorld(dgWorld* const world)
+{
+	dgScopeSpinPause lock(&m_lock);
+	m_worlds.Remove(world);
+}
+
+dgInt32 dgWorldScheduler::EstimateCost(const dgWorld* const world)
+{
+	const dgBodyMasterList& bodyList = *world;
+	const dgContactList& contactList = *world;
+	return bodyList.GetCount() + contactList.m_contactCount;
+}
+
+dgInt32 dgWorldScheduler::CompareEntries(const dgWorldEntry* const entryA, const dgWorldEntry* const entryB, void* const context)
+{
+	if (entryA->m_cost > entryB->m_cost) {
+		return -1;
+	} else if (entryA->m_cost < entryB->m_cost) {
+		return 1;
+	}
+	return 0;
+}
+
+bool dgWorldScheduler::AcquireIdleWorkers()
+{
+	if (m_updateSemaphore.TryWait()) {
+		BeginSection();
+		return true;
+	}
+	return false;
+}
+
+void dgWorldScheduler::ReleaseIdleWorkers()
+{
+	EndSection();
+	m_updateSemaphore.Release();
+}
+
+void dgWorldScheduler::Update(dgWorld** const worlds, dgInt32 count, dgFloat32 timestep)
+{
+	// a step can take several milliseconds, updates from other threads and borrowed workers sleep until it is done
+	m_updateSemaphore.Wait();
+	for (dgInt32 i = 0; i < count; i++) {
+		dgWorld* const world = worlds[i];
+		dgAssert(world->m_scheduler == this);
+		world->Sync();
+		world->m_savetimestep = timestep;
+	}
+
+	m_updateWorlds = worlds;
+	m_updateCount = count;
+	#ifdef DG_USE_THREAD_EMULATION
+		dgFloatExceptions exception;
+		dgSetPrecisionDouble precision;
+		RunStep();
+	#else
+		dgMutexThread::Tick();
+	#endif
+	m_updateWorlds = NULL;
+	m_updateCount = 0;
+	m_updateSemaphore.Release();
+}
+
+void dgWorldScheduler::TickCallback(dgInt32 threadID)
+{
+	RunStep();
+}
+
+void dgWorldScheduler::RunStep()
+{
+	D_TRACKTIME();
+	const dgInt32 threadCount = GetThreadCount();
+
+	dgInt32 totalCost = 0;
+	m_entries.ResizeIfNecessary(m_updateCount);
+	dgWorldEntry* const entries = &m_entries[0];
+	for (dgInt32 i = 0; i < m_updateCount; i++) {
+		entries[i].m_world = m_updateWorlds[i];
+		entries[i].m_cost = EstimateCost(m_updateWorlds[i]);
+		entries[i].m_bin = -1;
+		totalCost += entries[i].m_cost;
+	}
+	dgSort(entries, m_updateCount, CompareEntries);
+
+	// a world heavier than the average load of a worker would hold back the whole batch, 
+	// these are stepped one at a time with all the workers
+	dgInt32 start = 0;
+	if (threadCount > 1) {
+		const dgInt32 splitCost = dgMax(totalCost / threadCount, DG_SCHEDULER_MIN_SPLIT_COST);
+		for (; (start < m_updateCount) && (entries[start].m_cost >= splitCost); start++) {
+			dgWorld* const world = entries[start].m_world;
+			world->SetSharedHive(this);
+			world->RunStep();
+			world->SetSharedHive(NULL);
+		}
+	}
+
+	if (start < m_updateCount) {
+		// the rest go, heaviest first, to the least loaded worker, which steps its worlds one after the other
+		dgInt32 binCost[DG_MAX_THREADS_HIVE_COUNT];
+		for (dgInt32 i = 0; i < threadCount; i++) {
+			binCost[i] = 0;
+		}
+		for (dgInt32 i = start; i < m_updateCount; i++) {
+			dgInt32 bin = 0;
+			for (dgInt32 j = 1; j < threadCount; j++) {
+				bin = (binCost[j] < binCost[bin]) ? j : bin;
+			}
+			entries[i].m_bin = bin;
+			binCost[bin] += entries[i].m_cost + 1;
+		}
+
+		m_packedStart = start;
+		BeginSection();
+		for (dgInt32 i = 0; i < threadCount; i++) {
+			QueueJob(StepBinKernel, this, NULL, "dgWorldScheduler::StepBin");
+		}
+		SynchronizationBarrier();
+		EndSection();
+	}
+}
+
+void dgWorldScheduler::StepBinKernel(void* const context, void* const worldContext, dgInt32 threadID)
+{
+	D_TRACKTIME();
+	dgWorldScheduler* const me = (dgWorldScheduler*)context;
+	me->StepBin(threadID);
+}
+
+void dgWorldScheduler::StepBin(dgInt32 bin)
+{
+	const dgWorldEntry* const entries = &m_entries[0];
+	for (dgInt32 i = m_packedStart; i < m_updateCount; i++) {
+		if (entries[i].m_bin == bin) {
+			entries[i].m_world->RunStep();
+		}
+	}
+}
+
+void dgWorldScheduler::UpdateWorlds(dgWorld** const worlds, dgInt32 count, dgFloat32 timestep)
+{
+	if (count <= 0) {
+		return;
+	}
+
+	// a world listed twice would be stepped twice at the same time by two packed bins, keep only the first entry
+	dgStack<dgWorld*> pendingPool(count);
+	dgWorld** pending = &pendingPool[0];
+	dgInt32 uniqueCount = 0;
+	for (dgInt32 i = 0; i < count; i++) {
+		bool duplicated = false;
+		for (dgInt32 j = 0; (j < uniqueCount) && !duplicated; j++) {
+			duplicated = (pending[j] == worlds[i]);
+		}
+		if (!duplicated) {
+			pending[uniqueCount] = worlds[i];
+			uniqueCount++;
+		}
+	}
+	count = uniqueCount;
+
+	while (count) {
+		// move the worlds sharing the scheduler of the first pending world to the front
+		dgWorldScheduler* const scheduler = pending[0]->m_scheduler;
+		dgInt32 groupCount = 0;
+		for (dgInt32 i = 0; i < count; i++) {
+			if (pending[i]->m_scheduler == scheduler) {
+				dgSwap(pending[i], pending[groupCount]);
+				groupCount++;
+			}
+		}
+
+		if (scheduler) {
+			scheduler->Update(pending, groupCount, timestep);
+		} else {
+			for (dgInt32 i = 0; i < groupCount; i++) {
+				pending[i]->Update(timestep);
+			}
+		}
+		pending += groupCount;
+		count -= groupCount;
+	}
+}
@@ -0,0 +1,83 @@
+/* Copyright (c) <2003-2019> <Julio Jerez, Newton Game Dynamics>
+* 
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* 
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef __DG_WORLD_SCHEDULER_H__
+#define __DG_WORLD_SCHEDULER_H__
+
+#include "dgPhysicsStdafx.h"
+
+class dgWorld;
+
+// one pool of worker threads shared by all the worlds attached to it,
+// worlds stepped together are either split across all workers or packed with other small worlds on one worker
+class dgWorldScheduler: public dgMutexThread, public dgThreadHive
+{
+	public:
+	class dgWorldEntry
+	{
+		public:
+		dgWorld* m_world;
+		dgInt32 m_cost;
+		dgInt32 m_bin;
+	};
+
+	DG_CLASS_ALLOCATOR(allocator)
+
+	dgWorldScheduler(dgMemoryAllocator* const allocator, dgInt32 threadCount);
+	virtual ~dgWorldScheduler();
+
+	dgMemoryAllocator* GetAllocator() const;
+
+	void AddWorld(dgWorld* const world);
+	void RemoveWorld(dgWorld* const world);
+	void Update(dgWorld** const worlds, dgInt32 count, dgFloat32 timestep);
+
+	// lends the workers to work started outside of an update, false while the scheduler is stepping
+	bool AcquireIdleWorkers();
+	void ReleaseIdleWorkers();
+
+	static void UpdateWorlds(dgWorld** const worlds, dgInt32 count, dgFloat32 timestep);
+
+	private:
+	void RunStep();
+	void StepBin(dgInt32 bin);
+	virtual void TickCallback(dgInt32 threadID);
+
+	static dgInt32 EstimateCost(const dgWorld* const world);
+	static void StepBinKernel(void* const context, void* const worldContext, dgInt32 threadID);
+	static dgInt32 CompareEntries(const dgWorldEntry* const entryA, const dgWorldEntry* const entryB, void* const context);
+
+	dgMemoryAllocator* m_allocator;
+	dgList<dgWorld*> m_worlds;
+	dgArray<dgWorldEntry> m_entries;
+	dgWorld** m_updateWorlds;
+	dgInt32 m_updateCount;
+	dgInt32 m_packedStart;
+	dgInt32 m_lock;
+	dgThread::dgSemaphore m_updateSemaphore;
+};
+
+inline dgMemoryAllocator* dgWorldScheduler::GetAllocator() const
+{
+	return m_allocator;
+}
+
+#endif
@@ -0,0 +1,628 @@
+/* Copyright (c) <2003-2019> <Julio Jerez, Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "dgPhysicsStdafx.h"
+#include "dgBody.h"
+#include "dgWorld.h"
+
+// body state packets are byte streams, so they do not depend on the endianness or the alignment of the host.
+// header: magic, flags, baseline hash, position step, velocity step, body count (fixed 32 bit little endian)
+// removed: with the removed flag, the count of baseline bodies no longer in the world and their ids minus the previous id (varints)
+// record: id minus previous id, then 13 quantized values minus the baseline values (zigzag varints)
+#define DG_BODY_STATE_MAGIC				0x53544442
+#define DG_BODY_STATE_DELTA				1
+#define DG_BODY_STATE_REMOVED			2
+#define DG_BODY_STATE_VALUES			13
+#define DG_BODY_STATE_HEADER_SIZE		(5 * 4 + 1)
+#define DG_BODY_STATE_MAX_RECORD_SIZE	((DG_BODY_STATE_VALUES + 1) * 5)
+#define DG_BODY_STATE_ROTATION_SCALE	dgFloat32 (32767.0f)
+
+class dgBodyStateRecord
+{
+	public:
+	dgInt32 m_id;
+	dgInt32 m_value[DG_BODY_STATE_VALUES];
+};
+
+class dgBodyStateWriter
+{
+	public:
+	dgBodyStateWriter(void* const buffer, dgInt32 capacity)
+		:m_ptr((dgUnsigned8*)buffer)
+		,m_size(0)
+		,m_capacity(capacity)
+	{
+	}
+
+	DG_INLINE void PutByte(dgUnsigned32 value)
+	{
+		if (m_ptr && (m_size < m_capacity)) {
+			m_ptr[m_size] = dgUnsigned8(value);
+		}
+		m_size++;
+	}
+
+	DG_INLINE void PutFixed(dgUnsigned32 value)
+	{
+		PutByte(value);
+		PutByte(value >> 8);
+		PutByte(value >> 16);
+		PutByte(value >> 24);
+	}
+
+	DG_INLINE void PutVarint(dgUnsigned32 value)
+	{
+		for (; value >= 0x80; value >>= 7) {
+			PutByte((value & 0x7f) | 0x80);
+		}
+		PutByte(value);
+	}
+
+	DG_INLINE void PutDelta(dgInt32 value, dgInt32 base)
+	{
+		// wraps around for values far apart, the decoder wraps back
+		const dgInt32 delta = dgInt32(dgUnsigned32(value) - dgUnsigned32(base));
+		PutVarint((dgUnsigned32(delta) << 1) ^ dgUnsigned32(delta >> 31));
+	}
+
+	void PutRecord(const dgBodyStateRecord& record, const dgBodyStateRecord* const base, dgInt32 prevId)
+	{
+		PutVarint(dgUnsigned32(record.m_id - prevId));
+		for (dgInt32 i = 0; i < DG_BODY_STATE_VALUES; i++) {
+			PutDelta(record.m_value[i], base ? base->m_value[i] : 0);
+		}
+	}
+
+	dgUnsigned8* m_ptr;
+	dgInt32 m_size;
+	dgInt32 m_capacity;
+};
+
+class dgBodyStateReader
+{
+	public:
+	dgBodyStateReader()
+		:m_ptr(NULL)
+		,m_end(NULL)
+		,m_removed(NULL)
+		,m_prevId(0)
+		,m_count(0)
+		,m_removedCount(0)
+		,m_flags(0)
+		,m_baselineHash(0)
+		,m_positionStep(0)
+		,m_velocityStep(0)
+	{
+	}
+
+	bool Init(const void* const buffer, dgInt32 sizeInBytes)
+	{
+		m_ptr = (const dgUnsigned8*)buffer;
+		m_end = m_ptr + (buffer ? sizeInBytes : 0);
+		m_prevId = 0;
+		bool ok = GetFixed() == DG_BODY_STATE_MAGIC;
+		m_flags = GetByte(ok);
+		m_baselineHash = GetFixed();
+		m_positionStep = GetFixed();
+		m_velocityStep = GetFixed();
+		m_count = dgInt32(GetFixed());
+
+		m_removed = NULL;
+		m_removedCount = 0;
+		if (ok && (m_flags & DG_BODY_STATE_REMOVED)) {
+			// skip the removed ids, GetRemovedIds reads them when they are needed
+			m_removedCount = dgInt32(GetVarint(ok));
+			ok = ok && (m_removedCount > 0) && (m_removedCount <= (m_end - m_ptr));
+			m_removed = m_ptr;
+			for (dgInt32 i = 0; (i < m_removedCount) && ok; i++) {
+				GetVarint(ok);
+			}
+		}
+
+		// a record takes at least one byte per value, this also rejects a corrupted count
+		return ok && (m_count >= 0) && (m_count <= (m_end - m_ptr) / (DG_BODY_STATE_VALUES + 1));
+	}
+
+	bool GetRemovedIds(dgInt32* const ids) const
+	{
+		bool ok = true;
+		dgBodyStateReader reader(*this);
+		reader.m_ptr = m_removed;
+		dgInt32 prevId = 0;
+		for (dgInt32 i = 0; (i < m_removedCount) && ok; i++) {
+			const dgUnsigned32 idStep = reader.GetVarint(ok);
+			ids[i] = prevId + dgInt32(idStep);
+			ok = ok && (idStep > 0) && (ids[i] > prevId);
+			prevId = ids[i];
+		}
+		return ok;
+	}
+
+	DG_INLINE dgUnsigned32 GetByte(bool& ok)
+	{
+		if (m_ptr < m_end) {
+			return *m_ptr++;
+		}
+		ok = false;
+		return 0;
+	}
+
+	DG_INLINE dgUnsigned32 GetFixed()
+	{
+		bool ok = true;
+		dgUnsigned32 value = GetByte(ok);
+		value |= GetByte(ok) << 8;
+		value |= GetByte(ok) << 16;
+		value |= GetByte(ok) << 24;
+		return ok ? value : 0;
+	}
+
+	DG_INLINE dgUnsigned32 GetVarint(bool& ok)
+	{
+		dgUnsigned32 value = 0;
+		for (dgInt32 shift = 0; shift < 35; shift += 7) {
+			const dgUnsigned32 byte = GetByte(ok);
+			value |= (byte & 0x7f) << shift;
+			if (!(byte & 0x80)) {
+				return value;
+			}
+		}
+		ok = false;
+		return value;
+	}
+
+	// the base of a record is found by id, so the id is read before the record
+	DG_INLINE dgInt32 PeekId(bool& ok) const
+	{
+		dgBodyStateReader reader(*this);
+		return m_prevId + dgInt32(reader.GetVarint(ok));
+	}
+
+	bool GetRecord(dgBodyStateRecord& record, const dgBodyStateRecord* const base)
+	{
+		bool ok = true;
+		const dgUnsigned32 idStep = GetVarint(ok);
+		record.m_id = m_prevId + dgInt32(idStep);
+		ok = ok && (idStep > 0) && (record.m_id > m_prevId);
+		m_prevId = record.m_id;
+		for (dgInt32 i = 0; i < DG_BODY_STATE_VALUES; i++) {
+			const dgUnsigned32 zigzag = GetVarint(ok);
+			const dgUnsigned32 delta = (zigzag >> 1) ^ (dgUnsigned32(0) - (zigzag & 1));
+			record.m_value[i] = dgInt32(delta + dgUnsigned32(base ? base->m_value[i] : 0));
+		}
+		return ok;
+	}
+
+	const dgUnsigned8* m_ptr;
+	const dgUnsigned8* m_end;
+	const dgUnsigned8* m_removed;
+	dgInt32 m_prevId;
+	dgInt32 m_count;
+	dgInt32 m_removedCount;
+	dgUnsigned32 m_flags;
+	dgUnsigned32 m_baselineHash;
+	dgUnsigned32 m_positionStep;
+	dgUnsigned32 m_velocityStep;
+};
+
+// walks an absolute packet in id order, so records of a delta packet find their base in one pass
+class dgBodyStateBaseline
+{
+	public:
+	dgBodyStateBaseline()
+		:m_reader()
+		,m_index(0)
+		,m_valid(false)
+		,m_error(false)
+	{
+	}
+
+	bool Init(const void* const buffer, dgInt32 sizeInBytes)
+	{
+		m_index = 0;
+		m_valid = false;
+		m_error = !m_reader.Init(buffer, sizeInBytes) || (m_reader.m_flags & DG_BODY_STATE_DELTA);
+		if (!m_error) {
+			Next();
+		}
+		return !m_error;
+	}
+
+	void Next()
+	{
+		m_valid = false;
+		if (m_index < m_reader.m_count) {
+			m_index++;
+			m_valid = m_reader.GetRecord(m_record, NULL);
+			m_error = m_error || !m_valid;
+		}
+	}
+
+	const dgBodyStateRecord* Find(dgInt32 id)
+	{
+		while (m_valid && (m_record.m_id < id)) {
+			Next();
+		}
+		return (m_valid && (m_record.m_id == id)) ? &m_record : NULL;
+	}
+
+	dgBodyStateReader m_reader;
+	dgBodyStateRecord m_record;
+	dgInt32 m_index;
+	bool m_valid;
+	bool m_error;
+};
+
+static dgUnsigned32 dgBodyStateHash(const void* const buffer, dgInt32 sizeInBytes)
+{
+	// fnv-1a, a delta packet carries the hash of its baseline so a stale baseline is detected
+	const dgUnsigned8* const ptr = (const dgUnsigned8*)buffer;
+	dgUnsigned32 hash = 2166136261u;
+	for (dgInt32 i = 0; i < sizeInBytes; i++) {
+		hash = (hash ^ ptr[i]) * 16777619u;
+	}
+	return hash;
+}
+
+static dgUnsigned32 dgBodyStateFloatBits(dgFloat32 value)
+{
+	union {
+		dgUnsigned32 m_bits;
+		float m_value;
+	} data;
+	data.m_value = float (value);
+	return data.m_bits;
+}
+
+static dgFloat32 dgBodyStateBitsFloat(dgUnsigned32 bits)
+{
+	union {
+		dgUnsigned32 m_bits;
+		float m_value;
+	} data;
+	data.m_bits = bits;
+	return dgFloat32 (data.m_value);
+}
+
+static DG_INLINE dgInt32 dgBodyStateQuantize(dgFloat32 value, dgFloat32 invStep)
+{
+	const dgFloat64 q = floor(dgFloat64(value) * invStep + dgFloat64(0.5f));
+	return dgInt32 (dgClamp(q, dgFloat64(-2147483647.0), dgFloat64(2147483647.0)));
+}
+
+static dgInt32 dgBodyStateCompareId(dgBody* const* const bodyA, dgBody* const* const bodyB, void* const context)
+{
+	const dgInt32 idA = (*bodyA)->GetUniqueID();
+	const dgInt32 idB = (*bodyB)->GetUniqueID();
+	if (idA < idB) {
+		return -1;
+	} else if (idA > idB) {
+		return 1;
+	}
+	return 0;
+}
+
+static dgInt32 dgBodyStateCompareInt(const dgInt32* const idA, const dgInt32* const idB, void* const context)
+{
+	if (*idA < *idB) {
+		return -1;
+	} else if (*idA > *idB) {
+		return 1;
+	}
+	return 0;
+}
+
+// ids are visited in increasing order, so the cursor into the sorted removed ids only moves forward
+static DG_INLINE bool dgBodyStateIsRemoved(const dgInt32* const removed, dgInt32 removedCount, dgInt32& cursor, dgInt32 id)
+{
+	while ((cursor < removedCount) && (removed[cursor] < id)) {
+		cursor++;
+	}
+	return (cursor < removedCount) && (removed[cursor] == id);
+}
+
+static bool dgBodyStateDecodeRecord(const dgBodyStateRecord& record, dgFloat32 positionStep, dgFloat32 velocityStep, dgMatrix& matrix, dgVector& veloc, dgVector& omega)
+{
+	dgQuaternion rotation;
+	rotation.m_x = dgFloat32(record.m_value[3]) / DG_BODY_STATE_ROTATION_SCALE;
+	rotation.m_y = dgFloat32(record.m_value[4]) / DG_BODY_STATE_ROTATION_SCALE;
+	rotation.m_z = dgFloat32(record.m_value[5]) / DG_BODY_STATE_ROTATION_SCALE;
+	rotation.m_w = dgFloat32(record.m_value[6]) / DG_BODY_STATE_ROTATION_SCALE;
+	const dgFloat32 mag2 = rotation.DotProduct(rotation);
+	if (mag2 < dgFloat32(0.25f)) {
+		return false;
+	}
+	rotation.Scale(dgRsqrt(mag2));
+
+	const dgVector posit(dgFloat32(record.m_value[0]) * positionStep, dgFloat32(record.m_value[1]) * positionStep, dgFloat32(record.m_value[2]) * positionStep, dgFloat32(1.0f));
+	matrix = dgMatrix(rotation, posit);
+	veloc = dgVector(dgFloat32(record.m_value[7]) * velocityStep, dgFloat32(record.m_value[8]) * velocityStep, dgFloat32(record.m_value[9]) * velocityStep, dgFloat32(0.0f));
+	omega = dgVector(dgFloat32(record.m_value[10]) * velocityStep, dgFloat32(record.m_value[11]) * velocityStep, dgFloat32(record.m_value[12]) * velocityStep, dgFloat32(0.0f));
+	return true;
+}
+
+dgBody* dgWorld::GetFirstChangedBody(dgUnsigned32 generation) const
+{
+	const dgBodyMasterList& masterList = *this;
+	dgAssert(masterList.GetFirst()->GetInfo().GetBody() == GetSentinelBody());
+	for (dgBodyMasterList::dgListNode* node = masterList.GetFirst()->GetNext(); node; node = node->GetNext()) {
+		dgBody* const body = node->GetInfo().GetBody();
+		if (body->m_stateGeneration >= generation) {
+			return body;
+		}
+	}
+	return NULL;
+}
+
+dgBody* dgWorld::GetNextChangedBody(const dgBody* const body, dgUnsigned32 generation) const
+{
+	dgAssert(body->m_masterNode);
+	for (dgBodyMasterList::dgListNode* node = body->m_masterNode->GetNext(); node; node = node->GetNext()) {
+		dgBody* const nextBody = node->GetInfo().GetBody();
+		if (nextBody->m_stateGeneration >= generation) {
+			return nextBody;
+		}
+	}
+	return NULL;
+}
+
+dgInt32 dgWorld::EncodeBodyStates(dgUnsigned32 generation, dgFloat32 positionStep, dgFloat32 velocityStep, const void* const baseline, dgInt32 baselineSizeInBytes, void* const buffer, dgInt32 bufferSizeInBytes) const
+{
+	dgAssert(positionStep > dgFloat32(0.0f));
+	dgAssert(velocityStep > dgFloat32(0.0f));
+	if ((positionStep <= dgFloat32(0.0f)) || (velocityStep <= dgFloat32(0.0f))) {
+		return 0;
+	}
+
+	dgInt32 count = 0;
+	dgStack<dgBody*> bodyArray(GetBodiesCount() + 1);
+	for (dgBody* body = GetFirstChangedBody(generation); body; body = GetNextChangedBody(body, generation)) {
+		bodyArray[count] = body;
+		count++;
+	}
+
+	const dgUnsigned32 positionBits = dgBodyStateFloatBits(positionStep);
+	const dgUnsigned32 velocityBits = dgBodyStateFloatBits(velocityStep);
+
+	dgBodyStateBaseline base;
+	if (baseline) {
+		if (!base.Init(baseline, baselineSizeInBytes) || (base.m_reader.m_positionStep != positionBits) || (base.m_reader.m_velocityStep != velocityBits)) {
+			return 0;
+		}
+	}
+
+	// baseline bodies that are no longer in the world are sent as removed, so the merge drops them
+	dgInt32 removedCount = 0;
+	dgStack<dgInt32> removedArray(baseline ? base.m_reader.m_count + 1 : 1);
+	if (baseline) {
+		dgInt32 idCount = 0;
+		dgStack<dgInt32> idArray(GetBodiesCount() + 1);
+		const dgBodyMasterList& masterList = *this;
+		for (dgBodyMasterList::dgListNode* node = masterList.GetFirst()->GetNext(); node; node = node->GetNext()) {
+			idArray[idCount] = node->GetInfo().GetBody()->m_uniqueID;
+			idCount++;
+		}
+		dgSort(&idArray[0], idCount, dgBodyStateCompareInt);
+
+		dgInt32 index = 0;
+		dgBodyStateBaseline scan;
+		scan.Init(baseline, baselineSizeInBytes);
+		for (; scan.m_valid; scan.Next()) {
+			const dgInt32 id = scan.m_record.m_id;
+			while ((index < idCount) && (idArray[index] < id)) {
+				index++;
+			}
+			if ((index == idCount) || (idArray[index] != id)) {
+				removedArray[removedCount] = id;
+				removedCount++;
+			}
+		}
+		if (scan.m_error) {
+			return 0;
+		}
+	}
+
+	if (!buffer) {
+		return DG_BODY_STATE_HEADER_SIZE + (removedCount + 1) * 5 + count * DG_BODY_STATE_MAX_RECORD_SIZE;
+	}
+
+	dgSort(&bodyArray[0], count, dgBodyStateCompareId);
+
+	dgBodyStateWriter writer(buffer, bufferSizeInBytes);
+	writer.PutFixed(DG_BODY_STATE_MAGIC);
+	writer.PutByte((baseline ? DG_BODY_STATE_DELTA : 0) | (removedCount ? DG_BODY_STATE_REMOVED : 0));
+	writer.PutFixed(baseline ? dgBodyStateHash(baseline, baselineSizeInBytes) : 0);
+	writer.PutFixed(positionBits);
+	writer.PutFixed(velocityBits);
+	writer.PutFixed(dgUnsigned32(count));
+	if (removedCount) {
+		writer.PutVarint(dgUnsigned32(removedCount));
+		for (dgInt32 i = 0; i < removedCount; i++) {
+			writer.PutVarint(dgUnsigned32(removedArray[i] - (i ? removedArray[i - 1] : 0)));
+		}
+	}
+
+	const dgFloat32 invPositionStep = dgFloat32(1.0f) / positionStep;
+	const dgFloat32 invVelocityStep = dgFloat32(1.0f) / velocityStep;
+
+	dgInt32 prevId = 0;
+	for (dgInt32 i = 0; i < count; i++) {
+		const dgBody* const body = bodyArray[i];
+		const dgVector& posit = body->m_matrix.m_posit;
+		dgQuaternion rotation(body->m_rotation);
+		if (rotation.m_w < dgFloat32(0.0f)) {
+			rotation.Scale(dgFloat32(-1.0f));
+		}
+
+		dgBodyStateRecord record;
+		record.m_id = body->m_uniqueID;
+		record.m_value[0] = dgBodyStateQuantize(posit.m_x, invPositionStep);
+		record.m_value[1] = dgBodyStateQuantize(posit.m_y, invPositionStep);
+		record.m_value[2] = dgBodyStateQuantize(posit.m_z, invPositionStep);
+		record.m_value[3] = dgBodyStateQuantize(rotation.m_x, DG_BODY_STATE_ROTATION_SCALE);
+		record.m_value[4] = dgBodyStateQuantize(rotation.m_y, DG_BODY_STATE_ROTATION_SCALE);
+		record.m_value[5] = dgBodyStateQuantize(rotation.m_z, DG_BODY_STATE_ROTATION_SCALE);
+		record.m_value[6] = dgBodyStateQuantize(rotation.m_w, DG_BODY_STATE_ROTATION_SCALE);
+		record.m_value[7] = dgBodyStateQuantize(body->m_veloc.m_x, invVelocityStep);
+		record.m_value[8] = dgBodyStateQuantize(body->m_veloc.m_y, invVelocityStep);
+		record.m_value[9] = dgBodyStateQuantize(body->m_veloc.m_z, invVelocityStep);
+		record.m_value[10] = dgBodyStateQuantize(body->m_omega.m_x, invVelocityStep);
+		record.m_value[11] = dgBodyStateQuantize(body->m_omega.m_y, invVelocityStep);
+		record.m_value[12] = dgBodyStateQuantize(body->m_omega.m_z, invVelocityStep);
+
+		writer.PutRecord(record, baseline ? base.Find(record.m_id) : NULL, prevId);
+		prevId = record.m_id;
+	}
+	dgAssert(!base.m_error);
+	return (writer.m_size <= bufferSizeInBytes) ? writer.m_size : 0;
+}
+
+dgInt32 dgWorld::DecodeBodyStates(const void* const baseline, dgInt32 baselineSizeInBytes, const void* const packet, dgInt32 packetSizeInBytes, OnBodyStateDecode callback, void* const userData)
+{
+	dgBodyStateReader reader;
+	if (!reader.Init(packet, packetSizeInBytes)) {
+		return -1;
+	}
+
+	dgBodyStateBaseline base;
+	const bool isDelta = (reader.m_flags & DG_BODY_STATE_DELTA) ? true : false;
+	if (isDelta) {
+		if (!base.Init(baseline, baselineSizeInBytes) || (dgBodyStateHash(baseline, baselineSizeInBytes) != reader.m_baselineHash) ||
+			(base.m_reader.m_positionStep != reader.m_positionStep) || (base.m_reader.m_velocityStep != reader.m_velocityStep)) {
+			return -1;
+		}
+	}
+
+	const dgFloat32 positionStep = dgBodyStateBitsFloat(reader.m_positionStep);
+	const dgFloat32 velocityStep = dgBodyStateBitsFloat(reader.m_velocityStep);
+	for (dgInt32 i = 0; i < reader.m_count; i++) {
+		dgBodyStateRecord record;
+		dgMatrix matrix;
+		dgVector veloc;
+		dgVector omega;
+		bool ok = true;
+		const dgInt32 id = reader.PeekId(ok);
+		if (!ok || !reader.GetRecord(record, isDelta ? base.Find(id) : NULL) || base.m_error) {
+			return -1;
+		}
+		if (!dgBodyStateDecodeRecord(record, positionStep, velocityStep, matrix, veloc, omega)) {
+			return -1;
+		}
+		if (callback) {
+			callback(userData, record.m_id, &matrix[0][0], &veloc[0], &omega[0]);
+		}
+	}
+
+	dgStack<dgInt32> removed(reader.m_removedCount + 1);
+	if (!reader.GetRemovedIds(&removed[0])) {
+		return -1;
+	}
+	if (callback) {
+		for (dgInt32 i = 0; i < reader.m_removedCount; i++) {
+			callback(userData, removed[i], NULL, NULL, NULL);
+		}
+	}
+	return reader.m_count + reader.m_removedCount;
+}
+
+dgInt32 dgWorld::MergeBodyStates(const void* const baseline, dgInt32 baselineSizeInBytes, const void* const packet, dgInt32 packetSizeInBytes, void* const buffer, dgInt32 bufferSizeInBytes)
+{
+	dgBodyStateReader reader;
+	if (!reader.Init(packet, packetSizeInBytes)) {
+		return 0;
+	}
+
+	dgBodyStateBaseline base;
+	const bool isDelta = (reader.m_flags & DG_BODY_STATE_DELTA) ? true : false;
+	if (isDelta) {
+		if (!base.Init(baseline, baselineSizeInBytes) || (dgBodyStateHash(baseline, baselineSizeInBytes) != reader.m_baselineHash) ||
+			(base.m_reader.m_positionStep != reader.m_positionStep) || (base.m_reader.m_velocityStep != reader.m_velocityStep)) {
+			return 0;
+		}
+	} else if (baseline) {
+		// an absolute packet can still be merged over an older baseline
+		if (!base.Init(baseline, baselineSizeInBytes) || (base.m_reader.m_positionStep != reader.m_positionStep) || (base.m_reader.m_velocityStep != reader.m_velocityStep)) {
+			return 0;
+		}
+	}
+
+	dgBodyStateWriter writer(buffer, bufferSizeInBytes);
+	writer.PutFixed(DG_BODY_STATE_MAGIC);
+	writer.PutByte(0);
+	writer.PutFixed(0);
+	writer.PutFixed(reader.m_positionStep);
+	writer.PutFixed(reader.m_velocityStep);
+	// the count is patched when the merged size is known
+	const dgInt32 countOffset = writer.m_size;
+	writer.PutFixed(0);
+
+	dgStack<dgInt32> removed(reader.m_removedCount + 1);
+	if (!reader.GetRemovedIds(&removed[0])) {
+		return 0;
+	}
+
+	dgInt32 count = 0;
+	dgInt32 prevId = 0;
+	dgInt32 removedCursor = 0;
+	for (dgInt32 i = 0; i < reader.m_count; i++) {
+		bool ok = true;
+		const dgInt32 id = reader.PeekId(ok);
+		while (base.m_valid && (base.m_record.m_id < id)) {
+			if (!dgBodyStateIsRemoved(&removed[0], reader.m_removedCount, removedCursor, base.m_record.m_id)) {
+				writer.PutRecord(base.m_record, NULL, prevId);
+				prevId = base.m_record.m_id;
+				count++;
+			}
+			base.Next();
+		}
+		dgBodyStateRecord record;
+		if (!ok || !reader.GetRecord(record, isDelta ? base.Find(id) : NULL)) {
+			return 0;
+		}
+		if (base.m_valid && (base.m_record.m_id == id)) {
+			base.Next();
+		}
+		writer.PutRecord(record, NULL, prevId);
+		prevId = record.m_id;
+		count++;
+	}
+	for (; base.m_valid; base.Next()) {
+		if (!dgBodyStateIsRemoved(&removed[0], reader.m_removedCount, removedCursor, base.m_record.m_id)) {
+			writer.PutRecord(base.m_record, NULL, prevId);
+			prevId = base.m_record.m_id;
+			count++;
+		}
+	}
+	if (base.m_error) {
+		return 0;
+	}
+
+	if (!buffer) {
+		return writer.m_size;
+	}
+	if (writer.m_size > bufferSizeInBytes) {
+		return 0;
+	}
+	const dgInt32 size = writer.m_size;
+	writer.m_size = countOffset;
+	writer.PutFixed(dgUnsigned32(count));
+	return size;
+}